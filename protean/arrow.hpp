@@ -0,0 +1,76 @@
+#ifndef PROTEAN_ARROW_HPP
+#define PROTEAN_ARROW_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <stdint.h>
+
+/* The Arrow C data interface, as specified by the Apache Arrow project, so that */
+/* tables can be handed to and from Arrow consumers without depending on Arrow   */
+/*********************************************************************************/
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+    // Array type description
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowSchema*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+struct ArrowArray {
+    // Array data description
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+
+    // Release callback
+    void (*release)(struct ArrowArray*);
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+} // extern "C"
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace protean {
+
+    // Exports a DataTable as a struct array with a child array per column, or a typed_array
+    // of a numeric type as a primitive array.  Integer and floating point columns share
+    // their values with the table, which the array holds on to until it is released;
+    // booleans become bitmaps, dates date32 days, date/times microsecond timestamps, times
+    // microsecond durations and strings utf8, in buffers of the array's own.
+    PROTEAN_DECL void export_arrow(const boost::shared_ptr<const variant>& value, ArrowArray* array, ArrowSchema* schema);
+
+    // Imports a struct array as a DataTable, or a primitive array of a numeric type as a
+    // typed_array, copying the values, then releases 'array' and 'schema' as the Arrow
+    // interface asks of a consumer.  Null values are imported as default values.
+    PROTEAN_DECL variant import_arrow(ArrowArray* array, ArrowSchema* schema);
+
+} // namespace protean
+
+#endif // PROTEAN_ARROW_HPP
@@ -40,6 +40,15 @@ namespace protean {
             ZlibHeader      = 0x00000002,   // binary_writer: output zlib header
             CreateProxy     = 0x00000004,   // binary_reader: create proxy object if class has not been registered in factory
             DateTimeAsTicks = 0x00000008,   // binary_writer: serialise DateTime/Date/Time as milliseconds/days since 1/1/1400
+            BlockCompress   = 0x00000010,   // binary_writer: compress data in independent blocks, in parallel
+            StringTable     = 0x00000020,   // binary_writer: write Dictionary/Bag keys, column and class names once, then refer to them by id
+            StringTableValues = 0x00000040, // binary_writer: as StringTable, for short String values
+            ShapedLists     = 0x00000080,   // binary_writer: write the keys and types of Lists of like Dictionaries once, then values only
+            Compact         = 0x00000100,   // binary_writer: write version 2 format (varints, 1-byte booleans, no padding)
+            SubtreeLengths  = 0x00000200,   // binary_writer: prefix collections with their length and index large Dictionaries, for binary_lazy_variant
+            Recycle         = 0x00000400,   // binary_reader: decode into the collections and strings already held by the target variant
+            ParallelColumns = 0x00000800,   // binary_writer: encode DataTable columns independently, prefixed by their lengths, so they are written and read in parallel
+            LargeSizes      = 0x00001000,   // binary_writer: set in the header of every version 1 stream, whose sizes may be written as binary_large_size_marker
             Default         = None
         };
     };
@@ -58,8 +67,55 @@ namespace protean {
     } binary_time_t;
 
     static const boost::uint32_t binary_magic_number = 0x484913FF;
-    static const boost::uint16_t binary_major_version = 1;
-    static const boost::uint16_t binary_minor_version = 1;
+    // Version 1 pads to 4 bytes and writes lengths and tags as 32-bit words, version 2
+    // (binary_mode::Compact) writes them as varints without padding.  binary_writer
+    // writes version 1 unless asked otherwise, binary_reader reads both.
+    static const boost::uint16_t binary_major_version = 2;
+    static const boost::uint16_t binary_minor_version = 9;
+    static const boost::uint16_t binary_major_version_v1 = 1;
+
+    // Version 1 sizes that do not fit in 32 bits are written as this marker, followed by
+    // the size in 64 bits.  Only streams with binary_mode::LargeSizes in their header
+    // hold the marker, in older streams it is a size like any other.
+    static const boost::uint32_t binary_large_size_marker = 0xFFFFFFFF;
+
+    // Dictionaries with at least this many entries carry an index of entry offsets in
+    // binary_mode::SubtreeLengths
+    static const size_t binary_dictionary_index_threshold = 32;
+
+    // Uncompressed size of each block written in binary_mode::BlockCompress
+    static const size_t binary_compression_block_size = 1024 * 1024;
+
+    // Limits of the per-stream string table (binary_mode::StringTable/StringTableValues),
+    // strings beyond these are written inline
+    static const size_t binary_string_table_max_entries = 65536;
+    static const size_t binary_string_table_max_value_length = 32;
+
+    // DataTables with fewer rows than this are written and read on one thread, even in
+    // binary_mode::ParallelColumns
+    static const size_t binary_parallel_columns_min_rows = 4096;
+
+    // Mode of the stream into which each column of a DataTable is encoded in
+    // binary_mode::ParallelColumns: uncompressed, and without the string table as
+    // columns do not share one
+    inline int binary_column_mode(int mode)
+    {
+        return mode & ~(binary_mode::Compress | binary_mode::BlockCompress | binary_mode::ZlibHeader | binary_mode::StringTable | binary_mode::StringTableValues);
+    }
+
+    // Set in the type of a dictionary-encoded DataTable column, whose values are written
+    // once each, followed by the index of each row's value
+    static const boost::int32_t binary_dictionary_column = 0x40000000;
+
+    // Set in the type of an arena-encoded DataTable column, whose values are written as
+    // the length of each row followed by the arena in one block
+    static const boost::int32_t binary_arena_column = 0x20000000;
+
+    // Record container files (binary_record_writer/binary_record_reader)
+    static const boost::uint32_t binary_record_magic_number = 0x524913FF;
+    static const boost::uint16_t binary_record_major_version = 1;
+    static const boost::uint16_t binary_record_minor_version = 0;
+    static const size_t binary_record_block_size = 256 * 1024;
 
 } // namespace protean
 
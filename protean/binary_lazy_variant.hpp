@@ -0,0 +1,82 @@
+#ifndef PROTEAN_BINARY_LAZY_VARIANT_HPP
+#define PROTEAN_BINARY_LAZY_VARIANT_HPP
+
+#include <protean/config.hpp>
+
+#include <protean/binary_common.hpp>
+#include <protean/variant.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    class object_factory;
+
+    /* A view of a binary document that decodes values only when they are asked for.       */
+    /* The whole (decompressed) document is read into memory on construction; navigating   */
+    /* to a child skips its siblings without decoding them, in O(1) per sibling when the   */
+    /* document was written with binary_mode::SubtreeLengths, and looks up keys of large   */
+    /* Dictionaries through their offset index.  value() decodes the subtree in full.      */
+    /***************************************************************************************/
+    class PROTEAN_DECL binary_lazy_variant
+    {
+    public:
+        explicit binary_lazy_variant(std::istream& is);
+
+        variant::enum_type_t type() const;
+        size_t size() const;
+
+        template<int N>
+        bool is() const
+        {
+            return (type() & N)!=0;
+        }
+
+        // Dictionary/Bag
+        bool has_key(const std::string& key) const;
+        binary_lazy_variant operator[](const std::string& key) const;
+
+        // List/Tuple
+        binary_lazy_variant operator[](size_t n) const;
+
+        // decode this value and everything below it
+        variant value() const;
+
+        void set_factory(object_factory& factory);
+
+    private:
+        struct document;
+        class cursor;
+
+        binary_lazy_variant(const boost::shared_ptr<const document>& doc, object_factory* factory, variant::enum_type_t type, size_t offset);
+        binary_lazy_variant(const boost::shared_ptr<const document>& doc, object_factory* factory, const variant& value);
+
+        bool find(const std::string& key, variant::enum_type_t& type, size_t& offset) const;
+
+    private:
+        boost::shared_ptr<const document>   m_document;
+        object_factory*                     m_factory;
+        variant::enum_type_t                m_type;
+
+        // offset of the value (after its type) in the document
+        size_t                              m_offset;
+
+        // set instead of m_offset for values that had to be decoded eagerly, such as the
+        // items of shaped Lists
+        boost::shared_ptr<const variant>    m_value;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_BINARY_LAZY_VARIANT_HPP
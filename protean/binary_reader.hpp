@@ -6,6 +6,11 @@
 #include <protean/binary_common.hpp>
 #include <protean/variant.hpp>
 
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
 #if defined(_MSC_VER)
 #    pragma warning(push)
 #    pragma warning(disable:4251)
@@ -14,6 +19,11 @@
 namespace protean {
 
     class object_factory;
+
+    namespace detail {
+        template <typename Source>
+        class binary_skipper;
+    }
     
     class PROTEAN_DECL binary_reader
     {
@@ -39,13 +49,25 @@ namespace protean {
         // read from stream
         void read_bytes(char* value, size_t length);
         void read_value(variant::enum_type_t type, variant& value);
+        void skip_value(variant::enum_type_t type);
+
+        // read a key or String value, through the string table if enabled
+        const std::string& read_key();
+        const std::string& read_string();
 
         void set_factory(object_factory& factory);
+
+        // Read only the parts of a document that match these select-style paths, such as
+        // "positions/*/qty", and skip the rest without decoding it.  Collections keep the
+        // entries on the paths, Lists and Tuples keep the items that match.
+        void set_projection(const std::vector<std::string>& paths);
 	
 	protected:
 		bool eof() const;
 
     private:
+        struct projection;
+
         std::istream&                           m_is;
         boost::iostreams::filtering_istream     m_filter;
         int                                     m_mode;
@@ -53,11 +75,48 @@ namespace protean {
         object_factory*                         m_factory;
         boost::uint16_t                         m_major_version;
         boost::uint16_t                         m_minor_version;
+        bool                                    m_compact;
+        bool                                    m_subtree_lengths;
+        std::vector<std::string>                m_string_table;
+        std::string                             m_string;
+        boost::shared_ptr<const projection>     m_projection;
+
+        // binary_mode::Recycle: keys of the Dictionaries being read, innermost last, with
+        // the strings kept between documents so that their storage is reused
+        std::vector<std::string>                m_recycled_keys;
+        size_t                                  m_recycled_top;
+
+        void read_content(variant::enum_type_t type, variant& value);
+        size_t read_size();
+        void read_shaped_list(variant& value);
+        void read_column(data_table_column_base& column);
+        void read_dictionary_column(data_table_column_base& column);
+        void read_arena_column(data_table_column_base& column);
+        void read_parallel_columns(variant& value);
+        bool recycle(variant::enum_type_t type, const variant& value) const;
+        variant& recycle_entry(variant& value, const std::string& key);
+        void remove_stale_entries(variant& value, size_t first);
+        bool read_projected(variant::enum_type_t type, variant& value, const projection& node);
+        void skip_bytes(boost::uint64_t length);
+        void skip_string();
+        void skip_key();
+        void skip_string_value();
+        const std::string& read_string_reference();
+        boost::uint64_t read_varint();
+        boost::uint64_t read_word();
+        boost::int32_t read_int32();
+        boost::uint64_t read_uint64();
 
         void setup();
         void close();
 
+        // for data without a header, e.g. a subtree of a document already in memory
+        void setup(boost::uint16_t major_version, int writer_mode);
+
         friend PROTEAN_DECL binary_reader& operator>>(binary_reader& reader, variant& v);
+        friend class binary_lazy_variant;
+        template <typename Source>
+        friend class detail::binary_skipper;
     };
 
 } // namespace protean
@@ -0,0 +1,103 @@
+#ifndef PROTEAN_BINARY_RECORD_READER_HPP
+#define PROTEAN_BINARY_RECORD_READER_HPP
+
+#include <protean/config.hpp>
+
+#include <protean/binary_common.hpp>
+#include <protean/variant.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    class object_factory;
+
+    /* Random access to records in a container written by binary_record_writer.  The index */
+    /* footer is loaded on construction, after which any record is reached with a single   */
+    /* seek and the decoding of one block.  The stream must be seekable.                   */
+    /***************************************************************************************/
+    class PROTEAN_DECL binary_record_reader
+    {
+    public:
+        typedef std::pair<size_t, size_t> range_t;
+
+    public:
+        binary_record_reader(std::istream& is, int mode=binary_mode::Default);
+
+        // Shares the index already loaded by 'rhs', e.g. to scan one file from several
+        // threads, each with its own stream
+        binary_record_reader(std::istream& is, const binary_record_reader& rhs);
+
+        size_t size() const;
+
+        void read(size_t n, variant& value);
+        bool read(const std::string& key, variant& value);
+
+        bool has_key(const std::string& key) const;
+        const std::string& key(size_t n) const;
+
+        // Splits the records into at most 'parts' ordinal ranges [first, second) on
+        // block boundaries, so that parallel scans never decode the same block twice
+        std::vector<range_t> partition(size_t parts) const;
+
+        void set_factory(object_factory& factory);
+
+    private:
+        void read_index();
+        const std::vector<char>& load_block(size_t block);
+
+        void read_bytes(char* value, size_t length);
+
+        template <typename T>
+        void read_raw(T& value);
+
+    private:
+        struct block_entry
+        {
+            boost::uint64_t m_offset;
+            boost::uint32_t m_stored_length;
+            boost::uint32_t m_raw_length;
+        };
+
+        struct record_entry
+        {
+            boost::uint32_t m_block;
+            boost::uint32_t m_offset;
+            boost::uint32_t m_length;
+        };
+
+        struct index
+        {
+            int                             m_writer_mode;
+            std::vector<block_entry>        m_blocks;
+            std::vector<record_entry>       m_records;
+            std::vector<std::string>        m_keys;
+            std::map<std::string, size_t>   m_key_map;
+        };
+
+        std::istream&                   m_is;
+        int                             m_mode;
+        object_factory*                 m_factory;
+        boost::shared_ptr<const index>  m_index;
+
+        // most recently decoded block
+        size_t                          m_block_number;
+        std::vector<char>               m_block;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_BINARY_RECORD_READER_HPP
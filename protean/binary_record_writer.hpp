@@ -0,0 +1,82 @@
+#ifndef PROTEAN_BINARY_RECORD_WRITER_HPP
+#define PROTEAN_BINARY_RECORD_WRITER_HPP
+
+#include <protean/config.hpp>
+
+#include <protean/binary_common.hpp>
+#include <protean/variant.hpp>
+
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    /* Writes a seekable container of binary-encoded records:                                 */
+    /*   [HEADER][BLOCK 0]...[BLOCK N][INDEX][INDEX OFFSET][MAGIC]                             */
+    /* Records are appended to blocks of roughly 'block_size' bytes, each compressed on its   */
+    /* own when binary_mode::Compress is set.  The index footer holds the offset of every     */
+    /* block, the position of every record within its block and the optional record keys.    */
+    /* Records, blocks and keys are limited to 4GB each.                                      */
+    /******************************************************************************************/
+    class PROTEAN_DECL binary_record_writer
+    {
+    public:
+        binary_record_writer(std::ostream& os, int mode=binary_mode::Default, size_t block_size=binary_record_block_size);
+        ~binary_record_writer();
+
+        void write(const variant& value);
+        void write(const std::string& key, const variant& value);
+
+        // write the final block and the index.  The destructor closes the container too,
+        // but ignores any error doing so, so close() should be called to learn of them.
+        void close();
+
+        size_t size() const;
+
+    private:
+        void write_header();
+        void flush_block();
+        void write_bytes(const char* value, size_t length);
+
+        template <typename T>
+        void write_raw(const T& value);
+
+    private:
+        struct block_entry
+        {
+            boost::uint64_t m_offset;
+            boost::uint32_t m_stored_length;
+            boost::uint32_t m_raw_length;
+        };
+
+        struct record_entry
+        {
+            boost::uint32_t m_block;
+            boost::uint32_t m_offset;
+            boost::uint32_t m_length;
+        };
+
+        std::ostream&               m_os;
+        int                         m_mode;
+        size_t                      m_block_size;
+        boost::uint64_t             m_position;
+        std::vector<char>           m_block;
+        std::vector<block_entry>    m_blocks;
+        std::vector<record_entry>   m_records;
+        std::vector<std::string>    m_keys;
+        bool                        m_has_keys;
+        bool                        m_closed;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_BINARY_RECORD_WRITER_HPP
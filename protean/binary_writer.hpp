@@ -6,20 +6,29 @@
 #include <protean/binary_common.hpp>
 #include <protean/variant.hpp>
 
+#include <boost/unordered_map.hpp>
+
+#include <vector>
+
 #if defined(_MSC_VER)
 #    pragma warning(push)
 #    pragma warning(disable:4251)
 #endif
 
 namespace protean {
+
+    class data_table_view;
     
     class PROTEAN_DECL binary_writer
     {
     public:
         binary_writer(std::ostream &os, int mode=binary_mode::Default);
+
+        // does not throw, nor flush what is left of a document that failed to write
         ~binary_writer();
         
         void write(const variant& value);
+        void write(const data_table_view& value);
         void write(const std::string& value);
         void write(const detail::string& value);
         void write(bool value);
@@ -38,16 +47,45 @@ namespace protean {
         void write_bytes(const char* value, size_t length);
         void write_value(const variant& value);
 
+        // write a key or String value, through the string table if enabled
+        void write_key(const std::string& value);
+        void write_string(const std::string& value);
+
 	protected:
 		void setup();
         void close();
 
+        // abandon a document after an error, without flushing what is buffered
+        void discard();
+
+    private:
+        void write_content(const variant& value);
+        void write_size(size_t value);
+        void write_shaped_list(const variant& value);
+        void write_data_table(const data_table_view& value);
+        void write_column(const data_table_column_base& column, size_t offset, size_t length);
+        void write_dictionary_column(const data_table_column_base& column, size_t offset, size_t length);
+        void write_arena_column(const data_table_column_base& column, size_t offset, size_t length);
+        void write_parallel_columns(const data_table_view& value);
+        void write_string_reference(const std::string& value, bool cacheable);
+        void write_varint(boost::uint64_t value);
+        void put(const char* value, size_t length);
+        size_t begin_subtree();
+        void end_subtree(size_t start);
+
     private:
+        typedef boost::unordered_map<std::string, boost::uint32_t> string_table_t;
+
         std::ostream&                       m_os;
         boost::iostreams::filtering_ostream m_filter;
         int                                 m_mode;
+        bool                                m_compact;
+        bool                                m_subtree_lengths;
+        std::vector<char>                   m_buffer;
+        string_table_t                      m_string_table;
 
         friend PROTEAN_DECL binary_writer& operator<<(binary_writer& writer, const variant& v);
+        friend PROTEAN_DECL binary_writer& operator<<(binary_writer& writer, const data_table_view& v);
     };
 
 } // namespace protean
@@ -0,0 +1,41 @@
+#ifndef PROTEAN_DATA_TABLE_AGGREGATE_HPP
+#define PROTEAN_DATA_TABLE_AGGREGATE_HPP
+
+#include <protean/config.hpp>
+
+#include <string>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    /* One result column of a DataTable group-by: a function applied to the values of a  */
+    /* column for each group.  Sum, Min and Max of integer columns are Int64, of Float    */
+    /* and Double columns Double; Mean is always Double and Count is UInt64, and the      */
+    /* column of a Count may be left empty.  The result column is named 'name', or after  */
+    /* the function and column, e.g. "Sum(Price)", if that is empty.                      */
+    /**************************************************************************************/
+    struct PROTEAN_DECL data_table_aggregate
+    {
+        enum function_t { Sum, Count, Min, Max, Mean };
+
+        data_table_aggregate(function_t function, const std::string& column = std::string(), const std::string& name = std::string());
+
+        // Name of the result column
+        std::string result_name() const;
+
+        function_t  m_function;
+        std::string m_column;
+        std::string m_name;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DATA_TABLE_AGGREGATE_HPP
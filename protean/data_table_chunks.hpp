@@ -0,0 +1,115 @@
+#ifndef PROTEAN_DATA_TABLE_CHUNKS_HPP
+#define PROTEAN_DATA_TABLE_CHUNKS_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant.hpp>
+#include <protean/data_table_column_base.hpp>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+
+#include <iterator>
+#include <string>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    /* A DataTable that grows by whole chunks: a directory of DataTables of up to      */
+    /* chunk_size() rows each, with their columns reserved up front, so that appending */
+    /* never reallocates or copies the rows already held and memory stays close to the */
+    /* size of the rows.  Each chunk is a DataTable in its own right, to be scanned in  */
+    /* parallel, viewed or serialized; release() concatenates them.                     */
+    /*                                                                                  */
+    /* This is a staging area for ingestion, not chunked storage within DataTable: the  */
+    /* columns of a DataTable remain one std::vector each, which the typed iterators,   */
+    /* expressions, indexes, sorting, joins and the binary format rely on being         */
+    /* contiguous.  It cannot be held in a variant, and filtering, iterating or         */
+    /* serializing it as one table, or any other operation on the whole table, needs    */
+    /* release() first, which holds the rows twice over for no more than one chunk.     */
+    /************************************************************************************/
+    class PROTEAN_DECL data_table_chunks
+    {
+    public:
+        static const size_t default_chunk_size = 65536;
+
+    public:
+        explicit data_table_chunks(size_t chunk_size = default_chunk_size);
+
+        // Columns can only be added while there are no rows
+        data_table_chunks& add_column(variant_base::enum_type_t type, const std::string& name, data_table_column_base::encoding_t encoding = data_table_column_base::PlainEncoding);
+
+        template <typename Tuple>
+        data_table_chunks& push_back(const Tuple& value)
+        {
+            writable_chunk().push_back(value);
+            ++m_size;
+            return *this;
+        }
+
+        // Appends a range of rows column by column, a chunk at a time. Each chunk walks
+        // its part of the range once per column, so Iterator must be a forward iterator.
+        template <typename Iterator>
+        data_table_chunks& append(Iterator first, Iterator last)
+        {
+            BOOST_STATIC_ASSERT_MSG((boost::is_convertible<typename std::iterator_traits<Iterator>::iterator_category, std::forward_iterator_tag>::value),
+                "data_table_chunks::append() walks the range once per column and needs forward iterators");
+
+            while (first != last)
+            {
+                variant& chunk(writable_chunk());
+
+                Iterator next(first);
+                const size_t count(advance_within(next, last, m_chunk_size - chunk.size()));
+
+                chunk.append(first, next);
+                m_size += count;
+                first = next;
+            }
+            return *this;
+        }
+
+        size_t size() const                     { return m_size; }
+        bool empty() const                      { return m_size==0; }
+        size_t chunk_size() const               { return m_chunk_size; }
+
+        size_t chunk_count() const              { return m_chunks.size(); }
+        const variant& chunk(size_t i) const    { return m_chunks.at(i); }
+
+        // A DataTable of all the rows, leaving this with its columns but no rows.  Each
+        // chunk is released once it has been copied, so memory peaks at the size of the
+        // rows and one chunk rather than twice that.
+        variant release();
+
+    private:
+        // The last chunk, or a new one if that is full
+        variant& writable_chunk();
+
+        // Advances 'itr' by up to 'n', returning how far
+        template <typename Iterator>
+        static size_t advance_within(Iterator& itr, Iterator last, size_t n)
+        {
+            size_t count(0);
+            for ( ; count<n && itr!=last; ++count)
+                ++itr;
+            return count;
+        }
+
+    private:
+        variant                     m_schema;   // a DataTable with the columns and no rows
+        boost::ptr_vector<variant>  m_chunks;
+        size_t                      m_chunk_size;
+        size_t                      m_size;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DATA_TABLE_CHUNKS_HPP
@@ -19,6 +19,11 @@
 
 namespace protean {
 
+	namespace detail {
+		class string_dictionary;
+		class string_arena;
+	}
+
 	template <variant_base::enum_type_t E>
 	struct column_traits
 	{
@@ -41,6 +46,19 @@ namespace protean {
 
 		virtual data_table_column_base* clone() const = 0;
 		virtual void resize(size_t n) = 0;
+		virtual void reserve(size_t n) = 0;
+		virtual size_t capacity() const = 0;
+
+		// A new column of the same name, type and encoding holding the given rows of
+		// this column, in the order given.  Rows of npos hold the default value of the
+		// column's type.
+		virtual data_table_column_base* take(const std::vector<size_t>& rows) const = 0;
+
+		static const size_t npos = static_cast<size_t>(-1);
+
+		// Appends the values of 'other', a column of the same type, copying them into the
+		// dictionary or arena of this column if it is encoded
+		virtual void extend(const data_table_column_base& other) = 0;
 
 	protected:
 		data_table_column_base(const data_table_column_base& rhs) : m_name(rhs.m_name), m_type(rhs.m_type) {}
@@ -52,6 +70,35 @@ namespace protean {
 		virtual const std::string& name() const { return m_name; }
 		variant_base::enum_type_t type() const  { return m_type; }
 
+		// Names are not checked against those of the other columns of a table
+		void rename(const std::string& name)    { m_name = name; }
+
+		/* Encoding */
+		/************/
+	public:
+		// How the values of String and Any columns are held: a copy per row, a reference
+		// per row to one copy of each distinct value, or a reference per row into one
+		// contiguous block of all the values
+		enum encoding_t
+		{
+			PlainEncoding,
+			DictionaryEncoding,
+			ArenaEncoding
+		};
+
+		virtual encoding_t encoding() const = 0;
+
+		// Re-encodes the existing values, only String and Any columns may be encoded
+		virtual void set_encoding(encoding_t encoding) = 0;
+
+		// The distinct values of a dictionary-encoded column, null otherwise
+		virtual detail::string_dictionary* dictionary() = 0;
+		virtual const detail::string_dictionary* dictionary() const = 0;
+
+		// The values of an arena-encoded column, null otherwise
+		virtual detail::string_arena* arena() = 0;
+		virtual const detail::string_arena* arena() const = 0;
+
 		/* Variant interface */
 		/*********************/
 	public:
@@ -73,30 +120,49 @@ namespace protean {
 		template <typename V>
 		void push_back(const V& value);
 
+		// Appends 'count' values as push_back() does each of them, in one virtual call
+		template <typename V>
+		void push_back(const V* values, size_t count);
+
 		template <variant_base::enum_type_t E>
 		typename column_traits<E>::const_iterator begin() const;
 
 		template <variant_base::enum_type_t E>
 		typename column_traits<E>::const_iterator end() const;
 
+		// The rows of a dictionary or arena-encoded column refer to its storage, so
+		// mutable access decodes the column first, as set_encoding(PlainEncoding) does
 		template <variant_base::enum_type_t E>
 		typename column_traits<E>::iterator begin();
 
 		template <variant_base::enum_type_t E>
 		typename column_traits<E>::iterator end();
 
+		// Bulk operations, which leave it to the caller to keep the columns of a table
+		// the same length.  Values are stored as given, they are not added to the
+		// dictionary or arena of an encoded column.
+		template <variant_base::enum_type_t E>
+		void append(const typename column_traits<E>::value_type* values, size_t count);
+
+		// Replaces the values of the column, taking ownership of 'values' without copying
+		template <variant_base::enum_type_t E>
+		void assign(typename column_traits<E>::container_type&& values);
+
 	protected:
 		// Method implementations
 	#define PROTEAN_DETAIL_DT_COLUMN_DECLARE_PURE_VIRTUAL_IMPLS(r, data, elem)                                                   \
 		virtual std::vector<GET_TYPE(elem)>::const_iterator begin_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) const = 0; \
 		virtual std::vector<GET_TYPE(elem)>::const_iterator end_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) const = 0; \
 		virtual std::vector<GET_TYPE(elem)>::iterator begin_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) = 0; \
-		virtual std::vector<GET_TYPE(elem)>::iterator end_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) = 0;
+		virtual std::vector<GET_TYPE(elem)>::iterator end_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) = 0; \
+		virtual std::vector<GET_TYPE(elem)>& values_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) = 0;
 
 	#define PROTEAN_DETAIL_DT_COLUMN_DECLARE_PURE_VIRTUAL_PUSH_BACK_IMPL(r, data, type)  \
 		virtual void push_back_impl(const type& value, type* = 0) = 0;                   \
+		virtual void push_back_impl(const type* values, size_t count, type* = 0) = 0;    \
 
 		virtual void push_back_impl(const variant& value, variant* = 0) = 0;
+		virtual void push_back_impl(const variant* values, size_t count, variant* = 0) = 0;
 
 		BOOST_PP_SEQ_FOR_EACH(PROTEAN_DETAIL_DT_COLUMN_DECLARE_PURE_VIRTUAL_PUSH_BACK_IMPL, , SUPPORTED_TYPES)
 			BOOST_PP_SEQ_FOR_EACH(PROTEAN_DETAIL_DT_COLUMN_DECLARE_PURE_VIRTUAL_IMPLS, , COLUMN_TYPES)
@@ -104,7 +170,7 @@ namespace protean {
 			/* Member variables */
 			/********************/
 	private:
-		const std::string               m_name;
+		std::string                     m_name;
 		const variant_base::enum_type_t m_type;
 	};
 
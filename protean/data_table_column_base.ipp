@@ -12,6 +12,12 @@ namespace protean {
         return push_back_impl(value, static_cast<V*>(0));
     }
 
+    template <typename V>
+    void data_table_column_base::push_back(const V* values, size_t count)
+    {
+        return push_back_impl(values, count, static_cast<V*>(0));
+    }
+
     template <variant_base::enum_type_t E>
     typename column_traits<E>::const_iterator data_table_column_base::begin() const
     {
@@ -36,4 +42,17 @@ namespace protean {
         return end_impl(static_cast<typename column_traits<E>::enum_type*>(0));
     }
 
+    template <variant_base::enum_type_t E>
+    void data_table_column_base::append(const typename column_traits<E>::value_type* values, size_t count)
+    {
+        typename column_traits<E>::container_type& container(values_impl(static_cast<typename column_traits<E>::enum_type*>(0)));
+        container.insert(container.end(), values, values + count);
+    }
+
+    template <variant_base::enum_type_t E>
+    void data_table_column_base::assign(typename column_traits<E>::container_type&& values)
+    {
+        values_impl(static_cast<typename column_traits<E>::enum_type*>(0)).swap(values);
+    }
+
 } // namespace protean
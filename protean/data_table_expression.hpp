@@ -0,0 +1,112 @@
+#ifndef PROTEAN_DATA_TABLE_EXPRESSION_HPP
+#define PROTEAN_DATA_TABLE_EXPRESSION_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant_base.hpp>
+#include <protean/data_table_column_base.hpp>
+
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    namespace detail {
+        struct expression_node;
+    }
+
+    /* An expression over the columns of a DataTable: column references and literals       */
+    /* combined with comparisons, boolean logic and arithmetic, e.g.                        */
+    /*                                                                                      */
+    /*     data_table_expression::column("Price") * data_table_expression::column("Qty")    */
+    /*         > 1000.0 && !data_table_expression::column("Cancelled")                      */
+    /*                                                                                      */
+    /* Expressions are evaluated a column at a time over batches of rows, in tight loops    */
+    /* over contiguous arrays that the compiler vectorises.  Integer columns are evaluated  */
+    /* as Int64 and floating point as Double, mixing the two promotes to Double.  UInt64    */
+    /* columns stay unsigned and compare with Int64 by value; arithmetic on them gives a    */
+    /* UInt64 with another UInt64 and a Double otherwise.  Date, Time and DateTime columns  */
+    /* compare with each other and with literals of those types, not_a_date_time before    */
+    /* -infinity before all other values.                                                   */
+    /****************************************************************************************/
+    class PROTEAN_DECL data_table_expression
+    {
+    public:
+        typedef boost::ptr_vector<data_table_column_base> column_collection_t;
+
+        enum enum_operator_t
+        {
+            Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual,
+            And, Or, Not,
+            Add, Subtract, Multiply, Divide, Negate
+        };
+
+    public:
+        // Reference to the column of this name
+        static data_table_expression column(const std::string& name);
+
+        // Literals
+        data_table_expression(bool value);
+        data_table_expression(boost::int32_t value);
+        data_table_expression(boost::int64_t value);
+        data_table_expression(double value);
+        data_table_expression(const char* value);
+        data_table_expression(const std::string& value);
+        data_table_expression(const boost::gregorian::date& value);
+        data_table_expression(const boost::posix_time::ptime& value);
+        data_table_expression(const boost::posix_time::time_duration& value);
+
+        data_table_expression(enum_operator_t op, const data_table_expression& operand);
+        data_table_expression(enum_operator_t op, const data_table_expression& lhs, const data_table_expression& rhs);
+
+        // Type of the column that evaluate() produces for these columns
+        variant_base::enum_type_t type(const column_collection_t& columns) const;
+
+        // Rows of 'columns' for which this Boolean expression holds, in ascending order
+        std::vector<size_t> select(const column_collection_t& columns) const;
+
+        // A new column named 'name' holding the value of this expression for each row
+        data_table_column_base* evaluate(const column_collection_t& columns, const std::string& name) const;
+
+    private:
+        explicit data_table_expression(const boost::shared_ptr<const detail::expression_node>& node);
+
+    private:
+        boost::shared_ptr<const detail::expression_node> m_node;
+    };
+
+    PROTEAN_DECL data_table_expression operator==(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator!=(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator<(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator<=(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator>(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator>=(const data_table_expression& lhs, const data_table_expression& rhs);
+
+    // Both operands are always evaluated
+    PROTEAN_DECL data_table_expression operator&&(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator||(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator!(const data_table_expression& operand);
+
+    PROTEAN_DECL data_table_expression operator+(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator-(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator*(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator/(const data_table_expression& lhs, const data_table_expression& rhs);
+    PROTEAN_DECL data_table_expression operator-(const data_table_expression& operand);
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DATA_TABLE_EXPRESSION_HPP
@@ -0,0 +1,121 @@
+#ifndef PROTEAN_DATA_TABLE_FILE_HPP
+#define PROTEAN_DATA_TABLE_FILE_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant.hpp>
+#include <protean/data_table_column_base.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    class data_table_view;
+
+    /* A DataTable stored column by column in a file that is memory-mapped to be read.  */
+    /* The rows are split into row groups, holding a block per column aligned to 64     */
+    /* bytes and the least and greatest value of the column, so that scans can skip    */
+    /* the groups that cannot match.  Numeric blocks are read in place over the mapping; */
+    /* the schema and statistics are kept in a footer read when the file is opened.      */
+    /*************************************************************************************/
+    class PROTEAN_DECL data_table_file : boost::noncopyable
+    {
+    public:
+        static const size_t default_row_group_size = 1048576;
+
+        // Writes the rows of 'view' to 'path', replacing any file there.  Columns must be
+        // of a numeric, string or date/time type.
+        static void write(const std::string& path, const data_table_view& view, size_t row_group_size = default_row_group_size);
+
+        // Maps the file at 'path' and reads its footer
+        explicit data_table_file(const std::string& path);
+        ~data_table_file();
+
+    /* Schema */
+    /**********/
+    public:
+        size_t size() const                                         { return m_rows; }
+        bool empty() const                                          { return m_rows==0; }
+
+        size_t column_count() const                                 { return m_names.size(); }
+        const std::string& column_name(size_t column) const         { return m_names.at(column); }
+        variant_base::enum_type_t column_type(size_t column) const  { return m_types.at(column); }
+        size_t column_index(const std::string& name) const;
+
+    /* Row groups */
+    /**************/
+    public:
+        size_t row_group_count() const                              { return m_groups.size(); }
+        size_t row_group_offset(size_t group) const                 { return m_groups.at(group).m_offset; }
+        size_t row_group_size(size_t group) const                   { return m_groups.at(group).m_size; }
+
+        // Least and greatest value of a column in a row group, leaving out NaNs, or None if
+        // unknown because the group holds special dates or times, or nothing but NaNs
+        const variant& min(size_t group, size_t column) const       { return m_groups.at(group).m_min.at(column); }
+        const variant& max(size_t group, size_t column) const       { return m_groups.at(group).m_max.at(column); }
+
+        // Values of a column of an integer or floating point type in a row group, in place
+        template <variant_base::enum_type_t E>
+        boost::iterator_range<const typename column_traits<E>::value_type*> values(size_t group, size_t column) const
+        {
+            const typename column_traits<E>::value_type* first(
+                reinterpret_cast<const typename column_traits<E>::value_type*>(block(group, column, E)));
+            return boost::make_iterator_range(first, first + row_group_size(group));
+        }
+
+        // Value of a column in the n'th row of the file
+        variant value(size_t column, size_t n) const;
+
+    /* Queries */
+    /***********/
+    public:
+        // Row groups whose statistics admit values of 'column' in [lower, upper)
+        std::vector<size_t> row_groups(const std::string& column, const variant& lower, const variant& upper) const;
+
+        // Rows whose value of 'column' lies in [lower, upper), in row order, reading only
+        // the row groups above
+        std::vector<size_t> scan(const std::string& column, const variant& lower, const variant& upper) const;
+
+        // Copies the rows of a row group, or of the whole file, into a DataTable
+        variant table(size_t group) const;
+        variant table() const;
+
+    private:
+        // Start of the block of a column in a row group, checking that the column holds
+        // values of 'type' that are stored as they are in memory
+        const char* block(size_t group, size_t column, variant_base::enum_type_t type) const;
+        const char* block(size_t group, size_t column) const;
+
+        struct row_group
+        {
+            size_t                          m_offset;
+            size_t                          m_size;
+            std::vector<boost::uint64_t>    m_blocks;
+            std::vector<variant>            m_min;
+            std::vector<variant>            m_max;
+        };
+
+    private:
+        boost::iostreams::mapped_file_source    m_file;
+        size_t                                  m_rows;
+        std::vector<std::string>                m_names;
+        std::vector<variant_base::enum_type_t>  m_types;
+        std::vector<row_group>                  m_groups;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DATA_TABLE_FILE_HPP
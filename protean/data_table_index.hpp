@@ -0,0 +1,16 @@
+#ifndef PROTEAN_DATA_TABLE_INDEX_HPP
+#define PROTEAN_DATA_TABLE_INDEX_HPP
+
+namespace protean {
+
+    // Kind of secondary index on a DataTable column: a hash index answers equality
+    // lookups, a sorted index those and range lookups
+    enum data_table_index_t
+    {
+        HashIndex,
+        SortedIndex
+    };
+
+} // namespace protean
+
+#endif // PROTEAN_DATA_TABLE_INDEX_HPP
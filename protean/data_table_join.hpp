@@ -0,0 +1,16 @@
+#ifndef PROTEAN_DATA_TABLE_JOIN_HPP
+#define PROTEAN_DATA_TABLE_JOIN_HPP
+
+namespace protean {
+
+    // Whether a join of two DataTables keeps the rows of the left table that have no
+    // match in the right, with default values in the columns from the right
+    enum data_table_join_t
+    {
+        InnerJoin,
+        LeftJoin
+    };
+
+} // namespace protean
+
+#endif // PROTEAN_DATA_TABLE_JOIN_HPP
@@ -0,0 +1,61 @@
+#ifndef PROTEAN_DATA_TABLE_SELECTION_HPP
+#define PROTEAN_DATA_TABLE_SELECTION_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant.hpp>
+#include <protean/data_table_column_base.hpp>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    /* A view of some of the rows of a DataTable, in a given order, without copying  */
+    /* them.  The view refers to the columns of the table, which must outlive it and */
+    /* not change while it is in use; table() copies the rows into a new DataTable.  */
+    /*********************************************************************************/
+    class PROTEAN_DECL data_table_selection
+    {
+    public:
+        typedef boost::ptr_vector<data_table_column_base> column_collection_t;
+
+    public:
+        data_table_selection(const column_collection_t& columns, std::vector<size_t>&& rows);
+
+        size_t size() const                         { return m_rows.size(); }
+        bool empty() const                          { return m_rows.empty(); }
+
+        // Row of the table that is the n'th row of the selection
+        size_t row(size_t n) const                  { return m_rows[n]; }
+        const std::vector<size_t>& rows() const     { return m_rows; }
+
+        const column_collection_t& columns() const  { return *m_columns; }
+
+        // Value of the given column in the n'th row of the selection
+        template <variant_base::enum_type_t E>
+        typename column_traits<E>::container_type::const_reference get(size_t column, size_t n) const
+        {
+            return *((*m_columns)[column].begin<E>() + m_rows[n]);
+        }
+
+        // A DataTable holding a copy of the selected rows
+        variant table() const;
+
+    private:
+        const column_collection_t*  m_columns;
+        std::vector<size_t>         m_rows;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DATA_TABLE_SELECTION_HPP
@@ -0,0 +1,34 @@
+#ifndef PROTEAN_DATA_TABLE_SORT_HPP
+#define PROTEAN_DATA_TABLE_SORT_HPP
+
+#include <protean/config.hpp>
+
+#include <string>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    /* One key of a DataTable sort: a column whose values order the rows, either     */
+    /* ascending or descending.  Rows with equal values in every key keep their order. */
+    /***********************************************************************************/
+    struct PROTEAN_DECL data_table_sort_key
+    {
+        enum order_t { Ascending, Descending };
+
+        data_table_sort_key(const std::string& column, order_t order = Ascending);
+
+        std::string m_column;
+        order_t     m_order;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DATA_TABLE_SORT_HPP
@@ -0,0 +1,120 @@
+#ifndef PROTEAN_DATA_TABLE_VIEW_HPP
+#define PROTEAN_DATA_TABLE_VIEW_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant.hpp>
+#include <protean/data_table_column_base.hpp>
+#include <protean/data_table_iterator.hpp>
+#include <protean/detail/data_table_column.hpp>
+
+#include <boost/preprocessor/repetition/repeat.hpp>
+#include <boost/preprocessor/repetition/enum_params.hpp>
+#include <boost/preprocessor/repetition/enum.hpp>
+#include <boost/preprocessor/arithmetic/add.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    struct data_table_aggregate;
+
+    /* A contiguous range of the rows of a DataTable, and some of its columns, that    */
+    /* refers to the columns of the table rather than copying them, so that slicing is */
+    /* O(1).  The table must outlive the view and not change while it is in use;       */
+    /* table() copies the rows into a new DataTable.                                   */
+    /***********************************************************************************/
+    class PROTEAN_DECL data_table_view
+    {
+    public:
+        typedef boost::ptr_vector<data_table_column_base> column_collection_t;
+
+    public:
+        // Every row and column of a table
+        explicit data_table_view(const column_collection_t& columns);
+
+        size_t size() const                         { return m_length; }
+        bool empty() const                          { return m_length==0; }
+
+        // Row of the table that is the first row of the view
+        size_t offset() const                       { return m_offset; }
+
+        size_t column_count() const                 { return m_columns.size(); }
+        const data_table_column_base& column(size_t i) const;
+        const data_table_column_base& column(const std::string& name) const;
+
+        // Rows [offset, offset + length) of the view, clipped to its end
+        data_table_view slice(size_t offset, size_t length) const;
+
+        // The named columns of the view, in the given order
+        data_table_view select(const std::vector<std::string>& names) const;
+
+        // Value of the given column in the n'th row of the view
+        template <variant_base::enum_type_t E>
+        typename column_traits<E>::container_type::const_reference get(size_t column, size_t n) const
+        {
+            return *(m_columns[column]->begin<E>() + m_offset + n);
+        }
+
+        // A DataTable holding a copy of the rows and columns of the view
+        variant table() const;
+
+        // The 'aggregates' of the rows of the view, see detail::data_table::group_by
+        variant group_by(const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, size_t threads = 0) const;
+
+    /* Typed iterators over the columns of the view, as for a DataTable */
+    /********************************************************************/
+    public:
+        #define DATA_TABLE_VIEW_COLUMN_BEGIN(z, n, t) \
+            column(n).begin<t ## n>() + m_offset
+
+        #define DATA_TABLE_VIEW_COLUMN_END(z, n, t) \
+            column(n).begin<t ## n>() + (m_offset + m_length)
+
+        #define DATA_TABLE_VIEW_BEGIN(z, n, t)                                                                  \
+            template <BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), variant_base::enum_type_t t)>                    \
+            data_table_const_iterator<BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), t)> begin() const                \
+            {                                                                                                   \
+                return data_table_const_iterator<BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), t)>(                  \
+                    make_row( BOOST_PP_ENUM(BOOST_PP_ADD(n, 1), DATA_TABLE_VIEW_COLUMN_BEGIN, t) )              \
+                );                                                                                              \
+            }
+
+        #define DATA_TABLE_VIEW_END(z, n, t)                                                                    \
+            template <BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), variant_base::enum_type_t t)>                    \
+            data_table_const_iterator<BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), t)> end() const                  \
+            {                                                                                                   \
+                return data_table_const_iterator<BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), t)>(                  \
+                    make_row( BOOST_PP_ENUM(BOOST_PP_ADD(n, 1), DATA_TABLE_VIEW_COLUMN_END, t) )                \
+                );                                                                                              \
+            }
+
+        // data_table_const_iterator<E0, ..., En> begin() const;
+        BOOST_PP_REPEAT(DATA_TABLE_MAX_COLUMNS, DATA_TABLE_VIEW_BEGIN, DATA_TABLE_COLUMN_TYPE_PREFIX)
+        // data_table_const_iterator<E0, ..., En> end() const;
+        BOOST_PP_REPEAT(DATA_TABLE_MAX_COLUMNS, DATA_TABLE_VIEW_END, DATA_TABLE_COLUMN_TYPE_PREFIX)
+
+        #undef DATA_TABLE_VIEW_END
+        #undef DATA_TABLE_VIEW_BEGIN
+        #undef DATA_TABLE_VIEW_COLUMN_END
+        #undef DATA_TABLE_VIEW_COLUMN_BEGIN
+
+    private:
+        std::vector<const data_table_column_base*>  m_columns;
+        size_t                                      m_offset;
+        size_t                                      m_length;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DATA_TABLE_VIEW_HPP
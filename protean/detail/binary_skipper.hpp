@@ -0,0 +1,342 @@
+#ifndef PROTEAN_DETAIL_BINARY_SKIPPER_HPP
+#define PROTEAN_DETAIL_BINARY_SKIPPER_HPP
+
+#include <protean/config.hpp>
+#include <protean/binary_common.hpp>
+#include <protean/variant.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <vector>
+
+namespace protean { namespace detail {
+
+    /* Steps over an encoded value without decoding it, see binary_writer.  binary_reader reads */
+    /* from a stream and binary_lazy_variant from a document in memory, each is the Source:    */
+    /*   boost::uint64_t read_word()        32-bit word in version 1, varint in version 2      */
+    /*   boost::int32_t read_int32()        as read_word() but signed (zigzag in version 2)    */
+    /*   boost::uint64_t read_varint()                                                         */
+    /*   boost::uint64_t read_uint64()      raw 64-bit word, e.g. a subtree length             */
+    /*   size_t read_size()                                                                    */
+    /*   void skip_bytes(boost::uint64_t)                                                      */
+    /*   void skip_string()                 a length-prefixed string                           */
+    /*   void skip_key()                    a key, through the string table if enabled         */
+    /*   void skip_string_value()           a String value, likewise                           */
+    /*******************************************************************************************/
+    template <typename Source>
+    class binary_skipper
+    {
+    public:
+        binary_skipper(Source& source, int writer_mode, bool compact, bool subtree_lengths);
+
+        void skip_value(variant::enum_type_t type);
+
+    private:
+        variant::enum_type_t read_type();
+        void skip_padded(boost::uint64_t length);
+        void skip_integer(size_t width);
+        void skip_date();
+        void skip_time();
+        void skip_data_table();
+        void skip_shaped_list(size_t size);
+
+        Source& m_source;
+        int     m_writer_mode;
+        bool    m_compact;
+        bool    m_subtree_lengths;
+    };
+
+    template <typename Source>
+    binary_skipper<Source>::binary_skipper(Source& source, int writer_mode, bool compact, bool subtree_lengths) :
+        m_source(source),
+        m_writer_mode(writer_mode),
+        m_compact(compact),
+        m_subtree_lengths(subtree_lengths)
+    {
+    }
+
+    template <typename Source>
+    void binary_skipper<Source>::skip_value(variant::enum_type_t type)
+    {
+        if (m_subtree_lengths && (type & (variant::Collection | variant::Array))!=0)
+        {
+            m_source.skip_bytes(m_source.read_uint64());
+            return;
+        }
+
+        switch (type)
+        {
+            case variant::None:
+                break;
+            case variant::Boolean:
+                m_source.skip_bytes(m_compact ? 1 : 4);
+                break;
+            case variant::Int32:
+            case variant::UInt32:
+                skip_integer(4);
+                break;
+            case variant::Int64:
+            case variant::UInt64:
+                skip_integer(8);
+                break;
+            case variant::Float:
+                m_source.skip_bytes(sizeof(float));
+                break;
+            case variant::Double:
+                m_source.skip_bytes(sizeof(double));
+                break;
+            case variant::Date:
+                skip_date();
+                break;
+            case variant::Time:
+                skip_time();
+                break;
+            case variant::DateTime:
+                if ((m_writer_mode & binary_mode::DateTimeAsTicks)==0)
+                {
+                    skip_date();
+                }
+                skip_time();
+                break;
+            case variant::String:
+                m_source.skip_string_value();
+                break;
+            case variant::Any:
+                m_source.skip_string();
+                break;
+            case variant::Buffer:
+                skip_padded(m_source.read_size());
+                break;
+            case variant::Exception:
+                m_source.skip_string();
+                m_source.skip_string();
+                m_source.skip_string();
+                m_source.skip_string();
+                break;
+            case variant::Object:
+                m_source.skip_key();
+                skip_integer(4);
+                skip_value(read_type());
+                break;
+            case variant::Dictionary:
+            case variant::Bag:
+            {
+                const size_t size(m_source.read_size());
+                for (size_t i=0; i<size; ++i)
+                {
+                    m_source.skip_key();
+                    skip_value(read_type());
+                }
+                break;
+            }
+            case variant::List:
+            case variant::Tuple:
+            {
+                const size_t size(m_source.read_size());
+                if (type==variant::List && (m_writer_mode & binary_mode::ShapedLists)!=0)
+                {
+                    skip_shaped_list(size);
+                    break;
+                }
+                for (size_t i=0; i<size; ++i)
+                {
+                    skip_value(read_type());
+                }
+                break;
+            }
+            case variant::TimeSeries:
+            {
+                const size_t size(m_source.read_size());
+                for (size_t i=0; i<size; ++i)
+                {
+                    skip_value(variant::DateTime);
+                    skip_value(read_type());
+                }
+                break;
+            }
+            case variant::DataTable:
+                skip_data_table();
+                break;
+            case variant::Array:
+            {
+                const size_t size(m_source.read_size());
+                const variant::enum_type_t array_type(read_type());
+                for (size_t i=0; i<size; ++i)
+                {
+                    skip_value(array_type);
+                }
+                break;
+            }
+            default:
+                boost::throw_exception(variant_error("Case exhaustion: " + variant::enum_to_string(type)));
+        }
+    }
+
+    template <typename Source>
+    variant::enum_type_t binary_skipper<Source>::read_type()
+    {
+        return static_cast<variant::enum_type_t>(m_source.read_word());
+    }
+
+    // strings and buffers are padded to 4 bytes in version 1
+    template <typename Source>
+    void binary_skipper<Source>::skip_padded(boost::uint64_t length)
+    {
+        m_source.skip_bytes(m_compact ? length : length + (4 - (length % 4)) % 4);
+    }
+
+    // skips a 32 or 64-bit integer
+    template <typename Source>
+    void binary_skipper<Source>::skip_integer(size_t width)
+    {
+        if (m_compact)
+        {
+            m_source.read_varint();
+        }
+        else
+        {
+            m_source.skip_bytes(width);
+        }
+    }
+
+    template <typename Source>
+    void binary_skipper<Source>::skip_date()
+    {
+        if ((m_writer_mode & binary_mode::DateTimeAsTicks)!=0)
+        {
+            skip_integer(4);
+        }
+        else
+        {
+            m_source.skip_bytes(sizeof(binary_date_t));
+        }
+    }
+
+    template <typename Source>
+    void binary_skipper<Source>::skip_time()
+    {
+        if ((m_writer_mode & binary_mode::DateTimeAsTicks)!=0)
+        {
+            skip_integer(8);
+        }
+        else
+        {
+            m_source.skip_bytes(sizeof(binary_time_t));
+        }
+    }
+
+    template <typename Source>
+    void binary_skipper<Source>::skip_data_table()
+    {
+        const size_t columns(m_source.read_size());
+        const size_t rows(m_source.read_size());
+
+        std::vector<boost::int32_t> types(columns);
+        for (size_t i=0; i<columns; ++i)
+        {
+            types[i] = m_source.read_int32();
+        }
+        for (size_t i=0; i<columns; ++i)
+        {
+            m_source.skip_key();
+        }
+
+        if ((m_writer_mode & binary_mode::ParallelColumns)!=0)
+        {
+            std::vector<size_t> lengths(columns);
+            for (size_t i=0; i<columns; ++i)
+            {
+                lengths[i] = m_source.read_size();
+            }
+            for (size_t i=0; i<columns; ++i)
+            {
+                skip_padded(lengths[i]);
+            }
+            return;
+        }
+
+        for (size_t i=0; i<columns; ++i)
+        {
+            if ((types[i] & binary_arena_column)!=0)
+            {
+                // see binary_writer::write_arena_column
+                const size_t bytes(m_source.read_size());
+                for (size_t j=0; j<rows; ++j)
+                {
+                    m_source.read_size();
+                }
+                skip_padded(bytes);
+                continue;
+            }
+
+            if ((types[i] & binary_dictionary_column)!=0)
+            {
+                // see binary_writer::write_dictionary_column
+                const size_t size(m_source.read_size());
+                for (size_t j=0; j<size; ++j)
+                {
+                    m_source.skip_string();
+                }
+                for (size_t j=0; j<rows; ++j)
+                {
+                    m_source.read_size();
+                }
+                continue;
+            }
+
+            const variant::enum_type_t type(static_cast<variant::enum_type_t>(types[i]));
+            for (size_t j=0; j<rows; ++j)
+            {
+                if ((type & (variant::String | variant::Any))!=0)
+                {
+                    // columns are written without the string table
+                    m_source.skip_string();
+                }
+                else
+                {
+                    skip_value((type & variant::Primitive)!=0 ? type : read_type());
+                }
+            }
+        }
+    }
+
+    // see binary_writer::write_shaped_list
+    template <typename Source>
+    void binary_skipper<Source>::skip_shaped_list(size_t size)
+    {
+        if (m_source.read_word()==0)
+        {
+            for (size_t i=0; i<size; ++i)
+            {
+                skip_value(read_type());
+            }
+            return;
+        }
+
+        const size_t count(m_source.read_size());
+        std::vector<variant::enum_type_t> types(count);
+        for (size_t i=0; i<count; ++i)
+        {
+            m_source.skip_key();
+            types[i] = read_type();
+        }
+
+        for (size_t i=0; i<size; ++i)
+        {
+            if (m_source.read_word()==0)
+            {
+                skip_value(read_type());
+                continue;
+            }
+            for (size_t j=0; j<count; ++j)
+            {
+                skip_value(types[j]);
+            }
+        }
+    }
+
+}} // namespace protean::detail
+
+#endif // PROTEAN_DETAIL_BINARY_SKIPPER_HPP
@@ -0,0 +1,306 @@
+#ifndef PROTEAN_DETAIL_BLOCK_COMPRESSION_HPP
+#define PROTEAN_DETAIL_BLOCK_COMPRESSION_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant_error.hpp>
+#include <protean/detail/thread_pool.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/operations.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean { namespace detail {
+
+    /* Block-framed compression, used by binary_mode::BlockCompress.  The byte stream is cut into   */
+    /* fixed-size blocks that are deflated independently on the thread pool and written in order:  */
+    /*   [RAW LENGTH][STORED LENGTH][STORED BYTES] ... [0]                                          */
+    /* A zero raw length terminates the stream.                                                     */
+    /************************************************************************************************/
+    PROTEAN_DECL std::string compress_block(const std::vector<char>& raw, bool zlib_no_header);
+    PROTEAN_DECL void decompress_block(const std::string& stored, std::vector<char>& raw, bool zlib_no_header);
+
+    class block_compressor
+    {
+    public:
+        typedef char char_type;
+
+        struct category :
+            boost::iostreams::multichar_output_filter_tag,
+            boost::iostreams::closable_tag
+        {};
+
+        block_compressor(size_t block_size, bool zlib_no_header);
+
+        template <typename Sink>
+        std::streamsize write(Sink& sink, const char* s, std::streamsize n);
+
+        template <typename Sink>
+        void close(Sink& sink);
+
+    private:
+        template <typename Sink>
+        void flush_block(Sink& sink);
+
+        template <typename Sink>
+        void write_front(Sink& sink);
+
+        template <typename Sink>
+        static void write_frame(Sink& sink, boost::uint32_t raw_length, const std::string& stored);
+
+    private:
+        struct state
+        {
+            size_t                                  m_block_size;
+            bool                                    m_zlib_no_header;
+            std::vector<char>                       m_block;
+            std::deque<boost::uint32_t>             m_raw_lengths;
+            std::deque<std::future<std::string> >   m_pending;
+        };
+
+        // Filters are copied into the filter chain, hence the shared state
+        boost::shared_ptr<state> m_state;
+    };
+
+    class block_decompressor
+    {
+    public:
+        typedef char char_type;
+
+        struct category :
+            boost::iostreams::multichar_input_filter_tag
+        {};
+
+        explicit block_decompressor(bool zlib_no_header);
+
+        template <typename Source>
+        std::streamsize read(Source& source, char* s, std::streamsize n);
+
+    private:
+        template <typename Source>
+        void read_ahead(Source& source);
+
+        template <typename Source>
+        static void read_exact(Source& source, char* s, std::streamsize n);
+
+    private:
+        struct state
+        {
+            bool                                            m_zlib_no_header;
+            bool                                            m_finished;
+            std::vector<char>                               m_block;
+            size_t                                          m_position;
+            std::deque<std::future<std::vector<char> > >    m_pending;
+        };
+
+        boost::shared_ptr<state> m_state;
+    };
+
+    /* block_compressor */
+    /********************/
+    inline block_compressor::block_compressor(size_t block_size, bool zlib_no_header) :
+        m_state(boost::make_shared<state>())
+    {
+        m_state->m_block_size = block_size;
+        m_state->m_zlib_no_header = zlib_no_header;
+        m_state->m_block.reserve(block_size);
+    }
+
+    template <typename Sink>
+    std::streamsize block_compressor::write(Sink& sink, const char* s, std::streamsize n)
+    {
+        state& st(*m_state);
+
+        std::streamsize remaining(n);
+        while (remaining > 0)
+        {
+            size_t chunk = (std::min)(static_cast<size_t>(remaining), st.m_block_size - st.m_block.size());
+            st.m_block.insert(st.m_block.end(), s, s + chunk);
+            s += chunk;
+            remaining -= chunk;
+
+            if (st.m_block.size() == st.m_block_size)
+            {
+                flush_block(sink);
+            }
+        }
+        return n;
+    }
+
+    template <typename Sink>
+    void block_compressor::close(Sink& sink)
+    {
+        state& st(*m_state);
+
+        if (!st.m_block.empty())
+        {
+            flush_block(sink);
+        }
+
+        while (!st.m_pending.empty())
+        {
+            write_front(sink);
+        }
+
+        write_frame(sink, 0, std::string());
+    }
+
+    template <typename Sink>
+    void block_compressor::flush_block(Sink& sink)
+    {
+        state& st(*m_state);
+
+        // Bound the memory held by blocks in flight
+        while (st.m_pending.size() >= 2 * thread_pool::instance().size())
+        {
+            write_front(sink);
+        }
+
+        boost::shared_ptr<std::vector<char> > raw(boost::make_shared<std::vector<char> >());
+        raw->reserve(st.m_block_size);
+        raw->swap(st.m_block);
+
+        const bool zlib_no_header(st.m_zlib_no_header);
+
+        st.m_raw_lengths.push_back(static_cast<boost::uint32_t>(raw->size()));
+        st.m_pending.push_back(thread_pool::instance().submit_or_call([raw, zlib_no_header]() {
+            return compress_block(*raw, zlib_no_header);
+        }));
+    }
+
+    template <typename Sink>
+    void block_compressor::write_front(Sink& sink)
+    {
+        state& st(*m_state);
+
+        const boost::uint32_t raw_length(st.m_raw_lengths.front());
+        const std::string stored(st.m_pending.front().get());
+        st.m_raw_lengths.pop_front();
+        st.m_pending.pop_front();
+
+        write_frame(sink, raw_length, stored);
+    }
+
+    template <typename Sink>
+    void block_compressor::write_frame(Sink& sink, boost::uint32_t raw_length, const std::string& stored)
+    {
+        boost::uint32_t header[2];
+        header[0] = raw_length;
+        header[1] = static_cast<boost::uint32_t>(stored.size());
+
+        std::streamsize header_size = raw_length == 0 ? sizeof(boost::uint32_t) : sizeof(header);
+        if (boost::iostreams::write(sink, reinterpret_cast<const char*>(header), header_size) != header_size ||
+            boost::iostreams::write(sink, stored.data(), stored.size()) != static_cast<std::streamsize>(stored.size()))
+        {
+            boost::throw_exception(variant_error("Error writing compressed block to stream"));
+        }
+    }
+
+    /* block_decompressor */
+    /**********************/
+    inline block_decompressor::block_decompressor(bool zlib_no_header) :
+        m_state(boost::make_shared<state>())
+    {
+        m_state->m_zlib_no_header = zlib_no_header;
+        m_state->m_finished = false;
+        m_state->m_position = 0;
+    }
+
+    template <typename Source>
+    std::streamsize block_decompressor::read(Source& source, char* s, std::streamsize n)
+    {
+        state& st(*m_state);
+
+        std::streamsize result(0);
+        while (result < n)
+        {
+            if (st.m_position == st.m_block.size())
+            {
+                read_ahead(source);
+
+                if (st.m_pending.empty())
+                    break;
+
+                st.m_block = st.m_pending.front().get();
+                st.m_pending.pop_front();
+                st.m_position = 0;
+            }
+
+            size_t chunk = (std::min)(static_cast<size_t>(n - result), st.m_block.size() - st.m_position);
+            std::memcpy(s + result, &st.m_block[st.m_position], chunk);
+            st.m_position += chunk;
+            result += chunk;
+        }
+
+        return result == 0 && n > 0 ? -1 : result;
+    }
+
+    template <typename Source>
+    void block_decompressor::read_ahead(Source& source)
+    {
+        state& st(*m_state);
+
+        // Keep every worker busy decompressing blocks ahead of the decoder
+        while (!st.m_finished && st.m_pending.size() < 2 * thread_pool::instance().size())
+        {
+            boost::uint32_t raw_length;
+            read_exact(source, reinterpret_cast<char*>(&raw_length), sizeof(raw_length));
+
+            if (raw_length == 0)
+            {
+                st.m_finished = true;
+                break;
+            }
+
+            boost::uint32_t stored_length;
+            read_exact(source, reinterpret_cast<char*>(&stored_length), sizeof(stored_length));
+
+            boost::shared_ptr<std::string> stored(boost::make_shared<std::string>(stored_length, '\0'));
+            if (stored_length > 0)
+            {
+                read_exact(source, &(*stored)[0], stored_length);
+            }
+
+            const bool zlib_no_header(st.m_zlib_no_header);
+            st.m_pending.push_back(thread_pool::instance().submit_or_call([stored, raw_length, zlib_no_header]() {
+                std::vector<char> raw(raw_length);
+                decompress_block(*stored, raw, zlib_no_header);
+                return raw;
+            }));
+        }
+    }
+
+    template <typename Source>
+    void block_decompressor::read_exact(Source& source, char* s, std::streamsize n)
+    {
+        while (n > 0)
+        {
+            std::streamsize count = boost::iostreams::read(source, s, n);
+            if (count <= 0)
+            {
+                boost::throw_exception(variant_error("Error reading compressed block from stream"));
+            }
+            s += count;
+            n -= count;
+        }
+    }
+
+}} // namespace protean::detail
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DETAIL_BLOCK_COMPRESSION_HPP
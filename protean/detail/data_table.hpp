@@ -3,19 +3,50 @@
 
 #include <protean/config.hpp>
 #include <protean/data_table_column_base.hpp>
+#include <protean/data_table_join.hpp>
 #include <protean/data_table_iterator.hpp>
 #include <protean/variant_base.hpp>
+#include <protean/detail/data_table_index.hpp>
 #include <protean/detail/string.hpp>
 
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/static_assert.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/type_traits/remove_cv.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <iterator>
+#include <memory>
 
 #if defined(_MSC_VER)
 #    pragma warning(push)
 #    pragma warning(disable:4251)
 #endif
 
-namespace protean { namespace detail {
+namespace protean {
+
+    class data_table_expression;
+    struct data_table_aggregate;
+    struct data_table_sort_key;
+    class data_table_view;
+
+namespace detail {
+
+    // The type a column stores for a tuple element of type V
+    template <typename V>
+    struct append_storage
+    {
+        typedef V type;
+        static const V& convert(const V& value) { return value; }
+    };
+
+    template <>
+    struct append_storage<std::string>
+    {
+        typedef string type;
+        static string convert(const std::string& value) { return string(value.c_str(), value.size()); }
+    };
 
     class PROTEAN_DECL data_table : public collection
     {
@@ -34,11 +65,18 @@ namespace protean { namespace detail {
     public:
         data_table& add_column(variant_base::enum_type_t type);
         data_table& add_column(variant_base::enum_type_t type, const std::string& name);
+        data_table& add_column(variant_base::enum_type_t type, const std::string& name, data_table_column_base::encoding_t encoding);
+
+        // Adds a column holding the value of 'expression' for each row
+        data_table& add_column(const std::string& name, const data_table_expression& expression);
 
     private:
         template <variant_base::enum_type_t E>
         data_table& add_column(const std::string& name);
 
+        // Throws if there is no room for another column, or 'name' is taken
+        void check_new_column(const std::string& name) const;
+
         struct column_adder;
 
     /* Column access */
@@ -58,6 +96,73 @@ namespace protean { namespace detail {
         template <typename Tuple>
         data_table& push_back(const Tuple& value);
 
+        // Appends a range of rows column by column, reserving the space for them first.
+        // The range is walked once per column, so Iterator must be a forward iterator.
+        template <typename Iterator>
+        data_table& append(Iterator first, Iterator last);
+
+        data_table& reserve(size_t rows);
+
+        // Rows the columns can hold without reallocating
+        size_t capacity() const;
+
+    /* Aggregation */
+    /***************/
+    public:
+        // Replaces the columns of 'result' with one for each key column followed by one
+        // for each aggregate, holding a row per distinct key in order of first appearance.
+        // The table is split into chunks that are aggregated on up to 'threads' threads of
+        // the shared pool, all of them if zero, and their partial results merged in
+        // partitions by the hash of the key.
+        void group_by(const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, data_table& result, size_t threads = 0) const;
+
+        // Groups the rows of 'view' as above, replacing the columns in 'result'
+        static void group_by(const data_table_view& view, const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, column_container_type& result, size_t threads = 0);
+
+    /* Joins */
+    /*********/
+    public:
+        // Replaces the columns of 'result' with those of this table followed by those of
+        // 'right' other than its keys, holding a row for each pair of rows with equal keys.
+        // Columns of 'right' named as a column of this table are suffixed with "_right".
+        // A hash table is built on the smaller side, or on 'right' for a left join, and the
+        // other side probed in chunks on up to 'threads' threads of the shared pool; rows
+        // are in the order of the rows of this table, then of the matching rows of 'right'.
+        void join(const data_table& right, const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys, data_table_join_t type, data_table& result, size_t threads = 0) const;
+
+    /* Sorting */
+    /***********/
+    public:
+        // Fills 'permutation' with the rows in the order of 'keys', keeping the order of rows
+        // with equal keys. Numeric, boolean and date/time keys are radix sorted, strings merge
+        // sorted in chunks on up to 'threads' threads of the shared pool.
+        void sort_permutation(const std::vector<data_table_sort_key>& keys, std::vector<size_t>& permutation, size_t threads = 0) const;
+
+        // Reorders the rows by 'keys', gathering each column once
+        data_table& sort(const std::vector<data_table_sort_key>& keys, size_t threads = 0);
+
+    /* Indexes */
+    /***********/
+    public:
+        // Adds an index of 'type' on the named column unless it has one already.  Indexes
+        // keep up with appended rows, and are rebuilt on their next lookup after clear(),
+        // sort() or mutable access to the columns, through columns(), get_column() or the
+        // iterators.  Floating point values are ordered with NaNs last.
+        data_table& add_index(const std::string& column, data_table_index_t type);
+        data_table& drop_index(const std::string& column);
+
+        // Fills 'rows' with those whose value in 'column' equals 'value', in row order,
+        // using its hash index if it has one and its sorted index if not
+        void find(const std::string& column, const variant& value, std::vector<size_t>& rows) const;
+
+        // Fills 'rows' with those whose value in 'column' lies in [lower, upper), in order
+        // of value, using its sorted index
+        void equal_range(const std::string& column, const variant& lower, const variant& upper, std::vector<size_t>& rows) const;
+
+    private:
+        const data_table_index* get_index(const std::string& column, data_table_index_t type) const;
+        void reset_indexes();
+
     private:
         template <size_t N, typename HT, typename TT>
         void push_back_impl(const boost::tuples::cons<HT, TT>& tuple);
@@ -66,6 +171,13 @@ namespace protean { namespace detail {
         template <size_t N>
         void push_back_impl(const boost::tuples::null_type&);
 
+        template <size_t N, typename Iterator>
+        typename boost::enable_if_c<(N < boost::tuples::length<typename std::iterator_traits<Iterator>::value_type>::value)>::type
+        append_impl(Iterator first, Iterator last);
+        template <size_t N, typename Iterator>
+        typename boost::disable_if_c<(N < boost::tuples::length<typename std::iterator_traits<Iterator>::value_type>::value)>::type
+        append_impl(Iterator first, Iterator last);
+
     /* Collection interface */
     /************************/
     public:
@@ -119,8 +231,9 @@ namespace protean { namespace detail {
     /* Member variables */
     /********************/
     private:
-        column_container_type m_columns;
-        const size_t          m_capacity;
+        column_container_type                   m_columns;
+        const size_t                            m_capacity;
+        boost::ptr_vector<data_table_index>     m_indexes;
     };
 
 }} // namespace protean::detail
@@ -12,15 +12,10 @@ namespace protean { namespace detail {
     template <variant_base::enum_type_t E>
     data_table& data_table::add_column(const std::string& name)
     {
-        if (!m_columns.empty() && !get_column(0).empty())
+        if (!m_columns.empty() && !m_columns[0].empty())
             boost::throw_exception(variant_error("Cannot add a column since values have been inserted"));
 
-        if (m_columns.size() >= DATA_TABLE_MAX_COLUMNS)
-            boost::throw_exception(variant_error("Reached maximum column capacity"));
-
-        for ( const auto& column : m_columns )
-            if (column.name() == name)
-                boost::throw_exception(variant_error("Column name already in use"));
+        check_new_column(name);
 
         m_columns.push_back(new data_table_column<E>(name, m_capacity));
 
@@ -47,14 +42,14 @@ namespace protean { namespace detail {
     template <size_t N, typename HT, typename TT>
     void data_table::push_back_impl(const boost::tuples::cons<HT, TT>& tuple)
     {
-        get_column(N).push_back(tuple.get_head());
+        m_columns[N].push_back(tuple.get_head());
         push_back_impl<N+1>(tuple.get_tail());
     }
 
     template <size_t N, typename TT>
     void data_table::push_back_impl(const boost::tuples::cons<std::string, TT>& tuple)
     {
-        get_column(N).push_back( detail::string(tuple.get_head().c_str(), tuple.get_head().size()) );
+        m_columns[N].push_back( detail::string(tuple.get_head().c_str(), tuple.get_head().size()) );
         push_back_impl<N+1>(tuple.get_tail());
     }
 
@@ -62,6 +57,71 @@ namespace protean { namespace detail {
     void data_table::push_back_impl(const boost::tuples::null_type&)
     {}
 
+    /* Bulk append implementation */
+    /******************************/
+    template <typename Iterator>
+    data_table& data_table::append(Iterator first, Iterator last)
+    {
+        typedef typename std::iterator_traits<Iterator>::value_type Tuple;
+        BOOST_STATIC_ASSERT_MSG((boost::is_convertible<typename std::iterator_traits<Iterator>::iterator_category, std::forward_iterator_tag>::value),
+            "data_table::append() walks the range once per column and needs forward iterators");
+
+        size_t tuple_length = boost::tuples::length<Tuple>::value;
+        if (tuple_length != m_columns.size())
+            boost::throw_exception(variant_error(boost::str(
+                boost::format("Cannot insert value with %s elements into series with %s columns")
+                % tuple_length
+                % m_columns.size()
+            )));
+
+        // at least doubling, so that repeated appends of small batches are amortised
+        const size_t rows = size();
+        const size_t needed = rows + static_cast<size_t>(std::distance(first, last));
+        const size_t available = capacity();
+        if (needed > available)
+            reserve((std::max)(needed, 2 * available));
+
+        try
+        {
+            append_impl<0>(first, last);
+        }
+        catch (...)
+        {
+            // leave no partially appended columns behind
+            for (column_container_type::iterator column = m_columns.begin(); column != m_columns.end(); ++column)
+                column->resize(rows);
+            throw;
+        }
+        return *this;
+    }
+
+    template <size_t N, typename Iterator>
+    typename boost::enable_if_c<(N < boost::tuples::length<typename std::iterator_traits<Iterator>::value_type>::value)>::type
+    data_table::append_impl(Iterator first, Iterator last)
+    {
+        typedef typename boost::remove_cv<
+            typename boost::tuples::element<N, typename std::iterator_traits<Iterator>::value_type>::type
+        >::type element_type;
+        typedef append_storage<element_type> storage;
+
+        // gather the column's values so that it takes them in one call (an array rather
+        // than a std::vector, which does not store bool contiguously)
+        const size_t count = static_cast<size_t>(std::distance(first, last));
+        std::unique_ptr<typename storage::type[]> values(new typename storage::type[count]);
+        size_t i = 0;
+        for (Iterator iter = first; iter != last; ++iter)
+            values[i++] = storage::convert(boost::get<N>(*iter));
+
+        m_columns[N].push_back(values.get(), count);
+
+        append_impl<N+1>(first, last);
+    }
+
+    template <size_t N, typename Iterator>
+    typename boost::disable_if_c<(N < boost::tuples::length<typename std::iterator_traits<Iterator>::value_type>::value)>::type
+    data_table::append_impl(Iterator, Iterator)
+    {}
+
     /* Typed iterators implementation */
     /**********************************/
     #define COLUMN_BEGIN_ITERATOR(z, n, t) \
@@ -8,9 +8,12 @@
 #include <protean/detail/data_table_variant_iterator.hpp>
 #include <protean/detail/data_table_types.hpp>
 #include <protean/data_table_column_base.hpp>
+#include <protean/detail/string_dictionary.hpp>
+#include <protean/detail/string_arena.hpp>
 
 #include <vector>
 #include <string>
+#include <boost/scoped_ptr.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/throw_exception.hpp>
 #include <boost/preprocessor/seq/for_each.hpp>
@@ -64,6 +67,23 @@ namespace protean { namespace detail {
         virtual data_table_column_base* clone() const;
 
         virtual void resize(size_t n);
+        virtual void reserve(size_t n);
+        virtual size_t capacity() const;
+        virtual data_table_column_base* take(const std::vector<size_t>& rows) const;
+        virtual void extend(const data_table_column_base& other);
+
+    private:
+        data_table_column(const data_table_column& rhs);
+
+    /* Encoding */
+    /************/
+    public:
+        virtual encoding_t encoding() const;
+        virtual void set_encoding(encoding_t encoding);
+        virtual string_dictionary* dictionary();
+        virtual const string_dictionary* dictionary() const;
+        virtual string_arena* arena();
+        virtual const string_arena* arena() const;
 
     /* Variant interface */
     /*********************/
@@ -87,12 +107,15 @@ namespace protean { namespace detail {
             virtual std::vector<GET_TYPE(elem)>::const_iterator begin_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) const;  \
             virtual std::vector<GET_TYPE(elem)>::const_iterator end_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0) const;    \
             virtual std::vector<GET_TYPE(elem)>::iterator begin_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0);              \
-            virtual std::vector<GET_TYPE(elem)>::iterator end_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0);
+            virtual std::vector<GET_TYPE(elem)>::iterator end_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0);                \
+            virtual std::vector<GET_TYPE(elem)>& values_impl(column_traits<GET_ENUM(elem)>::enum_type* = 0);
 
         #define PROTEAN_DETAIL_DT_COLUMN_VIRTUAL_PUSH_BACK_IMPL_DECL(r, data, type)  \
             virtual void push_back_impl(const type& value, type* = 0);               \
+            virtual void push_back_impl(const type* values, size_t count, type* = 0); \
 
         virtual void push_back_impl(const variant& value, variant*);
+        virtual void push_back_impl(const variant* values, size_t count, variant*);
 
         BOOST_PP_SEQ_FOR_EACH(PROTEAN_DETAIL_DT_COLUMN_VIRTUAL_PUSH_BACK_IMPL_DECL, , SUPPORTED_TYPES)
         BOOST_PP_SEQ_FOR_EACH(PROTEAN_DETAIL_DT_COLUMN_VIRTUAL_IMPLS_DECL, , COLUMN_TYPES)
@@ -107,6 +130,13 @@ namespace protean { namespace detail {
         template <typename V>
         void push_back_impl_tmpl(const V& value, typename boost::disable_if<boost::is_same<V, value_type>, void*>::type = 0);
 
+        // void push_back(const V*, size_t)
+        template <typename V>
+        void push_back_impl_tmpl(const V* values, size_t count, typename boost::enable_if<boost::is_same<V, value_type>, void*>::type = 0);
+
+        template <typename V>
+        void push_back_impl_tmpl(const V* values, size_t count, typename boost::disable_if<boost::is_same<V, value_type>, void*>::type = 0);
+
         // void push_back(variant)
         template <typename V>
         void push_back_variant_impl_tmpl(const variant& value, typename boost::enable_if<is_variant<value_type, V>, void*>::type = 0);
@@ -142,10 +172,21 @@ namespace protean { namespace detail {
         template <variant_base::enum_type_t F>
         typename column_traits<F>::iterator end_impl_tmpl(typename boost::disable_if<is_same_column<E, F>, void*>::type = 0);
 
+        // container_type& values()
+        template <variant_base::enum_type_t F>
+        typename column_traits<F>::container_type& values_impl_tmpl(typename boost::enable_if<is_same_column<E, F>, void*>::type = 0);
+
+        template <variant_base::enum_type_t F>
+        typename column_traits<F>::container_type& values_impl_tmpl(typename boost::disable_if<is_same_column<E, F>, void*>::type = 0);
+
     /* Member variables */
     /********************/
     private:
         container_type m_values;
+
+        // set for dictionary- or arena-encoded columns, whose values refer to their contents
+        boost::scoped_ptr<string_dictionary> m_dictionary;
+        boost::scoped_ptr<string_arena>      m_arena;
     };
 
 
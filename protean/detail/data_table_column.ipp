@@ -1,5 +1,60 @@
 namespace protean { namespace detail {
 
+    /* Encodings apply to the columns holding detail::string (String and Any) */
+    /**************************************************************************/
+    template <typename T>
+    inline bool column_encodable(const std::vector<T>*)
+    {
+        return false;
+    }
+
+    inline bool column_encodable(const std::vector<string>*)
+    {
+        return true;
+    }
+
+    template <typename T>
+    inline void column_push_back(std::vector<T>& values, const T& value, string_dictionary* /*dictionary*/, string_arena* /*arena*/)
+    {
+        values.push_back(value);
+    }
+
+    inline void column_push_back(std::vector<string>& values, const string& value, string_dictionary* dictionary, string_arena* arena)
+    {
+        if (dictionary!=nullptr)
+        {
+            values.push_back(dictionary->intern(value));
+        }
+        else if (arena!=nullptr)
+        {
+            string row(arena->append(value.value(), value.size(), values));
+            values.push_back(std::move(row));
+        }
+        else
+        {
+            values.push_back(value);
+        }
+    }
+
+    template <typename T>
+    inline void column_append(std::vector<T>& values, const T* first, size_t count, string_dictionary* /*dictionary*/, string_arena* /*arena*/)
+    {
+        values.insert(values.end(), first, first + count);
+    }
+
+    inline void column_append(std::vector<string>& values, const string* first, size_t count, string_dictionary* dictionary, string_arena* arena)
+    {
+        if (dictionary==nullptr && arena==nullptr)
+        {
+            values.insert(values.end(), first, first + count);
+            return;
+        }
+        for (size_t i=0; i<count; ++i)
+        {
+            column_push_back(values, first[i], dictionary, arena);
+        }
+    }
+
     /************************/
     /* data_table_column<E> */
     /************************/
@@ -18,12 +73,157 @@ namespace protean { namespace detail {
         return new data_table_column(*this);
     }
 
+    template <variant_base::enum_type_t E>
+    data_table_column<E>::data_table_column(const data_table_column& rhs)
+        : data_table_column_base(rhs)
+    {
+        if (rhs.m_dictionary || rhs.m_arena)
+        {
+            // the copy refers to a dictionary or arena of its own
+            if (rhs.m_dictionary)
+                m_dictionary.reset(new string_dictionary());
+            if (rhs.m_arena)
+                m_arena.reset(new string_arena());
+
+            m_values.reserve(rhs.m_values.size());
+            for (const_iterator citr = rhs.m_values.begin(); citr != rhs.m_values.end(); ++citr)
+                column_push_back(m_values, *citr, m_dictionary.get(), m_arena.get());
+        }
+        else
+        {
+            m_values = rhs.m_values;
+        }
+    }
+
+    template <variant_base::enum_type_t E>
+    data_table_column_base* data_table_column<E>::take(const std::vector<size_t>& rows) const
+    {
+        data_table_column* result(new data_table_column(name(), rows.size()));
+        try
+        {
+            if (m_dictionary)
+                result->m_dictionary.reset(new string_dictionary());
+            if (m_arena)
+                result->m_arena.reset(new string_arena());
+
+            if (m_dictionary || m_arena)
+            {
+                const value_type empty = value_type();
+                for (std::vector<size_t>::const_iterator citr = rows.begin(); citr != rows.end(); ++citr)
+                    column_push_back(result->m_values, *citr == npos ? empty : m_values[*citr], result->m_dictionary.get(), result->m_arena.get());
+            }
+            else
+            {
+                result->m_values.resize(rows.size());
+                for (size_t i = 0; i < rows.size(); ++i)
+                {
+                    if (rows[i] != npos)
+                        result->m_values[i] = m_values[rows[i]];
+                }
+            }
+        }
+        catch (...)
+        {
+            delete result;
+            throw;
+        }
+        return result;
+    }
+
+    template <variant_base::enum_type_t E>
+    void data_table_column<E>::extend(const data_table_column_base& other)
+    {
+        if (other.type() != type())
+        {
+            boost::throw_exception(variant_error("Cannot extend column '" + name() + "' of type " + variant_base::enum_to_string(type())
+                + " with a column of type " + variant_base::enum_to_string(other.type())));
+        }
+
+        const container_type& values(static_cast<const data_table_column&>(other).m_values);
+        if (m_dictionary || m_arena)
+        {
+            m_values.reserve(m_values.size() + values.size());
+            for (const_iterator citr = values.begin(); citr != values.end(); ++citr)
+                column_push_back(m_values, *citr, m_dictionary.get(), m_arena.get());
+        }
+        else
+        {
+            m_values.insert(m_values.end(), values.begin(), values.end());
+        }
+    }
+
+    template <variant_base::enum_type_t E>
+    data_table_column_base::encoding_t data_table_column<E>::encoding() const
+    {
+        return m_dictionary ? DictionaryEncoding : (m_arena ? ArenaEncoding : PlainEncoding);
+    }
+
+    template <variant_base::enum_type_t E>
+    void data_table_column<E>::set_encoding(encoding_t encoding)
+    {
+        if (encoding == this->encoding())
+            return;
+
+        if (encoding != PlainEncoding && !column_encodable(&m_values))
+            boost::throw_exception(variant_error("Only String and Any columns can be encoded"));
+
+        // copies of references own their values, so re-encoding is a copy into either
+        // plain values or a new dictionary or arena
+        boost::scoped_ptr<string_dictionary> dictionary(encoding == DictionaryEncoding ? new string_dictionary() : nullptr);
+        boost::scoped_ptr<string_arena> arena(encoding == ArenaEncoding ? new string_arena() : nullptr);
+
+        container_type values;
+        values.reserve(m_values.size());
+        for (const_iterator citr = m_values.begin(); citr != m_values.end(); ++citr)
+            column_push_back(values, *citr, dictionary.get(), arena.get());
+
+        m_values.swap(values);
+        m_dictionary.swap(dictionary);
+        m_arena.swap(arena);
+    }
+
+    template <variant_base::enum_type_t E>
+    string_dictionary* data_table_column<E>::dictionary()
+    {
+        return m_dictionary.get();
+    }
+
+    template <variant_base::enum_type_t E>
+    const string_dictionary* data_table_column<E>::dictionary() const
+    {
+        return m_dictionary.get();
+    }
+
+    template <variant_base::enum_type_t E>
+    string_arena* data_table_column<E>::arena()
+    {
+        return m_arena.get();
+    }
+
+    template <variant_base::enum_type_t E>
+    const string_arena* data_table_column<E>::arena() const
+    {
+        return m_arena.get();
+    }
+
     template <variant_base::enum_type_t E>
     void data_table_column<E>::resize(size_t n)
     {
         m_values.resize(n);
     }
 
+    template <variant_base::enum_type_t E>
+    void data_table_column<E>::reserve(size_t n)
+    {
+        m_values.reserve(n);
+    }
+
+    template <variant_base::enum_type_t E>
+    size_t data_table_column<E>::capacity() const
+    {
+        return m_values.capacity();
+    }
+
     template <variant_base::enum_type_t E>
     bool data_table_column<E>::empty() const
     {
@@ -40,6 +240,10 @@ namespace protean { namespace detail {
     void data_table_column<E>::clear()
     {
         m_values.clear();
+        if (m_dictionary)
+            m_dictionary.reset(new string_dictionary());
+        if (m_arena)
+            m_arena->clear();
     }
 
     template <variant_base::enum_type_t E>
@@ -83,17 +287,32 @@ namespace protean { namespace detail {
                                                                                                                                                    \
         template <variant_base::enum_type_t E>                                                                                                     \
         std::vector<GET_TYPE(elem)>::iterator data_table_column<E>::end_impl(column_traits<GET_ENUM(elem)>::enum_type* p /* = 0 */)                \
-        { return end_impl_tmpl<GET_ENUM(elem)>(p); }
+        { return end_impl_tmpl<GET_ENUM(elem)>(p); }                                                                                               \
+                                                                                                                                                   \
+        template <variant_base::enum_type_t E>                                                                                                     \
+        std::vector<GET_TYPE(elem)>& data_table_column<E>::values_impl(column_traits<GET_ENUM(elem)>::enum_type* p /* = 0 */)                      \
+        { return values_impl_tmpl<GET_ENUM(elem)>(p); }
 
     #define PROTEAN_DETAIL_DT_COLUMN_VIRTUAL_PUSH_BACK_IMPL_DEF(r, data, type)     \
         template <variant_base::enum_type_t E>                                     \
         void data_table_column<E>::push_back_impl(const type& value, type* p /* = 0 */)  \
-        { push_back_impl_tmpl<type>(value, p); }
+        { push_back_impl_tmpl<type>(value, p); }                                   \
+                                                                                   \
+        template <variant_base::enum_type_t E>                                     \
+        void data_table_column<E>::push_back_impl(const type* values, size_t count, type* p /* = 0 */) \
+        { push_back_impl_tmpl<type>(values, count, p); }
 
     template <variant_base::enum_type_t E>
     void data_table_column<E>::push_back_impl(const variant& value, variant* p/* = 0*/)
     { push_back_variant_impl_tmpl<variant>(value, p); }
 
+    template <variant_base::enum_type_t E>
+    void data_table_column<E>::push_back_impl(const variant* values, size_t count, variant* p/* = 0*/)
+    {
+        for (size_t i=0; i<count; ++i)
+            push_back_variant_impl_tmpl<variant>(values[i], p);
+    }
+
 #if defined(_MSC_VER)
 #   pragma warning(push)
 #   pragma warning(disable:4702)
@@ -115,7 +334,7 @@ namespace protean { namespace detail {
         void data_table_column<E>::
         push_back_impl_tmpl(const V& value, typename boost::enable_if<boost::is_same<V, typename data_table_column<E>::value_type>, void*>::type /* = 0 */)
         {
-            return m_values.push_back(value);
+            column_push_back(m_values, value, m_dictionary.get(), m_arena.get());
         }
 
     template <variant_base::enum_type_t E>
@@ -126,6 +345,23 @@ namespace protean { namespace detail {
             boost::throw_exception(variant_error("Column types do not match in call to push_back()"));
         }
 
+    // void push_back(const V*, size_t)
+    template <variant_base::enum_type_t E>
+        template <typename V>
+        void data_table_column<E>::
+        push_back_impl_tmpl(const V* values, size_t count, typename boost::enable_if<boost::is_same<V, typename data_table_column<E>::value_type>, void*>::type /* = 0 */)
+        {
+            column_append(m_values, values, count, m_dictionary.get(), m_arena.get());
+        }
+
+    template <variant_base::enum_type_t E>
+        template <typename V>
+        void data_table_column<E>::
+        push_back_impl_tmpl(const V* /*values*/, size_t /*count*/, typename boost::disable_if<boost::is_same<V, typename data_table_column<E>::value_type>, void*>::type /* = 0 */)
+        {
+            boost::throw_exception(variant_error("Column types do not match in call to push_back()"));
+        }
+
     // void push_back(variant)
     template <variant_base::enum_type_t E>
         template <typename V>
@@ -184,6 +420,8 @@ namespace protean { namespace detail {
         typename column_traits<F>::iterator
         data_table_column<E>::begin_impl_tmpl(typename boost::enable_if<is_same_column<E, F>, void*>::type /* = 0 */)
         {
+            // rows handed out for modification must own their values
+            set_encoding(PlainEncoding);
             return m_values.begin();
         }
 
@@ -201,6 +439,7 @@ namespace protean { namespace detail {
         typename column_traits<F>::iterator
         data_table_column<E>::end_impl_tmpl(typename boost::enable_if<is_same_column<E, F>, void*>::type /* = 0 */)
         {
+            set_encoding(PlainEncoding);
             return m_values.end();
         }
 
@@ -212,4 +451,21 @@ namespace protean { namespace detail {
             boost::throw_exception(variant_error("Column types do not match in call to end()"));
         }
 
+    // container_type& values()
+    template <variant_base::enum_type_t E>
+        template <variant_base::enum_type_t F>
+        typename column_traits<F>::container_type&
+        data_table_column<E>::values_impl_tmpl(typename boost::enable_if<is_same_column<E, F>, void*>::type /* = 0 */)
+        {
+            return m_values;
+        }
+
+    template <variant_base::enum_type_t E>
+        template <variant_base::enum_type_t F>
+        typename column_traits<F>::container_type&
+        data_table_column<E>::values_impl_tmpl(typename boost::disable_if<is_same_column<E, F>, void*>::type /* = 0 */)
+        {
+            boost::throw_exception(variant_error("Column types do not match in bulk column operation"));
+        }
+
 }} // namespace protean::detail
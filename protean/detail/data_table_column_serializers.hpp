@@ -31,9 +31,10 @@ namespace protean {
         virtual ~data_table_column_writer() {}
 
     public:
-        virtual bool has_next() const = 0;
-        virtual void advance()        = 0;
-        virtual void write()          = 0;
+        virtual bool has_next() const       = 0;
+        virtual void advance()              = 0;
+        virtual void skip(size_t count)     = 0;
+        virtual void write()                = 0;
     };
 
     template <variant_base::enum_type_t E>
@@ -45,6 +46,7 @@ namespace protean {
     public:
         virtual bool has_next() const;
         virtual void advance();
+        virtual void skip(size_t count);
 
     protected:
 		typename column_traits<E>::container_type::const_iterator       m_iter;
@@ -26,6 +26,12 @@ namespace protean { namespace detail {
         ++m_iter;
     }
 
+    template <variant_base::enum_type_t E>
+    void data_table_column_writer_base<E>::skip(size_t count)
+    {
+        m_iter += count;
+    }
+
     /* Binary writer: writing to a binary_writer */
     /*********************************************/
     template <variant_base::enum_type_t E>
@@ -0,0 +1,69 @@
+#ifndef PROTEAN_DETAIL_DATA_TABLE_INDEX_HPP
+#define PROTEAN_DETAIL_DATA_TABLE_INDEX_HPP
+
+#include <protean/config.hpp>
+#include <protean/data_table_index.hpp>
+#include <protean/data_table_column_base.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    class variant;
+
+namespace detail {
+
+    /* A secondary index on a DataTable column, named rather than held so that it can */
+    /* be copied with the table.  It is built when first used and brought up to date  */
+    /* with any rows appended since each time it is used after that.                  */
+    /**********************************************************************************/
+    class PROTEAN_DECL data_table_index : boost::noncopyable
+    {
+    public:
+        data_table_index(const std::string& column, data_table_index_t type);
+        virtual ~data_table_index() {}
+
+        const std::string& column() const   { return m_column; }
+        data_table_index_t type() const     { return m_type; }
+
+        // An index of the same column and type, yet to be built
+        virtual data_table_index* clone() const = 0;
+
+        // Drops whatever has been built, for when the rows of the column have changed
+        virtual void reset() = 0;
+
+        // Fills 'rows' with those whose value in 'column' equals 'value', in row order
+        virtual void find(const data_table_column_base& column, const variant& value, std::vector<size_t>& rows) const = 0;
+
+        // Fills 'rows' with those whose value in 'column' lies in [lower, upper), in order of
+        // value then of row; only sorted indexes support this
+        virtual void equal_range(const data_table_column_base& column, const variant& lower, const variant& upper, std::vector<size_t>& rows) const;
+
+    private:
+        const std::string           m_column;
+        const data_table_index_t    m_type;
+    };
+
+    inline data_table_index* new_clone(const data_table_index& index)
+    {
+        return index.clone();
+    }
+
+    // Index of 'type' on 'column', which must be of a numeric, string or date/time type
+    PROTEAN_DECL data_table_index* make_data_table_index(const data_table_column_base& column, data_table_index_t type);
+
+}} // namespace protean::detail
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DETAIL_DATA_TABLE_INDEX_HPP
@@ -0,0 +1,158 @@
+#ifndef PROTEAN_DETAIL_DATA_TABLE_KEYS_HPP
+#define PROTEAN_DETAIL_DATA_TABLE_KEYS_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant.hpp>
+#include <protean/variant_error.hpp>
+#include <protean/data_table_column_base.hpp>
+#include <protean/detail/hash.hpp>
+#include <protean/detail/string.hpp>
+
+#include <boost/format.hpp>
+#include <boost/throw_exception.hpp>
+
+namespace protean { namespace detail {
+
+    /* The key columns of DataTable operators such as group-by and join, which hash and */
+    /* compare rows without boxing their values in variants                              */
+    /*************************************************************************************/
+    class key_column
+    {
+    public:
+        virtual ~key_column() {}
+
+        // Combines the hash of the key in each row of [first, last) into 'hashes', which
+        // starts at that of row 'first'
+        virtual void hash(size_t first, size_t last, boost::uint64_t* hashes) const = 0;
+
+        // Compares row 'lhs' of this column with row 'rhs' of 'other', a key column of the
+        // same type
+        virtual bool equal(size_t lhs, const key_column& other, size_t rhs) const = 0;
+    };
+
+    template <typename T>
+    inline boost::uint64_t key_hash(const T& value, boost::uint64_t seed)
+    {
+        return hash_value(value, seed);
+    }
+
+    inline boost::uint64_t key_hash(const string& value, boost::uint64_t seed)
+    {
+        return value.hash(seed);
+    }
+
+    template <typename T>
+    inline bool key_equal(const T& lhs, const T& rhs)
+    {
+        return lhs==rhs;
+    }
+
+    inline bool key_equal(const string& lhs, const string& rhs)
+    {
+        return lhs.compare(rhs)==0;
+    }
+
+    template <typename T>
+    inline bool key_less(const T& lhs, const T& rhs)
+    {
+        return lhs<rhs;
+    }
+
+    inline bool key_less(const string& lhs, const string& rhs)
+    {
+        return lhs.compare(rhs)<0;
+    }
+
+    // NaNs are ordered after every other value, and as equal to each other, so that the
+    // order is a strict weak ordering that can be sorted and merged
+    inline bool key_less(const float& lhs, const float& rhs)
+    {
+        return lhs<rhs || (rhs!=rhs && lhs==lhs);
+    }
+
+    inline bool key_less(const double& lhs, const double& rhs)
+    {
+        return lhs<rhs || (rhs!=rhs && lhs==lhs);
+    }
+
+    /* A value to be compared with those of a key column, converted from a variant to the */
+    /* type of the column                                                                  */
+    /***************************************************************************************/
+    template <typename T>
+    inline T key_value(const variant& value, T*)
+    {
+        return value.numerical_cast<T>();
+    }
+
+    inline string key_value(const variant& value, string*)
+    {
+        const std::string text(value.as<std::string>());
+        return string(text.c_str(), text.size());
+    }
+
+    inline boost::gregorian::date key_value(const variant& value, boost::gregorian::date*)
+    {
+        return value.as<variant::date_t>();
+    }
+
+    inline boost::posix_time::time_duration key_value(const variant& value, boost::posix_time::time_duration*)
+    {
+        return value.as<variant::time_t>();
+    }
+
+    inline boost::posix_time::ptime key_value(const variant& value, boost::posix_time::ptime*)
+    {
+        return value.as<variant::date_time_t>();
+    }
+
+    template <variant_base::enum_type_t E>
+    class typed_key_column : public key_column
+    {
+    public:
+        typed_key_column(const data_table_column_base& column, size_t offset) :
+            m_values(column.begin<E>() + offset)
+        {}
+
+        virtual void hash(size_t first, size_t last, boost::uint64_t* hashes) const
+        {
+            for (size_t i=first; i<last; ++i, ++hashes)
+            {
+                *hashes = key_hash(m_values[i], *hashes);
+            }
+        }
+
+        virtual bool equal(size_t lhs, const key_column& other, size_t rhs) const
+        {
+            return key_equal(m_values[lhs], static_cast<const typed_key_column&>(other).m_values[rhs]);
+        }
+
+    private:
+        const typename column_traits<E>::const_iterator m_values;
+    };
+
+    // Key column of the rows of 'column' from 'offset' on, numbered from zero
+    inline key_column* make_key_column(const data_table_column_base& column, size_t offset = 0)
+    {
+        switch (column.type())
+        {
+            case variant_base::Boolean:     return new typed_key_column<variant_base::Boolean>(column, offset);
+            case variant_base::Int32:       return new typed_key_column<variant_base::Int32>(column, offset);
+            case variant_base::UInt32:      return new typed_key_column<variant_base::UInt32>(column, offset);
+            case variant_base::Int64:       return new typed_key_column<variant_base::Int64>(column, offset);
+            case variant_base::UInt64:      return new typed_key_column<variant_base::UInt64>(column, offset);
+            case variant_base::String:      return new typed_key_column<variant_base::String>(column, offset);
+            case variant_base::Any:         return new typed_key_column<variant_base::Any>(column, offset);
+            case variant_base::Date:        return new typed_key_column<variant_base::Date>(column, offset);
+            case variant_base::Time:        return new typed_key_column<variant_base::Time>(column, offset);
+            case variant_base::DateTime:    return new typed_key_column<variant_base::DateTime>(column, offset);
+            default:
+                boost::throw_exception(variant_error(boost::str(boost::format("Column '%s' of type %s cannot be used as a key")
+                    % column.name()
+                    % variant_base::enum_to_string(column.type()))));
+        }
+        return nullptr;
+    }
+
+}} // namespace protean::detail
+
+#endif // PROTEAN_DETAIL_DATA_TABLE_KEYS_HPP
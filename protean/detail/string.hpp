@@ -4,9 +4,17 @@
 #include <protean/config.hpp>
 
 #include <string>
+#include <boost/config.hpp>
 #include <boost/cstdint.hpp>
 
-namespace protean { namespace detail {
+namespace protean {
+
+    class binary_reader;
+
+namespace detail {
+
+    class string_dictionary;
+    class string_arena;
 
     class PROTEAN_DECL string
     {
@@ -15,14 +23,24 @@ namespace protean { namespace detail {
         string(const char* text);
         string(const char* text, size_t len);
         string(const string& rhs);
+        string(string&& rhs) BOOST_NOEXCEPT;
         ~string();
 
         string& operator=(const string& rhs);
+        string& operator=(string&& rhs) BOOST_NOEXCEPT;
 
         const char* value() const;
         void initialise(const char* value, size_t size);
 
+        // as initialise, reusing the heap buffer if the new value fits
+        void assign(const char* value, size_t size);
+
         bool onStack() const;
+        bool isReference() const;
+
+        // If this refers to a value within [first, last), refers to it at the same offset
+        // from 'to' instead, for references to storage that has been moved
+        void rebase(const char* first, const char* last, const char* to);
 
         void swap(string& rhs);
 
@@ -32,6 +50,22 @@ namespace protean { namespace detail {
         int compare(const string& rhs) const;
         boost::uint64_t hash(boost::uint64_t seed) const;
 
+    private:
+        // A string that refers to 'value' instead of copying it, for the rows of dictionary
+        // and arena-encoded columns.  'value' must be 4-byte aligned and null-terminated, and
+        // outlive the reference.
+        //
+        // Copying a reference copies its value, moving it moves only the reference so that
+        // columns can move their rows without copying.  References are only made for the
+        // storage of columns, which hand them out as const rows, or decode themselves before
+        // handing out rows that may be moved from.
+        static string reference(const char* value, size_t size);
+        static string reference(const string& value);
+
+        friend class string_dictionary;
+        friend class string_arena;
+        friend class protean::binary_reader;
+
     private:
         char* heapPointer();
         const char* heapPointer() const;
@@ -0,0 +1,54 @@
+#ifndef PROTEAN_DETAIL_STRING_ARENA_HPP
+#define PROTEAN_DETAIL_STRING_ARENA_HPP
+
+#include <protean/config.hpp>
+#include <protean/detail/string.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean { namespace detail {
+
+    /* Contiguous storage of the values of an arena-encoded DataTable column, in row order,  */
+    /* each null-terminated and padded to the alignment string::reference requires.  Rows   */
+    /* are string::references into the arena, so they serve as its offsets; as the arena   */
+    /* grows by reallocation the references among the rows are moved with it.               */
+    /****************************************************************************************/
+    class PROTEAN_DECL string_arena : boost::noncopyable
+    {
+    public:
+        // Bytes taken by a value of 'size' characters
+        static size_t padded_size(size_t size);
+
+        // Appends a copy of 'value' and returns a string referring to it
+        string append(const char* value, size_t size, std::vector<string>& rows);
+
+        // Appends 'size' bytes to be filled in by the caller, e.g. from a stream
+        char* extend(size_t size, std::vector<string>& rows);
+
+        void reserve(size_t size, std::vector<string>& rows);
+        void clear();
+
+        const char* data() const;
+        size_t size() const;
+
+    private:
+        void grow(size_t size, std::vector<string>& rows);
+
+    private:
+        std::vector<char> m_bytes;
+    };
+
+}} // namespace protean::detail
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DETAIL_STRING_ARENA_HPP
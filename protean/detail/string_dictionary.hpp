@@ -0,0 +1,64 @@
+#ifndef PROTEAN_DETAIL_STRING_DICTIONARY_HPP
+#define PROTEAN_DETAIL_STRING_DICTIONARY_HPP
+
+#include <protean/config.hpp>
+#include <protean/detail/string.hpp>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_set.hpp>
+
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean { namespace detail {
+
+    /* Append-only store of distinct strings, held by dictionary-encoded DataTable columns.  */
+    /* Values are never moved once added, so each row of the column is a string::reference  */
+    /* to its entry, and equal rows compare by address.                                     */
+    /*****************************************************************************************/
+    class PROTEAN_DECL string_dictionary : boost::noncopyable
+    {
+    public:
+        string_dictionary();
+
+        // A reference to the dictionary's copy of 'value', which is added if it is new.
+        // Values short enough to be held in a string itself are returned as copies.
+        string intern(const string& value);
+        string intern(const char* value, size_t size);
+
+        // Number of distinct values held, and the bytes allocated for them
+        size_t size() const;
+        size_t bytes() const;
+
+    public:
+        // Hashing and equality of null-terminated values by content
+        struct hash
+        {
+            size_t operator()(const char* value) const;
+        };
+
+        struct equal
+        {
+            bool operator()(const char* lhs, const char* rhs) const;
+        };
+
+    private:
+        const char* add(const char* value, size_t size);
+
+    private:
+        std::vector<std::vector<char> >                 m_blocks;
+        boost::unordered_set<const char*, hash, equal>  m_values;
+        size_t                                          m_bytes;
+    };
+
+}} // namespace protean::detail
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DETAIL_STRING_DICTIONARY_HPP
@@ -0,0 +1,196 @@
+#ifndef PROTEAN_DETAIL_THREAD_POOL_HPP
+#define PROTEAN_DETAIL_THREAD_POOL_HPP
+
+#include <protean/config.hpp>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean { namespace detail {
+
+    /* Fixed-size pool of worker threads shared by the parallel serialisation */
+    /* and DataTable operators.                                               */
+    /**************************************************************************/
+    class PROTEAN_DECL thread_pool : boost::noncopyable
+    {
+    public:
+        // A size of zero uses one thread per hardware core
+        explicit thread_pool(size_t size = 0);
+        ~thread_pool();
+
+        size_t size() const;
+
+        template <typename Function>
+        std::future<typename std::result_of<Function()>::type> submit(Function function);
+
+        // As submit, but calls 'function' at once on this thread if it is a worker of the
+        // pool, which could otherwise wait on a task that no free worker is left to run
+        template <typename Function>
+        std::future<typename std::result_of<Function()>::type> submit_or_call(Function function);
+
+        // Whether the calling thread is one of the workers of this pool
+        bool is_worker() const;
+
+        // Process-wide pool, created on first use and never destroyed
+        static thread_pool& instance();
+
+    private:
+        void enqueue(const std::function<void()>& task);
+        void run();
+
+    private:
+        std::vector<std::thread>            m_threads;
+        std::deque<std::function<void()> >  m_tasks;
+        std::mutex                          m_mutex;
+        std::condition_variable             m_condition;
+        bool                                m_stopping;
+    };
+
+    template <typename Function>
+    std::future<typename std::result_of<Function()>::type> thread_pool::submit(Function function)
+    {
+        typedef typename std::result_of<Function()>::type result_type;
+
+        // std::function requires a copyable target, so the task is held by shared_ptr
+        boost::shared_ptr<std::packaged_task<result_type()> > task(
+            boost::make_shared<std::packaged_task<result_type()> >(function)
+        );
+
+        std::future<result_type> result(task->get_future());
+        enqueue([task]() { (*task)(); });
+
+        return result;
+    }
+
+    template <typename Function>
+    std::future<typename std::result_of<Function()>::type> thread_pool::submit_or_call(Function function)
+    {
+        typedef typename std::result_of<Function()>::type result_type;
+
+        if (!is_worker())
+        {
+            return submit(function);
+        }
+
+        std::packaged_task<result_type()> task(function);
+        std::future<result_type> result(task.get_future());
+        task();
+
+        return result;
+    }
+
+    /* Calls function(i) for every i in [0, count), spreading the calls over the pool. */
+    /* The calling thread takes part in the work, and only waits for helpers that have */
+    /* actually started, so parallel_for may safely be nested inside pool tasks.       */
+    /***********************************************************************************/
+    template <typename Function>
+    void parallel_for(size_t count, Function function, thread_pool& pool = thread_pool::instance())
+    {
+        if (count == 0)
+            return;
+
+        if (count == 1 || pool.size() < 2)
+        {
+            for (size_t i = 0; i < count; ++i)
+                function(i);
+            return;
+        }
+
+        struct state
+        {
+            state(size_t count, Function function) :
+                m_count(count), m_next(0), m_active(0), m_function(function)
+            {}
+
+            // Returns false once every index has been claimed
+            bool work()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_next == m_count)
+                        return false;
+                    ++m_active;
+                }
+
+                for (;;)
+                {
+                    size_t i;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (m_next == m_count || m_error)
+                            break;
+                        i = m_next++;
+                    }
+
+                    try
+                    {
+                        m_function(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (!m_error)
+                            m_error = std::current_exception();
+                        m_next = m_count;
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (--m_active == 0)
+                    m_done.notify_all();
+                return true;
+            }
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (m_next != m_count || m_active != 0)
+                    m_done.wait(lock);
+
+                if (m_error)
+                    std::rethrow_exception(m_error);
+            }
+
+            const size_t            m_count;
+            size_t                  m_next;
+            size_t                  m_active;
+            Function                m_function;
+            std::exception_ptr      m_error;
+            std::mutex              m_mutex;
+            std::condition_variable m_done;
+        };
+
+        boost::shared_ptr<state> shared(boost::make_shared<state>(count, function));
+
+        const size_t helpers = (std::min)(pool.size(), count) - 1;
+        for (size_t i = 0; i < helpers; ++i)
+            pool.submit([shared]() { shared->work(); });
+
+        shared->work();
+        shared->wait();
+    }
+
+}} // namespace protean::detail
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_DETAIL_THREAD_POOL_HPP
@@ -3,27 +3,50 @@
 
 #include <protean/config.hpp>
 
+#include <protean/variant_base.hpp>
 #include <protean/detail/collection.hpp>
 
+#include <boost/cstdint.hpp>
+
+#include <vector>
+
 #if defined(_MSC_VER)
 #    pragma warning(push)
 #    pragma warning(disable:4251)
 #endif
 
-namespace protean { namespace detail {
+namespace protean {
+
+    class data_table_column_base;
 
+namespace detail {
+
+    /* Times are held as ticks since the Unix epoch and values, while they are all numbers */
+    /* of one type, unboxed in a column of that type, so a series of numbers takes 16     */
+    /* bytes a point and can be scanned without touching a variant.  Other values are   */
+    /* held as variants, as are the values of a series once one is referred to by a    */
+    /* non-const iterator, until the next append finds them still all of one type.      */
+    /*************************************************************************************/
     class PROTEAN_DECL timeseries : public collection
     {
         typedef boost::posix_time::ptime date_time_t;
-        typedef std::vector< std::pair<date_time_t, variant> > container_t;
 
     public:
+        timeseries();
+        timeseries(const timeseries& rhs);
+        timeseries& operator=(const timeseries& rhs);
+        ~timeseries();
+
         int compare(const collection& rhs) const;
         boost::uint64_t hash(boost::uint64_t seed) const;
         bool empty() const;
         size_t size() const;
         void clear();
 
+        // Appends a point, keeping the values unboxed if they are all numbers of one type
+        void append(const date_time_t& time, const variant& value);
+
+        // Appends a point and returns its value, to be filled in; holds the values as variants
         variant& push_back(const date_time_t& time, const variant& value);
 
         variant_const_iterator_base* begin() const;
@@ -31,8 +54,63 @@ namespace protean { namespace detail {
         variant_iterator_base* begin();
         variant_iterator_base* end();
 
+    /* Columnar access */
+    /*******************/
+    public:
+        static boost::int64_t to_ticks(const date_time_t& time);
+        static date_time_t from_ticks(boost::int64_t ticks);
+
+        // Times of the points, in ticks
+        const std::vector<boost::int64_t>& times() const    { return m_times; }
+
+        // A Number type when the values are all of it and held unboxed, Variant when they
+        // are held as variants, None when there are none
+        variant_base::enum_type_t value_type() const        { return m_type; }
+
+        // The unboxed values, when value_type() is a Number type
+        const data_table_column_base& values() const;
+
+        // The value of the n'th point, boxed into 'copy' if it is held unboxed
+        const variant& value(size_t n, variant& copy) const;
+
+        // The value of the n'th point, to be changed in place; the values are boxed until
+        // the next append, which unboxes them if they are still numbers of one type
+        variant& value(size_t n);
+
+        // Replaces the points with ones at 'times', which are swapped out, holding the
+        // values of 'values', a column of a Number type that the series takes over
+        void assign(std::vector<boost::int64_t>& times, data_table_column_base* values);
+
+    /* Order of the times */
+    /**********************/
+    public:
+        // Whether the times of the points are in non-decreasing order, which the lookups
+        // of timeseries_view need
+        bool ordered() const                                { return m_ordered; }
+
+        // Whether adding a point earlier than the last point throws, rather than leaving
+        // the series unordered
+        bool order_enforced() const                         { return m_enforce_order; }
+        void enforce_order(bool enforce);
+
+    private:
+        // Ticks of 'time', checking it against the last point of the series
+        boost::int64_t next_ticks(const date_time_t& time);
+
+        // Moves unboxed values into variants
+        void box();
+
+        // Moves the values back into a column if they are all numbers of one type
+        void unbox();
+
     private:
-        container_t m_value;
+        std::vector<boost::int64_t>     m_times;
+        variant_base::enum_type_t       m_type;
+        data_table_column_base*         m_column;
+        std::vector<variant>            m_variants;
+        bool                            m_ordered;
+        bool                            m_enforce_order;
+        bool                            m_unbox;
     };
 
 }} // namespace protean::detail
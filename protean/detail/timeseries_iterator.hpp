@@ -3,6 +3,8 @@
 
 #include <protean/config.hpp>
 #include <protean/variant_error.hpp>
+#include <protean/variant.hpp>
+#include <protean/detail/timeseries.hpp>
 
 #if defined(_MSC_VER)
 #    pragma warning(push)
@@ -18,12 +20,13 @@ namespace protean { namespace detail {
     class PROTEAN_DECL timeseries_iterator_interface : public BASE
     {
         typedef typename ITERATOR_TRAITS::value_type& reference;
-        typedef typename ITERATOR_TRAITS::timeseries_iterator_type iterator_type;
+        typedef typename ITERATOR_TRAITS::timeseries_type timeseries_type;
         typedef typename BASE::date_time_t date_time_t;
 
     public:
-        timeseries_iterator_interface(const iterator_type& iterator) :
-            m_iterator(iterator)
+        timeseries_iterator_interface(timeseries_type* series, size_t index) :
+            m_series(series),
+            m_index(index)
         {
         }
         const std::string& key() const
@@ -32,19 +35,20 @@ namespace protean { namespace detail {
         }
         reference value() const
         {
-            return m_iterator->second;
+            return value(*m_series);
         }
         const date_time_t& time() const
         {
-            return m_iterator->first;
+            m_time = timeseries::from_ticks(m_series->times()[m_index]);
+            return m_time;
         }
         void increment()
         {
-            ++m_iterator;
+            ++m_index;
         }
         void decrement()
         {
-            --m_iterator;
+            --m_index;
         }
         bool equal(const variant_const_iterator_base *rhs) const
         {
@@ -55,23 +59,38 @@ namespace protean { namespace detail {
             {
                 boost::throw_exception (variant_error ("Unable to convert iterator to timeseries iterator"));
             }
-            return m_iterator==cast_rhs->iterator();
+            return m_index==cast_rhs->index();
         }
-        iterator_type iterator() const
+        size_t index() const
         {
-            return m_iterator;
+            return m_index;
         }
         BASE* clone()
         {
-            return new timeseries_iterator_interface(m_iterator);
+            return new timeseries_iterator_interface(m_series, m_index);
         }
         variant_const_iterator_base* to_const() const
         {
-            return new timeseries_iterator_interface<const_iterator_traits>(m_iterator);
+            return new timeseries_iterator_interface<const_iterator_traits>(m_series, m_index);
         }
 
     private:
-        iterator_type m_iterator;
+        // Values held unboxed are copied into a variant, values held as variants are
+        // referred to in place
+        const variant& value(const timeseries& series) const
+        {
+            return series.value(m_index, m_copy);
+        }
+        variant& value(timeseries& series) const
+        {
+            return series.value(m_index);
+        }
+
+    private:
+        timeseries_type*        m_series;
+        size_t                  m_index;
+        mutable date_time_t     m_time;
+        mutable variant         m_copy;
     };    
 
     typedef timeseries_iterator_interface<iterator_traits> timeseries_iterator;
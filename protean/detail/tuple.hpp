@@ -32,7 +32,7 @@ namespace protean { namespace detail {
         variant_iterator_base* end();
 
     private:
-        boost::uint16_t m_size;
+        size_t          m_size;
         variant*        m_value;
     };
 
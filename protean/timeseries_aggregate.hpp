@@ -0,0 +1,40 @@
+#ifndef PROTEAN_TIMESERIES_AGGREGATE_HPP
+#define PROTEAN_TIMESERIES_AGGREGATE_HPP
+
+#include <protean/config.hpp>
+
+#include <string>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    /* A function of the values of the points of a TimeSeries in a bar or window: the  */
+    /* first, greatest, least and last value, their sum, count or mean.  Open, High,   */
+    /* Low, Close and Sum of UInt64 values are UInt64, of other integer values Int64  */
+    /* and of other numbers Double; Mean is always Double and Count is UInt64.  The    */
+    /* result is named 'name', or after the function, e.g. "Open", if that is empty.   */
+    /***********************************************************************************/
+    struct PROTEAN_DECL timeseries_aggregate
+    {
+        enum function_t { Open, High, Low, Close, Sum, Count, Mean };
+
+        timeseries_aggregate(function_t function, const std::string& name = std::string());
+
+        // Name of the result column
+        std::string result_name() const;
+
+        function_t  m_function;
+        std::string m_name;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_TIMESERIES_AGGREGATE_HPP
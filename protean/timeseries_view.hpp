@@ -0,0 +1,125 @@
+#ifndef PROTEAN_TIMESERIES_VIEW_HPP
+#define PROTEAN_TIMESERIES_VIEW_HPP
+
+#include <protean/config.hpp>
+#include <protean/variant.hpp>
+#include <protean/data_table_column_base.hpp>
+#include <protean/timeseries_aggregate.hpp>
+#include <protean/detail/timeseries.hpp>
+
+#include <boost/range/iterator_range.hpp>
+
+#include <memory>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable:4251)
+#endif
+
+namespace protean {
+
+    /* A contiguous range of the points of a TimeSeries that refers to the times and   */
+    /* values of the series rather than copying them, found by binary search on times */
+    /* that are in order.  The series must outlive the view and not change while it is */
+    /* in use; series() copies the points into a new TimeSeries.                       */
+    /***********************************************************************************/
+    class PROTEAN_DECL timeseries_view
+    {
+        typedef boost::posix_time::ptime date_time_t;
+
+    public:
+        // Every point of a series
+        explicit timeseries_view(const detail::timeseries& series);
+
+        size_t size() const                         { return m_length; }
+        bool empty() const                          { return m_length==0; }
+
+        // Point of the series that is the first point of the view
+        size_t offset() const                       { return m_offset; }
+
+        // Time and value of the n'th point of the view
+        date_time_t time(size_t n) const;
+        variant value(size_t n) const;
+
+        // Times of the points of the view, in ticks, see detail::timeseries::to_ticks
+        boost::iterator_range<const boost::int64_t*> times() const
+        {
+            const boost::int64_t* first(m_series->times().data() + m_offset);
+            return boost::make_iterator_range(first, first + m_length);
+        }
+
+        // Type of the values, see detail::timeseries::value_type
+        variant_base::enum_type_t value_type() const { return m_series->value_type(); }
+
+        // Values of the points of the view, when they are held unboxed as type E
+        template <variant_base::enum_type_t E>
+        boost::iterator_range<typename column_traits<E>::const_iterator> values() const
+        {
+            typename column_traits<E>::const_iterator first(m_series->values().begin<E>() + m_offset);
+            return boost::make_iterator_range(first, first + m_length);
+        }
+
+        // Points [offset, offset + length) of the view, clipped to its end
+        timeseries_view slice(size_t offset, size_t length) const;
+
+    /* Lookups, in O(log n) */
+    /************************/
+    public:
+        // Points from the first at or after 'time' to the end of the view
+        timeseries_view lower_bound(const date_time_t& time) const;
+
+        // The last point at or before 'time', or no points if there is none
+        timeseries_view at_or_before(const date_time_t& time) const;
+
+        // Points at or after 'first' and before 'last'
+        timeseries_view range(const date_time_t& first, const date_time_t& last) const;
+
+        // A TimeSeries holding a copy of the points of the view
+        variant series() const;
+
+    /* Aggregation, in one pass over the points */
+    /********************************************/
+    public:
+        // The 'aggregates' of the points in each bar of 'interval', as a DataTable with
+        // the start of each bar in a "Time" column and a column per aggregate.  Bars are
+        // aligned to multiples of 'interval' since the epoch, so bars of a second, minute
+        // or hour start on the second, minute or hour; bars without points are left out.
+        // Here and below, the times must be in order and none of them special.
+        variant resample(const boost::posix_time::time_duration& interval, const std::vector<timeseries_aggregate>& aggregates) const;
+
+        // As above, for one aggregate, as a TimeSeries of the values of the bars
+        variant resample(const boost::posix_time::time_duration& interval, const timeseries_aggregate& aggregate) const;
+
+        // The 'aggregates' of the points in the 'window' up to and including each point,
+        // ie with times in (t - window, t], as a DataTable with a row per point.  Sums are
+        // kept running, so sums of floating point values may differ in their last bits
+        // from those added afresh.
+        variant rolling(const boost::posix_time::time_duration& window, const std::vector<timeseries_aggregate>& aggregates) const;
+
+        // As above, for one aggregate, as a TimeSeries with a point per point
+        variant rolling(const boost::posix_time::time_duration& window, const timeseries_aggregate& aggregate) const;
+
+    private:
+        timeseries_view(const detail::timeseries* series, size_t offset, size_t length);
+
+        // Index in the view of the first point at or after, or after, 'time'
+        size_t lower_index(const date_time_t& time) const;
+        size_t upper_index(const date_time_t& time) const;
+
+        // A TimeSeries of 'times', in ticks, holding 'values', see detail::timeseries::assign
+        static variant make_series(std::vector<boost::int64_t>&& times, std::unique_ptr<data_table_column_base> values);
+
+    private:
+        const detail::timeseries*   m_series;
+        size_t                      m_offset;
+        size_t                      m_length;
+    };
+
+} // namespace protean
+
+#if defined(_MSC_VER)
+#    pragma warning(pop)
+#endif
+
+#endif // PROTEAN_TIMESERIES_VIEW_HPP
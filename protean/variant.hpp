@@ -7,6 +7,8 @@
 #include <protean/variant_ref.hpp>
 #include <protean/data_table_iterator.hpp>
 #include <protean/data_table_column_base.hpp>
+#include <protean/data_table_join.hpp>
+#include <protean/data_table_index.hpp>
 
 #include <boost/preprocessor/repetition/repeat.hpp>
 #include <boost/preprocessor/repetition/enum_params.hpp>
@@ -17,6 +19,13 @@ namespace protean {
 
     class variant_ref;
     class variant_cref;
+    class data_table_expression;
+    class data_table_selection;
+    class data_table_view;
+    class timeseries_view;
+    struct timeseries_aggregate;
+    struct data_table_aggregate;
+    struct data_table_sort_key;
 
     template<typename T>
     class range_array_iterator;
@@ -202,11 +211,66 @@ namespace protean {
     public:
         variant& push_back(const date_time_t& time, const variant& value, enum_return_trait_t ret = ReturnSelf);
 
+        // Makes adding a point earlier than the last point of a TimeSeries throw, see
+        // detail::timeseries::enforce_order
+        variant& enforce_order(bool enforce = true);
+
+        // Binary searches over a TimeSeries whose times are in order, as views of the
+        // points that leave them in place, see timeseries_view
+        timeseries_view series_view() const;
+        timeseries_view lower_bound(const date_time_t& time) const;
+        timeseries_view at_or_before(const date_time_t& time) const;
+        timeseries_view range(const date_time_t& first, const date_time_t& last) const;
+
+        // Aggregates of the points of a TimeSeries in bars of 'interval', or in a window
+        // trailing each point, as a DataTable or, for one aggregate, a TimeSeries, see
+        // timeseries_view::resample and timeseries_view::rolling
+        variant resample(const time_t& interval, const std::vector<timeseries_aggregate>& aggregates) const;
+        variant resample(const time_t& interval, const timeseries_aggregate& aggregate) const;
+        variant rolling(const time_t& window, const std::vector<timeseries_aggregate>& aggregates) const;
+        variant rolling(const time_t& window, const timeseries_aggregate& aggregate) const;
+
     /* DataTable interface */
     /***********************/
     public:
         variant& add_column(enum_type_t type);
         variant& add_column(enum_type_t type, const std::string& name);
+        variant& add_column(enum_type_t type, const std::string& name, data_table_column_base::encoding_t encoding);
+
+        // Adds a column holding the value of 'expression' for each row
+        variant& add_column(const std::string& name, const data_table_expression& expression);
+
+        // The rows for which the Boolean 'expression' holds, as a view or as a new DataTable
+        data_table_selection where(const data_table_expression& expression) const;
+        variant filter(const data_table_expression& expression) const;
+
+        // A DataTable of the 'aggregates' of the rows with each distinct value of the
+        // 'keys' columns, see detail::data_table::group_by
+        variant group_by(const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, size_t threads = 0) const;
+
+        // A DataTable of the rows of this DataTable joined to those of 'right' with equal
+        // keys, see detail::data_table::join
+        variant join(const variant& right, const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys, data_table_join_t type = InnerJoin, size_t threads = 0) const;
+
+        // Reorders the rows of a DataTable by 'keys', see detail::data_table::sort
+        variant& sort(const std::vector<data_table_sort_key>& keys, size_t threads = 0);
+
+        // The rows of a DataTable in the order of 'keys', as a view that leaves them in place
+        data_table_selection sorted_view(const std::vector<data_table_sort_key>& keys, size_t threads = 0) const;
+
+        // All the rows and columns of a DataTable as a view, to be sliced without copying
+        data_table_view view() const;
+
+        // Adds or drops indexes on a column of a DataTable, see detail::data_table::add_index
+        variant& add_index(const std::string& column, data_table_index_t type = HashIndex);
+        variant& drop_index(const std::string& column);
+
+        // Rows of a DataTable whose value in 'column' equals 'value', in row order
+        std::vector<size_t> find(const std::string& column, const variant& value) const;
+
+        // Rows of a DataTable whose value in 'column' lies in [lower, upper), in order of
+        // value, which needs a sorted index on the column
+        std::vector<size_t> equal_range(const std::string& column, const variant& lower, const variant& upper) const;
 
 		const column_collection_t& columns() const;
 		column_collection_t& columns();
@@ -214,6 +278,13 @@ namespace protean {
         template <typename TUPLE>
         variant& push_back(const TUPLE& value);
 
+        // Appends a range of rows, e.g. from a std::vector of rows made with make_row
+        template <typename ITERATOR>
+        variant& append(ITERATOR first, ITERATOR last);
+
+        // Reserves space for this many rows in every column
+        variant& reserve(size_t rows);
+
         #define DATA_TABLE_BEGIN_ITERATOR_DECL(z, n, t)                                            \
             template <BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), enum_type_t t)>                     \
             data_table_iterator<BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), t)> begin();
@@ -293,6 +364,7 @@ namespace protean {
         friend class detail::xml_default_handler;
         friend class binary_reader;
         friend class binary_writer;
+        friend class timeseries_view;
     };
 
 } // namespace protean
@@ -13,6 +13,7 @@
 
 #include <protean/detail/variant_macros_define.hpp>
 #include <protean/detail/data_table.hpp>
+#include <protean/detail/timeseries.hpp>
 
 namespace protean {
 
@@ -309,6 +310,15 @@ namespace protean {
         // END_TRANSLATE_ERROR();
     }
 
+    template <typename ITERATOR>
+    variant& variant::append(ITERATOR first, ITERATOR last)
+    {
+        CHECK_VARIANT_FUNCTION(DataTable, "append<ITERATOR>()");
+
+        m_value.get<DataTable>().append(first, last);
+        return *this;
+    }
+
     #define DATA_TABLE_BEGIN_ITERATOR(z, n, t)                                                         \
         template <BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), variant::enum_type_t t)>                    \
         data_table_iterator<BOOST_PP_ENUM_PARAMS(BOOST_PP_ADD(n, 1), t)> variant::begin()              \
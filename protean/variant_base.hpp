@@ -22,7 +22,6 @@
 #    include <protean/detail/mapping.hpp>
 #        include <protean/detail/bag.hpp>
 #        include <protean/detail/dictionary.hpp>
-#    include <protean/detail/timeseries.hpp>
 #include <protean/handle.hpp>
 #include <protean/detail/variant_impl.hpp>
 
@@ -37,6 +36,7 @@ namespace protean {
     namespace detail {
          class xml_default_handler;
          class data_table;
+         class timeseries;
     }
 
     class PROTEAN_DECL variant_base
@@ -19,13 +19,17 @@ namespace protean {
 
     class variant;
 
+    namespace detail {
+        class timeseries;
+    }
+
     struct const_iterator_traits
     {
         typedef const variant value_type;
         typedef std::vector<variant>::const_iterator list_iterator_type;
         typedef std::map<std::string, variant>::const_iterator dictionary_iterator_type;
         typedef std::list<std::pair<std::string, variant> >::const_iterator bag_iterator_type;
-        typedef std::vector<std::pair<boost::posix_time::ptime, variant> >::const_iterator timeseries_iterator_type;
+        typedef const detail::timeseries timeseries_type;
         typedef const variant* tuple_iterator_type;
         typedef std::ptrdiff_t difference_type;
         template <typename T> struct column_iterator_type { typedef typename std::vector<T>::const_iterator type; };
@@ -37,7 +41,7 @@ namespace protean {
         typedef std::vector<variant>::iterator list_iterator_type;
         typedef std::map<std::string, variant>::iterator dictionary_iterator_type;
         typedef std::list<std::pair<std::string, variant> >::iterator bag_iterator_type;
-        typedef std::vector<std::pair<boost::posix_time::ptime, variant> >::iterator timeseries_iterator_type;
+        typedef detail::timeseries timeseries_type;
         typedef variant* tuple_iterator_type;
         typedef std::ptrdiff_t difference_type;
         template <typename T> struct column_iterator_type { typedef typename std::vector<T>::iterator type; };
@@ -0,0 +1,648 @@
+#include <protean/arrow.hpp>
+#include <protean/typed_array.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <limits>
+
+namespace protean {
+
+    namespace {
+
+        static const boost::gregorian::date s_epoch_date(1970, 1, 1);
+        static const boost::posix_time::ptime s_epoch(s_epoch_date);
+
+        // Buffer for empty arrays, which must still have one
+        static const boost::uint64_t s_empty[1] = { 0 };
+
+        /* Private data of the arrays and schemas we export */
+        /****************************************************/
+        struct exported_array
+        {
+            boost::shared_ptr<const variant>    m_owner;
+            std::vector<std::vector<char> >     m_data;
+            std::vector<const void*>            m_buffers;
+            std::vector<ArrowArray>             m_children;
+            std::vector<ArrowArray*>            m_child_pointers;
+        };
+
+        struct exported_schema
+        {
+            std::string                         m_format;
+            std::string                         m_name;
+            std::vector<ArrowSchema>            m_children;
+            std::vector<ArrowSchema*>           m_child_pointers;
+        };
+
+        void release_array(ArrowArray* array)
+        {
+            exported_array* data(static_cast<exported_array*>(array->private_data));
+            for (size_t i=0; i<data->m_children.size(); ++i)
+            {
+                if (data->m_children[i].release!=nullptr)
+                {
+                    data->m_children[i].release(&data->m_children[i]);
+                }
+            }
+            delete data;
+            array->release = nullptr;
+        }
+
+        void release_schema(ArrowSchema* schema)
+        {
+            exported_schema* data(static_cast<exported_schema*>(schema->private_data));
+            for (size_t i=0; i<data->m_children.size(); ++i)
+            {
+                if (data->m_children[i].release!=nullptr)
+                {
+                    data->m_children[i].release(&data->m_children[i]);
+                }
+            }
+            delete data;
+            schema->release = nullptr;
+        }
+
+        // Hands 'data' over to 'array', which takes ownership of it
+        void init_array(ArrowArray* array, size_t length, exported_array* data)
+        {
+            for (size_t i=0; i<data->m_buffers.size(); ++i)
+            {
+                if (data->m_buffers[i]==nullptr && i>0)
+                {
+                    data->m_buffers[i] = s_empty;
+                }
+            }
+            for (size_t i=0; i<data->m_children.size(); ++i)
+            {
+                data->m_child_pointers.push_back(&data->m_children[i]);
+            }
+
+            array->length = static_cast<int64_t>(length);
+            array->null_count = 0;
+            array->offset = 0;
+            array->n_buffers = static_cast<int64_t>(data->m_buffers.size());
+            array->n_children = static_cast<int64_t>(data->m_children.size());
+            array->buffers = data->m_buffers.empty() ? nullptr : &data->m_buffers[0];
+            array->children = data->m_child_pointers.empty() ? nullptr : &data->m_child_pointers[0];
+            array->dictionary = nullptr;
+            array->release = &release_array;
+            array->private_data = data;
+        }
+
+        // Hands 'data' over to 'schema', which takes ownership of it
+        void init_schema(ArrowSchema* schema, exported_schema* data)
+        {
+            for (size_t i=0; i<data->m_children.size(); ++i)
+            {
+                data->m_child_pointers.push_back(&data->m_children[i]);
+            }
+
+            schema->format = data->m_format.c_str();
+            schema->name = data->m_name.c_str();
+            schema->metadata = nullptr;
+            schema->flags = 0;
+            schema->n_children = static_cast<int64_t>(data->m_children.size());
+            schema->children = data->m_child_pointers.empty() ? nullptr : &data->m_child_pointers[0];
+            schema->dictionary = nullptr;
+            schema->release = &release_schema;
+            schema->private_data = data;
+        }
+
+        /* Export of the values of a column, or of a typed_array, into the buffers of */
+        /* an array: [VALIDITY][VALUES] or [VALIDITY][OFFSETS][TEXT]                 */
+        /******************************************************************************/
+        template <typename T, typename Iterator, typename Convert>
+        void export_converted(Iterator values, size_t length, Convert convert, exported_array& data)
+        {
+            data.m_data.push_back(std::vector<char>(std::max<size_t>(length * sizeof(T), 1)));
+            T* out(reinterpret_cast<T*>(&data.m_data.back()[0]));
+            for (size_t i=0; i<length; ++i, ++values)
+            {
+                out[i] = convert(*values);
+            }
+            data.m_buffers.push_back(nullptr);
+            data.m_buffers.push_back(&data.m_data.back()[0]);
+        }
+
+        template <typename Iterator>
+        void export_bitmap(Iterator values, size_t length, exported_array& data)
+        {
+            data.m_data.push_back(std::vector<char>((length + 7) / 8 + 1, 0));
+            char* out(&data.m_data.back()[0]);
+            for (size_t i=0; i<length; ++i, ++values)
+            {
+                if (*values)
+                {
+                    out[i / 8] |= static_cast<char>(1 << (i % 8));
+                }
+            }
+            data.m_buffers.push_back(nullptr);
+            data.m_buffers.push_back(out);
+        }
+
+        template <typename Offset>
+        void export_strings(const data_table_column_base& column, exported_array& data)
+        {
+            const size_t length(column.size());
+            column_traits<variant_base::String>::const_iterator values(column.begin<variant_base::String>());
+
+            data.m_data.push_back(std::vector<char>((length + 1) * sizeof(Offset)));
+            Offset* offsets(reinterpret_cast<Offset*>(&data.m_data.back()[0]));
+            offsets[0] = 0;
+            for (size_t i=0; i<length; ++i)
+            {
+                offsets[i + 1] = offsets[i] + static_cast<Offset>(values[i].size());
+            }
+
+            data.m_data.push_back(std::vector<char>(std::max<size_t>(static_cast<size_t>(offsets[length]), 1)));
+            char* text(&data.m_data.back()[0]);
+            for (size_t i=0; i<length; ++i)
+            {
+                std::memcpy(text + offsets[i], values[i].value(), values[i].size());
+            }
+
+            data.m_buffers.push_back(nullptr);
+            data.m_buffers.push_back(offsets);
+            data.m_buffers.push_back(text);
+        }
+
+        boost::int32_t date_to_arrow(const boost::gregorian::date& value)
+        {
+            return static_cast<boost::int32_t>((value - s_epoch_date).days());
+        }
+
+        boost::int64_t time_to_arrow(const boost::posix_time::time_duration& value)
+        {
+            return value.total_microseconds();
+        }
+
+        boost::int64_t date_time_to_arrow(const boost::posix_time::ptime& value)
+        {
+            return (value - s_epoch).total_microseconds();
+        }
+
+        template <variant_base::enum_type_t E>
+        void export_shared(const data_table_column_base& column, exported_array& data)
+        {
+            data.m_buffers.push_back(nullptr);
+            data.m_buffers.push_back(column.empty() ? nullptr : &*column.begin<E>());
+        }
+
+        // Fills 'data' with the buffers of 'column' and returns its Arrow format
+        std::string export_column(const data_table_column_base& column, exported_array& data)
+        {
+            switch (column.type())
+            {
+                case variant_base::Boolean:
+                    export_bitmap(column.begin<variant_base::Boolean>(), column.size(), data);
+                    return "b";
+                case variant_base::Int32:
+                    export_shared<variant_base::Int32>(column, data);
+                    return "i";
+                case variant_base::UInt32:
+                    export_shared<variant_base::UInt32>(column, data);
+                    return "I";
+                case variant_base::Int64:
+                    export_shared<variant_base::Int64>(column, data);
+                    return "l";
+                case variant_base::UInt64:
+                    export_shared<variant_base::UInt64>(column, data);
+                    return "L";
+                case variant_base::Float:
+                    export_shared<variant_base::Float>(column, data);
+                    return "f";
+                case variant_base::Double:
+                    export_shared<variant_base::Double>(column, data);
+                    return "g";
+                case variant_base::Date:
+                    export_converted<boost::int32_t>(column.begin<variant_base::Date>(), column.size(), &date_to_arrow, data);
+                    return "tdD";
+                case variant_base::Time:
+                    export_converted<boost::int64_t>(column.begin<variant_base::Time>(), column.size(), &time_to_arrow, data);
+                    return "tDu";
+                case variant_base::DateTime:
+                    export_converted<boost::int64_t>(column.begin<variant_base::DateTime>(), column.size(), &date_time_to_arrow, data);
+                    return "tsu:";
+                case variant_base::String:
+                {
+                    size_t total(0);
+                    for (column_traits<variant_base::String>::const_iterator itr(column.begin<variant_base::String>()), end(column.end<variant_base::String>()); itr!=end; ++itr)
+                    {
+                        total += itr->size();
+                    }
+                    if (total>static_cast<size_t>(std::numeric_limits<boost::int32_t>::max()))
+                    {
+                        export_strings<boost::int64_t>(column, data);
+                        return "U";
+                    }
+                    export_strings<boost::int32_t>(column, data);
+                    return "u";
+                }
+                default:
+                    boost::throw_exception(variant_error(boost::str(boost::format("Column '%s' of type %s cannot be exported to Arrow")
+                        % column.name()
+                        % variant_base::enum_to_string(column.type()))));
+            }
+            return std::string();
+        }
+
+        template <typename T>
+        struct array_value
+        {
+            T operator()(const variant_cref& value) const
+            {
+                return value.as<T>();
+            }
+        };
+
+        std::string export_typed_array(const typed_array& values, exported_array& data)
+        {
+            switch (values.type())
+            {
+                case variant_base::Boolean:
+                {
+                    std::vector<bool> bits;
+                    for (size_t i=0; i<values.size(); ++i)
+                    {
+                        bits.push_back(values[i].as<bool>());
+                    }
+                    export_bitmap(bits.begin(), bits.size(), data);
+                    return "b";
+                }
+                case variant_base::Int32:
+                    export_converted<boost::int32_t>(values.begin(), values.size(), array_value<boost::int32_t>(), data);
+                    return "i";
+                case variant_base::UInt32:
+                    export_converted<boost::uint32_t>(values.begin(), values.size(), array_value<boost::uint32_t>(), data);
+                    return "I";
+                case variant_base::Int64:
+                    export_converted<boost::int64_t>(values.begin(), values.size(), array_value<boost::int64_t>(), data);
+                    return "l";
+                case variant_base::UInt64:
+                    export_converted<boost::uint64_t>(values.begin(), values.size(), array_value<boost::uint64_t>(), data);
+                    return "L";
+                case variant_base::Float:
+                    export_converted<float>(values.begin(), values.size(), array_value<float>(), data);
+                    return "f";
+                case variant_base::Double:
+                    export_converted<double>(values.begin(), values.size(), array_value<double>(), data);
+                    return "g";
+                default:
+                    boost::throw_exception(variant_error("Array of " + variant_base::enum_to_string(values.type()) + " cannot be exported to Arrow"));
+            }
+            return std::string();
+        }
+
+        /* Import of the values of an array, into a column */
+        /***************************************************/
+        bool is_valid(const ArrowArray& array, size_t offset, size_t i)
+        {
+            const boost::uint8_t* validity(array.null_count!=0 && array.n_buffers>0 ? static_cast<const boost::uint8_t*>(array.buffers[0]) : nullptr);
+            const size_t bit(offset + static_cast<size_t>(array.offset) + i);
+            return validity==nullptr || (validity[bit / 8] & (1 << (bit % 8)))!=0;
+        }
+
+        template <variant_base::enum_type_t E, typename S, typename Convert>
+        void import_converted(const ArrowArray& array, size_t offset, size_t length, Convert convert, data_table_column_base& column)
+        {
+            const S* values(static_cast<const S*>(array.buffers[1]) + static_cast<size_t>(array.offset) + offset);
+
+            const size_t first(column.size());
+            column.resize(first + length);
+            typename column_traits<E>::iterator out(column.begin<E>() + first);
+            for (size_t i=0; i<length; ++i)
+            {
+                if (is_valid(array, offset, i))
+                {
+                    out[i] = convert(values[i]);
+                }
+            }
+        }
+
+        template <variant_base::enum_type_t E>
+        void import_values(const ArrowArray& array, size_t offset, size_t length, data_table_column_base& column)
+        {
+            typedef typename column_traits<E>::value_type value_type;
+
+            if (array.null_count==0)
+            {
+                const value_type* values(static_cast<const value_type*>(array.buffers[1]) + static_cast<size_t>(array.offset) + offset);
+                column.append<E>(values, length);
+            }
+            else
+            {
+                import_converted<E, value_type>(array, offset, length, [](const value_type& value) { return value; }, column);
+            }
+        }
+
+        void import_bitmap(const ArrowArray& array, size_t offset, size_t length, data_table_column_base& column)
+        {
+            const boost::uint8_t* bits(static_cast<const boost::uint8_t*>(array.buffers[1]));
+
+            const size_t first(column.size());
+            column.resize(first + length);
+            column_traits<variant_base::Boolean>::iterator out(column.begin<variant_base::Boolean>() + first);
+            for (size_t i=0; i<length; ++i)
+            {
+                const size_t bit(offset + static_cast<size_t>(array.offset) + i);
+                out[i] = is_valid(array, offset, i) && (bits[bit / 8] & (1 << (bit % 8)))!=0;
+            }
+        }
+
+        template <typename Offset>
+        void import_strings(const ArrowArray& array, size_t offset, size_t length, data_table_column_base& column)
+        {
+            const Offset* offsets(static_cast<const Offset*>(array.buffers[1]) + static_cast<size_t>(array.offset) + offset);
+            const char* text(static_cast<const char*>(array.buffers[2]));
+
+            column.reserve(column.size() + length);
+            for (size_t i=0; i<length; ++i)
+            {
+                if (is_valid(array, offset, i))
+                {
+                    column.push_back(detail::string(text + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i])));
+                }
+                else
+                {
+                    column.push_back(detail::string());
+                }
+            }
+        }
+
+        // Microseconds in a count of the unit of a timestamp, duration or time format
+        boost::int64_t to_microseconds(boost::int64_t value, char unit)
+        {
+            switch (unit)
+            {
+                case 's':   return value * 1000000;
+                case 'm':   return value * 1000;
+                case 'u':   return value;
+                case 'n':   return value / 1000;
+                default:
+                    boost::throw_exception(variant_error(std::string("Arrow time unit '") + unit + "' is not supported"));
+            }
+            return 0;
+        }
+
+        // Type of column for an Arrow format, None if not supported
+        variant_base::enum_type_t import_type(const std::string& format)
+        {
+            if (format=="b")                                    return variant_base::Boolean;
+            if (format=="c" || format=="s" || format=="i")      return variant_base::Int32;
+            if (format=="C" || format=="S" || format=="I")      return variant_base::UInt32;
+            if (format=="l")                                    return variant_base::Int64;
+            if (format=="L")                                    return variant_base::UInt64;
+            if (format=="f")                                    return variant_base::Float;
+            if (format=="g")                                    return variant_base::Double;
+            if (format=="tdD")                                  return variant_base::Date;
+            if (format.size()>=4 && format.compare(0, 2, "ts")==0 && format[3]==':')
+                                                                return variant_base::DateTime;
+            if (format.size()==3 && (format.compare(0, 2, "tD")==0 || format.compare(0, 2, "tt")==0))
+                                                                return variant_base::Time;
+            if (format=="u" || format=="U")                     return variant_base::String;
+            return variant_base::None;
+        }
+
+        void import_column(const ArrowArray& array, const std::string& format, size_t offset, size_t length, data_table_column_base& column)
+        {
+            if (array.dictionary!=nullptr)
+            {
+                boost::throw_exception(variant_error("Dictionary-encoded Arrow arrays are not supported"));
+            }
+
+            switch (column.type())
+            {
+                case variant_base::Boolean:
+                    import_bitmap(array, offset, length, column);
+                    break;
+                case variant_base::Int32:
+                    if (format=="c")
+                        import_converted<variant_base::Int32, boost::int8_t>(array, offset, length, [](boost::int8_t value) { return static_cast<boost::int32_t>(value); }, column);
+                    else if (format=="s")
+                        import_converted<variant_base::Int32, boost::int16_t>(array, offset, length, [](boost::int16_t value) { return static_cast<boost::int32_t>(value); }, column);
+                    else
+                        import_values<variant_base::Int32>(array, offset, length, column);
+                    break;
+                case variant_base::UInt32:
+                    if (format=="C")
+                        import_converted<variant_base::UInt32, boost::uint8_t>(array, offset, length, [](boost::uint8_t value) { return static_cast<boost::uint32_t>(value); }, column);
+                    else if (format=="S")
+                        import_converted<variant_base::UInt32, boost::uint16_t>(array, offset, length, [](boost::uint16_t value) { return static_cast<boost::uint32_t>(value); }, column);
+                    else
+                        import_values<variant_base::UInt32>(array, offset, length, column);
+                    break;
+                case variant_base::Int64:
+                    import_values<variant_base::Int64>(array, offset, length, column);
+                    break;
+                case variant_base::UInt64:
+                    import_values<variant_base::UInt64>(array, offset, length, column);
+                    break;
+                case variant_base::Float:
+                    import_values<variant_base::Float>(array, offset, length, column);
+                    break;
+                case variant_base::Double:
+                    import_values<variant_base::Double>(array, offset, length, column);
+                    break;
+                case variant_base::Date:
+                    import_converted<variant_base::Date, boost::int32_t>(array, offset, length, [](boost::int32_t value) { return s_epoch_date + boost::gregorian::days(value); }, column);
+                    break;
+                case variant_base::DateTime:
+                {
+                    const char unit(format[2]);
+                    import_converted<variant_base::DateTime, boost::int64_t>(array, offset, length, [unit](boost::int64_t value) { return s_epoch + boost::posix_time::microseconds(to_microseconds(value, unit)); }, column);
+                    break;
+                }
+                case variant_base::Time:
+                {
+                    const char unit(format[2]);
+                    if (format[1]=='t' && (unit=='s' || unit=='m'))
+                        import_converted<variant_base::Time, boost::int32_t>(array, offset, length, [unit](boost::int32_t value) { return boost::posix_time::microseconds(to_microseconds(value, unit)); }, column);
+                    else
+                        import_converted<variant_base::Time, boost::int64_t>(array, offset, length, [unit](boost::int64_t value) { return boost::posix_time::microseconds(to_microseconds(value, unit)); }, column);
+                    break;
+                }
+                case variant_base::String:
+                    if (format=="u")
+                        import_strings<boost::int32_t>(array, offset, length, column);
+                    else
+                        import_strings<boost::int64_t>(array, offset, length, column);
+                    break;
+                default:
+                    boost::throw_exception(variant_error("Case exhaustion: " + variant_base::enum_to_string(column.type())));
+            }
+        }
+
+        variant_base::enum_type_t checked_import_type(const ArrowSchema& schema)
+        {
+            const std::string format(schema.format);
+            const variant_base::enum_type_t type(import_type(format));
+            if (type==variant_base::None)
+            {
+                boost::throw_exception(variant_error("Arrow format '" + format + "' is not supported"));
+            }
+            return type;
+        }
+
+        variant import_value(const ArrowArray& array, const ArrowSchema& schema)
+        {
+            const std::string format(schema.format);
+            if (format=="+s")
+            {
+                variant result(variant::DataTable);
+                for (int64_t c=0; c<schema.n_children; ++c)
+                {
+                    const ArrowSchema& child(*schema.children[c]);
+                    result.add_column(checked_import_type(child), child.name!=nullptr ? std::string(child.name) : std::string());
+                }
+                for (int64_t c=0; c<schema.n_children; ++c)
+                {
+                    import_column(*array.children[c], schema.children[c]->format, static_cast<size_t>(array.offset), static_cast<size_t>(array.length), result.columns()[static_cast<size_t>(c)]);
+                }
+                return result;
+            }
+
+            const variant_base::enum_type_t type(checked_import_type(schema));
+            if ((type & variant_base::Number)==0)
+            {
+                boost::throw_exception(variant_error("Arrow format '" + format + "' cannot be imported as an array"));
+            }
+
+            variant column_table(variant::DataTable);
+            column_table.add_column(type, std::string());
+            data_table_column_base& column(column_table.columns()[0]);
+            import_column(array, format, 0, static_cast<size_t>(array.length), column);
+
+            const size_t length(column.size());
+            typed_array values(length, type);
+            switch (type)
+            {
+                #define ARRAY_VALUES(E)                                                          \
+                    case E:                                                                      \
+                        for (size_t i=0; i<length; ++i)                                          \
+                        {                                                                        \
+                            values[i] = static_cast<column_traits<E>::value_type>(column.begin<E>()[i]); \
+                        }                                                                        \
+                        break;
+
+                ARRAY_VALUES(variant_base::Boolean)
+                ARRAY_VALUES(variant_base::Int32)
+                ARRAY_VALUES(variant_base::UInt32)
+                ARRAY_VALUES(variant_base::Int64)
+                ARRAY_VALUES(variant_base::UInt64)
+                ARRAY_VALUES(variant_base::Float)
+                ARRAY_VALUES(variant_base::Double)
+
+                #undef ARRAY_VALUES
+
+                default:
+                    boost::throw_exception(variant_error("Case exhaustion: " + variant_base::enum_to_string(type)));
+            }
+            return variant(values);
+        }
+
+    } // namespace
+
+    void export_arrow(const boost::shared_ptr<const variant>& value, ArrowArray* array, ArrowSchema* schema)
+    {
+        exported_array* array_data(new exported_array);
+        exported_schema* schema_data(new exported_schema);
+        try
+        {
+            array_data->m_owner = value;
+
+            if (value->is<variant::DataTable>())
+            {
+                const variant::column_collection_t& columns(value->columns());
+
+                array_data->m_buffers.push_back(nullptr);
+                array_data->m_children.resize(columns.size());
+                schema_data->m_format = "+s";
+                schema_data->m_children.resize(columns.size());
+
+                for (size_t c=0; c<columns.size(); ++c)
+                {
+                    // children hold on to the table too, as they may be moved out of the parent
+                    exported_array* child_array(new exported_array);
+                    std::string format;
+                    try
+                    {
+                        child_array->m_owner = value;
+                        format = export_column(columns[c], *child_array);
+                    }
+                    catch (...)
+                    {
+                        delete child_array;
+                        throw;
+                    }
+                    init_array(&array_data->m_children[c], columns[c].size(), child_array);
+
+                    exported_schema* child_schema(new exported_schema);
+                    child_schema->m_format = format;
+                    child_schema->m_name = columns[c].name();
+                    init_schema(&schema_data->m_children[c], child_schema);
+                }
+
+                init_array(array, value->size(), array_data);
+            }
+            else if (value->is<variant::Array>())
+            {
+                const typed_array& values(value->as<typed_array>());
+                schema_data->m_format = export_typed_array(values, *array_data);
+                init_array(array, values.size(), array_data);
+            }
+            else
+            {
+                boost::throw_exception(variant_error("Attempt to export " + variant::enum_to_string(value->type()) + " to Arrow"));
+            }
+        }
+        catch (...)
+        {
+            for (size_t i=0; i<array_data->m_children.size(); ++i)
+            {
+                if (array_data->m_children[i].release!=nullptr)
+                {
+                    array_data->m_children[i].release(&array_data->m_children[i]);
+                }
+            }
+            for (size_t i=0; i<schema_data->m_children.size(); ++i)
+            {
+                if (schema_data->m_children[i].release!=nullptr)
+                {
+                    schema_data->m_children[i].release(&schema_data->m_children[i]);
+                }
+            }
+            delete array_data;
+            delete schema_data;
+            throw;
+        }
+        init_schema(schema, schema_data);
+    }
+
+    variant import_arrow(ArrowArray* array, ArrowSchema* schema)
+    {
+        if (array->release==nullptr || schema->release==nullptr)
+        {
+            boost::throw_exception(variant_error("Attempt to import a released Arrow array"));
+        }
+
+        variant result;
+        try
+        {
+            result = import_value(*array, *schema);
+        }
+        catch (...)
+        {
+            array->release(array);
+            schema->release(schema);
+            throw;
+        }
+
+        array->release(array);
+        schema->release(schema);
+        return result;
+    }
+
+} // namespace protean
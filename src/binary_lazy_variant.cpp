@@ -0,0 +1,449 @@
+#include <protean/binary_lazy_variant.hpp>
+#include <protean/binary_reader.hpp>
+#include <protean/detail/binary_skipper.hpp>
+#include <protean/detail/block_compression.hpp>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/make_shared.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace protean {
+
+    struct binary_lazy_variant::document
+    {
+        std::vector<char>   m_data;
+        boost::uint16_t     m_major_version;
+        int                 m_writer_mode;
+        bool                m_compact;
+        bool                m_subtree_lengths;
+    };
+
+    /* Walks the encoding of a document in memory, see binary_writer */
+    /*****************************************************************/
+    class binary_lazy_variant::cursor
+    {
+    public:
+        cursor(const document& doc, size_t offset) :
+            m_document(doc),
+            m_offset(offset)
+        {
+        }
+
+        size_t offset() const
+        {
+            return m_offset;
+        }
+
+        void skip_bytes(boost::uint64_t length)
+        {
+            if (length>m_document.m_data.size() - m_offset)
+            {
+                boost::throw_exception(variant_error("Unexpected end of binary data"));
+            }
+            m_offset += static_cast<size_t>(length);
+        }
+
+        // strings and buffers are padded to 4 bytes in version 1
+        void skip_padded(size_t length)
+        {
+            skip_bytes(m_document.m_compact ? length : length + (4 - (length % 4)) % 4);
+        }
+
+        void read_bytes(char* value, size_t length)
+        {
+            const size_t offset(m_offset);
+            skip_bytes(length);
+            std::memcpy(value, &m_document.m_data[offset], length);
+        }
+
+        boost::uint64_t read_varint()
+        {
+            boost::uint64_t value(0);
+            for (int shift=0; shift<64; shift+=7)
+            {
+                char byte;
+                read_bytes(&byte, 1);
+
+                value |= static_cast<boost::uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80)==0)
+                {
+                    return value;
+                }
+            }
+            boost::throw_exception(variant_error("Invalid varint, binary data is corrupt"));
+        }
+
+        // 32-bit word in version 1, varint in version 2
+        boost::uint64_t read_word()
+        {
+            if (m_document.m_compact)
+            {
+                return read_varint();
+            }
+            boost::uint32_t value;
+            read_bytes(reinterpret_cast<char*>(&value), sizeof(value));
+            return value;
+        }
+
+        boost::uint64_t read_uint64()
+        {
+            boost::uint64_t value;
+            read_bytes(reinterpret_cast<char*>(&value), sizeof(value));
+            return value;
+        }
+
+        boost::int64_t read_int32()
+        {
+            if (m_document.m_compact)
+            {
+                // zigzag
+                const boost::uint64_t value(read_varint());
+                return static_cast<boost::int64_t>(value >> 1) ^ -static_cast<boost::int64_t>(value & 1);
+            }
+            boost::int32_t value;
+            read_bytes(reinterpret_cast<char*>(&value), sizeof(value));
+            return value;
+        }
+
+        size_t read_size()
+        {
+            boost::uint64_t value(read_word());
+            if (!m_document.m_compact && value==binary_large_size_marker && (m_document.m_writer_mode & binary_mode::LargeSizes)!=0)
+            {
+                read_bytes(reinterpret_cast<char*>(&value), sizeof(value));
+            }
+            if (value>m_document.m_data.size())
+            {
+                boost::throw_exception(variant_error("Size exceeds the length of the binary data, data is corrupt"));
+            }
+            return static_cast<size_t>(value);
+        }
+
+        variant::enum_type_t read_type()
+        {
+            return static_cast<variant::enum_type_t>(read_word());
+        }
+
+        std::string read_string()
+        {
+            const size_t length(read_size());
+            const size_t offset(m_offset);
+            skip_padded(length);
+            return std::string(&m_document.m_data[0] + offset, length);
+        }
+
+        void skip_string()
+        {
+            skip_padded(read_size());
+        }
+
+        // String values and keys go through no string table, see binary_lazy_variant()
+        void skip_key()
+        {
+            skip_string();
+        }
+
+        void skip_string_value()
+        {
+            skip_string();
+        }
+
+        void skip_value(variant::enum_type_t type)
+        {
+            detail::binary_skipper<cursor>(*this, m_document.m_writer_mode, m_document.m_compact, m_document.m_subtree_lengths).skip_value(type);
+        }
+
+    private:
+        const document& m_document;
+        size_t          m_offset;
+    };
+
+    binary_lazy_variant::binary_lazy_variant(std::istream& is) :
+        m_factory(nullptr),
+        m_type(variant::None),
+        m_offset(0)
+    {
+        if (!is.good())
+        {
+            boost::throw_exception(variant_error("Input stream is bad"));
+        }
+
+        // [13 FF 48 49][MAJOR MINOR][MODE]
+        boost::uint32_t header[3];
+        if (!is.read(reinterpret_cast<char*>(header), sizeof(header)))
+        {
+            boost::throw_exception(variant_error("Error reading header from stream"));
+        }
+
+        if (header[0]!=binary_magic_number)
+        {
+            boost::throw_exception(variant_error("Bad magic number, this looks like invalid binary data"));
+        }
+
+        boost::shared_ptr<document> doc(boost::make_shared<document>());
+        doc->m_major_version = static_cast<boost::uint16_t>((header[1] >> 16) & 0x0000FFFF);
+        doc->m_writer_mode = static_cast<int>(header[2]);
+        doc->m_compact = doc->m_major_version>=2;
+        doc->m_subtree_lengths = (doc->m_writer_mode & binary_mode::SubtreeLengths)!=0;
+
+        if (doc->m_major_version>binary_major_version)
+        {
+            boost::throw_exception(variant_error((boost::format("Version of received binary data is not compatible, received version %d > this version %d")
+                % static_cast<int>(doc->m_major_version)
+                % static_cast<int>(binary_major_version)
+            ).str()));
+        }
+
+        if ((doc->m_writer_mode & (binary_mode::StringTable | binary_mode::StringTableValues))!=0)
+        {
+            boost::throw_exception(variant_error("Binary data written with a string table cannot be decoded lazily"));
+        }
+
+        // read the remainder of the document into memory
+        boost::iostreams::filtering_istream filter;
+        const bool zlib_no_header((doc->m_writer_mode & binary_mode::ZlibHeader)==0);
+        if ((doc->m_writer_mode & binary_mode::BlockCompress)!=0)
+        {
+            filter.push(detail::block_decompressor(zlib_no_header));
+        }
+        else if ((doc->m_writer_mode & binary_mode::Compress)!=0)
+        {
+            filter.push(boost::iostreams::zlib_decompressor(binary_compression_params(zlib_no_header)));
+        }
+        filter.push(is);
+
+        char buffer[64 * 1024];
+        while (filter.read(buffer, sizeof(buffer)) || filter.gcount()>0)
+        {
+            doc->m_data.insert(doc->m_data.end(), buffer, buffer + filter.gcount());
+        }
+
+        cursor c(*doc, 0);
+        m_type = c.read_type();
+        m_offset = c.offset();
+
+        m_document = doc;
+    }
+
+    binary_lazy_variant::binary_lazy_variant(const boost::shared_ptr<const document>& doc, object_factory* factory, variant::enum_type_t type, size_t offset) :
+        m_document(doc),
+        m_factory(factory),
+        m_type(type),
+        m_offset(offset)
+    {
+    }
+
+    binary_lazy_variant::binary_lazy_variant(const boost::shared_ptr<const document>& doc, object_factory* factory, const variant& value) :
+        m_document(doc),
+        m_factory(factory),
+        m_type(value.type()),
+        m_offset(0),
+        m_value(boost::make_shared<variant>(value))
+    {
+    }
+
+    variant::enum_type_t binary_lazy_variant::type() const
+    {
+        return m_type;
+    }
+
+    size_t binary_lazy_variant::size() const
+    {
+        if (m_value)
+        {
+            return m_value->size();
+        }
+
+        switch (m_type)
+        {
+            case variant::Dictionary:
+            case variant::Bag:
+            case variant::List:
+            case variant::Tuple:
+            case variant::TimeSeries:
+            case variant::Array:
+            case variant::DataTable:
+            {
+                cursor c(*m_document, m_offset);
+                if (m_document->m_subtree_lengths)
+                {
+                    c.read_uint64();
+                }
+
+                if (m_type==variant::DataTable)
+                {
+                    // [COLUMNS][ROWS]
+                    c.read_size();
+                }
+                return c.read_size();
+            }
+            default:
+                return value().size();
+        }
+    }
+
+    bool binary_lazy_variant::has_key(const std::string& key) const
+    {
+        if (m_value)
+        {
+            return m_value->has_key(key);
+        }
+
+        variant::enum_type_t type;
+        size_t offset;
+        return find(key, type, offset);
+    }
+
+    binary_lazy_variant binary_lazy_variant::operator[](const std::string& key) const
+    {
+        if (m_value)
+        {
+            return binary_lazy_variant(m_document, m_factory, (*m_value)[key]);
+        }
+
+        variant::enum_type_t type;
+        size_t offset;
+        if (!find(key, type, offset))
+        {
+            boost::throw_exception(variant_error("Key '" + key + "' not found"));
+        }
+        return binary_lazy_variant(m_document, m_factory, type, offset);
+    }
+
+    binary_lazy_variant binary_lazy_variant::operator[](size_t n) const
+    {
+        if (m_value)
+        {
+            return binary_lazy_variant(m_document, m_factory, (*m_value)[n]);
+        }
+
+        if ((m_type & variant::Sequence)==0)
+        {
+            boost::throw_exception(variant_error("Attempt to index " + variant::enum_to_string(m_type) + " by position"));
+        }
+
+        if (m_type==variant::List && (m_document->m_writer_mode & binary_mode::ShapedLists)!=0)
+        {
+            // items of shaped lists cannot be decoded on their own
+            return binary_lazy_variant(m_document, m_factory, value()[n]);
+        }
+
+        cursor c(*m_document, m_offset);
+        if (m_document->m_subtree_lengths)
+        {
+            c.read_uint64();
+        }
+
+        const size_t size(c.read_size());
+        if (n>=size)
+        {
+            boost::throw_exception(variant_error((boost::format("Index %u is out of range for %s of size %u") % n % variant::enum_to_string(m_type) % size).str()));
+        }
+
+        for (size_t i=0; i<n; ++i)
+        {
+            c.skip_value(c.read_type());
+        }
+
+        const variant::enum_type_t type(c.read_type());
+        return binary_lazy_variant(m_document, m_factory, type, c.offset());
+    }
+
+    variant binary_lazy_variant::value() const
+    {
+        if (m_value)
+        {
+            return *m_value;
+        }
+
+        const std::vector<char>& data(m_document->m_data);
+        boost::iostreams::stream<boost::iostreams::array_source> is(&data[0] + m_offset, data.size() - m_offset);
+
+        binary_reader reader(is);
+        if (m_factory!=nullptr)
+        {
+            reader.set_factory(*m_factory);
+        }
+
+        // the document is already decompressed
+        reader.setup(m_document->m_major_version, m_document->m_writer_mode & ~(binary_mode::Compress | binary_mode::BlockCompress));
+
+        variant result;
+        reader.read_value(m_type, result);
+        reader.close();
+
+        return result;
+    }
+
+    void binary_lazy_variant::set_factory(object_factory& factory)
+    {
+        m_factory = &factory;
+    }
+
+    bool binary_lazy_variant::find(const std::string& key, variant::enum_type_t& type, size_t& offset) const
+    {
+        if ((m_type & variant::Mapping)==0)
+        {
+            boost::throw_exception(variant_error("Attempt to look up key '" + key + "' in " + variant::enum_to_string(m_type)));
+        }
+
+        cursor c(*m_document, m_offset);
+        if (m_document->m_subtree_lengths)
+        {
+            c.read_uint64();
+        }
+
+        const size_t size(c.read_size());
+
+        if (m_document->m_subtree_lengths && m_type==variant::Dictionary && size>=binary_dictionary_index_threshold)
+        {
+            // binary search of the entry offsets, entries are in key order
+            const size_t index(c.offset());
+            const size_t entries(index + size * sizeof(boost::uint64_t));
+
+            size_t first(0), last(size);
+            while (first<last)
+            {
+                const size_t middle(first + (last - first) / 2);
+
+                cursor entry_offset(*m_document, index + middle * sizeof(boost::uint64_t));
+                cursor e(*m_document, entries + static_cast<size_t>(entry_offset.read_uint64()));
+
+                const int comparison(e.read_string().compare(key));
+                if (comparison==0)
+                {
+                    type = e.read_type();
+                    offset = e.offset();
+                    return true;
+                }
+                else if (comparison<0)
+                {
+                    first = middle + 1;
+                }
+                else
+                {
+                    last = middle;
+                }
+            }
+            return false;
+        }
+
+        for (size_t i=0; i<size; ++i)
+        {
+            const bool match(c.read_string()==key);
+            const variant::enum_type_t child_type(c.read_type());
+            if (match)
+            {
+                type = child_type;
+                offset = c.offset();
+                return true;
+            }
+            c.skip_value(child_type);
+        }
+        return false;
+    }
+
+} // namespace protean
@@ -9,17 +9,106 @@
 #include <protean/variant_base.hpp>
 #include <protean/detail/data_table.hpp>
 #include <protean/detail/data_table_column_serializers.hpp>
+#include <protean/detail/binary_skipper.hpp>
+#include <protean/detail/block_compression.hpp>
+#include <protean/detail/thread_pool.hpp>
+#include <protean/detail/string_dictionary.hpp>
+#include <protean/detail/string_arena.hpp>
 
 #include <boost/foreach.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/scoped_array.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/regex.hpp>
+
+#include <map>
+#include <set>
+
+#include <limits>
 
 namespace protean {
+
+    /* A tree of projection paths, see set_projection */
+    /**************************************************/
+    struct binary_reader::projection
+    {
+        typedef std::map<std::string, boost::shared_ptr<projection> > children_t;
+
+        projection() :
+            m_all(false)
+        {
+        }
+
+        // the whole value is wanted
+        bool                            m_all;
+
+        children_t                      m_children;
+        boost::shared_ptr<projection>   m_any;
+
+        const projection* find(const std::string& key) const
+        {
+            children_t::const_iterator citr(m_children.find(key));
+            return citr!=m_children.end() ? citr->second.get() : m_any.get();
+        }
+
+        void merge(const projection& rhs)
+        {
+            m_all = m_all || rhs.m_all;
+
+            BOOST_FOREACH(const children_t::value_type& child, rhs.m_children)
+            {
+                boost::shared_ptr<projection>& node(m_children[child.first]);
+                if (!node)
+                {
+                    node = boost::make_shared<projection>();
+                }
+                node->merge(*child.second);
+            }
+
+            if (rhs.m_any)
+            {
+                if (!m_any)
+                {
+                    m_any = boost::make_shared<projection>();
+                }
+                m_any->merge(*rhs.m_any);
+            }
+        }
+
+        // A key named in one path is also matched by '*' in another, so fold the
+        // wildcard into named children to leave one node to follow per key
+        void normalise()
+        {
+            BOOST_FOREACH(children_t::value_type& child, m_children)
+            {
+                if (m_any)
+                {
+                    child.second->merge(*m_any);
+                }
+                child.second->normalise();
+            }
+
+            if (m_any)
+            {
+                m_any->normalise();
+            }
+        }
+    };
+
+    static inline boost::int64_t zigzag_decode(boost::uint64_t value)
+    {
+        return static_cast<boost::int64_t>(value >> 1) ^ -static_cast<boost::int64_t>(value & 1);
+    }
     
     binary_reader::binary_reader(std::istream &is, int mode) :
         m_is(is),
         m_mode(mode),
-        m_factory(nullptr)
+        m_factory(nullptr),
+        m_compact(false),
+        m_subtree_lengths(false),
+        m_recycled_top(0)
     {
     }
 
@@ -29,6 +118,17 @@ namespace protean {
     }
 
     void binary_reader::read_value(variant::enum_type_t type, variant& value)
+    {
+        if (m_subtree_lengths && (type & (variant::Collection | variant::Array))!=0)
+        {
+            // [LENGTH][CONTENT], the length is only needed to skip the subtree
+            boost::uint64_t length;
+            read_bytes(reinterpret_cast<char*>(&length), sizeof(length));
+        }
+        read_content(type, value);
+    }
+
+    void binary_reader::read_content(variant::enum_type_t type, variant& value)
     {
         switch( type )
         {
@@ -40,8 +140,15 @@ namespace protean {
             }
             case variant::String:
             {
-                std::string s;
-                read( s ); value = s;
+                const std::string& s(read_string());
+                if (recycle(type, value))
+                {
+                    value.m_value.get<variant::String>().assign(s.c_str(), s.size());
+                }
+                else
+                {
+                    value = s;
+                }
                 break;
             }
             case variant::Int32:
@@ -104,15 +211,37 @@ namespace protean {
             case variant::Dictionary:
             case variant::Bag:
             {
-                value = variant( static_cast<variant::enum_type_t>(type) );
-                boost::uint32_t size; read( size );
+                const bool recycled(type==variant::Dictionary && recycle(type, value));
+                if (!recycled)
+                {
+                    value = variant( static_cast<variant::enum_type_t>(type) );
+                }
+                const size_t size(read_size());
+
+                if (m_subtree_lengths && type==variant::Dictionary && size>=binary_dictionary_index_threshold)
+                {
+                    // entry offsets, only needed for lookup without decoding
+                    const std::streamsize length(static_cast<std::streamsize>(size * sizeof(boost::uint64_t)));
+                    if (!m_filter.ignore(length) || m_filter.gcount()!=length)
+                    {
+                        boost::throw_exception(variant_error("Error reading from stream"));
+                    }
+                }
 
-                for (boost::uint32_t i=0; i<size; ++i)
+                if (recycled)
                 {
-                    std::string name;
-                    read(name);
+                    const size_t first(m_recycled_top);
+                    for (size_t i=0; i<size; ++i)
+                    {
+                        read(recycle_entry(value, read_key()));
+                    }
+                    remove_stale_entries(value, first);
+                    break;
+                }
 
-                    variant &val = value.insert(name, variant(), variant::ReturnItem);
+                for (size_t i=0; i<size; ++i)
+                {
+                    variant &val = value.insert(read_key(), variant(), variant::ReturnItem);
                     read( val );
                 }
                 break;
@@ -120,11 +249,31 @@ namespace protean {
             case variant::List:
             case variant::Tuple:
             {
-                boost::uint32_t size;
-                read(size);
-                value = variant(static_cast<variant::enum_type_t>(type), size);
+                const size_t size(read_size());
+                if (recycle(type, value) && (type==variant::List || value.size()==size))
+                {
+                    // keep the items that are there, they are read into below
+                    while (value.size()>size)
+                    {
+                        value.pop_back();
+                    }
+                    while (value.size()<size)
+                    {
+                        value.push_back(variant());
+                    }
+                }
+                else
+                {
+                    value = variant(static_cast<variant::enum_type_t>(type), size);
+                }
+
+                if (type==variant::List && (m_writer_mode & binary_mode::ShapedLists)!=0)
+                {
+                    read_shaped_list(value);
+                    break;
+                }
 
-                for (boost::uint32_t i=0; i<size; ++i)
+                for (size_t i=0; i<size; ++i)
                 {
                     read(value[i]);
                 }
@@ -132,8 +281,7 @@ namespace protean {
             }
             case variant::Buffer:
             {
-                boost::uint32_t size;
-                read(size);
+                const size_t size(read_size());
 
                 value = variant(variant::Buffer, size);
                 void* data = (void*)value.as<void*>();
@@ -144,23 +292,34 @@ namespace protean {
             case variant::TimeSeries:
             {
                 value = variant(static_cast<variant::enum_type_t>(type));
-                boost::uint32_t size; read(size);
+                const size_t size(read_size());
 
-                for (boost::uint32_t i=0; i<size; ++i)
+                variant number;
+                for (size_t i=0; i<size; ++i)
                 {
                     variant::date_time_t date_time;
                     read(date_time);
 
-                    variant &val = value.push_back(date_time, variant(), variant::ReturnItem);
-                    read(val);
+                    boost::uint32_t child_type;
+                    read(child_type);
+
+                    // numbers are appended to the unboxed values, others read in place
+                    if ((child_type & variant::Number)!=0)
+                    {
+                        read_value(static_cast<variant::enum_type_t>(child_type), number);
+                        value.push_back(date_time, number);
+                    }
+                    else
+                    {
+                        read_value(static_cast<variant::enum_type_t>(child_type), value.push_back(date_time, variant(), variant::ReturnItem));
+                    }
                 }
                 break;
             }
             case variant::DataTable:
             {
-                boost::int32_t numRows, numCols;
-                read( numCols );
-                read( numRows );
+                const size_t numCols(read_size());
+                const size_t numRows(read_size());
 
                 value = variant( variant::DataTable, numRows );
 
@@ -171,10 +330,18 @@ namespace protean {
 
 					std::vector<std::string> colNames( numCols );
 					BOOST_FOREACH( std::string& colName, colNames )
-						read( colName );
+						colName = read_key();
 
-					for ( boost::int32_t i( 0 ); i != numCols; ++i )
-						value.add_column( static_cast<variant::enum_type_t>( colTypes[i] ), colNames[i] );
+					for ( size_t i( 0 ); i != numCols; ++i )
+                    {
+                        const variant::enum_type_t colType( static_cast<variant::enum_type_t>( colTypes[i] & ~(binary_dictionary_column | binary_arena_column) ) );
+                        if ( (colTypes[i] & binary_dictionary_column)!=0 )
+                            value.add_column( colType, colNames[i], data_table_column_base::DictionaryEncoding );
+                        else if ( (colTypes[i] & binary_arena_column)!=0 )
+                            value.add_column( colType, colNames[i], data_table_column_base::ArenaEncoding );
+                        else
+                            value.add_column( colType, colNames[i] );
+                    }
 				}
 
 				BOOST_FOREACH(variant::column_collection_t::reference column, value.columns())
@@ -182,36 +349,25 @@ namespace protean {
                     // Default-allocate `rows' column values to be read into (no reallocation required since
                     // capacity of `rows' was specified in DataTable construction)
                     column.resize( numRows );
+                }
 
-                    if (column.type() & variant_base::Primitive)
-                    {
-                        boost::scoped_ptr<detail::data_table_column_reader> column_reader(
-                            detail::make_data_table_column_binary_reader(column, *this)
-                        );
+                if ((m_writer_mode & binary_mode::ParallelColumns)!=0)
+                {
+                    read_parallel_columns(value);
+                    break;
+                }
 
-                        while (column_reader->has_next())
-                        {
-                            column_reader->read();
-                            column_reader->advance();
-                        }
-                    }
-                    else
-                    {
-                        variant::iterator iter(column.begin());
-                        variant::iterator end(column.end());
-                        while (iter != end)
-                            read(*(iter++));
-                    }
+				BOOST_FOREACH(variant::column_collection_t::reference column, value.columns())
+                {
+                    read_column(column);
                 }
 
                 break;
             }
             case variant::Object:
             {
-                std::string class_name;
+                const std::string class_name(read_key());
                 boost::int32_t version;
-
-                read(class_name);
                 read(version);
 
                 handle<object> obj;
@@ -263,13 +419,12 @@ namespace protean {
             }
             case variant::Array:
             {
-                boost::uint32_t size;
-                read(size);
+                const size_t size(read_size());
                 boost::uint32_t array_type;
                 read(array_type);
 
                 handle<typed_array> a(new typed_array(size, static_cast<variant::enum_type_t>(array_type)));
-                for (boost::uint32_t i=0; i<size; ++i)
+                for (size_t i=0; i<size; ++i)
                 {
                     variant v;
                     read_value(static_cast<variant::enum_type_t>(array_type), v);
@@ -283,6 +438,518 @@ namespace protean {
         }
     }
 
+    void binary_reader::read_shaped_list(variant& value)
+    {
+        // see binary_writer::write_shaped_list
+        boost::uint32_t shaped;
+        read(shaped);
+
+        if (shaped==0)
+        {
+            for (size_t i=0; i<value.size(); ++i)
+            {
+                read(value[i]);
+            }
+            return;
+        }
+
+        const size_t count(read_size());
+
+        std::vector<std::string> keys(count);
+        std::vector<variant::enum_type_t> types(count);
+        for (size_t i=0; i<count; ++i)
+        {
+            keys[i] = read_key();
+
+            boost::uint32_t type;
+            read(type);
+            types[i] = static_cast<variant::enum_type_t>(type);
+        }
+
+        for (size_t i=0; i<value.size(); ++i)
+        {
+            variant& item(value[i]);
+
+            boost::uint32_t has_shape;
+            read(has_shape);
+
+            if (has_shape==0)
+            {
+                read(item);
+                continue;
+            }
+
+            if (recycle(variant::Dictionary, item))
+            {
+                const size_t first(m_recycled_top);
+                for (size_t j=0; j<count; ++j)
+                {
+                    read_value(types[j], recycle_entry(item, keys[j]));
+                }
+                remove_stale_entries(item, first);
+                continue;
+            }
+
+            item = variant(variant::Dictionary);
+            for (size_t j=0; j<count; ++j)
+            {
+                read_value(types[j], item.insert(keys[j], variant(), variant::ReturnItem));
+            }
+        }
+    }
+
+    void binary_reader::read_column(data_table_column_base& column)
+    {
+        if (column.encoding()==data_table_column_base::DictionaryEncoding)
+        {
+            read_dictionary_column(column);
+        }
+        else if (column.encoding()==data_table_column_base::ArenaEncoding)
+        {
+            read_arena_column(column);
+        }
+        else if (column.type() & variant_base::Primitive)
+        {
+            boost::scoped_ptr<detail::data_table_column_reader> column_reader(
+                detail::make_data_table_column_binary_reader(column, *this)
+            );
+
+            while (column_reader->has_next())
+            {
+                column_reader->read();
+                column_reader->advance();
+            }
+        }
+        else
+        {
+            variant::iterator iter(column.begin());
+            variant::iterator end(column.end());
+            while (iter != end)
+                read(*(iter++));
+        }
+    }
+
+    void binary_reader::read_dictionary_column(data_table_column_base& column)
+    {
+        // see binary_writer::write_dictionary_column, each distinct value is added to the
+        // column's dictionary and the rows refer to it
+        detail::string_dictionary& dictionary(*column.dictionary());
+
+        const size_t count(read_size());
+        std::vector<detail::string> entries;
+        entries.reserve(count);
+
+        std::string entry;
+        for (size_t i=0; i<count; ++i)
+        {
+            read(entry);
+            entries.push_back(dictionary.intern(entry.c_str(), entry.size()));
+        }
+
+        std::vector<detail::string> values;
+        values.reserve(column.size());
+        for (size_t i=0; i<column.size(); ++i)
+        {
+            const size_t code(read_size());
+            if (code>=entries.size())
+            {
+                boost::throw_exception(variant_error("Dictionary code is out of range, stream is corrupt"));
+            }
+            values.push_back(detail::string::reference(entries[code]));
+        }
+
+        if (column.type()==variant::String)
+        {
+            column.assign<variant::String>(std::move(values));
+        }
+        else
+        {
+            column.assign<variant::Any>(std::move(values));
+        }
+    }
+
+    void binary_reader::read_arena_column(data_table_column_base& column)
+    {
+        // see binary_writer::write_arena_column, the arena is read in one block and the rows
+        // refer to it
+        const size_t bytes(read_size());
+
+        std::vector<size_t> lengths(column.size());
+        size_t offset(0);
+        BOOST_FOREACH(size_t& length, lengths)
+        {
+            length = read_size();
+            offset += detail::string_arena::padded_size(length);
+        }
+        if (offset!=bytes)
+        {
+            boost::throw_exception(variant_error("Arena length does not match the lengths of its values, stream is corrupt"));
+        }
+
+        std::vector<detail::string> values;
+        values.reserve(lengths.size());
+
+        detail::string_arena& arena(*column.arena());
+        arena.clear();
+        char* data(arena.extend(bytes, values));
+        if (bytes>0)
+        {
+            read_bytes(data, bytes);
+        }
+
+        offset = 0;
+        BOOST_FOREACH(size_t length, lengths)
+        {
+            if (data[offset + length]!='\0')
+            {
+                boost::throw_exception(variant_error("Arena value is not null-terminated, stream is corrupt"));
+            }
+            values.push_back(detail::string::reference(data + offset, length));
+            offset += detail::string_arena::padded_size(length);
+        }
+
+        if (column.type()==variant::String)
+        {
+            column.assign<variant::String>(std::move(values));
+        }
+        else
+        {
+            column.assign<variant::Any>(std::move(values));
+        }
+    }
+
+    void binary_reader::read_parallel_columns(variant& value)
+    {
+        // see binary_writer::write_parallel_columns, the columns are read in full and then
+        // decoded concurrently
+        variant::column_collection_t& columns(value.columns());
+
+        std::vector<size_t> lengths(columns.size());
+        BOOST_FOREACH(size_t& length, lengths)
+        {
+            length = read_size();
+        }
+
+        std::vector<std::vector<char> > encoded(columns.size());
+        for (size_t i=0; i<columns.size(); ++i)
+        {
+            encoded[i].resize(lengths[i]);
+            if (!encoded[i].empty())
+            {
+                read_bytes(&encoded[i][0], encoded[i].size());
+            }
+        }
+
+        const int writer_mode(binary_column_mode(m_writer_mode));
+        auto decode = [&](size_t i)
+        {
+            boost::iostreams::stream<boost::iostreams::array_source> is(encoded[i].empty() ? "" : &encoded[i][0], encoded[i].size());
+
+            binary_reader reader(is, m_mode);
+            reader.m_factory = m_factory;
+            reader.setup(m_major_version, writer_mode);
+            reader.read_column(columns[i]);
+        };
+
+        if (value.size()>=binary_parallel_columns_min_rows)
+        {
+            // the object factory is not thread-safe, so columns that may hold Objects
+            // are decoded here once the others are done
+            std::vector<size_t> parallel, serial;
+            for (size_t i=0; i<columns.size(); ++i)
+            {
+                (m_factory!=nullptr && (columns[i].type() & variant::Primitive)==0 ? serial : parallel).push_back(i);
+            }
+
+            detail::parallel_for(parallel.size(), [&](size_t n) { decode(parallel[n]); });
+            BOOST_FOREACH(size_t i, serial)
+            {
+                decode(i);
+            }
+        }
+        else
+        {
+            for (size_t i=0; i<columns.size(); ++i)
+            {
+                decode(i);
+            }
+        }
+    }
+
+    bool binary_reader::recycle(variant::enum_type_t type, const variant& value) const
+    {
+        return (m_mode & binary_mode::Recycle)!=0 && value.type()==type;
+    }
+
+    variant& binary_reader::recycle_entry(variant& value, const std::string& key)
+    {
+        if (m_recycled_top==m_recycled_keys.size())
+        {
+            m_recycled_keys.push_back(key);
+        }
+        else
+        {
+            m_recycled_keys[m_recycled_top] = key;
+        }
+        ++m_recycled_top;
+
+        if (value.has_key(key))
+        {
+            return value.at(key);
+        }
+        return value.insert(key, variant(), variant::ReturnItem);
+    }
+
+    void binary_reader::remove_stale_entries(variant& value, size_t first)
+    {
+        // the keys read are m_recycled_keys[first, m_recycled_top), any other entry was
+        // left over from the previous value
+        if (value.size()!=m_recycled_top-first)
+        {
+            const std::set<std::string> keys(m_recycled_keys.begin() + first, m_recycled_keys.begin() + m_recycled_top);
+
+            std::vector<std::string> stale;
+            for (variant::const_iterator citr(value.begin()); citr!=value.end(); ++citr)
+            {
+                if (keys.find(citr.key())==keys.end())
+                {
+                    stale.push_back(citr.key());
+                }
+            }
+
+            for (size_t i=0; i<stale.size(); ++i)
+            {
+                value.remove(stale[i]);
+            }
+        }
+        m_recycled_top = first;
+    }
+
+    bool binary_reader::read_projected(variant::enum_type_t type, variant& value, const projection& node)
+    {
+        if (node.m_all)
+        {
+            read_value(type, value);
+            return true;
+        }
+
+        const bool mapping((type & variant::Mapping)!=0 && (!node.m_children.empty() || node.m_any));
+        const bool sequence((type & variant::Sequence)!=0 && node.m_any);
+        if (!mapping && !sequence)
+        {
+            // nothing below this value is wanted
+            skip_value(type);
+            return false;
+        }
+
+        if (m_subtree_lengths)
+        {
+            boost::uint64_t length;
+            read_bytes(reinterpret_cast<char*>(&length), sizeof(length));
+        }
+
+        const size_t size(read_size());
+        value = variant(type, type==variant::Tuple ? size : 0);
+
+        if (mapping)
+        {
+            if (m_subtree_lengths && type==variant::Dictionary && size>=binary_dictionary_index_threshold)
+            {
+                skip_bytes(size * sizeof(boost::uint64_t));
+            }
+
+            for (size_t i=0; i<size; ++i)
+            {
+                const std::string key(read_key());
+
+                boost::uint32_t child_type;
+                read(child_type);
+
+                const projection* child(node.find(key));
+                if (child==nullptr)
+                {
+                    skip_value(static_cast<variant::enum_type_t>(child_type));
+                    continue;
+                }
+
+                variant child_value;
+                if (read_projected(static_cast<variant::enum_type_t>(child_type), child_value, *child))
+                {
+                    value.insert(key, variant(), variant::ReturnItem).swap(child_value);
+                }
+            }
+            return true;
+        }
+
+        const projection& item_node(*node.m_any);
+
+        if (type==variant::List && (m_writer_mode & binary_mode::ShapedLists)!=0)
+        {
+            // see binary_writer::write_shaped_list
+            boost::uint32_t shaped;
+            read(shaped);
+
+            std::vector<std::string> keys;
+            std::vector<variant::enum_type_t> types;
+            if (shaped!=0)
+            {
+                const size_t count(read_size());
+                for (size_t i=0; i<count; ++i)
+                {
+                    keys.push_back(read_key());
+
+                    boost::uint32_t key_type;
+                    read(key_type);
+                    types.push_back(static_cast<variant::enum_type_t>(key_type));
+                }
+            }
+
+            for (size_t i=0; i<size; ++i)
+            {
+                boost::uint32_t has_shape(0);
+                if (shaped!=0)
+                {
+                    read(has_shape);
+                }
+
+                boost::uint32_t item_type(variant::Dictionary);
+                if (has_shape==0)
+                {
+                    read(item_type);
+                }
+
+                variant item;
+                if (has_shape==0)
+                {
+                    if (read_projected(static_cast<variant::enum_type_t>(item_type), item, item_node))
+                    {
+                        value.push_back(item);
+                    }
+                    continue;
+                }
+
+                if (item_node.m_children.empty() && !item_node.m_any)
+                {
+                    for (size_t j=0; j<keys.size(); ++j)
+                    {
+                        skip_value(types[j]);
+                    }
+                    continue;
+                }
+
+                item = variant(variant::Dictionary);
+                for (size_t j=0; j<keys.size(); ++j)
+                {
+                    const projection* child(item_node.find(keys[j]));
+                    if (child==nullptr)
+                    {
+                        skip_value(types[j]);
+                        continue;
+                    }
+
+                    variant child_value;
+                    if (read_projected(types[j], child_value, *child))
+                    {
+                        item.insert(keys[j], variant(), variant::ReturnItem).swap(child_value);
+                    }
+                }
+                value.push_back(item);
+            }
+            return true;
+        }
+
+        for (size_t i=0; i<size; ++i)
+        {
+            boost::uint32_t item_type;
+            read(item_type);
+
+            // Tuples keep their size, with None in place of items that do not match
+            variant item;
+            if (read_projected(static_cast<variant::enum_type_t>(item_type), item, item_node))
+            {
+                if (type==variant::Tuple)
+                {
+                    value[i].swap(item);
+                }
+                else
+                {
+                    value.push_back(item);
+                }
+            }
+        }
+        return true;
+    }
+
+    void binary_reader::skip_value(variant::enum_type_t type)
+    {
+        detail::binary_skipper<binary_reader>(*this, m_writer_mode, m_compact, m_subtree_lengths).skip_value(type);
+    }
+
+    boost::uint64_t binary_reader::read_word()
+    {
+        boost::uint32_t value;
+        read(value);
+        return value;
+    }
+
+    boost::int32_t binary_reader::read_int32()
+    {
+        boost::int32_t value;
+        read(value);
+        return value;
+    }
+
+    boost::uint64_t binary_reader::read_uint64()
+    {
+        boost::uint64_t value;
+        read_bytes(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    }
+
+    void binary_reader::skip_bytes(boost::uint64_t length)
+    {
+        while (length>0)
+        {
+            const std::streamsize chunk(static_cast<std::streamsize>((std::min)(length, static_cast<boost::uint64_t>(1) << 30)));
+            if (!m_filter.ignore(chunk) || m_filter.gcount()!=chunk)
+            {
+                boost::throw_exception(variant_error("Error reading from stream"));
+            }
+            length -= chunk;
+        }
+    }
+
+    void binary_reader::skip_string()
+    {
+        const size_t length(read_size());
+        skip_bytes(m_compact ? length : length + (4 - (length % 4)) % 4);
+    }
+
+    void binary_reader::skip_key()
+    {
+        if ((m_writer_mode & binary_mode::StringTable)!=0)
+        {
+            // new table entries must still be recorded
+            read_string_reference();
+        }
+        else
+        {
+            skip_string();
+        }
+    }
+
+    void binary_reader::skip_string_value()
+    {
+        if ((m_writer_mode & binary_mode::StringTableValues)!=0)
+        {
+            read_string_reference();
+        }
+        else
+        {
+            skip_string();
+        }
+    }
+
     void binary_reader::read(variant& value)
     {
         boost::uint32_t type = variant::None;
@@ -291,43 +958,99 @@ namespace protean {
     }
     void binary_reader::read(std::string& value)
     {
-        boost::uint32_t length;
-        read(length);
+        const size_t length(read_size());
 
-        boost::scoped_array<char> buffer( new char[length] );
-        read_bytes(buffer.get(), length);
-        value = std::string(buffer.get(), length);
+        // read in place, so that a string read into repeatedly keeps its capacity
+        value.resize(length);
+        if (length>0)
+        {
+            read_bytes(&value[0], length);
+        }
 
     }
     void binary_reader::read(detail::string& value)
     {
-        boost::uint32_t length;
-        read(length);
+        const size_t length(read_size());
 
         boost::scoped_array<char> buffer( new char[length] );
         read_bytes(buffer.get(), length);
         value.initialise(buffer.get(), length);
     }
+    const std::string& binary_reader::read_key()
+    {
+        if ((m_writer_mode & binary_mode::StringTable)!=0)
+        {
+            return read_string_reference();
+        }
+        read(m_string);
+        return m_string;
+    }
+    const std::string& binary_reader::read_string()
+    {
+        if ((m_writer_mode & binary_mode::StringTableValues)!=0)
+        {
+            return read_string_reference();
+        }
+        read(m_string);
+        return m_string;
+    }
     void binary_reader::read(bool& value)
     {
+        if (m_compact)
+        {
+            char b;
+            read_bytes(&b, 1);
+            value = (b != 0);
+            return;
+        }
         boost::int32_t b;
         read(b);
         value = (b != 0);
     }
     void binary_reader::read(boost::int32_t& value)
     {
+        if (m_compact)
+        {
+            const boost::int64_t v(zigzag_decode(read_varint()));
+            if (v<(std::numeric_limits<boost::int32_t>::min)() || v>(std::numeric_limits<boost::int32_t>::max)())
+            {
+                boost::throw_exception(variant_error("Varint out of range for Int32, binary data is corrupt"));
+            }
+            value = static_cast<boost::int32_t>(v);
+            return;
+        }
         read_bytes(reinterpret_cast<char*>(&value), 4 );
     }
     void binary_reader::read(boost::uint32_t& value )
     {
+        if (m_compact)
+        {
+            const boost::uint64_t v(read_varint());
+            if (v>(std::numeric_limits<boost::uint32_t>::max)())
+            {
+                boost::throw_exception(variant_error("Varint out of range for UInt32, binary data is corrupt"));
+            }
+            value = static_cast<boost::uint32_t>(v);
+            return;
+        }
         read_bytes(reinterpret_cast<char*>(&value), 4 );
     }
     void binary_reader::read(boost::int64_t& value )
     {
+        if (m_compact)
+        {
+            value = zigzag_decode(read_varint());
+            return;
+        }
         read_bytes(reinterpret_cast<char*>(&value), 8 );
     }
     void binary_reader::read(boost::uint64_t& value )
     {
+        if (m_compact)
+        {
+            value = read_varint();
+            return;
+        }
         read_bytes(reinterpret_cast<char*>(&value), 8 );
     }
     void binary_reader::read(float& value)
@@ -413,6 +1136,49 @@ namespace protean {
         m_factory = &factory;
     }
 
+    void binary_reader::set_projection(const std::vector<std::string>& paths)
+    {
+        if (paths.empty())
+        {
+            m_projection.reset();
+            return;
+        }
+
+        static const boost::regex expr("^(\\*|\\w+)$");
+
+        boost::shared_ptr<projection> root(boost::make_shared<projection>());
+        BOOST_FOREACH(const std::string& path, paths)
+        {
+            projection* node(root.get());
+
+            size_t head_start(path.find_first_not_of('/'));
+            while (head_start!=std::string::npos)
+            {
+                const size_t head_end(path.find_first_of('/', head_start));
+                const std::string head(path.substr(head_start, head_end - head_start));
+
+                if (!boost::regex_match(head, expr))
+                {
+                    boost::throw_exception(variant_error("Projection path has invalid syntax, predicates are not supported: " + head));
+                }
+
+                boost::shared_ptr<projection>& child(head=="*" ? node->m_any : node->m_children[head]);
+                if (!child)
+                {
+                    child = boost::make_shared<projection>();
+                }
+                node = child.get();
+
+                head_start = head_end==std::string::npos ? head_end : path.find_first_not_of('/', head_end);
+            }
+
+            node->m_all = true;
+        }
+
+        root->normalise();
+        m_projection = root;
+    }
+
     void binary_reader::read_bytes(char* buffer, size_t length)
     {
         if (!m_filter.read(buffer, length))
@@ -421,7 +1187,7 @@ namespace protean {
         }
 
         // read packing bytes (if necessary)
-        size_t residual = (4 - (length % 4)) % 4;
+        size_t residual = m_compact ? 0 : (4 - (length % 4)) % 4;
         if (residual != 0)
         {
             static int packing = 0;
@@ -432,6 +1198,79 @@ namespace protean {
         }
     }
 
+    size_t binary_reader::read_size()
+    {
+        boost::uint64_t value;
+        if (m_compact)
+        {
+            value = read_varint();
+        }
+        else
+        {
+            boost::uint32_t size;
+            read(size);
+            if (size!=binary_large_size_marker || (m_writer_mode & binary_mode::LargeSizes)==0)
+            {
+                return size;
+            }
+            read(value);
+        }
+
+        if (value>(std::numeric_limits<size_t>::max)())
+        {
+            boost::throw_exception(variant_error((boost::format("Size %u is too large for this platform") % value).str()));
+        }
+        return static_cast<size_t>(value);
+    }
+
+    const std::string& binary_reader::read_string_reference()
+    {
+        // see binary_writer::write_string_reference
+        const boost::uint64_t tag(read_varint());
+        if (tag>=2)
+        {
+            if (tag-2>=m_string_table.size())
+            {
+                boost::throw_exception(variant_error("Invalid string table reference, binary data is corrupt"));
+            }
+            return m_string_table[static_cast<size_t>(tag-2)];
+        }
+
+        std::string* target(&m_string);
+        if (tag==1)
+        {
+            m_string_table.push_back(std::string());
+            target = &m_string_table.back();
+        }
+
+        target->resize(static_cast<size_t>(read_varint()));
+        if (!target->empty() && !m_filter.read(&(*target)[0], target->size()))
+        {
+            boost::throw_exception(variant_error("Error reading from stream"));
+        }
+        return *target;
+    }
+
+    boost::uint64_t binary_reader::read_varint()
+    {
+        boost::uint64_t value(0);
+        for (int shift=0; shift<64; shift+=7)
+        {
+            char byte;
+            if (!m_filter.get(byte))
+            {
+                boost::throw_exception(variant_error("Error reading from stream"));
+            }
+
+            value |= static_cast<boost::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80)==0)
+            {
+                return value;
+            }
+        }
+        boost::throw_exception(variant_error("Invalid varint, binary data is corrupt"));
+    }
+
     void binary_reader::setup()
     {
         if( !m_is.good() )
@@ -464,14 +1303,30 @@ namespace protean {
             ).str()));
         }
 
-        m_writer_mode = header[2];
+        const int writer_mode(header[2]);
 
         // create compression filter if necessary
-        if ((m_writer_mode & binary_mode::Compress)!=0)
+        bool zlib_no_header = (writer_mode & binary_mode::ZlibHeader) == 0;
+        if ((writer_mode & binary_mode::BlockCompress)!=0)
+        {
+            m_filter.push(detail::block_decompressor(zlib_no_header));
+        }
+        else if ((writer_mode & binary_mode::Compress)!=0)
         {
-            bool zlib_no_header = (m_writer_mode & binary_mode::ZlibHeader) == 0;
             m_filter.push(boost::iostreams::zlib_decompressor(binary_compression_params(zlib_no_header)));
         }
+
+        setup(m_major_version, writer_mode);
+    }
+
+    void binary_reader::setup(boost::uint16_t major_version, int writer_mode)
+    {
+        m_major_version = major_version;
+        m_writer_mode = writer_mode;
+        m_compact = m_major_version>=2;
+        m_subtree_lengths = (m_writer_mode & binary_mode::SubtreeLengths)!=0;
+        m_string_table.clear();
+
         m_filter.push(m_is);
     }
 
@@ -488,7 +1343,18 @@ namespace protean {
     binary_reader& operator>>(binary_reader& reader, variant& v)
     {
         reader.setup();
-        reader.read( v );
+        if (reader.m_projection)
+        {
+            boost::uint32_t type = variant::None;
+            reader.read(type);
+
+            v = variant();
+            reader.read_projected(static_cast<variant::enum_type_t>(type), v, *reader.m_projection);
+        }
+        else
+        {
+            reader.read( v );
+        }
         reader.close();
 
         return reader;
@@ -0,0 +1,284 @@
+#include <protean/binary_record_reader.hpp>
+#include <protean/binary_reader.hpp>
+#include <protean/detail/block_compression.hpp>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/make_shared.hpp>
+
+namespace protean {
+
+    binary_record_reader::binary_record_reader(std::istream& is, int mode) :
+        m_is(is),
+        m_mode(mode),
+        m_factory(nullptr),
+        m_block_number(static_cast<size_t>(-1))
+    {
+        read_index();
+    }
+
+    binary_record_reader::binary_record_reader(std::istream& is, const binary_record_reader& rhs) :
+        m_is(is),
+        m_mode(rhs.m_mode),
+        m_factory(rhs.m_factory),
+        m_index(rhs.m_index),
+        m_block_number(static_cast<size_t>(-1))
+    {
+    }
+
+    size_t binary_record_reader::size() const
+    {
+        return m_index->m_records.size();
+    }
+
+    void binary_record_reader::read(size_t n, variant& value)
+    {
+        if (n>=size())
+        {
+            boost::throw_exception(variant_error((boost::format("Record %u is out of range for container of size %u") % n % size()).str()));
+        }
+
+        const record_entry& record(m_index->m_records[n]);
+        const std::vector<char>& block(load_block(record.m_block));
+
+        if (static_cast<size_t>(record.m_offset) + record.m_length > block.size())
+        {
+            boost::throw_exception(variant_error("Record extends beyond the end of its block, container is corrupt"));
+        }
+
+        boost::iostreams::stream<boost::iostreams::array_source> is(&block[0] + record.m_offset, record.m_length);
+
+        binary_reader reader(is, m_mode);
+        if (m_factory!=nullptr)
+        {
+            reader.set_factory(*m_factory);
+        }
+        reader >> value;
+    }
+
+    bool binary_record_reader::read(const std::string& key, variant& value)
+    {
+        std::map<std::string, size_t>::const_iterator citr(m_index->m_key_map.find(key));
+        if (citr==m_index->m_key_map.end())
+        {
+            return false;
+        }
+
+        read(citr->second, value);
+        return true;
+    }
+
+    bool binary_record_reader::has_key(const std::string& key) const
+    {
+        return m_index->m_key_map.find(key)!=m_index->m_key_map.end();
+    }
+
+    const std::string& binary_record_reader::key(size_t n) const
+    {
+        static const std::string empty;
+
+        if (n>=size())
+        {
+            boost::throw_exception(variant_error((boost::format("Record %u is out of range for container of size %u") % n % size()).str()));
+        }
+        return m_index->m_keys.empty() ? empty : m_index->m_keys[n];
+    }
+
+    std::vector<binary_record_reader::range_t> binary_record_reader::partition(size_t parts) const
+    {
+        std::vector<range_t> result;
+
+        const std::vector<record_entry>& records(m_index->m_records);
+        const size_t blocks(m_index->m_blocks.size());
+
+        if (records.empty() || parts==0)
+        {
+            return result;
+        }
+
+        size_t first(0);
+        for (size_t part=1; part<=parts && first<records.size(); ++part)
+        {
+            // first record of the block at which this part ends
+            const size_t end_block(blocks * part / parts);
+
+            size_t last(first);
+            while (last<records.size() && records[last].m_block<end_block)
+            {
+                ++last;
+            }
+
+            if (part==parts)
+            {
+                last = records.size();
+            }
+
+            if (last>first)
+            {
+                result.push_back(range_t(first, last));
+                first = last;
+            }
+        }
+
+        return result;
+    }
+
+    void binary_record_reader::set_factory(object_factory& factory)
+    {
+        m_factory = &factory;
+    }
+
+    void binary_record_reader::read_index()
+    {
+        if (!m_is.good())
+        {
+            boost::throw_exception(variant_error("Input stream is bad"));
+        }
+
+        boost::shared_ptr<index> idx(boost::make_shared<index>());
+
+        // header
+        const std::streamoff start(m_is.tellg());
+
+        boost::uint32_t magic, version, mode, unused;
+        read_raw(magic);
+        read_raw(version);
+        read_raw(mode);
+        read_raw(unused);
+
+        if (magic!=binary_record_magic_number)
+        {
+            boost::throw_exception(variant_error("Bad magic number, this does not look like a binary record container"));
+        }
+
+        const boost::uint16_t major_version((version >> 16) & 0x0000FFFF);
+        if (major_version>binary_record_major_version)
+        {
+            boost::throw_exception(variant_error((boost::format("Version of record container is not compatible, received version %d > this version %d")
+                % static_cast<int>(major_version)
+                % static_cast<int>(binary_record_major_version)
+            ).str()));
+        }
+        idx->m_writer_mode = static_cast<int>(mode);
+
+        // trailer
+        boost::uint64_t index_offset;
+        m_is.seekg(-16, std::ios_base::end);
+        read_raw(index_offset);
+        read_raw(magic);
+
+        if (magic!=binary_record_magic_number)
+        {
+            boost::throw_exception(variant_error("Bad magic number in record container trailer, the container may be truncated"));
+        }
+
+        // index
+        m_is.seekg(start + static_cast<std::streamoff>(index_offset), std::ios_base::beg);
+
+        boost::uint64_t block_count;
+        read_raw(block_count);
+        idx->m_blocks.resize(static_cast<size_t>(block_count));
+        for (size_t i=0; i<idx->m_blocks.size(); ++i)
+        {
+            block_entry& entry(idx->m_blocks[i]);
+            read_raw(entry.m_offset);
+            read_raw(entry.m_stored_length);
+            read_raw(entry.m_raw_length);
+            entry.m_offset += start;
+        }
+
+        boost::uint64_t record_count;
+        read_raw(record_count);
+        idx->m_records.resize(static_cast<size_t>(record_count));
+        for (size_t i=0; i<idx->m_records.size(); ++i)
+        {
+            record_entry& entry(idx->m_records[i]);
+            read_raw(entry.m_block);
+            read_raw(entry.m_offset);
+            read_raw(entry.m_length);
+        }
+
+        boost::uint32_t has_keys;
+        read_raw(has_keys);
+        if (has_keys!=0)
+        {
+            idx->m_keys.resize(idx->m_records.size());
+            for (size_t i=0; i<idx->m_keys.size(); ++i)
+            {
+                boost::uint32_t length;
+                read_raw(length);
+
+                std::string& key(idx->m_keys[i]);
+                key.resize(length);
+                if (length>0)
+                {
+                    read_bytes(&key[0], length);
+                }
+
+                if (!key.empty())
+                {
+                    idx->m_key_map[key] = i;
+                }
+            }
+        }
+
+        m_index = idx;
+    }
+
+    const std::vector<char>& binary_record_reader::load_block(size_t n)
+    {
+        if (n==m_block_number)
+        {
+            return m_block;
+        }
+
+        if (n>=m_index->m_blocks.size())
+        {
+            boost::throw_exception(variant_error("Record refers to a missing block, container is corrupt"));
+        }
+
+        const block_entry& block(m_index->m_blocks[n]);
+
+        m_block_number = static_cast<size_t>(-1);
+        m_is.clear();
+        m_is.seekg(static_cast<std::streamoff>(block.m_offset), std::ios_base::beg);
+
+        if ((m_index->m_writer_mode & (binary_mode::Compress | binary_mode::BlockCompress))!=0)
+        {
+            std::string stored(block.m_stored_length, '\0');
+            if (!stored.empty())
+            {
+                read_bytes(&stored[0], stored.size());
+            }
+
+            m_block.resize(block.m_raw_length);
+            detail::decompress_block(stored, m_block, (m_index->m_writer_mode & binary_mode::ZlibHeader)==0);
+        }
+        else
+        {
+            m_block.resize(block.m_raw_length);
+            if (!m_block.empty())
+            {
+                read_bytes(&m_block[0], m_block.size());
+            }
+        }
+
+        m_block_number = n;
+        return m_block;
+    }
+
+    void binary_record_reader::read_bytes(char* value, size_t length)
+    {
+        if (!m_is.read(value, length))
+        {
+            boost::throw_exception(variant_error("Error reading from stream"));
+        }
+    }
+
+    template <typename T>
+    void binary_record_reader::read_raw(T& value)
+    {
+        read_bytes(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+} // namespace protean
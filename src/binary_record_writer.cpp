@@ -0,0 +1,191 @@
+#include <protean/binary_record_writer.hpp>
+#include <protean/binary_writer.hpp>
+#include <protean/detail/block_compression.hpp>
+
+#include <sstream>
+
+namespace protean {
+
+    namespace {
+
+        // Lengths and offsets are held as 32 bits in the index
+        boost::uint32_t index_value(size_t value, const char* what)
+        {
+            if (value > 0xFFFFFFFFu)
+            {
+                boost::throw_exception(variant_error(std::string("Record container ") + what + " exceeds 4GB"));
+            }
+            return static_cast<boost::uint32_t>(value);
+        }
+
+    } // namespace
+
+    binary_record_writer::binary_record_writer(std::ostream& os, int mode, size_t block_size) :
+        m_os(os),
+        m_mode(mode),
+        m_block_size(block_size),
+        m_position(0),
+        m_has_keys(false),
+        m_closed(false)
+    {
+        m_block.reserve(m_block_size);
+        write_header();
+    }
+
+    binary_record_writer::~binary_record_writer()
+    {
+        // errors can only be reported by an explicit close()
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    size_t binary_record_writer::size() const
+    {
+        return m_records.size();
+    }
+
+    void binary_record_writer::write(const variant& value)
+    {
+        write(std::string(), value);
+    }
+
+    void binary_record_writer::write(const std::string& key, const variant& value)
+    {
+        if (m_closed)
+        {
+            boost::throw_exception(variant_error("Attempt to write to closed record container"));
+        }
+
+        // each record is a complete binary document, blocks are compressed as a whole
+        std::ostringstream oss;
+        binary_writer writer(oss, m_mode & ~(binary_mode::Compress | binary_mode::BlockCompress | binary_mode::ZlibHeader));
+        writer << value;
+
+        const std::string record(oss.str());
+
+        if (!m_block.empty() && m_block.size() + record.size() > m_block_size)
+        {
+            flush_block();
+        }
+
+        record_entry entry;
+        entry.m_block = index_value(m_blocks.size(), "block count");
+        entry.m_offset = index_value(m_block.size(), "block");
+        entry.m_length = index_value(record.size(), "record");
+        m_records.push_back(entry);
+
+        m_keys.push_back(key);
+        m_has_keys = m_has_keys || !key.empty();
+
+        m_block.insert(m_block.end(), record.begin(), record.end());
+    }
+
+    void binary_record_writer::close()
+    {
+        if (m_closed)
+        {
+            return;
+        }
+        m_closed = true;
+
+        if (!m_block.empty())
+        {
+            flush_block();
+        }
+
+        const boost::uint64_t index_offset(m_position);
+
+        // [BLOCK COUNT][OFFSET STORED RAW]...
+        write_raw(static_cast<boost::uint64_t>(m_blocks.size()));
+        for (size_t i=0; i<m_blocks.size(); ++i)
+        {
+            write_raw(m_blocks[i].m_offset);
+            write_raw(m_blocks[i].m_stored_length);
+            write_raw(m_blocks[i].m_raw_length);
+        }
+
+        // [RECORD COUNT][BLOCK OFFSET LENGTH]...
+        write_raw(static_cast<boost::uint64_t>(m_records.size()));
+        for (size_t i=0; i<m_records.size(); ++i)
+        {
+            write_raw(m_records[i].m_block);
+            write_raw(m_records[i].m_offset);
+            write_raw(m_records[i].m_length);
+        }
+
+        // [HAS KEYS]([LENGTH][KEY]...)
+        write_raw(static_cast<boost::uint32_t>(m_has_keys ? 1 : 0));
+        if (m_has_keys)
+        {
+            for (size_t i=0; i<m_keys.size(); ++i)
+            {
+                write_raw(index_value(m_keys[i].size(), "key"));
+                write_bytes(m_keys[i].c_str(), m_keys[i].size());
+            }
+        }
+
+        // [INDEX OFFSET][MAGIC][UNUSED]
+        write_raw(index_offset);
+        write_raw(binary_record_magic_number);
+        write_raw(static_cast<boost::uint32_t>(0));
+
+        m_os.flush();
+    }
+
+    void binary_record_writer::write_header()
+    {
+        if (!m_os.good())
+        {
+            boost::throw_exception(variant_error("Output stream is bad"));
+        }
+
+        // [13 FF 49 52][MAJOR MINOR][MODE][UNUSED]
+        write_raw(binary_record_magic_number);
+        write_raw(static_cast<boost::uint32_t>((binary_record_major_version << 16) | binary_record_minor_version));
+        write_raw(static_cast<boost::uint32_t>(m_mode));
+        write_raw(static_cast<boost::uint32_t>(0));
+    }
+
+    void binary_record_writer::flush_block()
+    {
+        block_entry entry;
+        entry.m_offset = m_position;
+        entry.m_raw_length = index_value(m_block.size(), "block");
+
+        if ((m_mode & (binary_mode::Compress | binary_mode::BlockCompress))!=0)
+        {
+            const std::string stored(detail::compress_block(m_block, (m_mode & binary_mode::ZlibHeader)==0));
+            entry.m_stored_length = index_value(stored.size(), "compressed block");
+            write_bytes(stored.data(), stored.size());
+        }
+        else
+        {
+            entry.m_stored_length = entry.m_raw_length;
+            write_bytes(&m_block[0], m_block.size());
+        }
+
+        m_blocks.push_back(entry);
+        m_block.clear();
+    }
+
+    void binary_record_writer::write_bytes(const char* value, size_t length)
+    {
+        if (length>0 && !m_os.write(value, length))
+        {
+            boost::throw_exception(variant_error("Error writing to stream"));
+        }
+        m_position += length;
+    }
+
+    template <typename T>
+    void binary_record_writer::write_raw(const T& value)
+    {
+        write_bytes(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+} // namespace protean
@@ -4,26 +4,87 @@
 
 #include <protean/binary_writer.hpp>
 #include <protean/variant.hpp>
+#include <protean/data_table_view.hpp>
 #include <protean/detail/data_table.hpp>
 #include <protean/detail/data_table_column_serializers.hpp>
+#include <protean/detail/block_compression.hpp>
+#include <protean/detail/thread_pool.hpp>
+#include <protean/detail/string_dictionary.hpp>
+#include <protean/detail/string_arena.hpp>
 
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <cstring>
+#include <sstream>
 
 namespace protean {
+
+    static inline boost::uint64_t zigzag_encode(boost::int64_t value)
+    {
+        return (static_cast<boost::uint64_t>(value) << 1) ^ static_cast<boost::uint64_t>(value >> 63);
+    }
+
+    // Whether 'record' is a Dictionary with the same keys and value types as 'shape'
+    static bool has_shape(const variant& record, const variant& shape)
+    {
+        if (!record.is<variant::Dictionary>() || record.size()!=shape.size())
+        {
+            return false;
+        }
+
+        variant::const_iterator record_it(record.begin()), shape_it(shape.begin()), shape_end(shape.end());
+        for ( ; shape_it!=shape_end; ++shape_it, ++record_it)
+        {
+            if (record_it.value().type()!=shape_it.value().type() || record_it.key()!=shape_it.key())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
     
     binary_writer::binary_writer(std::ostream &os, int mode) :
         m_os(os),
-        m_mode(mode | binary_mode::DateTimeAsTicks)
+        m_mode(mode | binary_mode::DateTimeAsTicks),
+        m_compact((mode & binary_mode::Compact)!=0),
+        m_subtree_lengths((mode & binary_mode::SubtreeLengths)!=0)
     {
+        if (m_subtree_lengths && (mode & (binary_mode::StringTable | binary_mode::StringTableValues))!=0)
+        {
+            boost::throw_exception(variant_error("binary_mode::SubtreeLengths cannot be combined with a string table, subtrees would not be self-contained"));
+        }
     }
 
     binary_writer::~binary_writer()
     {
-        close();
+        // every document is closed by operator<<, anything left is from one that failed
+        try
+        {
+            discard();
+        }
+        catch (...)
+        {
+        }
     }
 
     void binary_writer::write_value(const variant& value)
+    {
+        if (m_subtree_lengths && (value.type() & (variant::Collection | variant::Array))!=0)
+        {
+            // [LENGTH][CONTENT]
+            const size_t start(begin_subtree());
+            write_content(value);
+            end_subtree(start);
+        }
+        else
+        {
+            write_content(value);
+        }
+    }
+
+    void binary_writer::write_content(const variant& value)
     {
         switch(value.type())
         {
@@ -31,7 +92,7 @@ namespace protean {
                 write(value.as<double>());
                 break;
             case variant::String:
-                write(value.as<std::string>());
+                write_string(value.as<std::string>());
                 break;
             case variant::Int32:
                 write(value.as<boost::int32_t>());
@@ -69,19 +130,36 @@ namespace protean {
             case variant::Dictionary:
             case variant::Bag:
             {
-                write(static_cast<boost::uint32_t>(value.size()));
+                write_size(value.size());
+
+                // [OFFSET]... of each entry, for lookup by key without decoding
+                const bool indexed(m_subtree_lengths && value.is<variant::Dictionary>() && value.size()>=binary_dictionary_index_threshold);
+                size_t index(0), entries(0);
+                if (indexed)
+                {
+                    index = m_buffer.size();
+                    m_buffer.resize(index + value.size() * sizeof(boost::uint64_t));
+                    entries = m_buffer.size();
+                }
 
                 variant::const_iterator it, end = value.end();
                 for ( it=value.begin(); it != end; ++it )
                 {
-                    write(it.key());
+                    if (indexed)
+                    {
+                        const boost::uint64_t offset(m_buffer.size() - entries);
+                        std::memcpy(&m_buffer[index], &offset, sizeof(offset));
+                        index += sizeof(offset);
+                    }
+
+                    write_key(it.key());
                     write(it.value() );
                 }
                 break;
             }
             case variant::Tuple:
             {
-                write(static_cast<boost::uint32_t>(value.size()));
+                write_size(value.size());
 
                 for(size_t n(0); n!= value.size(); ++n)
                 {
@@ -92,7 +170,13 @@ namespace protean {
             }
             case variant::List:
             {
-                write(static_cast<boost::uint32_t>(value.size()));
+                write_size(value.size());
+
+                if ((m_mode & binary_mode::ShapedLists)!=0)
+                {
+                    write_shaped_list(value);
+                    break;
+                }
 
                 BOOST_FOREACH(const variant& child, value)
                 {
@@ -107,7 +191,7 @@ namespace protean {
             }
             case variant::TimeSeries:
             {
-                write(static_cast<boost::uint32_t>(value.size()));
+                write_size(value.size());
 
                 variant::const_iterator it, end = value.end();
                 for (it=value.begin(); it != end; ++it)
@@ -119,38 +203,7 @@ namespace protean {
             }
             case variant::DataTable:
             {
-				const auto& columns(value.columns());
-
-				write(static_cast<boost::int32_t>(columns.size()));
-				write(static_cast<boost::int32_t>(value.size()));
-
-                BOOST_FOREACH( const auto& column, columns )
-					write( static_cast<boost::int32_t>( column.type() ) );
-                BOOST_FOREACH( const auto& column, columns )
-					write( column.name() );
-
-                BOOST_FOREACH(variant::column_collection_t::const_reference column, columns)
-                {
-                    if (column.type() & variant_base::Primitive)
-                    {
-                        boost::scoped_ptr<detail::data_table_column_writer> column_writer(
-                            detail::make_data_table_column_binary_writer(column, *this)
-                        );
-
-                        while (column_writer->has_next())
-                        {
-                            column_writer->write();
-                            column_writer->advance();
-                        }
-                    }
-                    else
-                    {
-		                variant::const_iterator iter(column.begin());
-		                variant::const_iterator end(column.end());
-		                while (iter != end)
-		                    write(*(iter++));
-                    }
-                }
+                write_data_table(data_table_view(value.columns()));
                 break;
             }
             case variant::Object:
@@ -158,7 +211,7 @@ namespace protean {
                 const object& obj(value.as<object>());
 
                 // write class name
-                write(obj.name());
+                write_key(obj.name());
 
                 // write version
                 write(static_cast<boost::int32_t>(obj.version()));
@@ -187,7 +240,7 @@ namespace protean {
             case variant::Array:
             {
                 const typed_array& a(value.as<typed_array>());
-                write(static_cast<boost::uint32_t>(a.size()));
+                write_size(a.size());
                 write(static_cast<boost::uint32_t>(a.type()));
 
                 for(size_t n(0); n!=a.size(); ++n)
@@ -203,17 +256,319 @@ namespace protean {
         }
     }
 
+    void binary_writer::write_shaped_list(const variant& value)
+    {
+        // [0]([TYPE][VALUE])...                                     : no common shape
+        // [1][KEY COUNT]([KEY][TYPE])...([1][VALUE]...|[0][TYPE][VALUE])... : shaped by the first item
+        const variant* shape(nullptr);
+        if (value.size()>1)
+        {
+            const variant& first(*value.begin());
+            if (first.is<variant::Dictionary>() && first.size()>0)
+            {
+                shape = &first;
+            }
+        }
+
+        if (shape==nullptr)
+        {
+            write(static_cast<boost::uint32_t>(0));
+            BOOST_FOREACH(const variant& child, value)
+            {
+                write(child);
+            }
+            return;
+        }
+
+        write(static_cast<boost::uint32_t>(1));
+        write_size(shape->size());
+
+        variant::const_iterator it, end = shape->end();
+        for (it=shape->begin(); it!=end; ++it)
+        {
+            write_key(it.key());
+            write(static_cast<boost::uint32_t>(it.value().type()));
+        }
+
+        BOOST_FOREACH(const variant& child, value)
+        {
+            if (has_shape(child, *shape))
+            {
+                write(static_cast<boost::uint32_t>(1));
+
+                variant::const_iterator child_it, child_end = child.end();
+                for (child_it=child.begin(); child_it!=child_end; ++child_it)
+                {
+                    write_value(child_it.value());
+                }
+            }
+            else
+            {
+                write(static_cast<boost::uint32_t>(0));
+                write(child);
+            }
+        }
+    }
+
+    void binary_writer::write_data_table(const data_table_view& value)
+    {
+        write_size(value.column_count());
+        write_size(value.size());
+
+        for (size_t i=0; i<value.column_count(); ++i)
+        {
+            const data_table_column_base& column(value.column(i));
+
+            boost::int32_t type( static_cast<boost::int32_t>( column.type() ) );
+            if ( column.encoding()==data_table_column_base::DictionaryEncoding )
+                type |= binary_dictionary_column;
+            else if ( column.encoding()==data_table_column_base::ArenaEncoding )
+                type |= binary_arena_column;
+            write( type );
+        }
+        for (size_t i=0; i<value.column_count(); ++i)
+            write_key( value.column(i).name() );
+
+        if ((m_mode & binary_mode::ParallelColumns)!=0)
+        {
+            write_parallel_columns(value);
+            return;
+        }
+
+        for (size_t i=0; i<value.column_count(); ++i)
+        {
+            write_column(value.column(i), value.offset(), value.size());
+        }
+    }
+
+    void binary_writer::write_column(const data_table_column_base& column, size_t offset, size_t length)
+    {
+        if (column.encoding()==data_table_column_base::DictionaryEncoding)
+        {
+            write_dictionary_column(column, offset, length);
+        }
+        else if (column.encoding()==data_table_column_base::ArenaEncoding)
+        {
+            write_arena_column(column, offset, length);
+        }
+        else if (column.type() & variant_base::Primitive)
+        {
+            boost::scoped_ptr<detail::data_table_column_writer> column_writer(
+                detail::make_data_table_column_binary_writer(column, *this)
+            );
+
+            column_writer->skip(offset);
+            for (size_t i=0; i<length; ++i)
+            {
+                column_writer->write();
+                column_writer->advance();
+            }
+        }
+        else
+        {
+            variant::const_iterator iter(column.begin());
+            for (size_t i=0; i<offset; ++i)
+                ++iter;
+            for (size_t i=0; i<length; ++i)
+                write(*(iter++));
+        }
+    }
+
+    namespace {
+
+        // The distinct values of a dictionary-encoded column in order of first appearance,
+        // and the position of each row's value among them
+        template <variant_base::enum_type_t E>
+        void encode_dictionary(const data_table_column_base& column, size_t offset, size_t length, std::vector<const detail::string*>& values, std::vector<size_t>& codes)
+        {
+            typedef boost::unordered_map<const char*, size_t, detail::string_dictionary::hash, detail::string_dictionary::equal> index_t;
+
+            index_t index;
+            codes.reserve(length);
+
+            typename column_traits<E>::const_iterator citr(column.begin<E>() + offset), end(citr + length);
+            for ( ; citr!=end; ++citr)
+            {
+                const std::pair<index_t::iterator, bool> result(index.insert(index_t::value_type(citr->value(), values.size())));
+                if (result.second)
+                {
+                    values.push_back(&*citr);
+                }
+                codes.push_back(result.first->second);
+            }
+        }
+
+        // The rows [offset, offset + length) of an arena-encoded column and their lengths,
+        // returning whether the arena holds their values in row order from 'start', which it
+        // does unless rows were appended in bulk
+        template <variant_base::enum_type_t E>
+        bool arena_rows(const data_table_column_base& column, size_t offset, size_t length, std::vector<const detail::string*>& rows, std::vector<size_t>& lengths, size_t& start)
+        {
+            const detail::string_arena& arena(*column.arena());
+
+            rows.reserve(length);
+            lengths.reserve(length);
+
+            typename column_traits<E>::const_iterator citr(column.begin<E>() + offset), end(citr + length);
+
+            start = 0;
+            if (citr!=end && citr->value()>=arena.data() && citr->value()<arena.data() + arena.size())
+            {
+                start = static_cast<size_t>(citr->value() - arena.data());
+            }
+
+            bool contiguous(true);
+            size_t position(start);
+
+            for ( ; citr!=end; ++citr)
+            {
+                const size_t size(citr->size());
+                rows.push_back(&*citr);
+                lengths.push_back(size);
+
+                const char* expected(arena.data() + position);
+                position += detail::string_arena::padded_size(size);
+
+                contiguous = contiguous && position<=arena.size() && (citr->value()==expected || std::memcmp(citr->value(), expected, size + 1)==0);
+            }
+
+            // rows that run to the end of the column must also end its arena
+            return contiguous && (offset + length<column.size() || position==arena.size());
+        }
+
+    } // namespace
+
+    void binary_writer::write_arena_column(const data_table_column_base& column, size_t offset, size_t length)
+    {
+        // [BYTES][LENGTH]...[ARENA], the values null-terminated and padded as they are held
+        // in string_arena so that they are read back in one block
+        std::vector<const detail::string*> rows;
+        std::vector<size_t> lengths;
+        size_t start;
+        const bool contiguous(column.type()==variant::String
+            ? arena_rows<variant::String>(column, offset, length, rows, lengths, start)
+            : arena_rows<variant::Any>(column, offset, length, rows, lengths, start));
+
+        size_t bytes(0);
+        BOOST_FOREACH(size_t length, lengths)
+        {
+            bytes += detail::string_arena::padded_size(length);
+        }
+
+        write_size(bytes);
+        BOOST_FOREACH(size_t length, lengths)
+        {
+            write_size(length);
+        }
+
+        if (contiguous)
+        {
+            write_bytes(column.arena()->data() + start, bytes);
+        }
+        else
+        {
+            static const char padding[4] = { 0, 0, 0, 0 };
+            for (size_t i=0; i<rows.size(); ++i)
+            {
+                put(rows[i]->value(), lengths[i]);
+                put(padding, detail::string_arena::padded_size(lengths[i]) - lengths[i]);
+            }
+        }
+    }
+
+    void binary_writer::write_dictionary_column(const data_table_column_base& column, size_t offset, size_t length)
+    {
+        // [SIZE][VALUE]...[CODE]..., the value of each row is written once however many
+        // rows refer to it
+        std::vector<const detail::string*> values;
+        std::vector<size_t> codes;
+        if (column.type()==variant::String)
+        {
+            encode_dictionary<variant::String>(column, offset, length, values, codes);
+        }
+        else
+        {
+            encode_dictionary<variant::Any>(column, offset, length, values, codes);
+        }
+
+        write_size(values.size());
+        BOOST_FOREACH(const detail::string* value, values)
+        {
+            write(*value);
+        }
+        BOOST_FOREACH(size_t code, codes)
+        {
+            write_size(code);
+        }
+    }
+
+    void binary_writer::write_parallel_columns(const data_table_view& value)
+    {
+        // [LENGTH]...[COLUMN]..., each column is encoded into a stream of its own
+        const int mode(binary_column_mode(m_mode));
+
+        std::vector<std::string> encoded(value.column_count());
+        auto encode = [&](size_t i)
+        {
+            std::ostringstream oss;
+            {
+                binary_writer writer(oss, mode);
+                writer.m_filter.push(oss);
+                writer.write_column(value.column(i), value.offset(), value.size());
+                writer.close();
+            }
+            encoded[i] = oss.str();
+        };
+
+        if (value.size()>=binary_parallel_columns_min_rows)
+        {
+            detail::parallel_for(value.column_count(), encode);
+        }
+        else
+        {
+            for (size_t i=0; i<value.column_count(); ++i)
+            {
+                encode(i);
+            }
+        }
+
+        BOOST_FOREACH(const std::string& column, encoded)
+        {
+            write_size(column.size());
+        }
+        BOOST_FOREACH(const std::string& column, encoded)
+        {
+            write_bytes(column.data(), column.size());
+        }
+    }
+
     void binary_writer::write(const variant& value)
     {
         write(static_cast<boost::uint32_t>(value.type()));
         write_value( value );
     }
 
+    void binary_writer::write(const data_table_view& value)
+    {
+        // written as a DataTable of just the rows and columns of the view
+        write(static_cast<boost::uint32_t>(variant::DataTable));
+        if (m_subtree_lengths)
+        {
+            const size_t start(begin_subtree());
+            write_data_table(value);
+            end_subtree(start);
+        }
+        else
+        {
+            write_data_table(value);
+        }
+    }
+
     void binary_writer::write(const std::string& value)
     {
         size_t length = value.size();
 
-        write(static_cast<boost::uint32_t>(length));
+        write_size(length);
         if (length>0)
         {
             write_bytes(value.c_str(), length);
@@ -223,31 +578,79 @@ namespace protean {
     {
         size_t length = value.size();
 
-        write(static_cast<boost::uint32_t>(length));
+        write_size(length);
         if (length>0)
         {
             write_bytes(value.value(), length);
         }
     }
+    void binary_writer::write_key(const std::string& value)
+    {
+        if ((m_mode & binary_mode::StringTable)!=0)
+        {
+            write_string_reference(value, true);
+        }
+        else
+        {
+            write(value);
+        }
+    }
+    void binary_writer::write_string(const std::string& value)
+    {
+        if ((m_mode & binary_mode::StringTableValues)!=0)
+        {
+            write_string_reference(value, value.size()<=binary_string_table_max_value_length);
+        }
+        else
+        {
+            write(value);
+        }
+    }
     void binary_writer::write(bool arg)
     {
+        if (m_compact)
+        {
+            const char value(arg ? 1 : 0);
+            write_bytes(&value, 1);
+            return;
+        }
         boost::int32_t value(arg ? 1 : 0);
         write(value);
     }
     void binary_writer::write(boost::int32_t value)
     {
+        if (m_compact)
+        {
+            write_varint(zigzag_encode(value));
+            return;
+        }
         write_bytes(reinterpret_cast<const char*>(&value), 4);
     }
     void binary_writer::write(boost::uint32_t value)
     {
+        if (m_compact)
+        {
+            write_varint(value);
+            return;
+        }
         write_bytes(reinterpret_cast<const char*>(&value), 4);
     }
     void binary_writer::write(boost::int64_t value)
     {
+        if (m_compact)
+        {
+            write_varint(zigzag_encode(value));
+            return;
+        }
         write_bytes(reinterpret_cast<const char*>(&value), 8);
     }
     void binary_writer::write(boost::uint64_t value)
     {
+        if (m_compact)
+        {
+            write_varint(value);
+            return;
+        }
         write_bytes(reinterpret_cast<const char*>(&value), 8);
     }
     void binary_writer::write(float value)
@@ -273,28 +676,109 @@ namespace protean {
 
     void binary_writer::write(const void* data, size_t length)
     {
-        write(static_cast<boost::uint32_t>(length));
+        write_size(length);
         write_bytes(reinterpret_cast<const char*>(data), length);
     }
 
-    void binary_writer::write_bytes(const char* buffer, size_t length)
+    void binary_writer::write_size(size_t value)
     {
-        // write data
-        if (!m_filter.write(buffer, length))
+        if (m_compact)
         {
-            boost::throw_exception(variant_error("Error writing to stream"));
+            write_varint(value);
+        }
+        else if (value<binary_large_size_marker)
+        {
+            write(static_cast<boost::uint32_t>(value));
         }
+        else
+        {
+            // [FF FF FF FF][64-bit size]
+            write(binary_large_size_marker);
+            write(static_cast<boost::uint64_t>(value));
+        }
+    }
+
+    void binary_writer::write_bytes(const char* buffer, size_t length)
+    {
+        // write data
+        put(buffer, length);
 
         // write packing bytes (if necessary)
-        size_t residual = (4 - (length % 4)) % 4;
+        size_t residual = m_compact ? 0 : (4 - (length % 4)) % 4;
         if (residual!=0)
         {
             const int packing = 0;
-            if (!m_filter.write(reinterpret_cast<const char*>(&packing), residual))
+            put(reinterpret_cast<const char*>(&packing), residual);
+        }
+    }
+
+    void binary_writer::put(const char* buffer, size_t length)
+    {
+        if (m_subtree_lengths)
+        {
+            // subtree lengths are filled in once known, so the document is built in memory
+            m_buffer.insert(m_buffer.end(), buffer, buffer + length);
+        }
+        else if (!m_filter.write(buffer, length))
+        {
+            boost::throw_exception(variant_error("Error writing to stream"));
+        }
+    }
+
+    size_t binary_writer::begin_subtree()
+    {
+        // 64-bit placeholder for the length, filled in by end_subtree
+        m_buffer.resize(m_buffer.size() + sizeof(boost::uint64_t));
+        return m_buffer.size();
+    }
+
+    void binary_writer::end_subtree(size_t start)
+    {
+        const boost::uint64_t length(m_buffer.size() - start);
+        std::memcpy(&m_buffer[start - sizeof(length)], &length, sizeof(length));
+    }
+    
+    void binary_writer::write_string_reference(const std::string& value, bool cacheable)
+    {
+        // [0][LENGTH][BYTES]: inline string
+        // [1][LENGTH][BYTES]: inline string, added to the table with the next id
+        // [ID+2]:             string previously added to the table
+        // All as unpadded varints
+        boost::uint64_t tag(0);
+        if (cacheable)
+        {
+            string_table_t::const_iterator citr(m_string_table.find(value));
+            if (citr!=m_string_table.end())
             {
-                boost::throw_exception(variant_error("Error writing to stream"));
+                write_varint(static_cast<boost::uint64_t>(citr->second) + 2);
+                return;
+            }
+
+            if (m_string_table.size()<binary_string_table_max_entries)
+            {
+                const boost::uint32_t id(static_cast<boost::uint32_t>(m_string_table.size()));
+                m_string_table.insert(std::make_pair(value, id));
+                tag = 1;
             }
         }
+
+        write_varint(tag);
+        write_varint(value.size());
+        put(value.c_str(), value.size());
+    }
+
+    void binary_writer::write_varint(boost::uint64_t value)
+    {
+        char buffer[10];
+        size_t length(0);
+        while (value>=0x80)
+        {
+            buffer[length++] = static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        buffer[length++] = static_cast<char>(value);
+
+        put(buffer, length);
     }
     
     void binary_writer::setup()
@@ -304,13 +788,15 @@ namespace protean {
             boost::throw_exception(variant_error("Output stream is bad"));
         }
 
+        m_string_table.clear();
+
         boost::uint32_t header[3];
 
         // write header
         // [13 FF 48 49][MAJOR MINOR][MODE]
         header[0] = binary_magic_number;
-        header[1] = (binary_major_version << 16) | binary_minor_version;
-        header[2] = m_mode;
+        header[1] = ((m_compact ? binary_major_version : binary_major_version_v1) << 16) | binary_minor_version;
+        header[2] = m_compact ? m_mode : (m_mode | binary_mode::LargeSizes);
 
         if (!m_os.write(reinterpret_cast<const char*>(header), sizeof(header)))
         {
@@ -318,9 +804,13 @@ namespace protean {
         }
 
         // create compression filter if necessary
-        if ((m_mode & binary_mode::Compress)!=0)
+        bool zlib_no_header = (m_mode & binary_mode::ZlibHeader)==0;
+        if ((m_mode & binary_mode::BlockCompress)!=0)
+        {
+            m_filter.push(detail::block_compressor(binary_compression_block_size, zlib_no_header));
+        }
+        else if ((m_mode & binary_mode::Compress)!=0)
         {
-            bool zlib_no_header = (m_mode & binary_mode::ZlibHeader)==0;
             m_filter.push(boost::iostreams::zlib_compressor(binary_compression_params(zlib_no_header)));
         }
         m_filter.push(m_os);
@@ -328,13 +818,63 @@ namespace protean {
 
     void binary_writer::close()
     {
+        if (!m_buffer.empty())
+        {
+            std::vector<char> buffer;
+            buffer.swap(m_buffer);
+
+            if (!m_filter.write(&buffer[0], buffer.size()))
+            {
+                discard();
+                boost::throw_exception(variant_error("Error writing to stream"));
+            }
+        }
         m_filter.reset();
     }
 
+    void binary_writer::discard()
+    {
+        // detach the stream before closing the filters, so a compressor ends the
+        // truncated document in a null device rather than as though it were complete
+        m_buffer.clear();
+        m_filter.set_auto_close(false);
+        if (!m_filter.empty())
+        {
+            m_filter.pop();
+        }
+        m_filter.reset();
+        m_filter.set_auto_close(true);
+    }
+
     binary_writer& operator<<(binary_writer& writer, const variant& v)
     {
         writer.setup();
-        writer.write( v );
+        try
+        {
+            writer.write( v );
+        }
+        catch (...)
+        {
+            writer.discard();
+            throw;
+        }
+        writer.close();
+
+        return writer;
+    }
+
+    binary_writer& operator<<(binary_writer& writer, const data_table_view& v)
+    {
+        writer.setup();
+        try
+        {
+            writer.write( v );
+        }
+        catch (...)
+        {
+            writer.discard();
+            throw;
+        }
         writer.close();
 
         return writer;
@@ -0,0 +1,45 @@
+#include <protean/detail/block_compression.hpp>
+#include <protean/binary_common.hpp>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+
+namespace protean { namespace detail {
+
+    std::string compress_block(const std::vector<char>& raw, bool zlib_no_header)
+    {
+        std::string stored;
+
+        boost::iostreams::filtering_ostream os;
+        os.push(boost::iostreams::zlib_compressor(binary_compression_params(zlib_no_header)));
+        os.push(boost::iostreams::back_inserter(stored));
+
+        if (!raw.empty() && !os.write(&raw[0], raw.size()))
+        {
+            boost::throw_exception(variant_error("Error compressing block"));
+        }
+
+        // flush the compressor into 'stored'
+        os.reset();
+
+        return stored;
+    }
+
+    void decompress_block(const std::string& stored, std::vector<char>& raw, bool zlib_no_header)
+    {
+        if (raw.empty())
+        {
+            return;
+        }
+
+        boost::iostreams::filtering_istream is;
+        is.push(boost::iostreams::zlib_decompressor(binary_compression_params(zlib_no_header)));
+        is.push(boost::iostreams::array_source(stored.data(), stored.size()));
+
+        if (!is.read(&raw[0], raw.size()))
+        {
+            boost::throw_exception(variant_error("Error decompressing block, data is truncated or corrupt"));
+        }
+    }
+
+}} // namespace protean::detail
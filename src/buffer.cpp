@@ -11,8 +11,8 @@ namespace protean { namespace detail {
     buffer::buffer(size_t size) :
         m_size(size)
     {
-        m_data = std::malloc(size);
-        std::memset(m_data, 0, size);
+        // untouched pages of large allocations are left to the system to zero when used
+        m_data = std::calloc(size, 1);
     }
 
     buffer::buffer(const void* data, size_t size) :
@@ -1,4 +1,5 @@
 #include <protean/detail/data_table.hpp>
+#include <protean/data_table_expression.hpp>
 #include <protean/detail/hash.hpp>
 #include <protean/detail/data_table_variant_iterator.hpp>
 
@@ -42,36 +43,76 @@ namespace protean { namespace detail {
         );
     }
 
+    data_table& data_table::add_column(variant_base::enum_type_t type, const std::string& name, data_table_column_base::encoding_t encoding)
+    {
+        add_column(type, name);
+
+        try
+        {
+            m_columns.back().set_encoding(encoding);
+        }
+        catch (...)
+        {
+            m_columns.pop_back();
+            throw;
+        }
+
+        return *this;
+    }
+
+    void data_table::check_new_column(const std::string& name) const
+    {
+        if (m_columns.size() >= DATA_TABLE_MAX_COLUMNS)
+            boost::throw_exception(variant_error("Reached maximum column capacity"));
+
+        for ( const auto& column : m_columns )
+            if (column.name() == name)
+                boost::throw_exception(variant_error("Column name already in use"));
+    }
+
+    data_table& data_table::add_column(const std::string& name, const data_table_expression& expression)
+    {
+        check_new_column(name);
+        m_columns.push_back(expression.evaluate(m_columns, name));
+        return *this;
+    }
+
     data_table& data_table::add_column(variant_base::enum_type_t type)
     {
         return add_column(type, boost::str( boost::format("Column%d") % (m_columns.size() + 1) ));
     }
 
+    // The caller may change the values of a column it has mutable access to, which the
+    // indexes would not see, so they are rebuilt on their next lookup
     data_table_column_base& data_table::get_column(size_t i)
     {
-        if (i >= m_columns.size())
-            boost::throw_exception(variant_error("Column out of range"));
-
-        return m_columns[i];
+        data_table_column_base& column(const_cast<data_table_column_base&>(static_cast<const data_table*>(this)->get_column(i)));
+        reset_indexes();
+        return column;
     }
 
     data_table_column_base& data_table::get_column(const std::string& name)
     {
-        BOOST_FOREACH(column_container_type::reference column, m_columns)
-            if (column.name() == name)
-                return column;
-
-        boost::throw_exception(variant_error(boost::str(boost::format("No such column '%s'") % name)));
+        data_table_column_base& column(const_cast<data_table_column_base&>(static_cast<const data_table*>(this)->get_column(name)));
+        reset_indexes();
+        return column;
     }
 
     const data_table_column_base& data_table::get_column(size_t i) const
     {
-        return const_cast<data_table*>(this)->get_column(i);
+        if (i >= m_columns.size())
+            boost::throw_exception(variant_error("Column out of range"));
+
+        return m_columns[i];
     }
 
     const data_table_column_base& data_table::get_column(const std::string& name) const
     {
-        return const_cast<data_table*>(this)->get_column(name);
+        BOOST_FOREACH(column_container_type::const_reference column, m_columns)
+            if (column.name() == name)
+                return column;
+
+        boost::throw_exception(variant_error(boost::str(boost::format("No such column '%s'") % name)));
     }
 
     const data_table::column_container_type& data_table::columns() const
@@ -81,6 +122,7 @@ namespace protean { namespace detail {
 
     data_table::column_container_type& data_table::columns()
     {
+        reset_indexes();
         return m_columns;
     }
 
@@ -89,6 +131,23 @@ namespace protean { namespace detail {
         return m_columns.empty() || get_column(0).empty();
     }
 
+    data_table& data_table::reserve(size_t rows)
+    {
+        BOOST_FOREACH(column_container_type::reference column, m_columns)
+            column.reserve(rows);
+
+        return *this;
+    }
+
+    size_t data_table::capacity() const
+    {
+        size_t rows(m_columns.empty() ? 0 : get_column(0).capacity());
+        BOOST_FOREACH(column_container_type::const_reference column, m_columns)
+            rows = (std::min)(rows, column.capacity());
+
+        return rows;
+    }
+
     size_t data_table::size() const
     {
         return empty() ? 0 : get_column(0).size();
@@ -98,6 +157,8 @@ namespace protean { namespace detail {
     {
         BOOST_FOREACH(column_container_type::reference column, m_columns)
             column.clear();
+
+        reset_indexes();
     }
 
     int data_table::compare(const collection& rhs) const
@@ -170,6 +231,8 @@ namespace protean { namespace detail {
 
     variant_iterator_base* data_table::begin()
     {
+        reset_indexes();
+
         std::vector<variant_iterator<iterator_traits> > column_iterators;
         for (column_container_type::iterator iter = m_columns.begin(); iter != m_columns.end(); ++iter)
             column_iterators.push_back(iter->begin());
@@ -179,6 +242,8 @@ namespace protean { namespace detail {
 
     variant_iterator_base* data_table::end()
     {
+        reset_indexes();
+
         std::vector<variant_iterator<iterator_traits> > column_iterators;
         for (column_container_type::iterator iter = m_columns.begin(); iter != m_columns.end(); ++iter)
             column_iterators.push_back(iter->end());
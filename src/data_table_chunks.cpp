@@ -0,0 +1,64 @@
+#include <protean/data_table_chunks.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/throw_exception.hpp>
+
+namespace protean {
+
+    const size_t data_table_chunks::default_chunk_size;
+
+    data_table_chunks::data_table_chunks(size_t chunk_size /* = default_chunk_size */) :
+        m_schema(variant::DataTable),
+        m_chunk_size(chunk_size),
+        m_size(0)
+    {
+        if (chunk_size==0)
+        {
+            boost::throw_exception(variant_error("Chunks of a DataTable must hold at least one row"));
+        }
+    }
+
+    data_table_chunks& data_table_chunks::add_column(variant_base::enum_type_t type, const std::string& name, data_table_column_base::encoding_t encoding /* = data_table_column_base::PlainEncoding */)
+    {
+        if (!m_chunks.empty())
+        {
+            boost::throw_exception(variant_error("Attempt to add column '" + name + "' to a chunked DataTable with rows"));
+        }
+
+        m_schema.add_column(type, name, encoding);
+        return *this;
+    }
+
+    variant& data_table_chunks::writable_chunk()
+    {
+        if (m_chunks.empty() || m_chunks.back().size()>=m_chunk_size)
+        {
+            m_chunks.push_back(new variant(m_schema));
+            m_chunks.back().reserve(m_chunk_size);
+        }
+        return m_chunks.back();
+    }
+
+    variant data_table_chunks::release()
+    {
+        variant result(m_schema);
+        result.reserve(m_size);
+
+        variant::column_collection_t& columns(result.columns());
+        for (boost::ptr_vector<variant>::iterator itr = m_chunks.begin(); itr != m_chunks.end(); ++itr)
+        {
+            const variant::column_collection_t& chunk_columns(itr->columns());
+            for (size_t i=0; i<columns.size(); ++i)
+            {
+                columns[i].extend(chunk_columns[i]);
+            }
+
+            *itr = variant();
+        }
+
+        m_chunks.clear();
+        m_size = 0;
+        return result;
+    }
+
+} // namespace protean
@@ -0,0 +1,1179 @@
+#include <protean/data_table_expression.hpp>
+#include <protean/detail/data_table_column.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/type_traits/common_type.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace protean {
+
+    namespace detail {
+
+        struct expression_node
+        {
+            enum enum_kind_t { Column, Literal, Operator };
+
+            enum_kind_t                                             m_kind;
+
+            // column name, or value of a String literal
+            std::string                                             m_name;
+
+            // type and value of other literals, Boolean and time literals are held as integers
+            variant_base::enum_type_t                               m_type;
+            boost::int64_t                                          m_integer;
+            double                                                  m_number;
+
+            data_table_expression::enum_operator_t                  m_op;
+            std::vector<boost::shared_ptr<const expression_node> >  m_operands;
+        };
+
+    } // namespace detail
+
+    namespace {
+
+        // Rows are evaluated in batches of this size, small enough for the intermediate
+        // results of an expression to stay in cache
+        static const size_t s_batch_size = 4096;
+
+        // How values are represented during evaluation: Boolean as bytes, integers as Int64
+        // but for UInt64, which is kept unsigned, floating point as Double, strings as pointers
+        // to their characters and dates and times as microseconds from the epoch
+        enum enum_kind_t { BooleanKind, IntegerKind, UnsignedKind, NumberKind, StringKind, TimeKind };
+
+        const boost::gregorian::date s_epoch_date(1970, 1, 1);
+        const boost::posix_time::ptime s_epoch(s_epoch_date);
+        const boost::int64_t s_microseconds_per_day = 86400000000LL;
+
+        enum_kind_t kind_of(variant_base::enum_type_t type)
+        {
+            switch (type)
+            {
+                case variant_base::Boolean:
+                    return BooleanKind;
+                case variant_base::Int32:
+                case variant_base::UInt32:
+                case variant_base::Int64:
+                    return IntegerKind;
+                case variant_base::UInt64:
+                    return UnsignedKind;
+                case variant_base::Float:
+                case variant_base::Double:
+                    return NumberKind;
+                case variant_base::String:
+                case variant_base::Any:
+                    return StringKind;
+                case variant_base::Date:
+                case variant_base::Time:
+                case variant_base::DateTime:
+                    return TimeKind;
+                default:
+                    boost::throw_exception(variant_error("Values of type " + variant_base::enum_to_string(type) + " cannot be used in DataTable expressions"));
+            }
+            return BooleanKind;
+        }
+
+        // special values sort before (not_a_date_time, then -infinity) or after (+infinity) all others
+        const boost::int64_t s_not_a_date_time_ticks = (std::numeric_limits<boost::int64_t>::min)();
+        const boost::int64_t s_neg_infin_ticks = (std::numeric_limits<boost::int64_t>::min)() + 1;
+        const boost::int64_t s_pos_infin_ticks = (std::numeric_limits<boost::int64_t>::max)();
+
+        template <typename T>
+        boost::int64_t special_ticks(const T& value)
+        {
+            return value.is_pos_infinity() ? s_pos_infin_ticks : (value.is_neg_infinity() ? s_neg_infin_ticks : s_not_a_date_time_ticks);
+        }
+
+        boost::int64_t to_ticks(const boost::posix_time::ptime& value)
+        {
+            return value.is_special() ? special_ticks(value) : (value - s_epoch).total_microseconds();
+        }
+
+        boost::int64_t to_ticks(const boost::gregorian::date& value)
+        {
+            return value.is_special() ? special_ticks(value) : (value - s_epoch_date).days() * s_microseconds_per_day;
+        }
+
+        boost::int64_t to_ticks(const boost::posix_time::time_duration& value)
+        {
+            return value.is_special() ? special_ticks(value) : value.total_microseconds();
+        }
+
+        void from_ticks(boost::int64_t ticks, boost::posix_time::ptime& value)
+        {
+            if (ticks==s_pos_infin_ticks)
+                value = boost::posix_time::ptime(boost::posix_time::pos_infin);
+            else if (ticks==s_neg_infin_ticks)
+                value = boost::posix_time::ptime(boost::posix_time::neg_infin);
+            else if (ticks==s_not_a_date_time_ticks)
+                value = boost::posix_time::ptime(boost::posix_time::not_a_date_time);
+            else
+                value = s_epoch + boost::posix_time::microseconds(ticks);
+        }
+
+        void from_ticks(boost::int64_t ticks, boost::gregorian::date& value)
+        {
+            if (ticks==s_pos_infin_ticks)
+                value = boost::gregorian::date(boost::gregorian::pos_infin);
+            else if (ticks==s_neg_infin_ticks)
+                value = boost::gregorian::date(boost::gregorian::neg_infin);
+            else if (ticks==s_not_a_date_time_ticks)
+                value = boost::gregorian::date(boost::gregorian::not_a_date_time);
+            else
+                value = s_epoch_date + boost::gregorian::days(static_cast<long>(ticks / s_microseconds_per_day - (ticks % s_microseconds_per_day < 0 ? 1 : 0)));
+        }
+
+        void from_ticks(boost::int64_t ticks, boost::posix_time::time_duration& value)
+        {
+            if (ticks==s_pos_infin_ticks)
+                value = boost::posix_time::time_duration(boost::posix_time::pos_infin);
+            else if (ticks==s_neg_infin_ticks)
+                value = boost::posix_time::time_duration(boost::posix_time::neg_infin);
+            else if (ticks==s_not_a_date_time_ticks)
+                value = boost::posix_time::time_duration(boost::posix_time::not_a_date_time);
+            else
+                value = boost::posix_time::microseconds(ticks);
+        }
+
+        /* The values of one batch of rows, pointing either into a column or into the  */
+        /* evaluator's own storage                                                     */
+        /*******************************************************************************/
+        struct batch
+        {
+            batch() :
+                booleans(nullptr),
+                integers(nullptr),
+                unsigneds(nullptr),
+                numbers(nullptr),
+                strings(nullptr)
+            {}
+
+            const boost::uint8_t*       booleans;
+            const boost::int64_t*       integers;
+            const boost::uint64_t*      unsigneds;
+            const double*               numbers;
+            const char* const*          strings;
+
+            std::vector<boost::uint8_t> m_booleans;
+            std::vector<boost::int64_t> m_integers;
+            std::vector<boost::uint64_t> m_unsigneds;
+            std::vector<double>         m_numbers;
+            std::vector<const char*>    m_strings;
+        };
+
+        class evaluator
+        {
+        public:
+            evaluator(enum_kind_t kind, variant_base::enum_type_t type, bool literal = false) :
+                m_kind(kind),
+                m_type(type),
+                m_literal(literal)
+            {}
+            virtual ~evaluator() {}
+
+            enum_kind_t kind() const                { return m_kind; }
+            variant_base::enum_type_t type() const  { return m_type; }
+
+            // Evaluates rows [first, first + count), where count <= s_batch_size, into
+            // result(), which is valid until the next call
+            virtual void evaluate(size_t first, size_t count) = 0;
+
+            const batch& result() const             { return m_result; }
+
+            // Literals hold the same value for every row
+            bool is_literal() const                 { return m_literal; }
+
+        protected:
+            const enum_kind_t               m_kind;
+            const variant_base::enum_type_t m_type;
+            const bool                      m_literal;
+            batch                           m_result;
+        };
+
+        /* Column references */
+        /*********************/
+        template <typename Iterator>
+        void load(Iterator values, size_t count, batch& result, double*)
+        {
+            result.m_numbers.resize(s_batch_size);
+            for (size_t i=0; i<count; ++i)
+            {
+                result.m_numbers[i] = static_cast<double>(values[i]);
+            }
+            result.numbers = &result.m_numbers[0];
+        }
+
+        template <typename Iterator>
+        void load(Iterator values, size_t count, batch& result, boost::int64_t*)
+        {
+            result.m_integers.resize(s_batch_size);
+            for (size_t i=0; i<count; ++i)
+            {
+                result.m_integers[i] = static_cast<boost::int64_t>(values[i]);
+            }
+            result.integers = &result.m_integers[0];
+        }
+
+        // Double, Int64 and UInt64 columns are evaluated in place
+        inline void load(std::vector<double>::const_iterator values, size_t /*count*/, batch& result, double*)
+        {
+            result.numbers = &*values;
+        }
+
+        inline void load(std::vector<boost::int64_t>::const_iterator values, size_t /*count*/, batch& result, boost::int64_t*)
+        {
+            result.integers = &*values;
+        }
+
+        inline void load(std::vector<boost::uint64_t>::const_iterator values, size_t /*count*/, batch& result, boost::uint64_t*)
+        {
+            result.unsigneds = &*values;
+        }
+
+        template <typename Iterator>
+        void load(Iterator values, size_t count, batch& result, boost::uint8_t*)
+        {
+            result.m_booleans.resize(s_batch_size);
+            for (size_t i=0; i<count; ++i, ++values)
+            {
+                result.m_booleans[i] = *values ? 1 : 0;
+            }
+            result.booleans = &result.m_booleans[0];
+        }
+
+        template <typename Iterator>
+        void load(Iterator values, size_t count, batch& result, const char**)
+        {
+            result.m_strings.resize(s_batch_size);
+            for (size_t i=0; i<count; ++i)
+            {
+                result.m_strings[i] = values[i].value();
+            }
+            result.strings = &result.m_strings[0];
+        }
+
+        struct ticks_tag {};
+
+        template <typename Iterator>
+        void load(Iterator values, size_t count, batch& result, ticks_tag*)
+        {
+            result.m_integers.resize(s_batch_size);
+            for (size_t i=0; i<count; ++i)
+            {
+                result.m_integers[i] = to_ticks(values[i]);
+            }
+            result.integers = &result.m_integers[0];
+        }
+
+        // representation of each column type during evaluation
+        template <variant_base::enum_type_t E> struct column_kind                { typedef boost::int64_t type; };
+        template <> struct column_kind<variant_base::Boolean>                    { typedef boost::uint8_t type; };
+        template <> struct column_kind<variant_base::UInt64>                     { typedef boost::uint64_t type; };
+        template <> struct column_kind<variant_base::Float>                      { typedef double type; };
+        template <> struct column_kind<variant_base::Double>                     { typedef double type; };
+        template <> struct column_kind<variant_base::String>                     { typedef const char* type; };
+        template <> struct column_kind<variant_base::Any>                        { typedef const char* type; };
+        template <> struct column_kind<variant_base::Date>                       { typedef ticks_tag type; };
+        template <> struct column_kind<variant_base::Time>                       { typedef ticks_tag type; };
+        template <> struct column_kind<variant_base::DateTime>                   { typedef ticks_tag type; };
+
+        template <variant_base::enum_type_t E>
+        class column_evaluator : public evaluator
+        {
+        public:
+            explicit column_evaluator(const data_table_column_base& column) :
+                evaluator(kind_of(E), result_type()),
+                m_column(column)
+            {}
+
+            virtual void evaluate(size_t first, size_t count)
+            {
+                load(m_column.begin<E>() + first, count, m_result, static_cast<typename column_kind<E>::type*>(nullptr));
+            }
+
+        private:
+            static variant_base::enum_type_t result_type()
+            {
+                switch (kind_of(E))
+                {
+                    case IntegerKind:   return variant_base::Int64;
+                    case UnsignedKind:  return variant_base::UInt64;
+                    case NumberKind:    return variant_base::Double;
+                    case StringKind:    return variant_base::String;
+                    default:            return E;
+                }
+            }
+
+        private:
+            const data_table_column_base& m_column;
+        };
+
+        /* Literals, held as a batch of copies */
+        /***************************************/
+        class literal_evaluator : public evaluator
+        {
+        public:
+            explicit literal_evaluator(const detail::expression_node& node) :
+                evaluator(kind_of(node.m_type), node.m_type, true)
+            {
+                switch (m_kind)
+                {
+                    case BooleanKind:
+                        m_result.m_booleans.assign(s_batch_size, node.m_integer!=0 ? 1 : 0);
+                        m_result.booleans = &m_result.m_booleans[0];
+                        break;
+                    case IntegerKind:
+                    case TimeKind:
+                        m_result.m_integers.assign(s_batch_size, node.m_integer);
+                        m_result.integers = &m_result.m_integers[0];
+                        break;
+                    case UnsignedKind:
+                        m_result.m_unsigneds.assign(s_batch_size, static_cast<boost::uint64_t>(node.m_integer));
+                        m_result.unsigneds = &m_result.m_unsigneds[0];
+                        break;
+                    case NumberKind:
+                        m_result.m_numbers.assign(s_batch_size, node.m_number);
+                        m_result.numbers = &m_result.m_numbers[0];
+                        break;
+                    case StringKind:
+                        m_value = node.m_name;
+                        m_result.m_strings.assign(s_batch_size, m_value.c_str());
+                        m_result.strings = &m_result.m_strings[0];
+                        break;
+                }
+            }
+
+            virtual void evaluate(size_t /*first*/, size_t /*count*/)
+            {
+            }
+
+        private:
+            std::string m_value;
+        };
+
+        /* Kernels */
+        /***********/
+
+        // Operands of a kernel, either a batch of values or a single literal value
+        template <typename T>
+        struct array_operand
+        {
+            explicit array_operand(const T* values) : m_values(values) {}
+            T operator[](size_t i) const { return m_values[i]; }
+            const T* m_values;
+        };
+
+        template <typename T>
+        struct scalar_operand
+        {
+            explicit scalar_operand(T value) : m_value(value) {}
+            T operator[](size_t) const { return m_value; }
+            const T m_value;
+        };
+
+        template <typename L, typename R, typename T, typename Op>
+        void apply(L lhs, R rhs, size_t count, T* result, Op op)
+        {
+            for (size_t i=0; i<count; ++i)
+            {
+                result[i] = op(lhs[i], rhs[i]);
+            }
+        }
+
+        // Int64 and UInt64 operands are compared by value, rather than as UInt64
+        inline int compare_integers(boost::int64_t lhs, boost::uint64_t rhs)
+        {
+            return lhs<0 || static_cast<boost::uint64_t>(lhs)<rhs ? -1 : (static_cast<boost::uint64_t>(lhs)==rhs ? 0 : 1);
+        }
+
+        inline int compare_integers(boost::uint64_t lhs, boost::int64_t rhs)
+        {
+            return -compare_integers(rhs, lhs);
+        }
+
+        #define PROTEAN_EXPRESSION_COMPARISON(name, op)                                                     \
+            struct name                                                                                     \
+            {                                                                                               \
+                template <typename L, typename R> bool operator()(L lhs, R rhs) const { return lhs op rhs; } \
+                bool operator()(boost::int64_t lhs, boost::uint64_t rhs) const { return compare_integers(lhs, rhs) op 0; } \
+                bool operator()(boost::uint64_t lhs, boost::int64_t rhs) const { return compare_integers(lhs, rhs) op 0; } \
+            };
+
+        // Other operations on mixed Int64 and Double operands follow the usual arithmetic
+        // conversions, UInt64 operands of arithmetic are first converted to Double but for
+        // UInt64 with UInt64, see arithmetic_evaluator
+        PROTEAN_EXPRESSION_COMPARISON(equal_op, ==)
+        PROTEAN_EXPRESSION_COMPARISON(not_equal_op, !=)
+        PROTEAN_EXPRESSION_COMPARISON(less_op, <)
+        PROTEAN_EXPRESSION_COMPARISON(less_equal_op, <=)
+        PROTEAN_EXPRESSION_COMPARISON(greater_op, >)
+        PROTEAN_EXPRESSION_COMPARISON(greater_equal_op, >=)
+
+        #undef PROTEAN_EXPRESSION_COMPARISON
+
+        struct plus_op          { template <typename L, typename R> typename boost::common_type<L, R>::type operator()(L lhs, R rhs) const { return lhs + rhs; } };
+        struct minus_op         { template <typename L, typename R> typename boost::common_type<L, R>::type operator()(L lhs, R rhs) const { return lhs - rhs; } };
+        struct multiplies_op    { template <typename L, typename R> typename boost::common_type<L, R>::type operator()(L lhs, R rhs) const { return lhs * rhs; } };
+        struct divides_op       { template <typename L, typename R> double operator()(L lhs, R rhs) const { return static_cast<double>(lhs) / rhs; } };
+
+        struct string_equal     { bool operator()(const char* lhs, const char* rhs) const { return lhs==rhs || std::strcmp(lhs, rhs)==0; } };
+        struct string_not_equal { bool operator()(const char* lhs, const char* rhs) const { return lhs!=rhs && std::strcmp(lhs, rhs)!=0; } };
+        struct string_less      { bool operator()(const char* lhs, const char* rhs) const { return std::strcmp(lhs, rhs)<0; } };
+        struct string_less_eq   { bool operator()(const char* lhs, const char* rhs) const { return std::strcmp(lhs, rhs)<=0; } };
+        struct string_greater   { bool operator()(const char* lhs, const char* rhs) const { return std::strcmp(lhs, rhs)>0; } };
+        struct string_greater_eq{ bool operator()(const char* lhs, const char* rhs) const { return std::strcmp(lhs, rhs)>=0; } };
+
+        // Integer (and date/time), UInt64 or Double operands, as a batch or, for literals, a scalar
+        template <typename L, typename T, typename Op>
+        void apply_numeric(L lhs, const evaluator& rhs, size_t count, T* result, Op op)
+        {
+            const batch& values(rhs.result());
+            if (rhs.kind()==NumberKind)
+            {
+                if (rhs.is_literal())
+                    apply(lhs, scalar_operand<double>(values.numbers[0]), count, result, op);
+                else
+                    apply(lhs, array_operand<double>(values.numbers), count, result, op);
+            }
+            else if (rhs.kind()==UnsignedKind)
+            {
+                if (rhs.is_literal())
+                    apply(lhs, scalar_operand<boost::uint64_t>(values.unsigneds[0]), count, result, op);
+                else
+                    apply(lhs, array_operand<boost::uint64_t>(values.unsigneds), count, result, op);
+            }
+            else
+            {
+                if (rhs.is_literal())
+                    apply(lhs, scalar_operand<boost::int64_t>(values.integers[0]), count, result, op);
+                else
+                    apply(lhs, array_operand<boost::int64_t>(values.integers), count, result, op);
+            }
+        }
+
+        template <typename T, typename Op>
+        void apply_numeric(const evaluator& lhs, const evaluator& rhs, size_t count, T* result, Op op)
+        {
+            const batch& values(lhs.result());
+            if (lhs.kind()==NumberKind)
+                apply_numeric(array_operand<double>(values.numbers), rhs, count, result, op);
+            else if (lhs.kind()==UnsignedKind)
+                apply_numeric(array_operand<boost::uint64_t>(values.unsigneds), rhs, count, result, op);
+            else
+                apply_numeric(array_operand<boost::int64_t>(values.integers), rhs, count, result, op);
+        }
+
+        template <typename T>
+        void compare(data_table_expression::enum_operator_t op, const evaluator& lhs, const evaluator& rhs, size_t count, T* result)
+        {
+            switch (op)
+            {
+                case data_table_expression::Equal:          apply_numeric(lhs, rhs, count, result, equal_op());         break;
+                case data_table_expression::NotEqual:       apply_numeric(lhs, rhs, count, result, not_equal_op());     break;
+                case data_table_expression::Less:           apply_numeric(lhs, rhs, count, result, less_op());          break;
+                case data_table_expression::LessEqual:      apply_numeric(lhs, rhs, count, result, less_equal_op());    break;
+                case data_table_expression::Greater:        apply_numeric(lhs, rhs, count, result, greater_op());       break;
+                case data_table_expression::GreaterEqual:   apply_numeric(lhs, rhs, count, result, greater_equal_op()); break;
+                default:
+                    break;
+            }
+        }
+
+        template <typename T>
+        void compare(data_table_expression::enum_operator_t op, const T* lhs, const T* rhs, size_t count, boost::uint8_t* result)
+        {
+            const array_operand<T> l(lhs), r(rhs);
+            switch (op)
+            {
+                case data_table_expression::Equal:          apply(l, r, count, result, equal_op());         break;
+                case data_table_expression::NotEqual:       apply(l, r, count, result, not_equal_op());     break;
+                case data_table_expression::Less:           apply(l, r, count, result, less_op());          break;
+                case data_table_expression::LessEqual:      apply(l, r, count, result, less_equal_op());    break;
+                case data_table_expression::Greater:        apply(l, r, count, result, greater_op());       break;
+                case data_table_expression::GreaterEqual:   apply(l, r, count, result, greater_equal_op()); break;
+                default:
+                    break;
+            }
+        }
+
+        inline void compare(data_table_expression::enum_operator_t op, const char* const* lhs, const char* const* rhs, size_t count, boost::uint8_t* result)
+        {
+            const array_operand<const char*> l(lhs), r(rhs);
+            switch (op)
+            {
+                case data_table_expression::Equal:          apply(l, r, count, result, string_equal());       break;
+                case data_table_expression::NotEqual:       apply(l, r, count, result, string_not_equal());   break;
+                case data_table_expression::Less:           apply(l, r, count, result, string_less());        break;
+                case data_table_expression::LessEqual:      apply(l, r, count, result, string_less_eq());     break;
+                case data_table_expression::Greater:        apply(l, r, count, result, string_greater());     break;
+                case data_table_expression::GreaterEqual:   apply(l, r, count, result, string_greater_eq());  break;
+                default:
+                    break;
+            }
+        }
+
+        template <typename T>
+        void arithmetic(data_table_expression::enum_operator_t op, const evaluator& lhs, const evaluator& rhs, size_t count, T* result)
+        {
+            switch (op)
+            {
+                case data_table_expression::Add:        apply_numeric(lhs, rhs, count, result, plus_op());          break;
+                case data_table_expression::Subtract:   apply_numeric(lhs, rhs, count, result, minus_op());         break;
+                case data_table_expression::Multiply:   apply_numeric(lhs, rhs, count, result, multiplies_op());    break;
+                case data_table_expression::Divide:     apply_numeric(lhs, rhs, count, result, divides_op());       break;
+                default:
+                    break;
+            }
+        }
+
+        bool is_numeric(enum_kind_t kind)
+        {
+            return kind==IntegerKind || kind==UnsignedKind || kind==NumberKind;
+        }
+
+        std::string kind_to_string(enum_kind_t kind)
+        {
+            switch (kind)
+            {
+                case BooleanKind:   return "Boolean";
+                case IntegerKind:   return "Integer";
+                case UnsignedKind:  return "UInt64";
+                case NumberKind:    return "Double";
+                case StringKind:    return "String";
+                default:            return "Date/Time";
+            }
+        }
+
+        /* Operators */
+        /*************/
+        class comparison_evaluator : public evaluator
+        {
+        public:
+            comparison_evaluator(data_table_expression::enum_operator_t op, const boost::shared_ptr<evaluator>& lhs, const boost::shared_ptr<evaluator>& rhs) :
+                evaluator(BooleanKind, variant_base::Boolean),
+                m_op(op),
+                m_lhs(lhs),
+                m_rhs(rhs)
+            {
+                const enum_kind_t lhs_kind(lhs->kind()), rhs_kind(rhs->kind());
+                const bool numeric(is_numeric(lhs_kind) && is_numeric(rhs_kind));
+
+                if (!numeric && lhs_kind!=rhs_kind)
+                {
+                    boost::throw_exception(variant_error("Cannot compare " + kind_to_string(lhs_kind) + " with " + kind_to_string(rhs_kind) + " in DataTable expression"));
+                }
+
+                m_result.m_booleans.resize(s_batch_size);
+                m_result.booleans = &m_result.m_booleans[0];
+            }
+
+            virtual void evaluate(size_t first, size_t count)
+            {
+                m_lhs->evaluate(first, count);
+                m_rhs->evaluate(first, count);
+
+                boost::uint8_t* result(&m_result.m_booleans[0]);
+
+                switch (m_lhs->kind())
+                {
+                    case BooleanKind:
+                        compare(m_op, m_lhs->result().booleans, m_rhs->result().booleans, count, result);
+                        break;
+                    case StringKind:
+                        compare(m_op, m_lhs->result().strings, m_rhs->result().strings, count, result);
+                        break;
+                    default:
+                        compare(m_op, *m_lhs, *m_rhs, count, result);
+                        break;
+                }
+            }
+
+        private:
+            const data_table_expression::enum_operator_t    m_op;
+            boost::shared_ptr<evaluator>                    m_lhs;
+            boost::shared_ptr<evaluator>                    m_rhs;
+        };
+
+        class logical_evaluator : public evaluator
+        {
+        public:
+            logical_evaluator(data_table_expression::enum_operator_t op, const boost::shared_ptr<evaluator>& lhs, const boost::shared_ptr<evaluator>& rhs) :
+                evaluator(BooleanKind, variant_base::Boolean),
+                m_op(op),
+                m_lhs(lhs),
+                m_rhs(rhs)
+            {
+                if (lhs->kind()!=BooleanKind || (rhs && rhs->kind()!=BooleanKind))
+                {
+                    boost::throw_exception(variant_error("Operands of logical operators in DataTable expressions must be Boolean"));
+                }
+
+                m_result.m_booleans.resize(s_batch_size);
+                m_result.booleans = &m_result.m_booleans[0];
+            }
+
+            virtual void evaluate(size_t first, size_t count)
+            {
+                m_lhs->evaluate(first, count);
+
+                const boost::uint8_t* lhs(m_lhs->result().booleans);
+                boost::uint8_t* result(&m_result.m_booleans[0]);
+
+                if (m_op==data_table_expression::Not)
+                {
+                    for (size_t i=0; i<count; ++i)
+                    {
+                        result[i] = lhs[i] ^ 1;
+                    }
+                    return;
+                }
+
+                m_rhs->evaluate(first, count);
+                const boost::uint8_t* rhs(m_rhs->result().booleans);
+
+                if (m_op==data_table_expression::And)
+                {
+                    apply(lhs, rhs, count, result, std::bit_and<boost::uint8_t>());
+                }
+                else
+                {
+                    apply(lhs, rhs, count, result, std::bit_or<boost::uint8_t>());
+                }
+            }
+
+        private:
+            const data_table_expression::enum_operator_t    m_op;
+            boost::shared_ptr<evaluator>                    m_lhs;
+            boost::shared_ptr<evaluator>                    m_rhs;
+        };
+
+        // UInt64 values as Double
+        class number_evaluator : public evaluator
+        {
+        public:
+            explicit number_evaluator(const boost::shared_ptr<evaluator>& operand) :
+                evaluator(NumberKind, variant_base::Double),
+                m_operand(operand)
+            {
+                m_result.m_numbers.resize(s_batch_size);
+                m_result.numbers = &m_result.m_numbers[0];
+            }
+
+            virtual void evaluate(size_t first, size_t count)
+            {
+                m_operand->evaluate(first, count);
+
+                const boost::uint64_t* operand(m_operand->result().unsigneds);
+                for (size_t i=0; i<count; ++i)
+                {
+                    m_result.m_numbers[i] = static_cast<double>(operand[i]);
+                }
+            }
+
+        private:
+            boost::shared_ptr<evaluator> m_operand;
+        };
+
+        class arithmetic_evaluator : public evaluator
+        {
+        public:
+            // Integer operands give an Integer result, and UInt64 operands a UInt64 result,
+            // except for division and negation
+            arithmetic_evaluator(data_table_expression::enum_operator_t op, const boost::shared_ptr<evaluator>& lhs, const boost::shared_ptr<evaluator>& rhs) :
+                evaluator(result_kind(op, lhs.get(), rhs.get()), result_type(result_kind(op, lhs.get(), rhs.get()))),
+                m_op(op),
+                m_lhs(as_operand(lhs)),
+                m_rhs(as_operand(rhs))
+            {
+                if (m_kind==IntegerKind)
+                {
+                    m_result.m_integers.resize(s_batch_size);
+                    m_result.integers = &m_result.m_integers[0];
+                }
+                else if (m_kind==UnsignedKind)
+                {
+                    m_result.m_unsigneds.resize(s_batch_size);
+                    m_result.unsigneds = &m_result.m_unsigneds[0];
+                }
+                else
+                {
+                    m_result.m_numbers.resize(s_batch_size);
+                    m_result.numbers = &m_result.m_numbers[0];
+                }
+            }
+
+            virtual void evaluate(size_t first, size_t count)
+            {
+                m_lhs->evaluate(first, count);
+
+                if (m_op==data_table_expression::Negate)
+                {
+                    if (m_kind==IntegerKind)
+                    {
+                        const boost::int64_t* operand(m_lhs->result().integers);
+                        for (size_t i=0; i<count; ++i)
+                        {
+                            m_result.m_integers[i] = -operand[i];
+                        }
+                    }
+                    else
+                    {
+                        const double* operand(m_lhs->result().numbers);
+                        for (size_t i=0; i<count; ++i)
+                        {
+                            m_result.m_numbers[i] = -operand[i];
+                        }
+                    }
+                    return;
+                }
+
+                m_rhs->evaluate(first, count);
+
+                if (m_kind==IntegerKind)
+                {
+                    arithmetic(m_op, *m_lhs, *m_rhs, count, &m_result.m_integers[0]);
+                }
+                else if (m_kind==UnsignedKind)
+                {
+                    arithmetic(m_op, *m_lhs, *m_rhs, count, &m_result.m_unsigneds[0]);
+                }
+                else
+                {
+                    arithmetic(m_op, *m_lhs, *m_rhs, count, &m_result.m_numbers[0]);
+                }
+            }
+
+        private:
+            static enum_kind_t result_kind(data_table_expression::enum_operator_t op, const evaluator* lhs, const evaluator* rhs)
+            {
+                const bool numeric(is_numeric(lhs->kind()) && (rhs==nullptr || is_numeric(rhs->kind())));
+                if (!numeric)
+                {
+                    boost::throw_exception(variant_error("Operands of arithmetic operators in DataTable expressions must be numeric"));
+                }
+
+                const bool integer(lhs->kind()==IntegerKind && (rhs==nullptr || rhs->kind()==IntegerKind));
+                const bool unsigned_integer(lhs->kind()==UnsignedKind && rhs!=nullptr && rhs->kind()==UnsignedKind);
+                if (op==data_table_expression::Divide)
+                {
+                    return NumberKind;
+                }
+                return integer ? IntegerKind : (unsigned_integer ? UnsignedKind : NumberKind);
+            }
+
+            static variant_base::enum_type_t result_type(enum_kind_t kind)
+            {
+                return kind==IntegerKind ? variant_base::Int64 : (kind==UnsignedKind ? variant_base::UInt64 : variant_base::Double);
+            }
+
+            // UInt64 operands of a Double result are converted first, so that they are not
+            // mixed with Int64 as UInt64
+            boost::shared_ptr<evaluator> as_operand(const boost::shared_ptr<evaluator>& operand) const
+            {
+                if (m_kind==NumberKind && operand && operand->kind()==UnsignedKind)
+                {
+                    return boost::make_shared<number_evaluator>(operand);
+                }
+                return operand;
+            }
+
+        private:
+            const data_table_expression::enum_operator_t    m_op;
+            boost::shared_ptr<evaluator>                    m_lhs;
+            boost::shared_ptr<evaluator>                    m_rhs;
+        };
+
+        /* Binding of expressions to the columns of a table */
+        /****************************************************/
+        evaluator* bind_column(const data_table_column_base& column)
+        {
+            switch (column.type())
+            {
+                case variant_base::Boolean:     return new column_evaluator<variant_base::Boolean>(column);
+                case variant_base::Int32:       return new column_evaluator<variant_base::Int32>(column);
+                case variant_base::UInt32:      return new column_evaluator<variant_base::UInt32>(column);
+                case variant_base::Int64:       return new column_evaluator<variant_base::Int64>(column);
+                case variant_base::UInt64:      return new column_evaluator<variant_base::UInt64>(column);
+                case variant_base::Float:       return new column_evaluator<variant_base::Float>(column);
+                case variant_base::Double:      return new column_evaluator<variant_base::Double>(column);
+                case variant_base::String:      return new column_evaluator<variant_base::String>(column);
+                case variant_base::Any:         return new column_evaluator<variant_base::Any>(column);
+                case variant_base::Date:        return new column_evaluator<variant_base::Date>(column);
+                case variant_base::Time:        return new column_evaluator<variant_base::Time>(column);
+                case variant_base::DateTime:    return new column_evaluator<variant_base::DateTime>(column);
+                default:
+                    boost::throw_exception(variant_error(boost::str(boost::format("Column '%s' of type %s cannot be used in DataTable expressions")
+                        % column.name()
+                        % variant_base::enum_to_string(column.type()))));
+            }
+            return nullptr;
+        }
+
+        boost::shared_ptr<evaluator> bind(const detail::expression_node& node, const data_table_expression::column_collection_t& columns)
+        {
+            switch (node.m_kind)
+            {
+                case detail::expression_node::Column:
+                {
+                    for (data_table_expression::column_collection_t::const_iterator citr = columns.begin(); citr != columns.end(); ++citr)
+                    {
+                        if (citr->name()==node.m_name)
+                        {
+                            return boost::shared_ptr<evaluator>(bind_column(*citr));
+                        }
+                    }
+                    boost::throw_exception(variant_error("No such column '" + node.m_name + "' in DataTable expression"));
+                }
+                case detail::expression_node::Literal:
+                    return boost::make_shared<literal_evaluator>(node);
+                default:
+                    break;
+            }
+
+            const boost::shared_ptr<evaluator> lhs(bind(*node.m_operands[0], columns));
+            const boost::shared_ptr<evaluator> rhs(node.m_operands.size()>1 ? bind(*node.m_operands[1], columns) : boost::shared_ptr<evaluator>());
+
+            switch (node.m_op)
+            {
+                case data_table_expression::Equal:
+                case data_table_expression::NotEqual:
+                case data_table_expression::Less:
+                case data_table_expression::LessEqual:
+                case data_table_expression::Greater:
+                case data_table_expression::GreaterEqual:
+                    return boost::make_shared<comparison_evaluator>(node.m_op, lhs, rhs);
+                case data_table_expression::And:
+                case data_table_expression::Or:
+                case data_table_expression::Not:
+                    return boost::make_shared<logical_evaluator>(node.m_op, lhs, rhs);
+                default:
+                    return boost::make_shared<arithmetic_evaluator>(node.m_op, lhs, rhs);
+            }
+        }
+
+        size_t row_count(const data_table_expression::column_collection_t& columns)
+        {
+            return columns.empty() ? 0 : columns.front().size();
+        }
+
+        /* Results of evaluate() */
+        /*************************/
+        template <variant_base::enum_type_t E>
+        void append_ticks(data_table_column_base& column, const boost::int64_t* ticks, size_t count)
+        {
+            typename column_traits<E>::value_type value;
+            for (size_t i=0; i<count; ++i)
+            {
+                from_ticks(ticks[i], value);
+                column.push_back(value);
+            }
+        }
+
+        void append(data_table_column_base& column, const evaluator& expression, size_t count)
+        {
+            const batch& result(expression.result());
+            switch (column.type())
+            {
+                case variant_base::Boolean:
+                    for (size_t i=0; i<count; ++i)
+                    {
+                        column.push_back(result.booleans[i]!=0);
+                    }
+                    break;
+                case variant_base::Int64:
+                    column.append<variant_base::Int64>(result.integers, count);
+                    break;
+                case variant_base::UInt64:
+                    column.append<variant_base::UInt64>(result.unsigneds, count);
+                    break;
+                case variant_base::Double:
+                    column.append<variant_base::Double>(result.numbers, count);
+                    break;
+                case variant_base::String:
+                    for (size_t i=0; i<count; ++i)
+                    {
+                        column.push_back(detail::string(result.strings[i]));
+                    }
+                    break;
+                case variant_base::Date:
+                    append_ticks<variant_base::Date>(column, result.integers, count);
+                    break;
+                case variant_base::Time:
+                    append_ticks<variant_base::Time>(column, result.integers, count);
+                    break;
+                case variant_base::DateTime:
+                    append_ticks<variant_base::DateTime>(column, result.integers, count);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        data_table_column_base* make_column(variant_base::enum_type_t type, const std::string& name, size_t capacity)
+        {
+            switch (type)
+            {
+                case variant_base::Boolean:     return new detail::data_table_column<variant_base::Boolean>(name, capacity);
+                case variant_base::Int64:       return new detail::data_table_column<variant_base::Int64>(name, capacity);
+                case variant_base::UInt64:      return new detail::data_table_column<variant_base::UInt64>(name, capacity);
+                case variant_base::Double:      return new detail::data_table_column<variant_base::Double>(name, capacity);
+                case variant_base::String:      return new detail::data_table_column<variant_base::String>(name, capacity);
+                case variant_base::Date:        return new detail::data_table_column<variant_base::Date>(name, capacity);
+                case variant_base::Time:        return new detail::data_table_column<variant_base::Time>(name, capacity);
+                default:                        return new detail::data_table_column<variant_base::DateTime>(name, capacity);
+            }
+        }
+
+        boost::shared_ptr<detail::expression_node> make_literal(variant_base::enum_type_t type)
+        {
+            boost::shared_ptr<detail::expression_node> node(boost::make_shared<detail::expression_node>());
+            node->m_kind = detail::expression_node::Literal;
+            node->m_type = type;
+            node->m_integer = 0;
+            node->m_number = 0.0;
+            return node;
+        }
+
+    } // namespace
+
+    data_table_expression::data_table_expression(const boost::shared_ptr<const detail::expression_node>& node) :
+        m_node(node)
+    {
+    }
+
+    /*static*/ data_table_expression data_table_expression::column(const std::string& name)
+    {
+        boost::shared_ptr<detail::expression_node> node(boost::make_shared<detail::expression_node>());
+        node->m_kind = detail::expression_node::Column;
+        node->m_name = name;
+        return data_table_expression(node);
+    }
+
+    data_table_expression::data_table_expression(bool value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::Boolean));
+        node->m_integer = value ? 1 : 0;
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(boost::int32_t value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::Int64));
+        node->m_integer = value;
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(boost::int64_t value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::Int64));
+        node->m_integer = value;
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(double value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::Double));
+        node->m_number = value;
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(const char* value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::String));
+        node->m_name = value;
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(const std::string& value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::String));
+        node->m_name = value;
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(const boost::gregorian::date& value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::Date));
+        node->m_integer = to_ticks(value);
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(const boost::posix_time::ptime& value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::DateTime));
+        node->m_integer = to_ticks(value);
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(const boost::posix_time::time_duration& value)
+    {
+        boost::shared_ptr<detail::expression_node> node(make_literal(variant_base::Time));
+        node->m_integer = to_ticks(value);
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(enum_operator_t op, const data_table_expression& operand)
+    {
+        boost::shared_ptr<detail::expression_node> node(boost::make_shared<detail::expression_node>());
+        node->m_kind = detail::expression_node::Operator;
+        node->m_op = op;
+        node->m_operands.push_back(operand.m_node);
+        m_node = node;
+    }
+
+    data_table_expression::data_table_expression(enum_operator_t op, const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        boost::shared_ptr<detail::expression_node> node(boost::make_shared<detail::expression_node>());
+        node->m_kind = detail::expression_node::Operator;
+        node->m_op = op;
+        node->m_operands.push_back(lhs.m_node);
+        node->m_operands.push_back(rhs.m_node);
+        m_node = node;
+    }
+
+    variant_base::enum_type_t data_table_expression::type(const column_collection_t& columns) const
+    {
+        const boost::shared_ptr<evaluator> root(bind(*m_node, columns));
+        return root->type();
+    }
+
+    std::vector<size_t> data_table_expression::select(const column_collection_t& columns) const
+    {
+        const boost::shared_ptr<evaluator> root(bind(*m_node, columns));
+        if (root->kind()!=BooleanKind)
+        {
+            boost::throw_exception(variant_error("DataTable expression used to select rows must be Boolean"));
+        }
+
+        const size_t rows(row_count(columns));
+
+        // reserving for every row avoids copying the selection as it grows, only the
+        // pages written to are touched
+        std::vector<size_t> result;
+        result.reserve(rows);
+        std::vector<size_t> selected(s_batch_size);
+
+        for (size_t first=0; first<rows; first+=s_batch_size)
+        {
+            const size_t count((std::min)(s_batch_size, rows - first));
+            root->evaluate(first, count);
+
+            // without branching on the outcome, writing every row and advancing past those selected
+            const boost::uint8_t* mask(root->result().booleans);
+            size_t* output(&selected[0]);
+
+            size_t n(0);
+            for (size_t i=0; i<count; ++i)
+            {
+                output[n] = first + i;
+                n += mask[i];
+            }
+            result.insert(result.end(), output, output + n);
+        }
+
+        return result;
+    }
+
+    data_table_column_base* data_table_expression::evaluate(const column_collection_t& columns, const std::string& name) const
+    {
+        const boost::shared_ptr<evaluator> root(bind(*m_node, columns));
+
+        const size_t rows(row_count(columns));
+        data_table_column_base* result(make_column(root->type(), name, rows));
+
+        try
+        {
+            for (size_t first=0; first<rows; first+=s_batch_size)
+            {
+                const size_t count((std::min)(s_batch_size, rows - first));
+                root->evaluate(first, count);
+                append(*result, *root, count);
+            }
+        }
+        catch (...)
+        {
+            delete result;
+            throw;
+        }
+
+        return result;
+    }
+
+    data_table_expression operator==(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Equal, lhs, rhs);
+    }
+
+    data_table_expression operator!=(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::NotEqual, lhs, rhs);
+    }
+
+    data_table_expression operator<(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Less, lhs, rhs);
+    }
+
+    data_table_expression operator<=(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::LessEqual, lhs, rhs);
+    }
+
+    data_table_expression operator>(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Greater, lhs, rhs);
+    }
+
+    data_table_expression operator>=(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::GreaterEqual, lhs, rhs);
+    }
+
+    data_table_expression operator&&(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::And, lhs, rhs);
+    }
+
+    data_table_expression operator||(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Or, lhs, rhs);
+    }
+
+    data_table_expression operator!(const data_table_expression& operand)
+    {
+        return data_table_expression(data_table_expression::Not, operand);
+    }
+
+    data_table_expression operator+(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Add, lhs, rhs);
+    }
+
+    data_table_expression operator-(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Subtract, lhs, rhs);
+    }
+
+    data_table_expression operator*(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Multiply, lhs, rhs);
+    }
+
+    data_table_expression operator/(const data_table_expression& lhs, const data_table_expression& rhs)
+    {
+        return data_table_expression(data_table_expression::Divide, lhs, rhs);
+    }
+
+    data_table_expression operator-(const data_table_expression& operand)
+    {
+        return data_table_expression(data_table_expression::Negate, operand);
+    }
+
+} // namespace protean
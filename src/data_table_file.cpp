@@ -0,0 +1,694 @@
+#include <protean/data_table_file.hpp>
+#include <protean/data_table_view.hpp>
+#include <protean/binary_reader.hpp>
+#include <protean/binary_writer.hpp>
+#include <protean/detail/data_table_keys.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/integer_traits.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace protean {
+
+    namespace {
+
+        // [MAGIC][padding] [BLOCK]... [FOOTER][FOOTER LENGTH][MAGIC]
+        static const char s_magic[8] = { 'P', 'R', 'O', 'T', 'D', 'T', 'F', '1' };
+        static const size_t s_alignment = 64;
+        static const size_t s_trailer_size = sizeof(boost::uint64_t) + sizeof(s_magic);
+
+        // Special dates and times are stored as sentinels at the ends of the range of the
+        // storage type, as timeseries::to_ticks does, so that they keep their order
+        template <typename S, typename T>
+        S encode_special(const T& value)
+        {
+            return value.is_pos_infinity() ? boost::integer_traits<S>::const_max
+                : (value.is_neg_infinity() ? boost::integer_traits<S>::const_min + 1 : boost::integer_traits<S>::const_min);
+        }
+
+        template <typename T, typename S>
+        bool decode_special(S value, T& result)
+        {
+            switch (value)
+            {
+                case boost::integer_traits<S>::const_min:       result = T(boost::date_time::not_a_date_time);  return true;
+                case boost::integer_traits<S>::const_min + 1:   result = T(boost::date_time::neg_infin);        return true;
+                case boost::integer_traits<S>::const_max:       result = T(boost::date_time::pos_infin);        return true;
+                default:                                        return false;
+            }
+        }
+
+        /* How values of each type are stored: as they are in memory for numbers, as */
+        /* in the binary format for dates and times, and booleans as a byte each     */
+        /*****************************************************************************/
+        template <variant_base::enum_type_t E>
+        struct file_codec
+        {
+            typedef typename column_traits<E>::value_type value_type;
+            typedef value_type storage_type;
+
+            static storage_type encode(const value_type& value)     { return value; }
+            static value_type decode(storage_type value)            { return value; }
+
+            // Whether the value is a special date or time, see encode_special
+            static bool special(const value_type&)                  { return false; }
+        };
+
+        template <>
+        struct file_codec<variant_base::Boolean>
+        {
+            typedef bool value_type;
+            typedef boost::uint8_t storage_type;
+
+            static storage_type encode(bool value)                  { return value ? 1 : 0; }
+            static value_type decode(storage_type value)            { return value!=0; }
+            static bool special(bool)                               { return false; }
+        };
+
+        template <>
+        struct file_codec<variant_base::Date>
+        {
+            typedef variant::date_t value_type;
+            typedef boost::int32_t storage_type;
+
+            static storage_type encode(const value_type& value)
+            {
+                return value.is_special() ? encode_special<storage_type>(value) : static_cast<storage_type>((value - variant::min_date()).days());
+            }
+            static value_type decode(storage_type value)
+            {
+                value_type result;
+                return decode_special(value, result) ? result : variant::min_date() + boost::gregorian::days(value);
+            }
+            static bool special(const value_type& value)            { return value.is_special(); }
+        };
+
+        template <>
+        struct file_codec<variant_base::Time>
+        {
+            typedef variant::time_t value_type;
+            typedef boost::int64_t storage_type;
+
+            static storage_type encode(const value_type& value)
+            {
+                return value.is_special() ? encode_special<storage_type>(value) : value.total_milliseconds();
+            }
+            static value_type decode(storage_type value)
+            {
+                value_type result;
+                return decode_special(value, result) ? result : boost::posix_time::milliseconds(value);
+            }
+            static bool special(const value_type& value)            { return value.is_special(); }
+        };
+
+        template <>
+        struct file_codec<variant_base::DateTime>
+        {
+            typedef variant::date_time_t value_type;
+            typedef boost::int64_t storage_type;
+
+            static storage_type encode(const value_type& value)
+            {
+                return value.is_special() ? encode_special<storage_type>(value) : (value - variant::min_date_time()).total_milliseconds();
+            }
+            static value_type decode(storage_type value)
+            {
+                value_type result;
+                return decode_special(value, result) ? result : variant::min_date_time() + boost::posix_time::milliseconds(value);
+            }
+            static bool special(const value_type& value)            { return value.is_special(); }
+        };
+
+        void pad(std::ostream& os)
+        {
+            static const char zeros[s_alignment] = {};
+
+            const size_t position(static_cast<size_t>(os.tellp()));
+            if (position % s_alignment!=0)
+            {
+                os.write(zeros, s_alignment - position % s_alignment);
+            }
+        }
+
+        /* Reads and writes the blocks of a column of one type */
+        /*******************************************************/
+        class file_column
+        {
+        public:
+            virtual ~file_column() {}
+
+            // Writes rows [first, first + count) of 'column' as a block, setting 'min' and
+            // 'max' to the least and greatest of them, leaving out NaNs, or to None if the
+            // block holds special dates or times, or nothing but NaNs
+            virtual void write(std::ostream& os, const data_table_column_base& column, size_t first, size_t count, variant& min, variant& max) const = 0;
+
+            // Whether a block with values in [min, max] can hold any in [lower, upper), which
+            // it always may if they are unknown
+            virtual bool admits(const variant& min, const variant& max, const variant& lower, const variant& upper) const = 0;
+
+            // Appends 'offset' plus the position of each value in [lower, upper) to 'rows'
+            virtual void scan(const char* block, size_t count, const variant& lower, const variant& upper, size_t offset, std::vector<size_t>& rows) const = 0;
+
+            // Appends the 'count' values of 'block' to 'column'
+            virtual void load(const char* block, size_t count, data_table_column_base& column) const = 0;
+
+            // Value of the n'th row of a block of 'count'
+            virtual variant value(const char* block, size_t count, size_t n) const = 0;
+        };
+
+        template <variant_base::enum_type_t E>
+        class typed_file_column : public file_column
+        {
+            typedef file_codec<E>                           codec;
+            typedef typename codec::value_type              value_type;
+            typedef typename codec::storage_type            storage_type;
+
+        public:
+            virtual void write(std::ostream& os, const data_table_column_base& column, size_t first, size_t count, variant& min, variant& max) const
+            {
+                static const size_t npos = data_table_column_base::npos;
+
+                std::vector<storage_type> values(count);
+                size_t least(npos), greatest(npos);
+                bool special(false);
+
+                typename column_traits<E>::const_iterator value(column.begin<E>() + first);
+                for (size_t i=0; i<count; ++i, ++value)
+                {
+                    values[i] = codec::encode(*value);
+
+                    // NaNs are in no range, so are left out
+                    if (codec::special(*value))
+                    {
+                        special = true;
+                    }
+                    else if (*value==*value)
+                    {
+                        if (least==npos || values[i]<values[least])
+                        {
+                            least = i;
+                        }
+                        if (greatest==npos || values[greatest]<values[i])
+                        {
+                            greatest = i;
+                        }
+                    }
+                }
+
+                if (special || least==npos)
+                {
+                    min = max = variant();
+                }
+                else
+                {
+                    min = variant(codec::decode(values[least]));
+                    max = variant(codec::decode(values[greatest]));
+                }
+
+                os.write(reinterpret_cast<const char*>(&values[0]), count * sizeof(storage_type));
+            }
+
+            virtual bool admits(const variant& min, const variant& max, const variant& lower, const variant& upper) const
+            {
+                const storage_type lower_value(bound(lower));
+                const storage_type upper_value(bound(upper));
+                if (!(lower_value<upper_value))
+                {
+                    return false;
+                }
+                if (min.is<variant::None>() || max.is<variant::None>())
+                {
+                    return true;
+                }
+
+                // NaN statistics tell nothing of the block
+                const storage_type min_value(bound(min));
+                const storage_type max_value(bound(max));
+                return min_value!=min_value || max_value!=max_value || (!(max_value<lower_value) && min_value<upper_value);
+            }
+
+            virtual void scan(const char* block, size_t count, const variant& lower, const variant& upper, size_t offset, std::vector<size_t>& rows) const
+            {
+                const storage_type lower_value(bound(lower));
+                const storage_type upper_value(bound(upper));
+                const storage_type* values(reinterpret_cast<const storage_type*>(block));
+
+                for (size_t i=0; i<count; ++i)
+                {
+                    if (!(values[i]<lower_value) && values[i]<upper_value)
+                    {
+                        rows.push_back(offset + i);
+                    }
+                }
+            }
+
+            virtual void load(const char* block, size_t count, data_table_column_base& column) const
+            {
+                const storage_type* values(reinterpret_cast<const storage_type*>(block));
+
+                const size_t first(column.size());
+                column.resize(first + count);
+                std::transform(values, values + count, column.begin<E>() + first, &codec::decode);
+            }
+
+            virtual variant value(const char* block, size_t /* count */, size_t n) const
+            {
+                return variant(codec::decode(reinterpret_cast<const storage_type*>(block)[n]));
+            }
+
+        private:
+            static storage_type bound(const variant& value)
+            {
+                return codec::encode(detail::key_value(value, static_cast<value_type*>(nullptr)));
+            }
+        };
+
+        // [OFFSETS: count + 1 x uint64][TEXT]
+        class string_file_column : public file_column
+        {
+        public:
+            virtual void write(std::ostream& os, const data_table_column_base& column, size_t first, size_t count, variant& min, variant& max) const
+            {
+                std::vector<boost::uint64_t> offsets(count + 1, 0);
+                column_traits<variant_base::String>::const_iterator value(column.begin<variant_base::String>() + first);
+                for (size_t i=0; i<count; ++i)
+                {
+                    offsets[i + 1] = offsets[i] + value[i].size();
+                }
+                os.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size() * sizeof(boost::uint64_t));
+
+                size_t least(0), greatest(0);
+                for (size_t i=0; i<count; ++i)
+                {
+                    os.write(value[i].value(), value[i].size());
+
+                    if (value[i].compare(value[least])<0)
+                    {
+                        least = i;
+                    }
+                    if (value[greatest].compare(value[i])<0)
+                    {
+                        greatest = i;
+                    }
+                }
+
+                min = variant(std::string(value[least].value(), value[least].size()));
+                max = variant(std::string(value[greatest].value(), value[greatest].size()));
+            }
+
+            virtual bool admits(const variant& min, const variant& max, const variant& lower, const variant& upper) const
+            {
+                const std::string lower_value(lower.as<std::string>());
+                const std::string upper_value(upper.as<std::string>());
+
+                return lower_value<upper_value && !(max.as<std::string>()<lower_value) && min.as<std::string>()<upper_value;
+            }
+
+            virtual void scan(const char* block, size_t count, const variant& lower, const variant& upper, size_t offset, std::vector<size_t>& rows) const
+            {
+                const std::string lower_value(lower.as<std::string>());
+                const std::string upper_value(upper.as<std::string>());
+
+                for (size_t i=0; i<count; ++i)
+                {
+                    const char* text;
+                    size_t size;
+                    get(block, count, i, text, size);
+
+                    if (compare(text, size, lower_value)>=0 && compare(text, size, upper_value)<0)
+                    {
+                        rows.push_back(offset + i);
+                    }
+                }
+            }
+
+            virtual void load(const char* block, size_t count, data_table_column_base& column) const
+            {
+                column.reserve(column.size() + count);
+                for (size_t i=0; i<count; ++i)
+                {
+                    const char* text;
+                    size_t size;
+                    get(block, count, i, text, size);
+
+                    column.push_back(detail::string(text, size));
+                }
+            }
+
+            virtual variant value(const char* block, size_t count, size_t n) const
+            {
+                const char* text;
+                size_t size;
+                get(block, count, n, text, size);
+
+                return variant(std::string(text, size));
+            }
+
+        private:
+            // Text of the n'th of a block of 'count' strings
+            static void get(const char* block, size_t count, size_t n, const char*& text, size_t& size)
+            {
+                const boost::uint64_t* offsets(reinterpret_cast<const boost::uint64_t*>(block));
+
+                text = block + (count + 1) * sizeof(boost::uint64_t) + offsets[n];
+                size = static_cast<size_t>(offsets[n + 1] - offsets[n]);
+            }
+
+            static int compare(const char* text, size_t size, const std::string& rhs)
+            {
+                const int result(std::char_traits<char>::compare(text, rhs.c_str(), std::min(size, rhs.size())));
+                if (result!=0)
+                {
+                    return result;
+                }
+                return size<rhs.size() ? -1 : (size>rhs.size() ? 1 : 0);
+            }
+        };
+
+        const file_column& get_file_column(variant_base::enum_type_t type, const std::string& name)
+        {
+            static const typed_file_column<variant_base::Boolean>   boolean_column;
+            static const typed_file_column<variant_base::Int32>     int32_column;
+            static const typed_file_column<variant_base::UInt32>    uint32_column;
+            static const typed_file_column<variant_base::Int64>     int64_column;
+            static const typed_file_column<variant_base::UInt64>    uint64_column;
+            static const typed_file_column<variant_base::Float>     float_column;
+            static const typed_file_column<variant_base::Double>    double_column;
+            static const typed_file_column<variant_base::Date>      date_column;
+            static const typed_file_column<variant_base::Time>      time_column;
+            static const typed_file_column<variant_base::DateTime>  date_time_column;
+            static const string_file_column                         string_column;
+
+            switch (type)
+            {
+                case variant_base::Boolean:     return boolean_column;
+                case variant_base::Int32:       return int32_column;
+                case variant_base::UInt32:      return uint32_column;
+                case variant_base::Int64:       return int64_column;
+                case variant_base::UInt64:      return uint64_column;
+                case variant_base::Float:       return float_column;
+                case variant_base::Double:      return double_column;
+                case variant_base::Date:        return date_column;
+                case variant_base::Time:        return time_column;
+                case variant_base::DateTime:    return date_time_column;
+                case variant_base::String:      return string_column;
+                default:
+                    boost::throw_exception(variant_error(boost::str(boost::format("Column '%s' of type %s cannot be stored in a DataTable file")
+                        % name
+                        % variant_base::enum_to_string(type))));
+            }
+            return string_column;
+        }
+
+        size_t get_size(const variant& value)
+        {
+            return static_cast<size_t>(value.as<boost::uint64_t>());
+        }
+
+    } // namespace
+
+    const size_t data_table_file::default_row_group_size;
+
+    void data_table_file::write(const std::string& path, const data_table_view& view, size_t row_group_size /* = default_row_group_size */)
+    {
+        if (row_group_size==0)
+        {
+            boost::throw_exception(variant_error("DataTable file row groups must hold at least one row"));
+        }
+
+        std::vector<const file_column*> writers;
+        variant columns(variant::List);
+        for (size_t c=0; c<view.column_count(); ++c)
+        {
+            const data_table_column_base& column(view.column(c));
+            writers.push_back(&get_file_column(column.type(), column.name()));
+
+            variant schema(variant::Dictionary);
+            schema.insert("Name", variant(column.name()))
+                  .insert("Type", variant(static_cast<boost::int32_t>(column.type())));
+            columns.push_back(schema);
+        }
+
+        std::ofstream os(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!os)
+        {
+            boost::throw_exception(variant_error("Unable to open '" + path + "' for writing"));
+        }
+
+        os.write(s_magic, sizeof(s_magic));
+
+        variant groups(variant::List);
+        for (size_t first=0; first<view.size(); first+=row_group_size)
+        {
+            const size_t count(std::min(row_group_size, view.size() - first));
+
+            variant blocks(variant::List), mins(variant::List), maxs(variant::List);
+            for (size_t c=0; c<writers.size(); ++c)
+            {
+                pad(os);
+                blocks.push_back(variant(static_cast<boost::uint64_t>(os.tellp())));
+
+                variant min, max;
+                writers[c]->write(os, view.column(c), view.offset() + first, count, min, max);
+                mins.push_back(min);
+                maxs.push_back(max);
+            }
+
+            variant group(variant::Dictionary);
+            group.insert("Offset", variant(static_cast<boost::uint64_t>(first)))
+                 .insert("Size", variant(static_cast<boost::uint64_t>(count)))
+                 .insert("Blocks", blocks)
+                 .insert("Min", mins)
+                 .insert("Max", maxs);
+            groups.push_back(group);
+        }
+
+        variant footer(variant::Dictionary);
+        footer.insert("Rows", variant(static_cast<boost::uint64_t>(view.size())))
+              .insert("Columns", columns)
+              .insert("RowGroups", groups);
+
+        std::ostringstream footer_os;
+        {
+            binary_writer writer(footer_os);
+            writer << footer;
+        }
+        const std::string footer_bytes(footer_os.str());
+        const boost::uint64_t footer_size(footer_bytes.size());
+
+        os.write(footer_bytes.data(), footer_bytes.size());
+        os.write(reinterpret_cast<const char*>(&footer_size), sizeof(footer_size));
+        os.write(s_magic, sizeof(s_magic));
+
+        os.close();
+        if (!os)
+        {
+            boost::throw_exception(variant_error("Unable to write '" + path + "'"));
+        }
+    }
+
+    data_table_file::data_table_file(const std::string& path) :
+        m_rows(0)
+    {
+        try
+        {
+            m_file.open(path);
+        }
+        catch (const std::exception& e)
+        {
+            boost::throw_exception(variant_error("Unable to map '" + path + "': " + e.what()));
+        }
+
+        const char* data(m_file.data());
+        const size_t size(m_file.size());
+
+        if (size<sizeof(s_magic) + s_trailer_size
+            || std::memcmp(data, s_magic, sizeof(s_magic))!=0
+            || std::memcmp(data + size - sizeof(s_magic), s_magic, sizeof(s_magic))!=0)
+        {
+            boost::throw_exception(variant_error("'" + path + "' is not a DataTable file"));
+        }
+
+        boost::uint64_t footer_size;
+        std::memcpy(&footer_size, data + size - s_trailer_size, sizeof(footer_size));
+        if (footer_size>size - sizeof(s_magic) - s_trailer_size)
+        {
+            boost::throw_exception(variant_error("DataTable file '" + path + "' has a corrupt footer"));
+        }
+        const size_t footer_offset(size - s_trailer_size - static_cast<size_t>(footer_size));
+
+        variant footer;
+        {
+            boost::iostreams::stream<boost::iostreams::array_source> is(data + footer_offset, static_cast<size_t>(footer_size));
+            binary_reader reader(is);
+            reader >> footer;
+        }
+
+        m_rows = get_size(footer.at("Rows"));
+
+        const variant& columns(footer.at("Columns"));
+        for (size_t c=0; c<columns.size(); ++c)
+        {
+            m_names.push_back(columns[c].at("Name").as<std::string>());
+            m_types.push_back(static_cast<variant_base::enum_type_t>(columns[c].at("Type").as<boost::int32_t>()));
+        }
+
+        const variant& groups(footer.at("RowGroups"));
+        m_groups.resize(groups.size());
+        for (size_t g=0; g<groups.size(); ++g)
+        {
+            row_group& group(m_groups[g]);
+            group.m_offset = get_size(groups[g].at("Offset"));
+            group.m_size = get_size(groups[g].at("Size"));
+
+            const variant& blocks(groups[g].at("Blocks"));
+            const variant& mins(groups[g].at("Min"));
+            const variant& maxs(groups[g].at("Max"));
+            if (blocks.size()!=m_names.size() || mins.size()!=m_names.size() || maxs.size()!=m_names.size())
+            {
+                boost::throw_exception(variant_error("DataTable file '" + path + "' has a corrupt footer"));
+            }
+
+            for (size_t c=0; c<blocks.size(); ++c)
+            {
+                group.m_blocks.push_back(blocks[c].as<boost::uint64_t>());
+                if (group.m_blocks.back()>=footer_offset)
+                {
+                    boost::throw_exception(variant_error("DataTable file '" + path + "' has a corrupt footer"));
+                }
+                group.m_min.push_back(mins[c]);
+                group.m_max.push_back(maxs[c]);
+            }
+        }
+    }
+
+    data_table_file::~data_table_file()
+    {
+    }
+
+    size_t data_table_file::column_index(const std::string& name) const
+    {
+        const std::vector<std::string>::const_iterator itr(std::find(m_names.begin(), m_names.end(), name));
+        if (itr==m_names.end())
+        {
+            boost::throw_exception(variant_error("Column '" + name + "' not found in DataTable file"));
+        }
+        return static_cast<size_t>(itr - m_names.begin());
+    }
+
+    variant data_table_file::value(size_t column, size_t n) const
+    {
+        if (n>=m_rows)
+        {
+            boost::throw_exception(variant_error(boost::str(boost::format("Row %u is out of range for a DataTable file of %u rows") % n % m_rows)));
+        }
+
+        // the last group starting at or before row n
+        size_t first(0), last(m_groups.size());
+        while (last - first>1)
+        {
+            const size_t middle(first + (last - first) / 2);
+            if (m_groups[middle].m_offset<=n)
+            {
+                first = middle;
+            }
+            else
+            {
+                last = middle;
+            }
+        }
+
+        return get_file_column(column_type(column), column_name(column)).value(block(first, column), m_groups[first].m_size, n - m_groups[first].m_offset);
+    }
+
+    std::vector<size_t> data_table_file::row_groups(const std::string& column, const variant& lower, const variant& upper) const
+    {
+        const size_t c(column_index(column));
+        const file_column& reader(get_file_column(m_types[c], m_names[c]));
+
+        std::vector<size_t> groups;
+        for (size_t g=0; g<m_groups.size(); ++g)
+        {
+            if (reader.admits(m_groups[g].m_min[c], m_groups[g].m_max[c], lower, upper))
+            {
+                groups.push_back(g);
+            }
+        }
+        return groups;
+    }
+
+    std::vector<size_t> data_table_file::scan(const std::string& column, const variant& lower, const variant& upper) const
+    {
+        const size_t c(column_index(column));
+        const file_column& reader(get_file_column(m_types[c], m_names[c]));
+
+        std::vector<size_t> rows;
+        const std::vector<size_t> groups(row_groups(column, lower, upper));
+        for (size_t i=0; i<groups.size(); ++i)
+        {
+            const row_group& group(m_groups[groups[i]]);
+            reader.scan(block(groups[i], c), group.m_size, lower, upper, group.m_offset, rows);
+        }
+        return rows;
+    }
+
+    variant data_table_file::table(size_t group) const
+    {
+        variant result(variant::DataTable);
+        for (size_t c=0; c<m_names.size(); ++c)
+        {
+            result.add_column(m_types[c], m_names[c]);
+        }
+
+        for (size_t c=0; c<m_names.size(); ++c)
+        {
+            get_file_column(m_types[c], m_names[c]).load(block(group, c), row_group_size(group), result.columns()[c]);
+        }
+        return result;
+    }
+
+    variant data_table_file::table() const
+    {
+        variant result(variant::DataTable);
+        for (size_t c=0; c<m_names.size(); ++c)
+        {
+            result.add_column(m_types[c], m_names[c]);
+        }
+        result.reserve(m_rows);
+
+        for (size_t g=0; g<m_groups.size(); ++g)
+        {
+            for (size_t c=0; c<m_names.size(); ++c)
+            {
+                get_file_column(m_types[c], m_names[c]).load(block(g, c), m_groups[g].m_size, result.columns()[c]);
+            }
+        }
+        return result;
+    }
+
+    const char* data_table_file::block(size_t group, size_t column, variant_base::enum_type_t type) const
+    {
+        if (column_type(column)!=type || (type & (variant_base::Integer | variant_base::Float | variant_base::Double))==0)
+        {
+            boost::throw_exception(variant_error(boost::str(boost::format("Column '%s' of type %s cannot be read in place as %s")
+                % column_name(column)
+                % variant_base::enum_to_string(column_type(column))
+                % variant_base::enum_to_string(type))));
+        }
+        return block(group, column);
+    }
+
+    const char* data_table_file::block(size_t group, size_t column) const
+    {
+        return m_file.data() + m_groups.at(group).m_blocks.at(column);
+    }
+
+} // namespace protean
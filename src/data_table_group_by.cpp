@@ -0,0 +1,497 @@
+#include <protean/data_table_aggregate.hpp>
+#include <protean/data_table_view.hpp>
+#include <protean/detail/data_table.hpp>
+#include <protean/detail/data_table_column.hpp>
+#include <protean/detail/data_table_keys.hpp>
+#include <protean/detail/thread_pool.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace protean {
+
+    data_table_aggregate::data_table_aggregate(function_t function, const std::string& column /* = std::string() */, const std::string& name /* = std::string() */) :
+        m_function(function),
+        m_column(column),
+        m_name(name)
+    {
+    }
+
+    std::string data_table_aggregate::result_name() const
+    {
+        if (!m_name.empty())
+        {
+            return m_name;
+        }
+
+        static const char* names[] = { "Sum", "Count", "Min", "Max", "Mean" };
+        return m_column.empty() ? std::string(names[m_function]) : std::string(names[m_function]) + "(" + m_column + ")";
+    }
+
+namespace detail {
+
+    namespace {
+
+        // Tables smaller than this are grouped on the calling thread
+        static const size_t s_min_rows_per_thread = 65536;
+
+        /* Open-addressed table from keys to their groups, holding the hash of each   */
+        /* group so that most probes never look at the key columns                    */
+        /******************************************************************************/
+        class group_table
+        {
+        public:
+            group_table(const std::vector<boost::uint64_t>& hashes, const boost::ptr_vector<key_column>& keys) :
+                m_hashes(hashes),
+                m_keys(keys),
+                m_slots(16),
+                m_mask(15)
+            {}
+
+            // Group of 'row', adding a new group, numbered in order, if need be
+            size_t find_or_add(size_t row, std::vector<size_t>& first_rows)
+            {
+                const boost::uint64_t hash(m_hashes[row]);
+                for (size_t i=static_cast<size_t>(hash) & m_mask;; i=(i + 1) & m_mask)
+                {
+                    slot& s(m_slots[i]);
+                    if (s.m_group==0)
+                    {
+                        s.m_hash = hash;
+                        s.m_group = first_rows.size() + 1;
+                        first_rows.push_back(row);
+
+                        if (2 * first_rows.size() > m_slots.size())
+                            grow();
+                        return first_rows.size() - 1;
+                    }
+
+                    if (s.m_hash==hash && equal(first_rows[s.m_group - 1], row))
+                    {
+                        return s.m_group - 1;
+                    }
+                }
+            }
+
+        private:
+            struct slot
+            {
+                slot() : m_hash(0), m_group(0) {}
+                boost::uint64_t m_hash;
+                size_t          m_group;    // group number + 1, zero if the slot is free
+            };
+
+            bool equal(size_t lhs, size_t rhs) const
+            {
+                for (boost::ptr_vector<key_column>::const_iterator citr = m_keys.begin(); citr != m_keys.end(); ++citr)
+                {
+                    if (!citr->equal(lhs, *citr, rhs))
+                        return false;
+                }
+                return true;
+            }
+
+            void grow()
+            {
+                std::vector<slot> slots(2 * m_slots.size());
+                const size_t mask(slots.size() - 1);
+
+                for (std::vector<slot>::const_iterator citr = m_slots.begin(); citr != m_slots.end(); ++citr)
+                {
+                    if (citr->m_group!=0)
+                    {
+                        size_t i(static_cast<size_t>(citr->m_hash) & mask);
+                        while (slots[i].m_group!=0)
+                            i = (i + 1) & mask;
+                        slots[i] = *citr;
+                    }
+                }
+
+                m_slots.swap(slots);
+                m_mask = mask;
+            }
+
+        private:
+            const std::vector<boost::uint64_t>&     m_hashes;
+            const boost::ptr_vector<key_column>&    m_keys;
+            std::vector<slot>                       m_slots;
+            size_t                                  m_mask;
+        };
+
+        /* Aggregates */
+        /**************/
+        struct aggregate_spec
+        {
+            data_table_aggregate::function_t    m_function;
+            const data_table_column_base*       m_column;
+            size_t                              m_offset;   // row of the column that is the first row grouped
+            bool                                m_integer;  // accumulated as Int64, otherwise Double
+        };
+
+        // Groups in order of their first row, with their partial aggregates: Mean is
+        // held as a sum until the result is made
+        struct group_set
+        {
+            std::vector<size_t>                         m_first_rows;
+            std::vector<boost::uint64_t>                m_counts;
+            std::vector<std::vector<boost::int64_t> >   m_integers;     // per aggregate
+            std::vector<std::vector<double> >           m_numbers;      // per aggregate
+        };
+
+        template <typename T>
+        T initial_value(data_table_aggregate::function_t function)
+        {
+            switch (function)
+            {
+                case data_table_aggregate::Min:   return (std::numeric_limits<T>::max)();
+                case data_table_aggregate::Max:   return (std::numeric_limits<T>::lowest)();
+                default:                          return T();
+            }
+        }
+
+        template <typename T>
+        inline void combine(data_table_aggregate::function_t function, T& result, T value)
+        {
+            switch (function)
+            {
+                case data_table_aggregate::Min:   result = (std::min)(result, value); break;
+                case data_table_aggregate::Max:   result = (std::max)(result, value); break;
+                default:                          result += value;                    break;
+            }
+        }
+
+        template <variant_base::enum_type_t E, typename T>
+        void accumulate(data_table_aggregate::function_t function, const data_table_column_base& column, size_t first, const std::vector<size_t>& groups, std::vector<T>& result)
+        {
+            const typename column_traits<E>::const_iterator values(column.begin<E>() + first);
+            const size_t count(groups.size());
+
+            // a loop per function, rather than a switch per row
+            switch (function)
+            {
+                case data_table_aggregate::Sum:
+                case data_table_aggregate::Mean:
+                    for (size_t i=0; i<count; ++i)
+                        result[groups[i]] += static_cast<T>(values[i]);
+                    break;
+                case data_table_aggregate::Min:
+                    for (size_t i=0; i<count; ++i)
+                        result[groups[i]] = (std::min)(result[groups[i]], static_cast<T>(values[i]));
+                    break;
+                case data_table_aggregate::Max:
+                    for (size_t i=0; i<count; ++i)
+                        result[groups[i]] = (std::max)(result[groups[i]], static_cast<T>(values[i]));
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void accumulate(const aggregate_spec& spec, size_t first, const std::vector<size_t>& groups, group_set& result, size_t n)
+        {
+            const size_t size(result.m_first_rows.size());
+
+            if (spec.m_integer)
+            {
+                std::vector<boost::int64_t>& integers(result.m_integers[n]);
+                integers.assign(size, initial_value<boost::int64_t>(spec.m_function));
+
+                switch (spec.m_column->type())
+                {
+                    case variant_base::Int32:   accumulate<variant_base::Int32>(spec.m_function, *spec.m_column, spec.m_offset + first, groups, integers);   break;
+                    case variant_base::UInt32:  accumulate<variant_base::UInt32>(spec.m_function, *spec.m_column, spec.m_offset + first, groups, integers);  break;
+                    case variant_base::Int64:   accumulate<variant_base::Int64>(spec.m_function, *spec.m_column, spec.m_offset + first, groups, integers);   break;
+                    default:                    accumulate<variant_base::UInt64>(spec.m_function, *spec.m_column, spec.m_offset + first, groups, integers);  break;
+                }
+            }
+            else
+            {
+                std::vector<double>& numbers(result.m_numbers[n]);
+                numbers.assign(size, initial_value<double>(spec.m_function));
+
+                switch (spec.m_column->type())
+                {
+                    case variant_base::Float:   accumulate<variant_base::Float>(spec.m_function, *spec.m_column, spec.m_offset + first, groups, numbers);    break;
+                    default:                    accumulate<variant_base::Double>(spec.m_function, *spec.m_column, spec.m_offset + first, groups, numbers);   break;
+                }
+            }
+        }
+
+        aggregate_spec make_spec(const data_table_view& view, const data_table_aggregate& aggregate)
+        {
+            aggregate_spec spec;
+            spec.m_function = aggregate.m_function;
+            spec.m_column = nullptr;
+            spec.m_offset = view.offset();
+            spec.m_integer = false;
+
+            if (aggregate.m_function==data_table_aggregate::Count && aggregate.m_column.empty())
+            {
+                return spec;
+            }
+
+            spec.m_column = &view.column(aggregate.m_column);
+            if (aggregate.m_function==data_table_aggregate::Count)
+            {
+                return spec;
+            }
+
+            switch (spec.m_column->type())
+            {
+                case variant_base::Int32:
+                case variant_base::UInt32:
+                case variant_base::Int64:
+                case variant_base::UInt64:
+                    spec.m_integer = true;
+                    break;
+                case variant_base::Float:
+                case variant_base::Double:
+                    break;
+                default:
+                    boost::throw_exception(variant_error(boost::str(boost::format("Cannot aggregate column '%s' of type %s, only Count applies to non-numeric columns")
+                        % aggregate.m_column
+                        % variant_base::enum_to_string(spec.m_column->type()))));
+            }
+            return spec;
+        }
+
+        // Groups and aggregates the rows [first, last), reading each column in order
+        void group_rows(size_t first, size_t last, const std::vector<boost::uint64_t>& hashes, const boost::ptr_vector<key_column>& keys, const std::vector<aggregate_spec>& specs, group_set& result)
+        {
+            group_table table(hashes, keys);
+
+            std::vector<size_t> groups(last - first);
+            for (size_t i=first; i<last; ++i)
+            {
+                const size_t group(table.find_or_add(i, result.m_first_rows));
+                if (group==result.m_counts.size())
+                {
+                    result.m_counts.push_back(0);
+                }
+
+                groups[i - first] = group;
+                ++result.m_counts[group];
+            }
+
+            result.m_integers.resize(specs.size());
+            result.m_numbers.resize(specs.size());
+            for (size_t n=0; n<specs.size(); ++n)
+            {
+                if (specs[n].m_function!=data_table_aggregate::Count)
+                {
+                    accumulate(specs[n], first, groups, result, n);
+                }
+            }
+        }
+
+        size_t partition_of(boost::uint64_t hash, size_t partitions)
+        {
+            return static_cast<size_t>((hash >> 32) % partitions);
+        }
+
+        // Merges the groups of every chunk that fall in partition 'p', taking the chunks in
+        // order so that each group keeps the first row at which it appears
+        void merge_partition(const std::vector<group_set>& chunks, size_t p, size_t partitions, const std::vector<boost::uint64_t>& hashes, const boost::ptr_vector<key_column>& keys, const std::vector<aggregate_spec>& specs, group_set& result)
+        {
+            group_table table(hashes, keys);
+
+            result.m_integers.resize(specs.size());
+            result.m_numbers.resize(specs.size());
+
+            for (std::vector<group_set>::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk)
+            {
+                for (size_t g=0; g<chunk->m_first_rows.size(); ++g)
+                {
+                    const size_t row(chunk->m_first_rows[g]);
+                    if (partition_of(hashes[row], partitions)!=p)
+                    {
+                        continue;
+                    }
+
+                    const size_t group(table.find_or_add(row, result.m_first_rows));
+                    if (group==result.m_counts.size())
+                    {
+                        result.m_counts.push_back(0);
+                        for (size_t n=0; n<specs.size(); ++n)
+                        {
+                            if (specs[n].m_function==data_table_aggregate::Count)
+                                continue;
+                            else if (specs[n].m_integer)
+                                result.m_integers[n].push_back(initial_value<boost::int64_t>(specs[n].m_function));
+                            else
+                                result.m_numbers[n].push_back(initial_value<double>(specs[n].m_function));
+                        }
+                    }
+
+                    result.m_counts[group] += chunk->m_counts[g];
+                    for (size_t n=0; n<specs.size(); ++n)
+                    {
+                        if (specs[n].m_function==data_table_aggregate::Count)
+                            continue;
+                        else if (specs[n].m_integer)
+                            combine(specs[n].m_function, result.m_integers[n][group], chunk->m_integers[n][g]);
+                        else
+                            combine(specs[n].m_function, result.m_numbers[n][group], chunk->m_numbers[n][g]);
+                    }
+                }
+            }
+        }
+
+        // Where each group of the result comes from
+        struct group_ref
+        {
+            size_t m_first_row;
+            size_t m_partition;
+            size_t m_group;
+
+            bool operator<(const group_ref& rhs) const { return m_first_row < rhs.m_first_row; }
+        };
+
+        template <variant_base::enum_type_t E, typename F>
+        data_table_column_base* make_result_column(const std::string& name, const std::vector<group_ref>& order, const std::vector<group_set>& parts, F value)
+        {
+            std::vector<typename column_traits<E>::value_type> result(order.size());
+            for (size_t i=0; i<order.size(); ++i)
+            {
+                result[i] = value(parts[order[i].m_partition], order[i].m_group);
+            }
+
+            data_table_column<E>* column(new data_table_column<E>(name));
+            column->template assign<E>(std::move(result));
+            return column;
+        }
+
+    } // namespace
+
+    void data_table::group_by(const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, data_table& result, size_t threads /* = 0 */) const
+    {
+        group_by(data_table_view(m_columns), keys, aggregates, result.m_columns, threads);
+    }
+
+    void data_table::group_by(const data_table_view& view, const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, column_container_type& result, size_t threads /* = 0 */)
+    {
+        if (keys.empty())
+        {
+            boost::throw_exception(variant_error("Group-by requires at least one key column"));
+        }
+
+        boost::ptr_vector<key_column> key_columns;
+        std::vector<const data_table_column_base*> key_sources;
+        for (std::vector<std::string>::const_iterator citr = keys.begin(); citr != keys.end(); ++citr)
+        {
+            key_sources.push_back(&view.column(*citr));
+            key_columns.push_back(make_key_column(*key_sources.back(), view.offset()));
+        }
+
+        std::vector<aggregate_spec> specs;
+        for (std::vector<data_table_aggregate>::const_iterator citr = aggregates.begin(); citr != aggregates.end(); ++citr)
+        {
+            specs.push_back(make_spec(view, *citr));
+        }
+
+        const size_t rows(view.size());
+
+        thread_pool& pool(thread_pool::instance());
+        if (threads==0)
+        {
+            threads = pool.size();
+        }
+
+        const size_t chunks((std::max)(static_cast<size_t>(1), (std::min)(threads, rows / s_min_rows_per_thread)));
+        const size_t partitions(chunks);
+
+        std::vector<boost::uint64_t> hashes(rows);
+
+        // aggregate each chunk of rows by itself...
+        std::vector<group_set> chunk_groups(chunks);
+
+        parallel_for(chunks, [&](size_t c) {
+            const size_t first(rows * c / chunks), last(rows * (c + 1) / chunks);
+
+            for (boost::ptr_vector<key_column>::const_iterator citr = key_columns.begin(); citr != key_columns.end(); ++citr)
+            {
+                citr->hash(first, last, hashes.empty() ? nullptr : &hashes[first]);
+            }
+
+            group_rows(first, last, hashes, key_columns, specs, chunk_groups[c]);
+        }, pool);
+
+        // ...then merge the groups of the chunks, partitioned by hash
+        std::vector<group_set> parts;
+        if (chunks==1)
+        {
+            parts.swap(chunk_groups);
+        }
+        else
+        {
+            parts.resize(partitions);
+            parallel_for(partitions, [&](size_t p) {
+                merge_partition(chunk_groups, p, partitions, hashes, key_columns, specs, parts[p]);
+            }, pool);
+        }
+
+        // groups are returned in order of their first appearance in the table
+        std::vector<group_ref> order;
+        for (size_t p=0; p<partitions; ++p)
+        {
+            for (size_t g=0; g<parts[p].m_first_rows.size(); ++g)
+            {
+                const group_ref ref = { parts[p].m_first_rows[g], p, g };
+                order.push_back(ref);
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        std::vector<size_t> first_rows(order.size());
+        for (size_t i=0; i<order.size(); ++i)
+        {
+            first_rows[i] = view.offset() + order[i].m_first_row;
+        }
+
+        column_container_type columns;
+        for (size_t k=0; k<key_sources.size(); ++k)
+        {
+            columns.push_back(key_sources[k]->take(first_rows));
+        }
+
+        for (size_t n=0; n<specs.size(); ++n)
+        {
+            const std::string name(aggregates[n].result_name());
+
+            if (specs[n].m_function==data_table_aggregate::Count)
+            {
+                columns.push_back(make_result_column<variant_base::UInt64>(name, order, parts, [](const group_set& set, size_t g) {
+                    return set.m_counts[g];
+                }));
+            }
+            else if (specs[n].m_function==data_table_aggregate::Mean)
+            {
+                const bool integer(specs[n].m_integer);
+                columns.push_back(make_result_column<variant_base::Double>(name, order, parts, [integer, n](const group_set& set, size_t g) {
+                    const double sum(integer ? static_cast<double>(set.m_integers[n][g]) : set.m_numbers[n][g]);
+                    return sum / static_cast<double>(set.m_counts[g]);
+                }));
+            }
+            else if (specs[n].m_integer)
+            {
+                columns.push_back(make_result_column<variant_base::Int64>(name, order, parts, [n](const group_set& set, size_t g) {
+                    return set.m_integers[n][g];
+                }));
+            }
+            else
+            {
+                columns.push_back(make_result_column<variant_base::Double>(name, order, parts, [n](const group_set& set, size_t g) {
+                    return set.m_numbers[n][g];
+                }));
+            }
+        }
+
+        result.swap(columns);
+    }
+
+}} // namespace protean::detail
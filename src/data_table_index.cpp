@@ -0,0 +1,412 @@
+#include <protean/detail/data_table_index.hpp>
+#include <protean/detail/data_table.hpp>
+#include <protean/detail/data_table_keys.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+
+namespace protean { namespace detail {
+
+    data_table_index::data_table_index(const std::string& column, data_table_index_t type) :
+        m_column(column),
+        m_type(type)
+    {
+    }
+
+    void data_table_index::equal_range(const data_table_column_base& column, const variant& /* lower */, const variant& /* upper */, std::vector<size_t>& /* rows */) const
+    {
+        boost::throw_exception(variant_error("Range lookup on column '" + column.name() + "' needs a sorted index"));
+    }
+
+    namespace {
+
+        static const size_t npos = data_table_column_base::npos;
+
+        /* Open-addressing hash table with a slot per distinct value, holding the first and */
+        /* last of its rows, which are chained in row order                                 */
+        /************************************************************************************/
+        template <variant_base::enum_type_t E>
+        class hash_index : public data_table_index
+        {
+            typedef typename column_traits<E>::value_type       value_type;
+            typedef typename column_traits<E>::const_iterator   const_iterator;
+
+            struct slot
+            {
+                boost::uint64_t m_hash;
+                size_t          m_head;
+                size_t          m_tail;
+            };
+
+        public:
+            explicit hash_index(const std::string& column) :
+                data_table_index(column, HashIndex),
+                m_rows(0)
+            {
+            }
+
+            virtual data_table_index* clone() const
+            {
+                return new hash_index(column());
+            }
+
+            virtual void reset()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                std::vector<slot>().swap(m_slots);
+                std::vector<size_t>().swap(m_next);
+                m_rows = 0;
+            }
+
+            virtual void find(const data_table_column_base& column, const variant& value, std::vector<size_t>& rows) const
+            {
+                const value_type key(key_value(value, static_cast<value_type*>(nullptr)));
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                update(column);
+
+                rows.clear();
+                if (m_slots.empty())
+                {
+                    return;
+                }
+
+                const const_iterator values(column.begin<E>());
+                const boost::uint64_t hash(key_hash(key, 0));
+                const size_t mask(m_slots.size()-1);
+
+                for (size_t i=hash & mask; m_slots[i].m_head!=npos; i=(i+1) & mask)
+                {
+                    const slot& s(m_slots[i]);
+                    if (s.m_hash==hash && key_equal(values[s.m_head], key))
+                    {
+                        for (size_t row=s.m_head; row!=npos; row=m_next[row])
+                        {
+                            rows.push_back(row);
+                        }
+                        return;
+                    }
+                }
+            }
+
+        private:
+            // Indexes the rows appended since the last call, or all of them again if the
+            // column has shrunk
+            void update(const data_table_column_base& column) const
+            {
+                const size_t rows(column.size());
+                if (rows<m_rows)
+                {
+                    m_slots.clear();
+                    m_next.clear();
+                    m_rows = 0;
+                }
+                if (rows==m_rows)
+                {
+                    return;
+                }
+
+                if (2*rows>m_slots.size())
+                {
+                    rehash(rows);
+                }
+                m_next.resize(rows, npos);
+
+                const const_iterator values(column.begin<E>());
+                for (size_t row=m_rows; row<rows; ++row)
+                {
+                    insert(values, row);
+                }
+                m_rows = rows;
+            }
+
+            // Moves the slots to a table with room for 'rows' distinct values at half load
+            void rehash(size_t rows) const
+            {
+                size_t capacity = 16;
+                while (capacity<2*rows)
+                {
+                    capacity *= 2;
+                }
+
+                const slot empty = { 0, npos, npos };
+                std::vector<slot> slots(capacity, empty);
+                const size_t mask(capacity-1);
+
+                for (size_t i=0; i<m_slots.size(); ++i)
+                {
+                    if (m_slots[i].m_head!=npos)
+                    {
+                        size_t j = m_slots[i].m_hash & mask;
+                        while (slots[j].m_head!=npos)
+                        {
+                            j = (j+1) & mask;
+                        }
+                        slots[j] = m_slots[i];
+                    }
+                }
+
+                m_slots.swap(slots);
+            }
+
+            void insert(const const_iterator& values, size_t row) const
+            {
+                const boost::uint64_t hash(key_hash(values[row], 0));
+                const size_t mask(m_slots.size()-1);
+
+                for (size_t i=hash & mask; ; i=(i+1) & mask)
+                {
+                    slot& s(m_slots[i]);
+                    if (s.m_head==npos)
+                    {
+                        s.m_hash = hash;
+                        s.m_head = s.m_tail = row;
+                        return;
+                    }
+                    if (s.m_hash==hash && key_equal(values[s.m_head], values[row]))
+                    {
+                        m_next[s.m_tail] = row;
+                        s.m_tail = row;
+                        return;
+                    }
+                }
+            }
+
+        private:
+            mutable std::mutex          m_mutex;
+            mutable std::vector<slot>   m_slots;
+            mutable std::vector<size_t> m_next;
+            mutable size_t              m_rows;
+        };
+
+        /* The rows of the column in order of value, equal values in row order */
+        /***********************************************************************/
+        template <variant_base::enum_type_t E>
+        class sorted_index : public data_table_index
+        {
+            typedef typename column_traits<E>::value_type       value_type;
+            typedef typename column_traits<E>::const_iterator   const_iterator;
+
+            struct row_less
+            {
+                explicit row_less(const const_iterator& values) :
+                    m_values(values)
+                {}
+
+                bool operator()(size_t lhs, size_t rhs) const
+                {
+                    return key_less(m_values[lhs], m_values[rhs]);
+                }
+
+                const const_iterator m_values;
+            };
+
+        public:
+            explicit sorted_index(const std::string& column) :
+                data_table_index(column, SortedIndex),
+                m_rows(0)
+            {
+            }
+
+            virtual data_table_index* clone() const
+            {
+                return new sorted_index(column());
+            }
+
+            virtual void reset()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                std::vector<size_t>().swap(m_order);
+                m_rows = 0;
+            }
+
+            virtual void find(const data_table_column_base& column, const variant& value, std::vector<size_t>& rows) const
+            {
+                const value_type key(key_value(value, static_cast<value_type*>(nullptr)));
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                update(column);
+
+                const const_iterator values(column.begin<E>());
+                rows.assign(
+                    lower_bound(values, key),
+                    std::partition_point(m_order.cbegin(), m_order.cend(), [&](size_t row) { return !key_less(key, values[row]); }));
+            }
+
+            virtual void equal_range(const data_table_column_base& column, const variant& lower, const variant& upper, std::vector<size_t>& rows) const
+            {
+                const value_type lower_key(key_value(lower, static_cast<value_type*>(nullptr)));
+                const value_type upper_key(key_value(upper, static_cast<value_type*>(nullptr)));
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                update(column);
+
+                rows.clear();
+                if (!key_less(lower_key, upper_key))
+                {
+                    return;
+                }
+
+                const const_iterator values(column.begin<E>());
+                rows.assign(lower_bound(values, lower_key), lower_bound(values, upper_key));
+            }
+
+        private:
+            // First position in the order whose value is not less than 'key'
+            std::vector<size_t>::const_iterator lower_bound(const const_iterator& values, const value_type& key) const
+            {
+                return std::partition_point(m_order.cbegin(), m_order.cend(), [&](size_t row) { return key_less(values[row], key); });
+            }
+
+            // Sorts the rows appended since the last call and merges them in, or sorts all
+            // of them again if the column has shrunk
+            void update(const data_table_column_base& column) const
+            {
+                const size_t rows(column.size());
+                if (rows<m_rows)
+                {
+                    m_order.clear();
+                    m_rows = 0;
+                }
+                if (rows==m_rows)
+                {
+                    return;
+                }
+
+                m_order.resize(rows);
+                const std::vector<size_t>::iterator middle(m_order.begin() + m_rows);
+                std::iota(middle, m_order.end(), m_rows);
+
+                const row_less less(column.begin<E>());
+                std::stable_sort(middle, m_order.end(), less);
+                std::inplace_merge(m_order.begin(), middle, m_order.end(), less);
+
+                m_rows = rows;
+            }
+
+        private:
+            mutable std::mutex          m_mutex;
+            mutable std::vector<size_t> m_order;
+            mutable size_t              m_rows;
+        };
+
+        template <variant_base::enum_type_t E>
+        data_table_index* make_typed_index(const std::string& column, data_table_index_t type)
+        {
+            switch (type)
+            {
+                case HashIndex:     return new hash_index<E>(column);
+                case SortedIndex:   return new sorted_index<E>(column);
+                default:
+                    boost::throw_exception(variant_error("Case exhaustion: unknown index type"));
+            }
+            return nullptr;
+        }
+
+    } // namespace
+
+    data_table_index* make_data_table_index(const data_table_column_base& column, data_table_index_t type)
+    {
+        switch (column.type())
+        {
+            case variant_base::Boolean:     return make_typed_index<variant_base::Boolean>(column.name(), type);
+            case variant_base::Int32:       return make_typed_index<variant_base::Int32>(column.name(), type);
+            case variant_base::UInt32:      return make_typed_index<variant_base::UInt32>(column.name(), type);
+            case variant_base::Int64:       return make_typed_index<variant_base::Int64>(column.name(), type);
+            case variant_base::UInt64:      return make_typed_index<variant_base::UInt64>(column.name(), type);
+            case variant_base::Float:       return make_typed_index<variant_base::Float>(column.name(), type);
+            case variant_base::Double:      return make_typed_index<variant_base::Double>(column.name(), type);
+            case variant_base::String:      return make_typed_index<variant_base::String>(column.name(), type);
+            case variant_base::Date:        return make_typed_index<variant_base::Date>(column.name(), type);
+            case variant_base::Time:        return make_typed_index<variant_base::Time>(column.name(), type);
+            case variant_base::DateTime:    return make_typed_index<variant_base::DateTime>(column.name(), type);
+            default:
+                boost::throw_exception(variant_error(boost::str(boost::format("Column '%s' of type %s cannot be indexed")
+                    % column.name()
+                    % variant_base::enum_to_string(column.type()))));
+        }
+        return nullptr;
+    }
+
+    /* data_table indexes */
+    /**********************/
+    data_table& data_table::add_index(const std::string& column, data_table_index_t type)
+    {
+        if (get_index(column, type)==nullptr)
+        {
+            const data_table& table(*this);
+            m_indexes.push_back(make_data_table_index(table.get_column(column), type));
+        }
+        return *this;
+    }
+
+    data_table& data_table::drop_index(const std::string& column)
+    {
+        for (boost::ptr_vector<data_table_index>::iterator index=m_indexes.begin(); index!=m_indexes.end(); )
+        {
+            if (index->column()==column)
+            {
+                index = m_indexes.erase(index);
+            }
+            else
+            {
+                ++index;
+            }
+        }
+        return *this;
+    }
+
+    void data_table::find(const std::string& column, const variant& value, std::vector<size_t>& rows) const
+    {
+        const data_table_index* index(get_index(column, HashIndex));
+        if (index==nullptr)
+        {
+            index = get_index(column, SortedIndex);
+        }
+        if (index==nullptr)
+        {
+            boost::throw_exception(variant_error("Column '" + column + "' has no index"));
+        }
+
+        index->find(get_column(column), value, rows);
+    }
+
+    void data_table::equal_range(const std::string& column, const variant& lower, const variant& upper, std::vector<size_t>& rows) const
+    {
+        const data_table_index* index(get_index(column, SortedIndex));
+        if (index==nullptr)
+        {
+            boost::throw_exception(variant_error("Column '" + column + "' has no sorted index"));
+        }
+
+        index->equal_range(get_column(column), lower, upper, rows);
+    }
+
+    const data_table_index* data_table::get_index(const std::string& column, data_table_index_t type) const
+    {
+        for (size_t i=0; i<m_indexes.size(); ++i)
+        {
+            if (m_indexes[i].column()==column && m_indexes[i].type()==type)
+            {
+                return &m_indexes[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void data_table::reset_indexes()
+    {
+        for (size_t i=0; i<m_indexes.size(); ++i)
+        {
+            m_indexes[i].reset();
+        }
+    }
+
+}} // namespace protean::detail
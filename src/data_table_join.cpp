@@ -0,0 +1,359 @@
+#include <protean/data_table_join.hpp>
+#include <protean/detail/data_table.hpp>
+#include <protean/detail/data_table_keys.hpp>
+#include <protean/detail/thread_pool.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+
+namespace protean { namespace detail {
+
+    namespace {
+
+        // Probe sides smaller than this are joined on the calling thread
+        static const size_t s_min_rows_per_thread = 65536;
+
+        // Probe rows are hashed in batches of this size
+        static const size_t s_batch_size = 4096;
+
+        static const size_t npos = data_table_column_base::npos;
+
+        bool keys_equal(const boost::ptr_vector<key_column>& lhs, size_t lhs_row, const boost::ptr_vector<key_column>& rhs, size_t rhs_row)
+        {
+            for (size_t k=0; k<lhs.size(); ++k)
+            {
+                if (!lhs[k].equal(lhs_row, rhs[k], rhs_row))
+                    return false;
+            }
+            return true;
+        }
+
+        /* Open-addressed table from the keys of the build side to the rows that hold */
+        /* them, which are chained in order so that matches are emitted in row order  */
+        /******************************************************************************/
+        class join_table
+        {
+        public:
+            join_table(const boost::ptr_vector<key_column>& keys, size_t rows) :
+                m_keys(keys),
+                m_hashes(rows),
+                m_next(rows, npos)
+            {
+                size_t capacity(16);
+                while (capacity < 2 * rows)
+                    capacity *= 2;
+
+                m_slots.resize(capacity);
+                m_mask = capacity - 1;
+
+                // last row of the chain of each slot, only needed while inserting
+                std::vector<size_t> tails(capacity, npos);
+
+                for (boost::ptr_vector<key_column>::const_iterator citr = keys.begin(); citr != keys.end(); ++citr)
+                {
+                    citr->hash(0, rows, m_hashes.empty() ? nullptr : &m_hashes[0]);
+                }
+
+                for (size_t row=0; row<rows; ++row)
+                {
+                    insert(row, tails);
+                }
+            }
+
+            // First row of the build side with the same key as 'row' of the probe side, npos if none
+            size_t find(boost::uint64_t hash, const boost::ptr_vector<key_column>& keys, size_t row) const
+            {
+                for (size_t i=static_cast<size_t>(hash) & m_mask;; i=(i + 1) & m_mask)
+                {
+                    const slot& s(m_slots[i]);
+                    if (s.m_head==npos)
+                    {
+                        return npos;
+                    }
+
+                    if (s.m_hash==hash && keys_equal(m_keys, s.m_head, keys, row))
+                    {
+                        return s.m_head;
+                    }
+                }
+            }
+
+            // Next row of the build side with the same key as 'row', npos if none
+            size_t next(size_t row) const
+            {
+                return m_next[row];
+            }
+
+        private:
+            void insert(size_t row, std::vector<size_t>& tails)
+            {
+                const boost::uint64_t hash(m_hashes[row]);
+                for (size_t i=static_cast<size_t>(hash) & m_mask;; i=(i + 1) & m_mask)
+                {
+                    slot& s(m_slots[i]);
+                    if (s.m_head==npos)
+                    {
+                        s.m_hash = hash;
+                        s.m_head = tails[i] = row;
+                        return;
+                    }
+
+                    if (s.m_hash==hash && keys_equal(m_keys, s.m_head, m_keys, row))
+                    {
+                        m_next[tails[i]] = row;
+                        tails[i] = row;
+                        return;
+                    }
+                }
+            }
+
+        private:
+            struct slot
+            {
+                slot() : m_hash(0), m_head(npos) {}
+                boost::uint64_t m_hash;
+                size_t          m_head;
+            };
+
+            const boost::ptr_vector<key_column>&    m_keys;
+            std::vector<boost::uint64_t>            m_hashes;
+            std::vector<size_t>                     m_next;
+            std::vector<slot>                       m_slots;
+            size_t                                  m_mask;
+        };
+
+        // Matching rows of the probe and build sides, npos in build_rows for unmatched
+        // rows of a left join
+        struct matches
+        {
+            std::vector<size_t> m_probe_rows;
+            std::vector<size_t> m_build_rows;
+        };
+
+        void probe(const join_table& table, const boost::ptr_vector<key_column>& keys, size_t first, size_t last, bool keep_unmatched, matches& result)
+        {
+            result.m_probe_rows.reserve(last - first);
+            result.m_build_rows.reserve(last - first);
+
+            std::vector<boost::uint64_t> hashes(s_batch_size);
+            for (size_t batch=first; batch<last; batch+=s_batch_size)
+            {
+                const size_t count((std::min)(s_batch_size, last - batch));
+
+                std::fill(hashes.begin(), hashes.end(), 0);
+                for (boost::ptr_vector<key_column>::const_iterator citr = keys.begin(); citr != keys.end(); ++citr)
+                {
+                    citr->hash(batch, batch + count, &hashes[0]);
+                }
+
+                for (size_t i=0; i<count; ++i)
+                {
+                    const size_t row(batch + i);
+                    size_t match(table.find(hashes[i], keys, row));
+
+                    if (match==npos && keep_unmatched)
+                    {
+                        result.m_probe_rows.push_back(row);
+                        result.m_build_rows.push_back(npos);
+                    }
+
+                    for (; match!=npos; match=table.next(match))
+                    {
+                        result.m_probe_rows.push_back(row);
+                        result.m_build_rows.push_back(match);
+                    }
+                }
+            }
+        }
+
+        // Reorders matches found by probing with the right side into the order of the rows
+        // of the build side, keeping the order of the probed rows that match each of them
+        void in_build_order(matches& all, size_t build_rows)
+        {
+            std::vector<size_t> offsets(build_rows + 1, 0);
+            for (std::vector<size_t>::const_iterator citr = all.m_build_rows.begin(); citr != all.m_build_rows.end(); ++citr)
+            {
+                ++offsets[*citr + 1];
+            }
+            for (size_t row=0; row<build_rows; ++row)
+            {
+                offsets[row + 1] += offsets[row];
+            }
+
+            matches ordered;
+            ordered.m_probe_rows.resize(all.m_probe_rows.size());
+            ordered.m_build_rows.resize(all.m_build_rows.size());
+            for (size_t i=0; i<all.m_build_rows.size(); ++i)
+            {
+                const size_t n(offsets[all.m_build_rows[i]]++);
+                ordered.m_probe_rows[n] = all.m_probe_rows[i];
+                ordered.m_build_rows[n] = all.m_build_rows[i];
+            }
+
+            all.m_probe_rows.swap(ordered.m_probe_rows);
+            all.m_build_rows.swap(ordered.m_build_rows);
+        }
+
+        // Name of a column of the right side in the result, with a suffix if the name is
+        // already taken by a column of the left
+        std::string right_name(const std::string& name, const std::vector<std::string>& taken)
+        {
+            if (std::find(taken.begin(), taken.end(), name)==taken.end())
+            {
+                return name;
+            }
+
+            const std::string suffixed(name + "_right");
+            if (std::find(taken.begin(), taken.end(), suffixed)!=taken.end())
+            {
+                boost::throw_exception(variant_error(boost::str(boost::format("Cannot name column '%s' of the right table in a join, both '%s' and '%s' are taken")
+                    % name
+                    % name
+                    % suffixed)));
+            }
+            return suffixed;
+        }
+
+        void key_columns(const data_table& table, const std::vector<std::string>& names, boost::ptr_vector<key_column>& result)
+        {
+            for (std::vector<std::string>::const_iterator citr = names.begin(); citr != names.end(); ++citr)
+            {
+                result.push_back(make_key_column(table.get_column(*citr)));
+            }
+        }
+
+    } // namespace
+
+    void data_table::join(const data_table& right, const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys, data_table_join_t type, data_table& result, size_t threads /* = 0 */) const
+    {
+        if (left_keys.empty() || left_keys.size()!=right_keys.size())
+        {
+            boost::throw_exception(variant_error("Join requires the same number of key columns, at least one, on each side"));
+        }
+
+        for (size_t k=0; k<left_keys.size(); ++k)
+        {
+            const data_table_column_base& lhs(get_column(left_keys[k]));
+            const data_table_column_base& rhs(right.get_column(right_keys[k]));
+
+            if (lhs.type()!=rhs.type())
+            {
+                boost::throw_exception(variant_error(boost::str(boost::format("Cannot join column '%s' of type %s with column '%s' of type %s")
+                    % lhs.name()
+                    % variant_base::enum_to_string(lhs.type())
+                    % rhs.name()
+                    % variant_base::enum_to_string(rhs.type()))));
+            }
+        }
+
+        // the hash table is built on the smaller side, except that a left join must probe
+        // with every row on the left
+        const bool build_left(type==InnerJoin && size()<right.size());
+
+        const data_table& build(build_left ? *this : right);
+        const data_table& probe_side(build_left ? right : *this);
+
+        boost::ptr_vector<key_column> build_keys, probe_keys;
+        key_columns(build, build_left ? left_keys : right_keys, build_keys);
+        key_columns(probe_side, build_left ? right_keys : left_keys, probe_keys);
+
+        const join_table table(build_keys, build.size());
+
+        // probe in chunks, each producing its matches in row order
+        const size_t rows(probe_side.size());
+
+        thread_pool& pool(thread_pool::instance());
+        if (threads==0)
+        {
+            threads = pool.size();
+        }
+
+        const size_t chunks((std::max)(static_cast<size_t>(1), (std::min)(threads, rows / s_min_rows_per_thread)));
+        std::vector<matches> chunk_matches(chunks);
+
+        parallel_for(chunks, [&](size_t c) {
+            probe(table, probe_keys, rows * c / chunks, rows * (c + 1) / chunks, type==LeftJoin, chunk_matches[c]);
+        }, pool);
+
+        matches all;
+        if (chunks==1)
+        {
+            all.m_probe_rows.swap(chunk_matches[0].m_probe_rows);
+            all.m_build_rows.swap(chunk_matches[0].m_build_rows);
+        }
+        else
+        {
+            size_t size(0);
+            for (size_t c=0; c<chunks; ++c)
+            {
+                size += chunk_matches[c].m_probe_rows.size();
+            }
+
+            all.m_probe_rows.reserve(size);
+            all.m_build_rows.reserve(size);
+            for (size_t c=0; c<chunks; ++c)
+            {
+                all.m_probe_rows.insert(all.m_probe_rows.end(), chunk_matches[c].m_probe_rows.begin(), chunk_matches[c].m_probe_rows.end());
+                all.m_build_rows.insert(all.m_build_rows.end(), chunk_matches[c].m_build_rows.begin(), chunk_matches[c].m_build_rows.end());
+                matches().m_probe_rows.swap(chunk_matches[c].m_probe_rows);
+                matches().m_build_rows.swap(chunk_matches[c].m_build_rows);
+            }
+        }
+
+        if (build_left)
+        {
+            in_build_order(all, size());
+        }
+
+        const std::vector<size_t>& left_rows(build_left ? all.m_build_rows : all.m_probe_rows);
+        const std::vector<size_t>& right_rows(build_left ? all.m_probe_rows : all.m_build_rows);
+
+        // every column of the left, then those of the right other than its keys, gathered
+        // a column at a time
+        std::vector<std::pair<const data_table_column_base*, const std::vector<size_t>*> > sources;
+        std::vector<std::string> names;
+        for (column_container_type::const_iterator citr = m_columns.begin(); citr != m_columns.end(); ++citr)
+        {
+            sources.push_back(std::make_pair(&*citr, &left_rows));
+            names.push_back(citr->name());
+        }
+        for (column_container_type::const_iterator citr = right.m_columns.begin(); citr != right.m_columns.end(); ++citr)
+        {
+            if (std::find(right_keys.begin(), right_keys.end(), citr->name())==right_keys.end())
+            {
+                sources.push_back(std::make_pair(&*citr, &right_rows));
+                names.push_back(right_name(citr->name(), names));
+            }
+        }
+
+        std::vector<data_table_column_base*> gathered(sources.size(), nullptr);
+        try
+        {
+            parallel_for(sources.size(), [&](size_t i) {
+                gathered[i] = sources[i].first->take(*sources[i].second);
+                gathered[i]->rename(names[i]);
+            }, pool);
+        }
+        catch (...)
+        {
+            for (size_t i=0; i<gathered.size(); ++i)
+            {
+                delete gathered[i];
+            }
+            throw;
+        }
+
+        column_container_type columns;
+        for (size_t i=0; i<gathered.size(); ++i)
+        {
+            columns.push_back(gathered[i]);
+        }
+
+        result.m_columns.swap(columns);
+    }
+
+}} // namespace protean::detail
@@ -0,0 +1,23 @@
+#include <protean/data_table_selection.hpp>
+
+namespace protean {
+
+    data_table_selection::data_table_selection(const column_collection_t& columns, std::vector<size_t>&& rows) :
+        m_columns(&columns),
+        m_rows(std::move(rows))
+    {
+    }
+
+    variant data_table_selection::table() const
+    {
+        variant result(variant::DataTable, m_rows.size());
+
+        for (column_collection_t::const_iterator citr = m_columns->begin(); citr != m_columns->end(); ++citr)
+        {
+            result.columns().push_back(citr->take(m_rows));
+        }
+
+        return result;
+    }
+
+} // namespace protean
@@ -0,0 +1,422 @@
+#include <protean/data_table_sort.hpp>
+#include <protean/detail/data_table.hpp>
+#include <protean/detail/thread_pool.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace protean {
+
+    data_table_sort_key::data_table_sort_key(const std::string& column, order_t order /* = Ascending */) :
+        m_column(column),
+        m_order(order)
+    {
+    }
+
+namespace detail {
+
+    namespace {
+
+        // Tables smaller than this are sorted on the calling thread
+        static const size_t s_min_rows_per_thread = 65536;
+
+        static const boost::posix_time::ptime s_epoch(boost::gregorian::date(1970, 1, 1));
+
+        /* Unsigned images of values that order as the values do, so that columns of */
+        /* these types can be radix sorted; only strings need to be compared         */
+        /*****************************************************************************/
+        template <typename T> struct has_radix_key                      : boost::false_type {};
+        template <> struct has_radix_key<bool>                          : boost::true_type {};
+        template <> struct has_radix_key<boost::int32_t>                : boost::true_type {};
+        template <> struct has_radix_key<boost::uint32_t>               : boost::true_type {};
+        template <> struct has_radix_key<boost::int64_t>                : boost::true_type {};
+        template <> struct has_radix_key<boost::uint64_t>               : boost::true_type {};
+        template <> struct has_radix_key<float>                         : boost::true_type {};
+        template <> struct has_radix_key<double>                        : boost::true_type {};
+        template <> struct has_radix_key<boost::gregorian::date>        : boost::true_type {};
+        template <> struct has_radix_key<boost::posix_time::time_duration> : boost::true_type {};
+        template <> struct has_radix_key<boost::posix_time::ptime>      : boost::true_type {};
+
+        inline boost::uint64_t radix_key(bool value)
+        {
+            return value ? 1 : 0;
+        }
+
+        inline boost::uint64_t radix_key(boost::int32_t value)
+        {
+            return static_cast<boost::uint32_t>(value) ^ 0x80000000u;
+        }
+
+        inline boost::uint64_t radix_key(boost::uint32_t value)
+        {
+            return value;
+        }
+
+        inline boost::uint64_t radix_key(boost::int64_t value)
+        {
+            return static_cast<boost::uint64_t>(value) ^ 0x8000000000000000ull;
+        }
+
+        inline boost::uint64_t radix_key(boost::uint64_t value)
+        {
+            return value;
+        }
+
+        // negative numbers have every bit flipped and positive ones the sign bit, which puts
+        // -0 before 0 and NaNs at either end
+        inline boost::uint64_t radix_key(double value)
+        {
+            boost::uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return (bits & 0x8000000000000000ull) ? ~bits : bits ^ 0x8000000000000000ull;
+        }
+
+        inline boost::uint64_t radix_key(float value)
+        {
+            return radix_key(static_cast<double>(value));
+        }
+
+        // special dates are held as day numbers before and after those of any other
+        inline boost::uint64_t radix_key(const boost::gregorian::date& value)
+        {
+            return value.day_number();
+        }
+
+        inline boost::uint64_t radix_key(const boost::posix_time::time_duration& value)
+        {
+            return radix_key(static_cast<boost::int64_t>(value.ticks()));
+        }
+
+        inline boost::uint64_t radix_key(const boost::posix_time::ptime& value)
+        {
+            return radix_key(value - s_epoch);
+        }
+
+        template <typename T>
+        inline int sort_compare(const T& lhs, const T& rhs)
+        {
+            return lhs<rhs ? -1 : (rhs<lhs ? 1 : 0);
+        }
+
+        inline int sort_compare(const string& lhs, const string& rhs)
+        {
+            return lhs.compare(rhs);
+        }
+
+        /* A key column of a sort, which orders rows either by radix keys or by comparing */
+        /* their values directly                                                          */
+        /**********************************************************************************/
+        class sort_column
+        {
+        public:
+            explicit sort_column(bool descending) :
+                m_descending(descending)
+            {}
+
+            virtual ~sort_column() {}
+
+            // Whether the column can be ordered by radix_keys()
+            virtual bool radix() const = 0;
+
+            // The radix key of each of 'count' rows, inverted for a descending sort
+            virtual void radix_keys(const size_t* rows, size_t count, boost::uint64_t* keys) const = 0;
+
+            // Negative, zero or positive as row 'lhs' sorts before, with or after row 'rhs'
+            virtual int compare(size_t lhs, size_t rhs) const = 0;
+
+        protected:
+            const bool m_descending;
+        };
+
+        template <variant_base::enum_type_t E>
+        class typed_sort_column : public sort_column
+        {
+            typedef typename column_traits<E>::value_type value_type;
+
+        public:
+            typed_sort_column(const data_table_column_base& column, bool descending) :
+                sort_column(descending),
+                m_values(column.begin<E>())
+            {}
+
+            virtual bool radix() const
+            {
+                return has_radix_key<value_type>::value;
+            }
+
+            virtual void radix_keys(const size_t* rows, size_t count, boost::uint64_t* keys) const
+            {
+                radix_keys(rows, count, keys, has_radix_key<value_type>());
+            }
+
+            virtual int compare(size_t lhs, size_t rhs) const
+            {
+                const int result(sort_compare(m_values[lhs], m_values[rhs]));
+                return m_descending ? -result : result;
+            }
+
+        private:
+            void radix_keys(const size_t* rows, size_t count, boost::uint64_t* keys, boost::true_type) const
+            {
+                const boost::uint64_t mask(m_descending ? ~0ull : 0ull);
+                for (size_t i=0; i<count; ++i)
+                {
+                    keys[i] = radix_key(m_values[rows[i]]) ^ mask;
+                }
+            }
+
+            void radix_keys(const size_t*, size_t, boost::uint64_t*, boost::false_type) const
+            {
+            }
+
+        private:
+            const typename column_traits<E>::const_iterator m_values;
+        };
+
+        sort_column* make_sort_column(const data_table_column_base& column, bool descending)
+        {
+            switch (column.type())
+            {
+                case variant_base::Boolean:     return new typed_sort_column<variant_base::Boolean>(column, descending);
+                case variant_base::Int32:       return new typed_sort_column<variant_base::Int32>(column, descending);
+                case variant_base::UInt32:      return new typed_sort_column<variant_base::UInt32>(column, descending);
+                case variant_base::Int64:       return new typed_sort_column<variant_base::Int64>(column, descending);
+                case variant_base::UInt64:      return new typed_sort_column<variant_base::UInt64>(column, descending);
+                case variant_base::Float:       return new typed_sort_column<variant_base::Float>(column, descending);
+                case variant_base::Double:      return new typed_sort_column<variant_base::Double>(column, descending);
+                case variant_base::String:      return new typed_sort_column<variant_base::String>(column, descending);
+                case variant_base::Any:         return new typed_sort_column<variant_base::Any>(column, descending);
+                case variant_base::Date:        return new typed_sort_column<variant_base::Date>(column, descending);
+                case variant_base::Time:        return new typed_sort_column<variant_base::Time>(column, descending);
+                case variant_base::DateTime:    return new typed_sort_column<variant_base::DateTime>(column, descending);
+                default:
+                    boost::throw_exception(variant_error(boost::str(boost::format("Column '%s' of type %s cannot be used as a sort key")
+                        % column.name()
+                        % variant_base::enum_to_string(column.type()))));
+            }
+            return nullptr;
+        }
+
+        // Orders rows by the key columns [first, last) in turn
+        class row_less
+        {
+        public:
+            row_less(const boost::ptr_vector<sort_column>& columns, size_t first, size_t last) :
+                m_columns(columns),
+                m_first(first),
+                m_last(last)
+            {}
+
+            bool operator()(size_t lhs, size_t rhs) const
+            {
+                for (size_t k=m_first; k<m_last; ++k)
+                {
+                    const int result(m_columns[k].compare(lhs, rhs));
+                    if (result!=0)
+                    {
+                        return result<0;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            const boost::ptr_vector<sort_column>&   m_columns;
+            size_t                                  m_first;
+            size_t                                  m_last;
+        };
+
+        // Stable least-significant-digit radix sort of the rows in 'permutation' by their
+        // radix keys in 'column', a byte at a time, skipping bytes that all keys share
+        void radix_sort(const sort_column& column, std::vector<size_t>& permutation, std::vector<size_t>& buffer)
+        {
+            const size_t rows(permutation.size());
+
+            std::vector<boost::uint64_t> keys(rows);
+            column.radix_keys(&permutation[0], rows, &keys[0]);
+
+            std::vector<size_t> counts(8 * 256, 0);
+            for (size_t i=0; i<rows; ++i)
+            {
+                const boost::uint64_t key(keys[i]);
+                for (size_t b=0; b<8; ++b)
+                {
+                    ++counts[b * 256 + ((key >> (8 * b)) & 0xff)];
+                }
+            }
+
+            std::vector<boost::uint64_t> key_buffer(rows);
+            buffer.resize(rows);
+
+            for (size_t b=0; b<8; ++b)
+            {
+                size_t* offsets(&counts[b * 256]);
+                const unsigned int shift(static_cast<unsigned int>(8 * b));
+
+                if (offsets[(keys[0] >> shift) & 0xff]==rows)
+                {
+                    continue;
+                }
+
+                size_t offset(0);
+                for (size_t d=0; d<256; ++d)
+                {
+                    const size_t count(offsets[d]);
+                    offsets[d] = offset;
+                    offset += count;
+                }
+
+                for (size_t i=0; i<rows; ++i)
+                {
+                    const size_t position(offsets[(keys[i] >> shift) & 0xff]++);
+                    key_buffer[position] = keys[i];
+                    buffer[position] = permutation[i];
+                }
+
+                keys.swap(key_buffer);
+                permutation.swap(buffer);
+            }
+        }
+
+        // Stable merge sort of the rows in 'permutation': chunks are sorted on up to
+        // 'threads' threads, then merged in pairs, the pairs of each round in parallel
+        void merge_sort(const row_less& less, std::vector<size_t>& permutation, std::vector<size_t>& buffer, size_t threads, thread_pool& pool)
+        {
+            const size_t rows(permutation.size());
+            const size_t chunks((std::max)(static_cast<size_t>(1), (std::min)(threads, rows / s_min_rows_per_thread)));
+
+            std::vector<size_t> bounds(chunks + 1);
+            for (size_t c=0; c<=chunks; ++c)
+            {
+                bounds[c] = rows * c / chunks;
+            }
+
+            parallel_for(chunks, [&](size_t c) {
+                std::stable_sort(permutation.begin() + bounds[c], permutation.begin() + bounds[c + 1], less);
+            }, pool);
+
+            buffer.resize(rows);
+            while (bounds.size()>2)
+            {
+                const size_t runs(bounds.size() - 1);
+
+                parallel_for((runs + 1) / 2, [&](size_t p) {
+                    const size_t first(bounds[2 * p]);
+                    const size_t middle(bounds[(std::min)(2 * p + 1, runs)]);
+                    const size_t last(bounds[(std::min)(2 * p + 2, runs)]);
+
+                    std::merge(permutation.begin() + first, permutation.begin() + middle,
+                               permutation.begin() + middle, permutation.begin() + last,
+                               buffer.begin() + first, less);
+                }, pool);
+
+                permutation.swap(buffer);
+
+                std::vector<size_t> merged;
+                for (size_t i=0; i<bounds.size(); i+=2)
+                {
+                    merged.push_back(bounds[i]);
+                }
+                if (merged.back()!=rows)
+                {
+                    merged.push_back(rows);
+                }
+                bounds.swap(merged);
+            }
+        }
+
+    } // namespace
+
+    void data_table::sort_permutation(const std::vector<data_table_sort_key>& keys, std::vector<size_t>& permutation, size_t threads /* = 0 */) const
+    {
+        if (keys.empty())
+        {
+            boost::throw_exception(variant_error("Sort requires at least one key column"));
+        }
+
+        boost::ptr_vector<sort_column> columns;
+        for (std::vector<data_table_sort_key>::const_iterator citr = keys.begin(); citr != keys.end(); ++citr)
+        {
+            columns.push_back(make_sort_column(get_column(citr->m_column), citr->m_order==data_table_sort_key::Descending));
+        }
+
+        permutation.resize(size());
+        std::iota(permutation.begin(), permutation.end(), static_cast<size_t>(0));
+
+        if (permutation.size()<2)
+        {
+            return;
+        }
+
+        thread_pool& pool(thread_pool::instance());
+        if (threads==0)
+        {
+            threads = pool.size();
+        }
+
+        // as each pass is stable, sorting by the keys from last to first orders the rows by
+        // all of them: each radix key takes a pass of its own and each run of other keys a
+        // single merge sort
+        std::vector<size_t> buffer;
+        for (size_t last=columns.size(); last>0;)
+        {
+            if (columns[last - 1].radix())
+            {
+                radix_sort(columns[last - 1], permutation, buffer);
+                --last;
+            }
+            else
+            {
+                size_t first(last - 1);
+                while (first>0 && !columns[first - 1].radix())
+                {
+                    --first;
+                }
+
+                merge_sort(row_less(columns, first, last), permutation, buffer, threads, pool);
+                last = first;
+            }
+        }
+    }
+
+    data_table& data_table::sort(const std::vector<data_table_sort_key>& keys, size_t threads /* = 0 */)
+    {
+        std::vector<size_t> permutation;
+        sort_permutation(keys, permutation, threads);
+
+        // gather each column once, a column per thread
+        std::vector<data_table_column_base*> gathered(m_columns.size(), nullptr);
+        try
+        {
+            parallel_for(m_columns.size(), [&](size_t i) {
+                gathered[i] = m_columns[i].take(permutation);
+            }, thread_pool::instance());
+        }
+        catch (...)
+        {
+            for (size_t i=0; i<gathered.size(); ++i)
+            {
+                delete gathered[i];
+            }
+            throw;
+        }
+
+        column_container_type columns;
+        for (size_t i=0; i<gathered.size(); ++i)
+        {
+            columns.push_back(gathered[i]);
+        }
+
+        m_columns.swap(columns);
+        reset_indexes();
+        return *this;
+    }
+
+}} // namespace protean::detail
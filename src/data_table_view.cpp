@@ -0,0 +1,83 @@
+#include <protean/data_table_view.hpp>
+#include <protean/detail/data_table.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/format.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace protean {
+
+    data_table_view::data_table_view(const column_collection_t& columns) :
+        m_offset(0),
+        m_length(columns.empty() ? 0 : columns.front().size())
+    {
+        for (column_collection_t::const_iterator citr = columns.begin(); citr != columns.end(); ++citr)
+        {
+            m_columns.push_back(&*citr);
+        }
+    }
+
+    const data_table_column_base& data_table_view::column(size_t i) const
+    {
+        if (i >= m_columns.size())
+            boost::throw_exception(variant_error("Column out of range"));
+
+        return *m_columns[i];
+    }
+
+    const data_table_column_base& data_table_view::column(const std::string& name) const
+    {
+        for (std::vector<const data_table_column_base*>::const_iterator citr = m_columns.begin(); citr != m_columns.end(); ++citr)
+        {
+            if ((*citr)->name() == name)
+                return **citr;
+        }
+
+        boost::throw_exception(variant_error(boost::str(boost::format("No such column '%s'") % name)));
+    }
+
+    data_table_view data_table_view::slice(size_t offset, size_t length) const
+    {
+        data_table_view result(*this);
+        result.m_offset = m_offset + (std::min)(offset, m_length);
+        result.m_length = (std::min)(length, m_length - (result.m_offset - m_offset));
+        return result;
+    }
+
+    data_table_view data_table_view::select(const std::vector<std::string>& names) const
+    {
+        data_table_view result(*this);
+        result.m_columns.clear();
+
+        for (std::vector<std::string>::const_iterator citr = names.begin(); citr != names.end(); ++citr)
+        {
+            result.m_columns.push_back(&column(*citr));
+        }
+        return result;
+    }
+
+    variant data_table_view::table() const
+    {
+        std::vector<size_t> rows(m_length);
+        std::iota(rows.begin(), rows.end(), m_offset);
+
+        variant result(variant::DataTable, m_length);
+        for (std::vector<const data_table_column_base*>::const_iterator citr = m_columns.begin(); citr != m_columns.end(); ++citr)
+        {
+            result.columns().push_back((*citr)->take(rows));
+        }
+
+        return result;
+    }
+
+    variant data_table_view::group_by(const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, size_t threads /* = 0 */) const
+    {
+        variant result(variant::DataTable);
+        detail::data_table::group_by(*this, keys, aggregates, result.columns(), threads);
+        return result;
+    }
+
+} // namespace protean
@@ -3,10 +3,13 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <functional>
+#include <utility>
 
 namespace protean { namespace detail {
 
     static const boost::uint64_t s_onStackMask    = 0x0000000000000001ull;
+    static const boost::uint64_t s_referenceMask  = 0x0000000000000002ull;
 
     string::string() :
         m_rawData(0)
@@ -38,9 +41,16 @@ namespace protean { namespace detail {
         }
     }
 
+    string::string( string&& rhs ) BOOST_NOEXCEPT :
+        m_rawData(rhs.m_rawData)
+    {
+        rhs.m_rawData=0;
+        rhs.setStackFlag();
+    }
+
     string::~string()
     {
-        if ( !onStack() )
+        if ( !onStack() && !isReference() )
         {
             alignedFree(heapPointer());
         }
@@ -52,6 +62,38 @@ namespace protean { namespace detail {
         return *this;
     }
 
+    string& string::operator=(string&& rhs) BOOST_NOEXCEPT
+    {
+        string(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    /*static*/ string string::reference( const char* value, size_t size )
+    {
+        if ( size<7 )
+        {
+            return string(value, size);
+        }
+
+        assert( (reinterpret_cast<boost::uint64_t>(value) & (s_onStackMask | s_referenceMask))==0 );
+
+        string result;
+        result.m_rawData = reinterpret_cast<boost::uint64_t>(value) | s_referenceMask;
+        return result;
+    }
+
+    /*static*/ string string::reference( const string& value )
+    {
+        if ( value.onStack() )
+        {
+            return value;
+        }
+
+        string result;
+        result.m_rawData = reinterpret_cast<boost::uint64_t>(value.heapPointer()) | s_referenceMask;
+        return result;
+    }
+
     void string::swap(string& rhs)
     {
         std::swap(m_rawData, rhs.m_rawData);
@@ -93,10 +135,40 @@ namespace protean { namespace detail {
         }
     }
 
+    void string::assign( const char* value, size_t size )
+    {
+        // the heap buffer holds at least as many characters as the current value
+        if ( !onStack() && !isReference() && size>=7 && size<=std::strlen(heapPointer()) )
+        {
+            std::memcpy(heapPointer(), value, size);
+            *(heapPointer()+size)=0;
+        }
+        else
+        {
+            string(value, size).swap(*this);
+        }
+    }
+
     bool string::onStack() const {
         return (m_rawData&s_onStackMask) != 0;
     }
 
+    bool string::isReference() const {
+        return !onStack() && (m_rawData&s_referenceMask) != 0;
+    }
+
+    void string::rebase( const char* first, const char* last, const char* to )
+    {
+        if ( isReference() )
+        {
+            const char* ptr(heapPointer());
+            if ( std::less_equal<const char*>()(first, ptr) && std::less<const char*>()(ptr, last) )
+            {
+                m_rawData = reinterpret_cast<boost::uint64_t>(to + (ptr - first)) | s_referenceMask;
+            }
+        }
+    }
+
     size_t string::size() const
     {
         return std::strlen(value());
@@ -116,7 +188,7 @@ namespace protean { namespace detail {
     char* string::heapPointer()
     {
         assert(!onStack());
-        return m_heapPtr;
+        return reinterpret_cast<char*>(static_cast<size_t>(m_rawData & ~s_referenceMask));
     }
 
     void string::heapPointer(char* ptr)
@@ -148,6 +220,11 @@ namespace protean { namespace detail {
 
     int string::compare(const string& rhs) const
     {
+        // values of a dictionary-encoded column are equal if they refer to the same entry
+        if (value()==rhs.value())
+        {
+            return 0;
+        }
 		return strcmp(value(), rhs.value());
     }
 
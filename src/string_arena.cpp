@@ -0,0 +1,98 @@
+#include <protean/detail/string_arena.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace protean { namespace detail {
+
+    // string::reference requires 4-byte aligned values
+    static const size_t s_alignment = 4;
+
+    /*static*/ size_t string_arena::padded_size(size_t size)
+    {
+        return (size + 1 + s_alignment - 1) & ~(s_alignment - 1);
+    }
+
+    string string_arena::append(const char* value, size_t size, std::vector<string>& rows)
+    {
+        const size_t offset(m_bytes.size());
+        const size_t length(padded_size(size));
+
+        if (offset + length > m_bytes.capacity())
+        {
+            // 'value' may be one of the rows, which is moved as the arena grows
+            const char* first(m_bytes.data());
+            const bool inside(std::less_equal<const char*>()(first, value) && std::less<const char*>()(value, first + offset));
+            const size_t position(inside ? value - first : 0);
+
+            grow(offset + length, rows);
+
+            if (inside)
+            {
+                value = m_bytes.data() + position;
+            }
+        }
+
+        m_bytes.resize(offset + length, '\0');
+        std::memcpy(&m_bytes[offset], value, size);
+
+        return string::reference(&m_bytes[offset], size);
+    }
+
+    char* string_arena::extend(size_t size, std::vector<string>& rows)
+    {
+        const size_t offset(m_bytes.size());
+        if (offset + size > m_bytes.capacity())
+        {
+            grow(offset + size, rows);
+        }
+
+        m_bytes.resize(offset + size);
+        return m_bytes.data() + offset;
+    }
+
+    void string_arena::reserve(size_t size, std::vector<string>& rows)
+    {
+        if (size > m_bytes.capacity())
+        {
+            grow(size, rows);
+        }
+    }
+
+    void string_arena::clear()
+    {
+        std::vector<char>().swap(m_bytes);
+    }
+
+    const char* string_arena::data() const
+    {
+        return m_bytes.data();
+    }
+
+    size_t string_arena::size() const
+    {
+        return m_bytes.size();
+    }
+
+    void string_arena::grow(size_t size, std::vector<string>& rows)
+    {
+        // at least doubling, so that the cost of moving the rows is amortised
+        std::vector<char> bytes;
+        bytes.reserve((std::max)(size, 2 * m_bytes.capacity()));
+        bytes.assign(m_bytes.begin(), m_bytes.end());
+
+        if (!m_bytes.empty())
+        {
+            const char* first(m_bytes.data());
+            const char* last(first + m_bytes.size());
+            for (std::vector<string>::iterator itr = rows.begin(); itr != rows.end(); ++itr)
+            {
+                itr->rebase(first, last, bytes.data());
+            }
+        }
+
+        m_bytes.swap(bytes);
+    }
+
+}} // namespace protean::detail
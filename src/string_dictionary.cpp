@@ -0,0 +1,80 @@
+#include <protean/detail/string_dictionary.hpp>
+#include <protean/detail/hash.hpp>
+
+#include <cstring>
+
+namespace protean { namespace detail {
+
+    // Values are appended to blocks of this size, or to a block of their own if larger
+    static const size_t s_blockSize = 64 * 1024;
+
+    // string::reference requires 4-byte aligned values
+    static const size_t s_alignment = 8;
+
+    string_dictionary::string_dictionary() :
+        m_bytes(0)
+    {
+    }
+
+    string string_dictionary::intern(const string& value)
+    {
+        return intern(value.value(), value.size());
+    }
+
+    string string_dictionary::intern(const char* value, size_t size)
+    {
+        if (size<7)
+        {
+            return string(value, size);
+        }
+
+        // lookup relies on 'value' being null-terminated
+        boost::unordered_set<const char*, hash, equal>::const_iterator citr(m_values.find(value));
+        if (citr==m_values.end())
+        {
+            citr = m_values.insert(add(value, size)).first;
+        }
+        return string::reference(*citr, size);
+    }
+
+    size_t string_dictionary::size() const
+    {
+        return m_values.size();
+    }
+
+    size_t string_dictionary::bytes() const
+    {
+        return m_bytes;
+    }
+
+    const char* string_dictionary::add(const char* value, size_t size)
+    {
+        const size_t length((size + 1 + s_alignment - 1) & ~(s_alignment - 1));
+
+        if (m_blocks.empty() || m_blocks.back().capacity() - m_blocks.back().size() < length)
+        {
+            // blocks are reserved up front and never grown, so values stay where they are
+            m_blocks.push_back(std::vector<char>());
+            m_blocks.back().reserve((std::max)(s_blockSize, length));
+            m_bytes += m_blocks.back().capacity();
+        }
+
+        std::vector<char>& block(m_blocks.back());
+        const size_t offset(block.size());
+        block.resize(offset + length, '\0');
+        std::memcpy(&block[offset], value, size);
+
+        return &block[offset];
+    }
+
+    size_t string_dictionary::hash::operator()(const char* value) const
+    {
+        return static_cast<size_t>(hash_value(value, 0));
+    }
+
+    bool string_dictionary::equal::operator()(const char* lhs, const char* rhs) const
+    {
+        return std::strcmp(lhs, rhs)==0;
+    }
+
+}} // namespace protean::detail
@@ -0,0 +1,107 @@
+#include <protean/detail/thread_pool.hpp>
+
+#include <boost/config.hpp>
+
+// Compilers without C++11 thread_local, such as vc120, have an extension for plain
+// thread-local data, which is all that is needed here
+#if !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+#   define PROTEAN_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#   define PROTEAN_THREAD_LOCAL __declspec(thread)
+#else
+#   define PROTEAN_THREAD_LOCAL __thread
+#endif
+
+namespace protean { namespace detail {
+
+    namespace {
+
+        // Pool whose worker is the current thread, if any
+        PROTEAN_THREAD_LOCAL const thread_pool* s_current_pool = nullptr;
+
+    } // namespace
+
+    thread_pool::thread_pool(size_t size) :
+        m_stopping(false)
+    {
+        if (size == 0)
+        {
+            size = std::thread::hardware_concurrency();
+            if (size == 0)
+                size = 1;
+        }
+
+        m_threads.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_threads.push_back(std::thread(&thread_pool::run, this));
+        }
+    }
+
+    thread_pool::~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_condition.notify_all();
+
+        for (size_t i = 0; i < m_threads.size(); ++i)
+        {
+            m_threads[i].join();
+        }
+    }
+
+    size_t thread_pool::size() const
+    {
+        return m_threads.size();
+    }
+
+    bool thread_pool::is_worker() const
+    {
+        return s_current_pool==this;
+    }
+
+    thread_pool& thread_pool::instance()
+    {
+        // Leaked rather than destroyed at exit, where joining the workers from a static
+        // destructor would run under the loader lock of a DLL and could deadlock; the
+        // workers are left waiting and end with the process
+        static thread_pool* pool(new thread_pool());
+        return *pool;
+    }
+
+    void thread_pool::enqueue(const std::function<void()>& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(task);
+        }
+        m_condition.notify_one();
+    }
+
+    void thread_pool::run()
+    {
+        s_current_pool = this;
+
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (!m_stopping && m_tasks.empty())
+                    m_condition.wait(lock);
+
+                if (m_tasks.empty())
+                    return;
+
+                task = m_tasks.front();
+                m_tasks.pop_front();
+            }
+
+            // Exceptions are captured by the packaged_task and reported through its future
+            task();
+        }
+    }
+
+}} // namespace protean::detail
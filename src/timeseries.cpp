@@ -1,12 +1,146 @@
 #include <protean/detail/timeseries.hpp>
 #include <protean/detail/timeseries_iterator.hpp>
+#include <protean/detail/data_table_column.hpp>
 #include <protean/variant.hpp>
 #include <protean/variant_error.hpp>
 
 #include <protean/detail/hash.hpp>
 
+#include <boost/format.hpp>
+#include <boost/integer_traits.hpp>
+
+#include <algorithm>
+#include <memory>
+
 namespace protean { namespace detail {
 
+    namespace {
+
+        static const boost::int64_t not_a_date_time_ticks = boost::integer_traits<boost::int64_t>::const_min;
+        static const boost::int64_t neg_infin_ticks = boost::integer_traits<boost::int64_t>::const_min + 1;
+        static const boost::int64_t pos_infin_ticks = boost::integer_traits<boost::int64_t>::const_max;
+
+        const boost::posix_time::ptime& epoch()
+        {
+            static const boost::posix_time::ptime value(boost::gregorian::date(1970, 1, 1));
+            return value;
+        }
+
+        /* Moves values of one number type in and out of a column of that type */
+        /************************************************************************/
+        class value_codec
+        {
+        public:
+            virtual ~value_codec() { }
+
+            virtual data_table_column_base* make_column() const = 0;
+            virtual void push_back(data_table_column_base& column, const variant& value) const = 0;
+            virtual variant at(const data_table_column_base& column, size_t n) const = 0;
+        };
+
+        template <variant_base::enum_type_t E>
+        class typed_value_codec : public value_codec
+        {
+            typedef typename column_traits<E>::value_type value_type;
+
+        public:
+            data_table_column_base* make_column() const
+            {
+                return new data_table_column<E>("");
+            }
+            void push_back(data_table_column_base& column, const variant& value) const
+            {
+                column.push_back(value.as<value_type>());
+            }
+            variant at(const data_table_column_base& column, size_t n) const
+            {
+                return variant(static_cast<value_type>(column.begin<E>()[n]));
+            }
+        };
+
+        const value_codec& codec(variant_base::enum_type_t type)
+        {
+            static const typed_value_codec<variant_base::Boolean>   boolean_codec;
+            static const typed_value_codec<variant_base::Int32>     int32_codec;
+            static const typed_value_codec<variant_base::UInt32>    uint32_codec;
+            static const typed_value_codec<variant_base::Int64>     int64_codec;
+            static const typed_value_codec<variant_base::UInt64>    uint64_codec;
+            static const typed_value_codec<variant_base::Float>     float_codec;
+            static const typed_value_codec<variant_base::Double>    double_codec;
+
+            switch (type)
+            {
+                case variant_base::Boolean:     return boolean_codec;
+                case variant_base::Int32:       return int32_codec;
+                case variant_base::UInt32:      return uint32_codec;
+                case variant_base::Int64:       return int64_codec;
+                case variant_base::UInt64:      return uint64_codec;
+                case variant_base::Float:       return float_codec;
+                case variant_base::Double:      return double_codec;
+                default:
+                    boost::throw_exception(variant_error(boost::str(boost::format("TimeSeries values of type %s cannot be held unboxed")
+                        % variant_base::enum_to_string(type))));
+            }
+            return double_codec;
+        }
+
+        bool is_unboxed(variant_base::enum_type_t type)
+        {
+            return (type & variant_base::Number)!=0 && type!=variant_base::Variant;
+        }
+
+    } // namespace
+
+    timeseries::timeseries() :
+        m_type(variant_base::None),
+        m_column(nullptr),
+        m_ordered(true),
+        m_enforce_order(false),
+        m_unbox(false)
+    {
+    }
+
+    timeseries::timeseries(const timeseries& rhs) :
+        m_times(rhs.m_times),
+        m_type(rhs.m_type),
+        m_column(rhs.m_column==nullptr ? nullptr : rhs.m_column->clone()),
+        m_variants(rhs.m_variants),
+        m_ordered(rhs.m_ordered),
+        m_enforce_order(rhs.m_enforce_order),
+        m_unbox(rhs.m_unbox)
+    {
+    }
+
+    timeseries& timeseries::operator=(const timeseries& rhs)
+    {
+        if (this!=&rhs)
+        {
+            data_table_column_base* column(rhs.m_column==nullptr ? nullptr : rhs.m_column->clone());
+            try
+            {
+                m_times = rhs.m_times;
+                m_variants = rhs.m_variants;
+            }
+            catch (...)
+            {
+                delete column;
+                throw;
+            }
+            delete m_column;
+            m_column = column;
+            m_type = rhs.m_type;
+            m_ordered = rhs.m_ordered;
+            m_enforce_order = rhs.m_enforce_order;
+            m_unbox = rhs.m_unbox;
+        }
+        return *this;
+    }
+
+    timeseries::~timeseries()
+    {
+        delete m_column;
+    }
+
     int timeseries::compare(const collection& rhs) const
     {
         const timeseries* cast_rhs = dynamic_cast<const timeseries*>(&rhs);
@@ -14,47 +148,250 @@ namespace protean { namespace detail {
         {
             boost::throw_exception(variant_error("Unable to cast collection to timeseries"));
         }
-        return (std::lexicographical_compare(m_value.begin(), m_value.end(), cast_rhs->m_value.begin(), cast_rhs->m_value.end()) ?
-            -1 : (std::lexicographical_compare(cast_rhs->m_value.begin(), cast_rhs->m_value.end(), m_value.begin(), m_value.end()) ? 1 : 0));
+
+        variant lhs_copy, rhs_copy;
+        const size_t n(std::min(size(), cast_rhs->size()));
+        for (size_t i=0; i<n; ++i)
+        {
+            if (m_times[i]!=cast_rhs->m_times[i])
+            {
+                return m_times[i]<cast_rhs->m_times[i] ? -1 : 1;
+            }
+            const int cmp(value(i, lhs_copy).compare(cast_rhs->value(i, rhs_copy)));
+            if (cmp!=0)
+            {
+                return cmp;
+            }
+        }
+        return size()<cast_rhs->size() ? -1 : (size()>cast_rhs->size() ? 1 : 0);
     }
 
     boost::uint64_t timeseries::hash(boost::uint64_t seed) const
     {
-        return hash_range(m_value.begin(), m_value.end(), seed);
+        // Hashes the (time, value) pairs the series used to be held as, so hashes are unchanged
+        variant copy;
+        for (size_t i=0; i<size(); ++i)
+        {
+            seed = hash_value(from_ticks(m_times[i]), seed);
+            seed = hash_value(value(i, copy), seed);
+        }
+        return seed;
     }
 
     bool timeseries::empty() const
     {
-        return m_value.empty();
+        return m_times.empty();
     }
     size_t timeseries::size() const
     {
-        return m_value.size();
+        return m_times.size();
     }
     void timeseries::clear()
     {
-        m_value.clear();
+        delete m_column;
+        m_column = nullptr;
+        m_type = variant_base::None;
+        m_times.clear();
+        m_variants.clear();
+        m_ordered = true;
+        m_unbox = false;
     }
+
+    void timeseries::append(const date_time_t& time, const variant& value)
+    {
+        const boost::int64_t ticks(next_ticks(time));
+
+        if (m_type==variant_base::None && is_unboxed(value.type()))
+        {
+            m_column = codec(value.type()).make_column();
+            m_type = value.type();
+        }
+        else if (m_unbox)
+        {
+            unbox();
+        }
+
+        if (m_type==value.type())
+        {
+            codec(m_type).push_back(*m_column, value);
+        }
+        else
+        {
+            box();
+            m_type = variant_base::Variant;
+            m_variants.push_back(value);
+        }
+        m_times.push_back(ticks);
+        m_ordered = m_ordered && (m_times.size()<2 || m_times[m_times.size()-2]<=ticks);
+    }
+
     variant& timeseries::push_back(const date_time_t& time, const variant& value)
     {
-        m_value.push_back( std::make_pair(time, value) );
-        return m_value.rbegin()->second;
+        const boost::int64_t ticks(next_ticks(time));
+
+        box();
+        m_type = variant_base::Variant;
+        m_unbox = false;
+        m_variants.push_back(value);
+        m_times.push_back(ticks);
+        m_ordered = m_ordered && (m_times.size()<2 || m_times[m_times.size()-2]<=ticks);
+        return m_variants.back();
     }
+
     variant_const_iterator_base* timeseries::begin() const
     {
-        return new timeseries_const_iterator(m_value.begin());
+        return new timeseries_const_iterator(this, 0);
     }
     variant_const_iterator_base* timeseries::end() const
     {
-        return new timeseries_const_iterator(m_value.end());
+        return new timeseries_const_iterator(this, size());
     }
+    // The values are only boxed when an iterator is dereferenced, see value(n)
     variant_iterator_base* timeseries::begin()
     {
-        return new timeseries_iterator(m_value.begin());
+        return new timeseries_iterator(this, 0);
     }
     variant_iterator_base* timeseries::end()
     {
-        return new timeseries_iterator(m_value.end());
+        return new timeseries_iterator(this, size());
+    }
+
+    boost::int64_t timeseries::to_ticks(const date_time_t& time)
+    {
+        if (time.is_special())
+        {
+            return time.is_pos_infinity() ? pos_infin_ticks : (time.is_neg_infinity() ? neg_infin_ticks : not_a_date_time_ticks);
+        }
+        return (time - epoch()).ticks();
+    }
+
+    timeseries::date_time_t timeseries::from_ticks(boost::int64_t ticks)
+    {
+        switch (ticks)
+        {
+            case not_a_date_time_ticks:     return date_time_t(boost::posix_time::not_a_date_time);
+            case neg_infin_ticks:           return date_time_t(boost::posix_time::neg_infin);
+            case pos_infin_ticks:           return date_time_t(boost::posix_time::pos_infin);
+            default:                        return epoch() + boost::posix_time::time_duration(0, 0, 0, ticks);
+        }
+    }
+
+    const data_table_column_base& timeseries::values() const
+    {
+        if (m_column==nullptr)
+        {
+            boost::throw_exception(variant_error(boost::str(boost::format("TimeSeries values of type %s are not held unboxed")
+                % variant_base::enum_to_string(m_type))));
+        }
+        return *m_column;
+    }
+
+    const variant& timeseries::value(size_t n, variant& copy) const
+    {
+        if (m_column==nullptr)
+        {
+            return m_variants[n];
+        }
+        copy = codec(m_type).at(*m_column, n);
+        return copy;
+    }
+
+    variant& timeseries::value(size_t n)
+    {
+        if (m_column!=nullptr)
+        {
+            box();
+            m_unbox = true;
+        }
+        return m_variants[n];
+    }
+
+    void timeseries::assign(std::vector<boost::int64_t>& times, data_table_column_base* values)
+    {
+        if (values->size()!=times.size() || !is_unboxed(values->type()))
+        {
+            delete values;
+            boost::throw_exception(variant_error("Unable to assign TimeSeries values that are not numbers, or not one per time"));
+        }
+
+        delete m_column;
+        m_column = values;
+        m_type = values->type();
+        m_times.swap(times);
+        m_variants.clear();
+        m_ordered = std::is_sorted(m_times.begin(), m_times.end());
+        m_unbox = false;
+    }
+
+    void timeseries::enforce_order(bool enforce)
+    {
+        if (enforce && !m_ordered)
+        {
+            boost::throw_exception(variant_error("Unable to enforce the order of a TimeSeries whose times are out of order"));
+        }
+        m_enforce_order = enforce;
+    }
+
+    boost::int64_t timeseries::next_ticks(const date_time_t& time)
+    {
+        const boost::int64_t ticks(to_ticks(time));
+        if (m_enforce_order && !m_times.empty() && ticks<m_times.back())
+        {
+            boost::throw_exception(variant_error(boost::str(boost::format("Attempt to add a point at %s before the last point of the TimeSeries, at %s")
+                % boost::posix_time::to_simple_string(time)
+                % boost::posix_time::to_simple_string(from_ticks(m_times.back())))));
+        }
+        return ticks;
+    }
+
+    void timeseries::box()
+    {
+        if (m_column!=nullptr)
+        {
+            const value_codec& type_codec(codec(m_type));
+
+            std::vector<variant> variants;
+            variants.reserve(m_column->size());
+            for (size_t i=0; i<m_column->size(); ++i)
+            {
+                variants.push_back(type_codec.at(*m_column, i));
+            }
+            m_variants.swap(variants);
+
+            delete m_column;
+            m_column = nullptr;
+            m_type = variant_base::Variant;
+        }
+    }
+
+    void timeseries::unbox()
+    {
+        m_unbox = false;
+
+        const variant_base::enum_type_t type(m_variants.empty() ? variant_base::None : m_variants.front().type());
+        if (!is_unboxed(type))
+        {
+            return;
+        }
+        for (size_t i=1; i<m_variants.size(); ++i)
+        {
+            if (m_variants[i].type()!=type)
+            {
+                return;
+            }
+        }
+
+        const value_codec& type_codec(codec(type));
+        std::unique_ptr<data_table_column_base> column(type_codec.make_column());
+        column->reserve(m_variants.size());
+        for (size_t i=0; i<m_variants.size(); ++i)
+        {
+            type_codec.push_back(*column, m_variants[i]);
+        }
+
+        m_column = column.release();
+        m_type = type;
+        std::vector<variant>().swap(m_variants);
     }
 
 }} // namespace protean::detail
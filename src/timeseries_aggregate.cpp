@@ -0,0 +1,417 @@
+#include <protean/timeseries_aggregate.hpp>
+#include <protean/timeseries_view.hpp>
+#include <protean/detail/data_table_column.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <deque>
+
+namespace protean {
+
+    timeseries_aggregate::timeseries_aggregate(function_t function, const std::string& name /* = std::string() */) :
+        m_function(function),
+        m_name(name)
+    {
+    }
+
+    std::string timeseries_aggregate::result_name() const
+    {
+        if (!m_name.empty())
+        {
+            return m_name;
+        }
+
+        static const char* names[] = { "Open", "High", "Low", "Close", "Sum", "Count", "Mean" };
+        return names[m_function];
+    }
+
+    namespace {
+
+        /* The values of one aggregate, held as Int64, Double or UInt64 as its type asks */
+        /*********************************************************************************/
+        struct aggregate_result
+        {
+            // 'accumulator' is the type the values are aggregated as, see run_pass
+            aggregate_result(const timeseries_aggregate& aggregate, variant_base::enum_type_t accumulator) :
+                m_function(aggregate.m_function),
+                m_name(aggregate.result_name()),
+                m_type(aggregate.m_function==timeseries_aggregate::Count ? variant_base::UInt64 :
+                      (aggregate.m_function==timeseries_aggregate::Mean ? variant_base::Double : accumulator))
+            {
+            }
+
+            void reserve(size_t n)
+            {
+                switch (m_type)
+                {
+                    case variant_base::UInt64:  m_unsigneds.reserve(n); break;
+                    case variant_base::Int64:   m_integers.reserve(n);  break;
+                    default:                    m_numbers.reserve(n);   break;
+                }
+            }
+
+            void push_back(boost::int64_t value)    { m_integers.push_back(value); }
+            void push_back(boost::uint64_t value)   { m_unsigneds.push_back(value); }
+            void push_back(double value)            { m_numbers.push_back(value); }
+
+            // Moves the values into a new column
+            data_table_column_base* column()
+            {
+                switch (m_type)
+                {
+                    case variant_base::UInt64:  return make_column<variant_base::UInt64>(m_unsigneds);
+                    case variant_base::Int64:   return make_column<variant_base::Int64>(m_integers);
+                    default:                    return make_column<variant_base::Double>(m_numbers);
+                }
+            }
+
+            template <variant_base::enum_type_t E>
+            data_table_column_base* make_column(typename column_traits<E>::container_type& values)
+            {
+                detail::data_table_column<E>* result(new detail::data_table_column<E>(m_name));
+                result->template assign<E>(std::move(values));
+                return result;
+            }
+
+            timeseries_aggregate::function_t    m_function;
+            std::string                         m_name;
+            variant_base::enum_type_t           m_type;
+            std::vector<boost::int64_t>         m_integers;
+            std::vector<double>                 m_numbers;
+            std::vector<boost::uint64_t>        m_unsigneds;
+        };
+
+        // Sum, greatest and least of the values in [first, last), in loops simple enough
+        // for the compiler to vectorise
+        template <typename A, typename I>
+        A sum_of(I first, I last)
+        {
+            A result(0);
+            for (; first!=last; ++first)
+            {
+                result += static_cast<A>(*first);
+            }
+            return result;
+        }
+
+        template <typename A, typename I>
+        A max_of(I first, I last)
+        {
+            A result(static_cast<A>(*first));
+            for (++first; first!=last; ++first)
+            {
+                result = (std::max)(result, static_cast<A>(*first));
+            }
+            return result;
+        }
+
+        template <typename A, typename I>
+        A min_of(I first, I last)
+        {
+            A result(static_cast<A>(*first));
+            for (++first; first!=last; ++first)
+            {
+                result = (std::min)(result, static_cast<A>(*first));
+            }
+            return result;
+        }
+
+        // Start of the bar of 'interval' ticks that holds 'ticks', which is not special
+        inline boost::int64_t bar_of(boost::int64_t ticks, boost::int64_t interval)
+        {
+            const boost::int64_t remainder(ticks % interval);
+            return ticks - (remainder<0 ? remainder + interval : remainder);
+        }
+
+        /* One pass over points in bars, aggregating the contiguous values of each bar */
+        /********************************************************************************/
+        class resampler
+        {
+        public:
+            resampler(const boost::int64_t* ticks, size_t size, boost::int64_t interval, std::vector<boost::int64_t>& bars, std::vector<aggregate_result>& results) :
+                m_ticks(ticks),
+                m_size(size),
+                m_interval(interval),
+                m_bars(bars),
+                m_results(results)
+            {
+            }
+
+            template <typename A, typename I>
+            void run(I values) const
+            {
+                for (size_t first=0; first<m_size; )
+                {
+                    // differences of ticks that are not special cannot overflow, unlike the
+                    // end of a bar of a long interval
+                    const boost::int64_t bar(bar_of(m_ticks[first], m_interval));
+
+                    size_t last(first + 1);
+                    while (last<m_size && m_ticks[last] - bar<m_interval)
+                    {
+                        ++last;
+                    }
+
+                    m_bars.push_back(bar);
+                    for (std::vector<aggregate_result>::iterator result=m_results.begin(); result!=m_results.end(); ++result)
+                    {
+                        switch (result->m_function)
+                        {
+                            case timeseries_aggregate::Open:    result->push_back(static_cast<A>(values[first]));                   break;
+                            case timeseries_aggregate::High:    result->push_back(max_of<A>(values + first, values + last));         break;
+                            case timeseries_aggregate::Low:     result->push_back(min_of<A>(values + first, values + last));         break;
+                            case timeseries_aggregate::Close:   result->push_back(static_cast<A>(values[last - 1]));                break;
+                            case timeseries_aggregate::Sum:     result->push_back(sum_of<A>(values + first, values + last));         break;
+                            case timeseries_aggregate::Count:   result->push_back(static_cast<boost::uint64_t>(last - first));      break;
+                            case timeseries_aggregate::Mean:
+                                result->push_back(static_cast<double>(sum_of<A>(values + first, values + last)) / static_cast<double>(last - first));
+                                break;
+                        }
+                    }
+                    first = last;
+                }
+            }
+
+        private:
+            const boost::int64_t*           m_ticks;
+            size_t                          m_size;
+            boost::int64_t                  m_interval;
+            std::vector<boost::int64_t>&    m_bars;
+            std::vector<aggregate_result>&  m_results;
+        };
+
+        /* One pass over points with a window trailing each, adding the values that   */
+        /* enter it and removing those that leave.  The greatest and least values are */
+        /* kept at the front of queues of the points that may yet become them.        */
+        /******************************************************************************/
+        class roller
+        {
+        public:
+            roller(const boost::int64_t* ticks, size_t size, boost::int64_t window, std::vector<aggregate_result>& results) :
+                m_ticks(ticks),
+                m_size(size),
+                m_window(window),
+                m_results(results)
+            {
+            }
+
+            template <typename A, typename I>
+            void run(I values) const
+            {
+                bool high(false), low(false);
+                for (std::vector<aggregate_result>::iterator result=m_results.begin(); result!=m_results.end(); ++result)
+                {
+                    result->reserve(m_size);
+                    high = high || result->m_function==timeseries_aggregate::High;
+                    low = low || result->m_function==timeseries_aggregate::Low;
+                }
+
+                std::deque<size_t> highs, lows;
+                A sum(0);
+                size_t first(0);
+
+                for (size_t i=0; i<m_size; ++i)
+                {
+                    const A value(static_cast<A>(values[i]));
+
+                    sum += value;
+                    if (high)
+                    {
+                        while (!highs.empty() && static_cast<A>(values[highs.back()])<=value)
+                        {
+                            highs.pop_back();
+                        }
+                        highs.push_back(i);
+                    }
+                    if (low)
+                    {
+                        while (!lows.empty() && static_cast<A>(values[lows.back()])>=value)
+                        {
+                            lows.pop_back();
+                        }
+                        lows.push_back(i);
+                    }
+
+                    while (m_ticks[i] - m_ticks[first]>=m_window)
+                    {
+                        sum -= static_cast<A>(values[first]);
+                        ++first;
+                    }
+                    while (high && highs.front()<first)
+                    {
+                        highs.pop_front();
+                    }
+                    while (low && lows.front()<first)
+                    {
+                        lows.pop_front();
+                    }
+
+                    for (std::vector<aggregate_result>::iterator result=m_results.begin(); result!=m_results.end(); ++result)
+                    {
+                        switch (result->m_function)
+                        {
+                            case timeseries_aggregate::Open:    result->push_back(static_cast<A>(values[first]));          break;
+                            case timeseries_aggregate::High:    result->push_back(static_cast<A>(values[highs.front()]));  break;
+                            case timeseries_aggregate::Low:     result->push_back(static_cast<A>(values[lows.front()]));   break;
+                            case timeseries_aggregate::Close:   result->push_back(value);                                  break;
+                            case timeseries_aggregate::Sum:     result->push_back(sum);                                    break;
+                            case timeseries_aggregate::Count:   result->push_back(static_cast<boost::uint64_t>(i + 1 - first)); break;
+                            case timeseries_aggregate::Mean:
+                                result->push_back(static_cast<double>(sum) / static_cast<double>(i + 1 - first));
+                                break;
+                        }
+                    }
+                }
+            }
+
+        private:
+            const boost::int64_t*           m_ticks;
+            size_t                          m_size;
+            boost::int64_t                  m_window;
+            std::vector<aggregate_result>&  m_results;
+        };
+
+        bool is_integer(variant_base::enum_type_t type)
+        {
+            return (type & variant_base::Integer)!=0 && type!=variant_base::Variant;
+        }
+
+        // Type the values of 'view' are accumulated as: UInt64 for UInt64, Int64 for other
+        // integers and Double for other numbers, or values held as variants
+        variant_base::enum_type_t accumulator(const timeseries_view& view)
+        {
+            const variant_base::enum_type_t type(view.value_type());
+            if (type==variant_base::UInt64)
+            {
+                return variant_base::UInt64;
+            }
+            return is_integer(type) ? variant_base::Int64 : variant_base::Double;
+        }
+
+        // Runs 'pass' over the values of 'view', as the type of accumulator(view).  Values
+        // held as variants are converted to Double first.
+        template <typename P>
+        void run_pass(const timeseries_view& view, const P& pass)
+        {
+            switch (view.value_type())
+            {
+                case variant_base::Boolean: pass.template run<boost::int64_t>(view.values<variant_base::Boolean>().begin());  break;
+                case variant_base::Int32:   pass.template run<boost::int64_t>(view.values<variant_base::Int32>().begin());    break;
+                case variant_base::UInt32:  pass.template run<boost::int64_t>(view.values<variant_base::UInt32>().begin());   break;
+                case variant_base::Int64:   pass.template run<boost::int64_t>(view.values<variant_base::Int64>().begin());    break;
+                case variant_base::UInt64:  pass.template run<boost::uint64_t>(view.values<variant_base::UInt64>().begin());  break;
+                case variant_base::Float:   pass.template run<double>(view.values<variant_base::Float>().begin());            break;
+                case variant_base::Double:  pass.template run<double>(view.values<variant_base::Double>().begin());           break;
+                default:
+                {
+                    std::vector<double> values(view.size());
+                    for (size_t i=0; i<view.size(); ++i)
+                    {
+                        values[i] = view.value(i).numerical_cast<double>();
+                    }
+                    pass.template run<double>(values.begin());
+                    break;
+                }
+            }
+        }
+
+        std::vector<aggregate_result> make_results(const timeseries_view& view, const std::vector<timeseries_aggregate>& aggregates)
+        {
+            std::vector<aggregate_result> results;
+            for (std::vector<timeseries_aggregate>::const_iterator citr = aggregates.begin(); citr != aggregates.end(); ++citr)
+            {
+                results.push_back(aggregate_result(*citr, accumulator(view)));
+            }
+            return results;
+        }
+
+        // Checks that 'ticks' are in order and none is special, which only the first and
+        // last can be if they are, so that bars and windows can be found by arithmetic on
+        // them without overflow
+        void check_times(bool ordered, const boost::iterator_range<const boost::int64_t*>& ticks, const char* what)
+        {
+            if (!ordered)
+            {
+                boost::throw_exception(variant_error(std::string("Attempt to ") + what + " a TimeSeries whose times are out of order"));
+            }
+            if (!ticks.empty() && (detail::timeseries::from_ticks(ticks.front()).is_special() || detail::timeseries::from_ticks(ticks.back()).is_special()))
+            {
+                boost::throw_exception(variant_error(std::string("Attempt to ") + what + " a TimeSeries holding a special time"));
+            }
+        }
+
+        boost::int64_t positive_ticks(const boost::posix_time::time_duration& duration, const char* what)
+        {
+            if (duration.is_special() || duration.ticks()<=0)
+            {
+                boost::throw_exception(variant_error(std::string("TimeSeries ") + what + " must be a positive duration"));
+            }
+            return duration.ticks();
+        }
+
+        // A DataTable of a "Time" column holding 'ticks' and a column per result
+        variant make_table(const std::vector<boost::int64_t>& ticks, std::vector<aggregate_result>& results)
+        {
+            std::vector<boost::posix_time::ptime> times(ticks.size());
+            for (size_t i=0; i<ticks.size(); ++i)
+            {
+                times[i] = detail::timeseries::from_ticks(ticks[i]);
+            }
+
+            variant result(variant::DataTable);
+            detail::data_table_column<variant_base::DateTime>* time_column(new detail::data_table_column<variant_base::DateTime>("Time"));
+            result.columns().push_back(time_column);
+            time_column->assign<variant_base::DateTime>(std::move(times));
+
+            for (std::vector<aggregate_result>::iterator citr = results.begin(); citr != results.end(); ++citr)
+            {
+                result.columns().push_back(citr->column());
+            }
+            return result;
+        }
+
+    } // namespace
+
+    variant timeseries_view::resample(const boost::posix_time::time_duration& interval, const std::vector<timeseries_aggregate>& aggregates) const
+    {
+        check_times(m_series->ordered(), times(), "resample");
+
+        std::vector<boost::int64_t> bars;
+        std::vector<aggregate_result> results(make_results(*this, aggregates));
+        run_pass(*this, resampler(times().begin(), m_length, positive_ticks(interval, "resample interval"), bars, results));
+        return make_table(bars, results);
+    }
+
+    variant timeseries_view::resample(const boost::posix_time::time_duration& interval, const timeseries_aggregate& aggregate) const
+    {
+        check_times(m_series->ordered(), times(), "resample");
+
+        std::vector<boost::int64_t> bars;
+        std::vector<aggregate_result> results(make_results(*this, std::vector<timeseries_aggregate>(1, aggregate)));
+        run_pass(*this, resampler(times().begin(), m_length, positive_ticks(interval, "resample interval"), bars, results));
+        return make_series(std::move(bars), std::unique_ptr<data_table_column_base>(results.front().column()));
+    }
+
+    variant timeseries_view::rolling(const boost::posix_time::time_duration& window, const std::vector<timeseries_aggregate>& aggregates) const
+    {
+        check_times(m_series->ordered(), times(), "roll a window over");
+
+        std::vector<aggregate_result> results(make_results(*this, aggregates));
+        run_pass(*this, roller(times().begin(), m_length, positive_ticks(window, "rolling window"), results));
+        return make_table(std::vector<boost::int64_t>(times().begin(), times().end()), results);
+    }
+
+    variant timeseries_view::rolling(const boost::posix_time::time_duration& window, const timeseries_aggregate& aggregate) const
+    {
+        check_times(m_series->ordered(), times(), "roll a window over");
+
+        std::vector<aggregate_result> results(make_results(*this, std::vector<timeseries_aggregate>(1, aggregate)));
+        run_pass(*this, roller(times().begin(), m_length, positive_ticks(window, "rolling window"), results));
+
+        std::vector<boost::int64_t> ticks(times().begin(), times().end());
+        return make_series(std::move(ticks), std::unique_ptr<data_table_column_base>(results.front().column()));
+    }
+
+} // namespace protean
@@ -0,0 +1,99 @@
+#include <protean/timeseries_view.hpp>
+#include <protean/variant_error.hpp>
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+
+namespace protean {
+
+    timeseries_view::timeseries_view(const detail::timeseries& series) :
+        m_series(&series),
+        m_offset(0),
+        m_length(series.size())
+    {
+    }
+
+    timeseries_view::timeseries_view(const detail::timeseries* series, size_t offset, size_t length) :
+        m_series(series),
+        m_offset(offset),
+        m_length(length)
+    {
+    }
+
+    timeseries_view::date_time_t timeseries_view::time(size_t n) const
+    {
+        if (n >= m_length)
+            boost::throw_exception(variant_error("Point out of range"));
+
+        return detail::timeseries::from_ticks(m_series->times()[m_offset + n]);
+    }
+
+    variant timeseries_view::value(size_t n) const
+    {
+        if (n >= m_length)
+            boost::throw_exception(variant_error("Point out of range"));
+
+        variant copy;
+        return m_series->value(m_offset + n, copy);
+    }
+
+    timeseries_view timeseries_view::slice(size_t offset, size_t length) const
+    {
+        const size_t first((std::min)(offset, m_length));
+        return timeseries_view(m_series, m_offset + first, (std::min)(length, m_length - first));
+    }
+
+    timeseries_view timeseries_view::lower_bound(const date_time_t& time) const
+    {
+        return slice(lower_index(time), m_length);
+    }
+
+    timeseries_view timeseries_view::at_or_before(const date_time_t& time) const
+    {
+        const size_t n(upper_index(time));
+        return n==0 ? slice(0, 0) : slice(n - 1, 1);
+    }
+
+    timeseries_view timeseries_view::range(const date_time_t& first, const date_time_t& last) const
+    {
+        const size_t lower(lower_index(first));
+        return slice(lower, (std::max)(lower_index(last), lower) - lower);
+    }
+
+    variant timeseries_view::series() const
+    {
+        variant result(variant::TimeSeries);
+        for (size_t i=0; i<m_length; ++i)
+        {
+            result.push_back(time(i), value(i));
+        }
+        return result;
+    }
+
+    variant timeseries_view::make_series(std::vector<boost::int64_t>&& times, std::unique_ptr<data_table_column_base> values)
+    {
+        variant result(variant::TimeSeries);
+        result.m_value.get<variant::TimeSeries>().assign(times, values.release());
+        return result;
+    }
+
+    size_t timeseries_view::lower_index(const date_time_t& time) const
+    {
+        if (!m_series->ordered())
+            boost::throw_exception(variant_error("Attempt to look up a time in a TimeSeries whose times are out of order"));
+
+        const boost::iterator_range<const boost::int64_t*> ticks(times());
+        return std::lower_bound(ticks.begin(), ticks.end(), detail::timeseries::to_ticks(time)) - ticks.begin();
+    }
+
+    size_t timeseries_view::upper_index(const date_time_t& time) const
+    {
+        if (!m_series->ordered())
+            boost::throw_exception(variant_error("Attempt to look up a time in a TimeSeries whose times are out of order"));
+
+        const boost::iterator_range<const boost::int64_t*> ticks(times());
+        return std::upper_bound(ticks.begin(), ticks.end(), detail::timeseries::to_ticks(time)) - ticks.begin();
+    }
+
+} // namespace protean
@@ -8,13 +8,8 @@
 namespace protean { namespace detail {
 
     tuple::tuple(size_t size) :
-        m_size(static_cast<boost::uint16_t>(size))
+        m_size(size)
     {
-        if (size>0xFFFF)
-        {
-            boost::throw_exception(variant_error((boost::format("Size %u exceeds tuple capacity") % size).str()));
-        }
-
         m_value = new variant[size];
     }
 
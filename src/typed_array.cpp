@@ -3,13 +3,12 @@
 #include <protean/detail/hash.hpp>
 
 #include <boost/bind.hpp>
-#include <boost/cast.hpp>
 #include <boost/function.hpp>
 
 namespace protean {
 
     typed_array::typed_array(size_t size, variant_base::enum_type_t type) :
-        m_size(boost::numeric_cast<boost::uint32_t>(size)),
+        m_size(size),
         m_type(type)
     {
         m_data = new variant_base[m_size];
@@ -20,7 +19,7 @@ namespace protean {
     }
 
     typed_array::typed_array(size_t size, const variant& init) :
-        m_size(boost::numeric_cast<boost::uint32_t>(size)),
+        m_size(size),
         m_type(init.type())
     {
         m_data = new variant_base[m_size];
@@ -9,6 +9,13 @@
 #include <protean/detail/dummy_iterator.hpp>
 #include <protean/detail/hash.hpp>
 #include <protean/detail/data_table.hpp>
+#include <protean/data_table_expression.hpp>
+#include <protean/data_table_selection.hpp>
+#include <protean/data_table_view.hpp>
+#include <protean/timeseries_view.hpp>
+#include <protean/timeseries_aggregate.hpp>
+#include <protean/data_table_aggregate.hpp>
+#include <protean/data_table_sort.hpp>
 #include <protean/variant_ref.hpp>
 
 #include <protean/detail/variant_macros_define.hpp>
@@ -346,9 +353,113 @@ namespace protean {
 
         CHECK_VARIANT_FUNCTION(TimeSeries, "pop_back()");
 
-        variant& result = m_value.get<TimeSeries>().push_back(time, value);
+        if (ret==ReturnSelf)
+        {
+            m_value.get<TimeSeries>().append(time, value);
+            return *this;
+        }
+        return m_value.get<TimeSeries>().push_back(time, value);
 
-        return (ret==ReturnSelf ? *this : result);
+        END_TRANSLATE_ERROR();
+    }
+
+
+    variant& variant::enforce_order(bool enforce /* = true */)
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "enforce_order()");
+
+        m_value.get<TimeSeries>().enforce_order(enforce);
+        return *this;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    timeseries_view variant::series_view() const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "series_view()");
+
+        return timeseries_view(m_value.get<TimeSeries>());
+
+        END_TRANSLATE_ERROR();
+    }
+
+    timeseries_view variant::lower_bound(const date_time_t& time) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "lower_bound()");
+
+        return timeseries_view(m_value.get<TimeSeries>()).lower_bound(time);
+
+        END_TRANSLATE_ERROR();
+    }
+
+    timeseries_view variant::at_or_before(const date_time_t& time) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "at_or_before()");
+
+        return timeseries_view(m_value.get<TimeSeries>()).at_or_before(time);
+
+        END_TRANSLATE_ERROR();
+    }
+
+    timeseries_view variant::range(const date_time_t& first, const date_time_t& last) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "range()");
+
+        return timeseries_view(m_value.get<TimeSeries>()).range(first, last);
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant variant::resample(const time_t& interval, const std::vector<timeseries_aggregate>& aggregates) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "resample()");
+
+        return timeseries_view(m_value.get<TimeSeries>()).resample(interval, aggregates);
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant variant::resample(const time_t& interval, const timeseries_aggregate& aggregate) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "resample()");
+
+        return timeseries_view(m_value.get<TimeSeries>()).resample(interval, aggregate);
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant variant::rolling(const time_t& window, const std::vector<timeseries_aggregate>& aggregates) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "rolling()");
+
+        return timeseries_view(m_value.get<TimeSeries>()).rolling(window, aggregates);
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant variant::rolling(const time_t& window, const timeseries_aggregate& aggregate) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(TimeSeries, "rolling()");
+
+        return timeseries_view(m_value.get<TimeSeries>()).rolling(window, aggregate);
 
         END_TRANSLATE_ERROR();
     }
@@ -379,6 +490,185 @@ namespace protean {
         END_TRANSLATE_ERROR();
     }
 
+    variant& variant::add_column(enum_type_t type, const std::string& name, data_table_column_base::encoding_t encoding)
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "add_column()");
+
+        m_value.get<DataTable>().add_column(type, name, encoding);
+
+        return *this;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant& variant::add_column(const std::string& name, const data_table_expression& expression)
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "add_column()");
+
+        m_value.get<DataTable>().add_column(name, expression);
+
+        return *this;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    data_table_selection variant::where(const data_table_expression& expression) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "where()");
+
+        const column_collection_t& columns(m_value.get<DataTable>().columns());
+        return data_table_selection(columns, expression.select(columns));
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant variant::filter(const data_table_expression& expression) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        return where(expression).table();
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant variant::group_by(const std::vector<std::string>& keys, const std::vector<data_table_aggregate>& aggregates, size_t threads /* = 0 */) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "group_by()");
+
+        variant result(DataTable);
+        m_value.get<DataTable>().group_by(keys, aggregates, result.m_value.get<DataTable>(), threads);
+        return result;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant variant::join(const variant& right, const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys, data_table_join_t type /* = InnerJoin */, size_t threads /* = 0 */) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "join()");
+
+        if (!right.is<DataTable>())
+        {
+            boost::throw_exception(variant_error("Attempt to join DataTable with " + enum_to_string(right.type())));
+        }
+
+        variant result(DataTable);
+        m_value.get<DataTable>().join(right.m_value.get<DataTable>(), left_keys, right_keys, type, result.m_value.get<DataTable>(), threads);
+        return result;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant& variant::sort(const std::vector<data_table_sort_key>& keys, size_t threads /* = 0 */)
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "sort()");
+
+        m_value.get<DataTable>().sort(keys, threads);
+        return *this;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    data_table_selection variant::sorted_view(const std::vector<data_table_sort_key>& keys, size_t threads /* = 0 */) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "sorted_view()");
+
+        const detail::data_table& table(m_value.get<DataTable>());
+
+        std::vector<size_t> permutation;
+        table.sort_permutation(keys, permutation, threads);
+        return data_table_selection(table.columns(), std::move(permutation));
+
+        END_TRANSLATE_ERROR();
+    }
+
+    data_table_view variant::view() const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "view()");
+
+        return data_table_view(m_value.get<DataTable>().columns());
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant& variant::add_index(const std::string& column, data_table_index_t type /* = HashIndex */)
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "add_index()");
+
+        m_value.get<DataTable>().add_index(column, type);
+        return *this;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant& variant::drop_index(const std::string& column)
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "drop_index()");
+
+        m_value.get<DataTable>().drop_index(column);
+        return *this;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    std::vector<size_t> variant::find(const std::string& column, const variant& value) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "find()");
+
+        std::vector<size_t> rows;
+        m_value.get<DataTable>().find(column, value, rows);
+        return rows;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    std::vector<size_t> variant::equal_range(const std::string& column, const variant& lower, const variant& upper) const
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "equal_range()");
+
+        std::vector<size_t> rows;
+        m_value.get<DataTable>().equal_range(column, lower, upper, rows);
+        return rows;
+
+        END_TRANSLATE_ERROR();
+    }
+
+    variant& variant::reserve(size_t rows)
+    {
+        BEGIN_TRANSLATE_ERROR();
+
+        CHECK_VARIANT_FUNCTION(DataTable, "reserve()");
+
+        m_value.get<DataTable>().reserve(rows);
+
+        return *this;
+
+        END_TRANSLATE_ERROR();
+    }
+
 	const variant::column_collection_t& variant::columns() const
 	{
 		BEGIN_TRANSLATE_ERROR();
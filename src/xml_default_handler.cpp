@@ -189,10 +189,25 @@ namespace protean { namespace detail {
                         if (!context->attributes().has_key("type"))
                             boost::throw_exception(variant_error("Missing 'type' attribute for DataTable column declaration"));
 
+                        data_table_column_base::encoding_t encoding(data_table_column_base::PlainEncoding);
+                        if (context->attributes().has_key("encoding"))
+                        {
+                            const std::string& name(context->attributes()["encoding"].as<std::string>());
+                            if (name == "Dictionary")
+                                encoding = data_table_column_base::DictionaryEncoding;
+                            else if (name == "Arena")
+                                encoding = data_table_column_base::ArenaEncoding;
+                            else if (name != "Plain")
+                                boost::throw_exception(variant_error("Unrecognised 'encoding' attribute '" + name + "' for DataTable column declaration"));
+
+                            context->attributes().remove("encoding");
+                        }
+
                         context->m_element = &parent_context->element();
                         context->element().add_column(
                             variant::string_to_enum(context->attributes()["type"].as<std::string>()),
-                            context->attributes()["name"].as<std::string>()
+                            context->attributes()["name"].as<std::string>(),
+                            encoding
                         );
 
                         context->m_in_columns = true;
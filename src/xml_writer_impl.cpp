@@ -487,9 +487,13 @@ namespace protean { namespace detail {
                            ; column_iter != dt.columns().end()
                            ; ++column_iter)
                     {
-                        push("Column")
+                        variant& attributes(push("Column")
                             .insert("name", variant(column_iter->name()))
-                            .insert("type", variant(variant::enum_to_string(column_iter->type())));
+                            .insert("type", variant(variant::enum_to_string(column_iter->type()))));
+                        if (column_iter->encoding() == data_table_column_base::DictionaryEncoding)
+                            attributes.insert("encoding", variant("Dictionary"));
+                        else if (column_iter->encoding() == data_table_column_base::ArenaEncoding)
+                            attributes.insert("encoding", variant("Arena"));
                         m_os << indent();
                         write_empty_element();
                         pop();
@@ -10,7 +10,18 @@ using boost::unit_test::test_suite;
 #include <boost/date_time.hpp>
 #include <protean/binary_writer.hpp>
 #include <protean/binary_reader.hpp>
+#include <protean/binary_lazy_variant.hpp>
+#include <protean/data_table_expression.hpp>
+#include <protean/data_table_selection.hpp>
+#include <protean/data_table_aggregate.hpp>
+#include <protean/data_table_sort.hpp>
+#include <protean/data_table_view.hpp>
+#include <protean/data_table_chunks.hpp>
+#include <protean/data_table_file.hpp>
+#include <protean/arrow.hpp>
 #include <iostream>
+#include <map>
+#include <thread>
 #include <boost/chrono/chrono.hpp>
 #include <boost/chrono/chrono_io.hpp>
 
@@ -496,4 +507,2100 @@ BOOST_AUTO_TEST_CASE(test_data_table_binary_serialization_performance)
     */ // End of commented-out performance test (uncomment to run)
 }
 
+BOOST_AUTO_TEST_CASE(test_data_table_binary_parallel_columns)
+{
+    const boost::posix_time::ptime initial_time = boost::posix_time::time_from_string("2002-01-20 09:00:00.000");
+
+    // above and below binary_parallel_columns_min_rows
+    const size_t sizes[] = { 10, 10000 };
+
+    const int modes[] = {
+        binary_mode::ParallelColumns,
+        binary_mode::ParallelColumns | binary_mode::Compact,
+        binary_mode::ParallelColumns | binary_mode::Compress,
+        binary_mode::ParallelColumns | binary_mode::SubtreeLengths,
+        binary_mode::ParallelColumns | binary_mode::StringTable | binary_mode::StringTableValues
+    };
+
+    for (size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); ++i)
+    {
+        variant dt(variant::DataTable);
+        dt.add_column(variant::DateTime, "Time")
+          .add_column(variant::Double,   "Price")
+          .add_column(variant::String,   "Data")
+          .add_column(variant::Int32,    "Volume")
+          .add_column(variant::Boolean,  "Flag")
+          .add_column(variant::Dictionary, "Extra");
+
+        for (size_t j=0; j<sizes[i]; ++j)
+        {
+            variant extra(variant::Dictionary);
+            extra.insert("key", j % 2 == 0 ? variant(static_cast<int>(j)) : variant("extra"));
+            dt.push_back(make_row(
+                initial_time + boost::posix_time::hours(static_cast<int>(j)),
+                100.4 + j,
+                detail::string(j % 3 == 0 ? "short" : "a longer string value"),
+                static_cast<int>(j),
+                j % 2 == 0,
+                extra
+            ));
+        }
+
+        variant v1(variant::Dictionary);
+        v1.insert("table", dt)
+          .insert("trailer", variant("after the table"));
+
+        for (size_t k=0; k<sizeof(modes)/sizeof(modes[0]); ++k)
+        {
+            std::ostringstream oss;
+            binary_writer writer(oss, modes[k]);
+            writer << v1;
+
+            variant v2;
+            std::istringstream iss1(oss.str());
+            binary_reader reader1(iss1);
+            reader1 >> v2;
+
+            BOOST_CHECK(v2.compare(v1)==0);
+
+            // skipping the table without decoding it
+            variant v3;
+            std::istringstream iss2(oss.str());
+            binary_reader reader2(iss2);
+            reader2.set_projection(std::vector<std::string>(1, "trailer"));
+            reader2 >> v3;
+
+            BOOST_CHECK(v3["trailer"].compare(v1["trailer"])==0);
+            BOOST_CHECK(!v3.has_key("table"));
+
+            if ((modes[k] & binary_mode::StringTable)==0)
+            {
+                std::istringstream iss3(oss.str());
+                binary_lazy_variant lazy(iss3);
+
+                BOOST_CHECK(lazy["trailer"].value().compare(v1["trailer"])==0);
+                BOOST_CHECK_EQUAL(lazy["table"].size(), sizes[i]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_binary_parallel_columns_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    #define NUM_COLUMNS 50
+
+    static const int rows = 1000000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    variant dt(variant::DataTable, rows);
+    for (int i = 0; i < NUM_COLUMNS; ++i)
+        dt.add_column(variant::Int32);
+
+    const data_table_row<
+        BOOST_PP_ENUM(NUM_COLUMNS, IDENTITY, variant::Int32)
+    >::type row =
+        make_row(BOOST_PP_ENUM_PARAMS(NUM_COLUMNS, ));
+
+    for (int i = 0; i < rows; ++i)
+        dt.push_back(row);
+
+    const int modes[] = { binary_mode::Default, binary_mode::ParallelColumns, binary_mode::Compact, binary_mode::Compact | binary_mode::ParallelColumns };
+    for (size_t i = 0; i < sizeof(modes)/sizeof(modes[0]); ++i)
+    {
+        const std::string name((boost::format("DataTable mode %d") % modes[i]).str());
+
+        std::ostringstream oss;
+        binary_writer bw(oss, modes[i]);
+
+        start = boost::chrono::high_resolution_clock::now();
+        bw << dt;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Serialization", start, finish);
+
+        std::istringstream iss(oss.str());
+        binary_reader br(iss);
+        variant deserialized_dt;
+
+        start = boost::chrono::high_resolution_clock::now();
+        br >> deserialized_dt;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Deserialization", start, finish);
+    }
+
+    #undef NUM_COLUMNS
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_bulk_construction)
+{
+    const boost::posix_time::ptime initial_time = boost::posix_time::time_from_string("2002-01-20 09:00:00.000");
+
+    // row by row
+    variant dt1(variant::DataTable);
+    dt1.add_column(variant::DateTime, "Time")
+       .add_column(variant::Double,   "Price")
+       .add_column(variant::String,   "Data")
+       .add_column(variant::Boolean,  "Flag");
+
+    typedef data_table_row<variant::DateTime, variant::Double, variant::String, variant::Boolean>::type row_type;
+    std::vector<row_type> rows;
+    for (int i = 0; i < 100; ++i)
+    {
+        const row_type row(make_row(initial_time + boost::posix_time::hours(i), 100.4 + i, detail::string(i % 2 == 0 ? "even" : "an odd row"), i % 3 == 0));
+        dt1.push_back(row);
+        rows.push_back(row);
+    }
+
+    // as a batch of rows
+    variant dt2(variant::DataTable);
+    dt2.add_column(variant::DateTime, "Time")
+       .add_column(variant::Double,   "Price")
+       .add_column(variant::String,   "Data")
+       .add_column(variant::Boolean,  "Flag");
+    dt2.reserve(rows.size())
+       .append(rows.begin(), rows.begin() + 40)
+       .append(rows.begin() + 40, rows.end());
+
+    BOOST_CHECK_EQUAL(dt2.size(), 100u);
+    BOOST_CHECK(dt2.compare(dt1) == 0);
+
+    // a column at a time
+    std::vector<boost::posix_time::ptime> times;
+    std::vector<double> prices;
+    std::vector<detail::string> data;
+    std::vector<bool> flags;
+    for (int i = 0; i < 100; ++i)
+    {
+        times.push_back(initial_time + boost::posix_time::hours(i));
+        prices.push_back(100.4 + i);
+        data.push_back(detail::string(i % 2 == 0 ? "even" : "an odd row"));
+        flags.push_back(i % 3 == 0);
+    }
+
+    variant dt3(variant::DataTable);
+    dt3.add_column(variant::DateTime, "Time")
+       .add_column(variant::Double,   "Price")
+       .add_column(variant::String,   "Data")
+       .add_column(variant::Boolean,  "Flag");
+
+    dt3.columns()[0].append<variant::DateTime>(&times[0], 60);
+    dt3.columns()[0].append<variant::DateTime>(&times[60], 40);
+    dt3.columns()[1].append<variant::Double>(&prices[0], prices.size());
+    dt3.columns()[2].assign<variant::String>(std::move(data));
+    dt3.columns()[3].assign<variant::Boolean>(std::move(flags));
+
+    BOOST_CHECK(data.empty());
+    BOOST_CHECK(dt3.compare(dt1) == 0);
+
+    BOOST_CHECK_THROW(dt3.columns()[1].append<variant::Int32>(nullptr, 0), variant_error);
+    BOOST_CHECK_THROW(dt3.columns()[0].assign<variant::Double>(std::vector<double>()), variant_error);
+
+    // a failed batch leaves the table as it was
+    variant dt4(variant::DataTable);
+    dt4.add_column(variant::Int32, "Id")
+       .add_column(variant::Dictionary, "Extra");
+
+    std::vector<data_table_row<variant::Int32, variant::Variant>::type> bad_rows;
+    bad_rows.push_back(make_row(1, variant(variant::Dictionary)));
+    bad_rows.push_back(make_row(2, variant(42)));
+
+    BOOST_CHECK_THROW(dt4.append(bad_rows.begin(), bad_rows.end()), variant_error);
+    BOOST_CHECK_EQUAL(dt4.size(), 0u);
+    BOOST_CHECK(dt4.columns()[0].empty() && dt4.columns()[1].empty());
+
+    // many small batches reallocate the columns a logarithmic number of times
+    variant dt5(variant::DataTable);
+    dt5.add_column(variant::DateTime, "Time")
+       .add_column(variant::Double,   "Price")
+       .add_column(variant::String,   "Data")
+       .add_column(variant::Boolean,  "Flag");
+
+    size_t reallocations = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const size_t capacity = dt5.columns()[1].capacity();
+        dt5.append(rows.begin() + i % 97, rows.begin() + i % 97 + 3);
+        if (dt5.columns()[1].capacity() != capacity)
+            ++reallocations;
+    }
+
+    BOOST_CHECK_EQUAL(dt5.size(), 3000u);
+    BOOST_CHECK(reallocations <= 16);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_bulk_construction_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    #define NUM_COLUMNS 20
+
+    static const size_t rows = 10000000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    {
+        variant dt(variant::DataTable);
+        for (int i = 0; i < NUM_COLUMNS; ++i)
+            dt.add_column(variant::Double);
+
+        const data_table_row<
+            BOOST_PP_ENUM(NUM_COLUMNS, IDENTITY, variant::Double)
+        >::type row =
+            make_row(BOOST_PP_ENUM(NUM_COLUMNS, IDENTITY, 1.0));
+
+        start = boost::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < rows; ++i)
+            dt.push_back(row);
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, "DataTable", "push_back", start, finish);
+    }
+
+    {
+        variant dt(variant::DataTable);
+        for (int i = 0; i < NUM_COLUMNS; ++i)
+            dt.add_column(variant::Double);
+
+        const std::vector<double> values(rows, 1.0);
+
+        start = boost::chrono::high_resolution_clock::now();
+        dt.reserve(rows);
+        for (int i = 0; i < NUM_COLUMNS; ++i)
+            dt.columns()[i].append<variant::Double>(&values[0], values.size());
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, "DataTable", "Column append", start, finish);
+    }
+
+    {
+        variant dt(variant::DataTable);
+        for (int i = 0; i < NUM_COLUMNS; ++i)
+            dt.add_column(variant::Double);
+
+        std::vector<std::vector<double> > columns(NUM_COLUMNS, std::vector<double>(rows, 1.0));
+
+        start = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < NUM_COLUMNS; ++i)
+            dt.columns()[i].assign<variant::Double>(std::move(columns[i]));
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, "DataTable", "Column assign", start, finish);
+    }
+
+    #undef NUM_COLUMNS
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_dictionary_encoding)
+{
+    static const char* const tickers[] = { "VOD.L", "BARC.L", "ROYAL DUTCH SHELL", "HSBC HOLDINGS", "GLENCORE" };
+
+    variant dt1(variant::DataTable);
+    dt1.add_column(variant::Int32,  "Id")
+       .add_column(variant::String, "Ticker")
+       .add_column(variant::Any,    "Venue");
+
+    variant dt2(variant::DataTable);
+    dt2.add_column(variant::Int32,  "Id")
+       .add_column(variant::String, "Ticker", data_table_column_base::DictionaryEncoding)
+       .add_column(variant::Any,    "Venue", data_table_column_base::DictionaryEncoding);
+
+    BOOST_CHECK(dt1.columns()[1].encoding() == data_table_column_base::PlainEncoding);
+    BOOST_CHECK(dt2.columns()[1].encoding() == data_table_column_base::DictionaryEncoding);
+    BOOST_CHECK(dt2.columns()[0].dictionary() == nullptr);
+    BOOST_CHECK_THROW(dt2.add_column(variant::Double, "Price", data_table_column_base::DictionaryEncoding), variant_error);
+    BOOST_CHECK_EQUAL(dt2.columns().size(), 3u);
+
+    typedef data_table_row<variant::Int32, variant::String, variant::Any>::type row_type;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const row_type row(make_row(i, detail::string(tickers[i % 5]), detail::string(i % 2 == 0 ? "LONDON STOCK EXCHANGE" : "CHI-X")));
+        dt1.push_back(row);
+        dt2.push_back(row);
+    }
+
+    // one copy of each distinct value too long to be held inline, which the rows refer to
+    BOOST_CHECK_EQUAL(dt2.columns()[1].dictionary()->size(), 3u);
+    BOOST_CHECK_EQUAL(dt2.columns()[2].dictionary()->size(), 1u);
+
+    const data_table_column_base& column(dt2.columns()[1]);
+    BOOST_CHECK(column.begin<variant::String>()[2].value() == column.begin<variant::String>()[7].value());
+    BOOST_CHECK_EQUAL(std::string(column.begin<variant::String>()[7].value()), "ROYAL DUTCH SHELL");
+    BOOST_CHECK(dt2.compare(dt1) == 0);
+
+    // copies refer to a dictionary of their own
+    variant dt3(dt2);
+    BOOST_CHECK(dt3.columns()[1].encoding() == data_table_column_base::DictionaryEncoding);
+    BOOST_CHECK(dt3.columns()[1].dictionary() != dt2.columns()[1].dictionary());
+    BOOST_CHECK(dt3.columns()[1].begin<variant::String>()[2].value() != column.begin<variant::String>()[2].value());
+    BOOST_CHECK(dt3.compare(dt1) == 0);
+
+    // re-encoding keeps the values
+    dt3.columns()[1].set_encoding(data_table_column_base::PlainEncoding);
+    dt3.columns()[2].set_encoding(data_table_column_base::PlainEncoding);
+    BOOST_CHECK(dt3.columns()[1].dictionary() == nullptr);
+    BOOST_CHECK(dt3.compare(dt1) == 0);
+    BOOST_CHECK(dt3.compare(dt2) == 0);
+
+    variant v1(variant::Dictionary);
+    v1.insert("table", dt2)
+      .insert("trailer", variant("after the table"));
+
+    const int modes[] = {
+        binary_mode::Default,
+        binary_mode::Compact,
+        binary_mode::Compress,
+        binary_mode::StringTable | binary_mode::StringTableValues,
+        binary_mode::SubtreeLengths,
+        binary_mode::ParallelColumns | binary_mode::Compact
+    };
+
+    for (size_t k = 0; k < sizeof(modes)/sizeof(modes[0]); ++k)
+    {
+        std::ostringstream oss;
+        binary_writer writer(oss, modes[k]);
+        writer << v1;
+
+        variant v2;
+        std::istringstream iss1(oss.str());
+        binary_reader reader1(iss1);
+        reader1 >> v2;
+
+        BOOST_CHECK(v2.compare(v1) == 0);
+        BOOST_CHECK(v2["table"].columns()[1].encoding() == data_table_column_base::DictionaryEncoding);
+        BOOST_CHECK_EQUAL(v2["table"].columns()[1].dictionary()->size(), 3u);
+
+        // skipping the table without decoding it
+        variant v3;
+        std::istringstream iss2(oss.str());
+        binary_reader reader2(iss2);
+        reader2.set_projection(std::vector<std::string>(1, "trailer"));
+        reader2 >> v3;
+
+        BOOST_CHECK(v3["trailer"].compare(v1["trailer"]) == 0);
+        BOOST_CHECK(!v3.has_key("table"));
+
+        if ((modes[k] & binary_mode::StringTable) == 0)
+        {
+            std::istringstream iss3(oss.str());
+            binary_lazy_variant lazy(iss3);
+
+            BOOST_CHECK(lazy["trailer"].value().compare(v1["trailer"]) == 0);
+            BOOST_CHECK_EQUAL(lazy["table"].size(), 1000u);
+        }
+    }
+
+    // each distinct value is written once
+    std::ostringstream plain, encoded;
+    binary_writer plain_writer(plain);
+    plain_writer << dt3;
+    binary_writer encoded_writer(encoded);
+    encoded_writer << dt2;
+    BOOST_CHECK(encoded.str().size() < plain.str().size() / 2);
+
+    // mutable access decodes the column, so rows moved out of it own their values
+    detail::string moved(std::move(dt2.columns()[1].begin<variant::String>()[2]));
+    BOOST_CHECK(dt2.columns()[1].encoding() == data_table_column_base::PlainEncoding);
+    BOOST_CHECK_EQUAL(std::string(dt2.columns()[1].begin<variant::String>()[7].value()), "ROYAL DUTCH SHELL");
+
+    dt2 = variant();
+    BOOST_CHECK(!moved.isReference());
+    BOOST_CHECK_EQUAL(std::string(moved.value()), "ROYAL DUTCH SHELL");
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_dictionary_encoding_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const size_t rows = 5000000;
+
+    static const char* const tickers[] = {
+        "VODAFONE GROUP PLC", "BARCLAYS PLC", "GLENCORE PLC", "ROYAL DUTCH SHELL PLC", "HSBC HOLDINGS PLC",
+        "BP PLC", "RIO TINTO PLC", "UNILEVER PLC", "ASTRAZENECA PLC", "LLOYDS BANKING GROUP PLC"
+    };
+    static const char* const venues[] = { "LONDON STOCK EXCHANGE", "CHI-X EUROPE", "BATS EUROPE", "TURQUOISE" };
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    const data_table_column_base::encoding_t encodings[] = { data_table_column_base::PlainEncoding, data_table_column_base::DictionaryEncoding };
+    for (size_t i = 0; i < sizeof(encodings)/sizeof(encodings[0]); ++i)
+    {
+        const std::string name(encodings[i] == data_table_column_base::PlainEncoding ? "Plain" : "Dictionary");
+
+        variant dt(variant::DataTable, rows);
+        dt.add_column(variant::Double, "Price")
+          .add_column(variant::String, "Ticker", encodings[i])
+          .add_column(variant::String, "Venue", encodings[i]);
+
+        start = boost::chrono::high_resolution_clock::now();
+        for (size_t j = 0; j < rows; ++j)
+            dt.push_back(make_row(100.0 + j, detail::string(tickers[j % 10]), detail::string(venues[(j / 3) % 4])));
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Construction", start, finish);
+
+        // bytes held for the values themselves, besides the 8 bytes per row
+        size_t bytes = 0;
+        for (size_t c = 1; c < 3; ++c)
+        {
+            data_table_column_base& column(dt.columns()[c]);
+            if (column.dictionary() != nullptr)
+            {
+                bytes += column.dictionary()->bytes();
+            }
+            else
+            {
+                for (column_traits<variant::String>::const_iterator citr = column.begin<variant::String>(); citr != column.end<variant::String>(); ++citr)
+                    bytes += citr->onStack() ? 0 : citr->size() + 1;
+            }
+        }
+        std::cout << name << ": " << bytes << " bytes of string values" << std::endl;
+
+        std::ostringstream oss;
+        binary_writer writer(oss);
+        start = boost::chrono::high_resolution_clock::now();
+        writer << dt;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Serialization", start, finish);
+        std::cout << name << ": " << oss.str().size() << " bytes serialized" << std::endl;
+
+        variant loaded;
+        std::istringstream iss(oss.str());
+        binary_reader reader(iss);
+        start = boost::chrono::high_resolution_clock::now();
+        reader >> loaded;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Deserialization", start, finish);
+
+        // count the rows of one ticker
+        const detail::string ticker(tickers[3]);
+        const data_table_column_base& column(loaded.columns()[1]);
+
+        start = boost::chrono::high_resolution_clock::now();
+        size_t matches = 0;
+        for (column_traits<variant::String>::const_iterator citr = column.begin<variant::String>(); citr != column.end<variant::String>(); ++citr)
+            matches += citr->compare(ticker) == 0 ? 1 : 0;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Scan", start, finish);
+        BOOST_CHECK_EQUAL(matches, rows / 10);
+
+        start = boost::chrono::high_resolution_clock::now();
+        loaded = variant();
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Destruction", start, finish);
+    }
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_arena_encoding)
+{
+    variant dt1(variant::DataTable);
+    dt1.add_column(variant::Int32,  "Id")
+       .add_column(variant::String, "Name")
+       .add_column(variant::Any,    "Text");
+
+    variant dt2(variant::DataTable);
+    dt2.add_column(variant::Int32,  "Id")
+       .add_column(variant::String, "Name", data_table_column_base::ArenaEncoding)
+       .add_column(variant::Any,    "Text", data_table_column_base::ArenaEncoding);
+
+    BOOST_CHECK(dt2.columns()[1].encoding() == data_table_column_base::ArenaEncoding);
+    BOOST_CHECK(dt2.columns()[1].dictionary() == nullptr);
+    BOOST_CHECK(dt2.columns()[0].arena() == nullptr);
+    BOOST_CHECK_THROW(dt2.add_column(variant::Int64, "Size", data_table_column_base::ArenaEncoding), variant_error);
+
+    // the arena grows several times, moving the rows that refer to it
+    typedef data_table_row<variant::Int32, variant::String, variant::Any>::type row_type;
+    for (int i = 0; i < 5000; ++i)
+    {
+        const std::string name((boost::format("customer name %d") % i).str());
+        const row_type row(make_row(i, detail::string(name.c_str()), detail::string(i % 4 == 0 ? "tiny" : "some longer free text")));
+        dt1.push_back(row);
+        dt2.push_back(row);
+    }
+
+    // the values are held contiguously, in row order
+    const data_table_column_base& column(dt2.columns()[1]);
+    const char* first(column.arena()->data());
+    BOOST_CHECK(column.begin<variant::String>()[0].value() == first);
+    BOOST_CHECK(column.begin<variant::String>()[1].value() == first + detail::string_arena::padded_size(15));
+    BOOST_CHECK_EQUAL(std::string(column.begin<variant::String>()[4999].value()), "customer name 4999");
+    BOOST_CHECK(dt2.compare(dt1) == 0);
+
+    // copies have an arena of their own
+    variant dt3(dt2);
+    data_table_column_base& copied_column(dt3.columns()[1]);
+    const data_table_column_base& copied_rows(copied_column);
+    BOOST_CHECK(copied_column.arena() != column.arena());
+    BOOST_CHECK(copied_rows.begin<variant::String>()[0].value() == copied_column.arena()->data());
+    BOOST_CHECK(dt3.compare(dt1) == 0);
+
+    // a row appended from the same column
+    copied_column.push_back(copied_rows.begin<variant::String>()[0]);
+    BOOST_CHECK(copied_column.encoding() == data_table_column_base::ArenaEncoding);
+    BOOST_CHECK_EQUAL(std::string(copied_rows.begin<variant::String>()[5000].value()), "customer name 0");
+    copied_column.resize(5000);
+
+    dt3.columns()[2].set_encoding(data_table_column_base::DictionaryEncoding);
+    BOOST_CHECK(dt3.columns()[2].arena() == nullptr);
+    BOOST_CHECK(dt3.compare(dt1) == 0);
+
+    variant v1(variant::Dictionary);
+    v1.insert("table", dt2)
+      .insert("trailer", variant("after the table"));
+
+    const int modes[] = {
+        binary_mode::Default,
+        binary_mode::Compact,
+        binary_mode::Compress,
+        binary_mode::StringTable | binary_mode::StringTableValues,
+        binary_mode::SubtreeLengths,
+        binary_mode::ParallelColumns
+    };
+
+    for (size_t k = 0; k < sizeof(modes)/sizeof(modes[0]); ++k)
+    {
+        std::ostringstream oss;
+        binary_writer writer(oss, modes[k]);
+        writer << v1;
+
+        variant v2;
+        std::istringstream iss1(oss.str());
+        binary_reader reader1(iss1);
+        reader1 >> v2;
+
+        BOOST_CHECK(v2.compare(v1) == 0);
+
+        const data_table_column_base& read_column(v2["table"].columns()[1]);
+        BOOST_CHECK(read_column.encoding() == data_table_column_base::ArenaEncoding);
+        BOOST_CHECK(read_column.begin<variant::String>()[1].value() == read_column.arena()->data() + detail::string_arena::padded_size(15));
+
+        // skipping the table without decoding it
+        variant v3;
+        std::istringstream iss2(oss.str());
+        binary_reader reader2(iss2);
+        reader2.set_projection(std::vector<std::string>(1, "trailer"));
+        reader2 >> v3;
+
+        BOOST_CHECK(v3["trailer"].compare(v1["trailer"]) == 0);
+        BOOST_CHECK(!v3.has_key("table"));
+
+        if ((modes[k] & binary_mode::StringTable) == 0)
+        {
+            std::istringstream iss3(oss.str());
+            binary_lazy_variant lazy(iss3);
+
+            BOOST_CHECK(lazy["trailer"].value().compare(v1["trailer"]) == 0);
+            BOOST_CHECK_EQUAL(lazy["table"].size(), 5000u);
+        }
+    }
+
+    // assigning rows through iterators decodes the column first
+    dt2.columns()[1].begin<variant::String>()[10] = detail::string("replaced value");
+    dt1.columns()[1].begin<variant::String>()[10] = detail::string("replaced value");
+    BOOST_CHECK(dt2.columns()[1].encoding() == data_table_column_base::PlainEncoding);
+
+    std::ostringstream oss;
+    binary_writer writer(oss);
+    writer << dt2;
+
+    variant v4;
+    std::istringstream iss(oss.str());
+    binary_reader reader(iss);
+    reader >> v4;
+
+    BOOST_CHECK(v4.compare(dt1) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_arena_encoding_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const size_t rows = 5000000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    const data_table_column_base::encoding_t encodings[] = { data_table_column_base::PlainEncoding, data_table_column_base::ArenaEncoding };
+    for (size_t i = 0; i < sizeof(encodings)/sizeof(encodings[0]); ++i)
+    {
+        const std::string name(encodings[i] == data_table_column_base::PlainEncoding ? "Plain" : "Arena");
+
+        variant dt(variant::DataTable, rows);
+        dt.add_column(variant::String, "OrderId", encodings[i]);
+
+        char buffer[32];
+        start = boost::chrono::high_resolution_clock::now();
+        for (size_t j = 0; j < rows; ++j)
+        {
+            sprintf(buffer, "ORD-%012u", static_cast<unsigned>(j));
+            dt.columns()[0].push_back(detail::string(buffer));
+        }
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Construction", start, finish);
+
+        std::ostringstream oss;
+        binary_writer writer(oss);
+        start = boost::chrono::high_resolution_clock::now();
+        writer << dt;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Serialization", start, finish);
+
+        variant loaded;
+        std::istringstream iss(oss.str());
+        binary_reader reader(iss);
+        start = boost::chrono::high_resolution_clock::now();
+        reader >> loaded;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Deserialization", start, finish);
+
+        // touch every byte of every value
+        const data_table_column_base& column(loaded.columns()[0]);
+        start = boost::chrono::high_resolution_clock::now();
+        size_t digits = 0;
+        for (column_traits<variant::String>::const_iterator citr = column.begin<variant::String>(); citr != column.end<variant::String>(); ++citr)
+            for (const char* c = citr->value(); *c != 0; ++c)
+                digits += (*c >= '0' && *c <= '9') ? 1 : 0;
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Scan", start, finish);
+        BOOST_CHECK_EQUAL(digits, rows * 12);
+
+        start = boost::chrono::high_resolution_clock::now();
+        loaded = variant();
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, name, "Destruction", start, finish);
+    }
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_expression)
+{
+    typedef data_table_expression expr;
+
+    const boost::gregorian::date initial_date(2020, 1, 1);
+
+    // more rows than are evaluated in one batch
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int32,   "Id")
+      .add_column(variant::Double,  "Price")
+      .add_column(variant::Int64,   "Qty")
+      .add_column(variant::String,  "Name", data_table_column_base::DictionaryEncoding)
+      .add_column(variant::Date,    "Day")
+      .add_column(variant::Boolean, "Cancelled");
+
+    typedef data_table_row<variant::Int32, variant::Double, variant::Int64, variant::String, variant::Date, variant::Boolean>::type row_type;
+    for (int i = 0; i < 10000; ++i)
+    {
+        const row_type row(make_row(i, 0.5 * i, static_cast<boost::int64_t>(i % 7), detail::string(i % 3 == 0 ? "buy" : "sell"), initial_date + boost::gregorian::days(i % 100), i % 5 == 0));
+        dt.push_back(row);
+    }
+
+    // comparisons, mixing integers with doubles
+    data_table_selection selection(dt.where(expr::column("Price") * expr::column("Qty") > 10000 && !expr::column("Cancelled")));
+
+    size_t expected = 0;
+    for (int i = 0; i < 10000; ++i)
+    {
+        if (0.5 * i * (i % 7) > 10000 && i % 5 != 0)
+        {
+            BOOST_REQUIRE(expected < selection.size());
+            BOOST_CHECK_EQUAL(selection.row(expected), static_cast<size_t>(i));
+            ++expected;
+        }
+    }
+    BOOST_CHECK_EQUAL(selection.size(), expected);
+    BOOST_CHECK_EQUAL(selection.get<variant::Int32>(0, 0), static_cast<boost::int32_t>(selection.row(0)));
+
+    // strings and dates
+    BOOST_CHECK_EQUAL(dt.where(expr::column("Name") == "buy").size(), 3334u);
+    BOOST_CHECK_EQUAL(dt.where(expr::column("Name") != std::string("buy") && expr::column("Name") >= "sell").size(), 6666u);
+    BOOST_CHECK_EQUAL(dt.where(expr::column("Day") < initial_date + boost::gregorian::days(10)).size(), 1000u);
+    BOOST_CHECK_EQUAL(dt.where(expr::column("Day") >= boost::gregorian::date(boost::gregorian::pos_infin)).size(), 0u);
+    BOOST_CHECK_EQUAL(dt.where(expr::column("Cancelled") || expr::column("Id") <= 1).size(), 2001u);
+    BOOST_CHECK(dt.where(expr::column("Id") < 0).empty());
+
+    // filtering copies the selected rows, keeping the encoding of each column
+    variant filtered(dt.filter(expr::column("Id") >= 9990 || expr::column("Id") == 3));
+    BOOST_CHECK_EQUAL(filtered.size(), 11u);
+    BOOST_CHECK_EQUAL(filtered.columns().size(), dt.columns().size());
+    BOOST_CHECK(filtered.columns()[3].encoding() == data_table_column_base::DictionaryEncoding);
+    BOOST_CHECK(filtered.columns()[3].dictionary() != dt.columns()[3].dictionary());
+    BOOST_CHECK_EQUAL(filtered.columns()[0].begin<variant::Int32>()[0], 3);
+    BOOST_CHECK_EQUAL(filtered.columns()[0].begin<variant::Int32>()[10], 9999);
+    BOOST_CHECK_EQUAL(std::string(filtered.columns()[3].begin<variant::String>()[1].value()), "buy");
+    BOOST_CHECK(filtered.columns()[4].begin<variant::Date>()[1] == initial_date + boost::gregorian::days(90));
+    BOOST_CHECK(!filtered.columns()[5].begin<variant::Boolean>()[0]);
+
+    variant empty(dt.filter(expr(false)));
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK_EQUAL(empty.columns().size(), dt.columns().size());
+
+    // derived columns
+    dt.add_column("Total", expr::column("Price") * expr::column("Qty"))
+      .add_column("Next", expr::column("Qty") + 1)
+      .add_column("Ratio", expr::column("Qty") / 2)
+      .add_column("Large", -expr::column("Qty") < -3)
+      .add_column("Label", expr("fixed"))
+      .add_column("Later", expr::column("Day"));
+
+    BOOST_CHECK(dt.columns()[6].type() == variant::Double);
+    BOOST_CHECK(dt.columns()[7].type() == variant::Int64);
+    BOOST_CHECK(dt.columns()[8].type() == variant::Double);
+    BOOST_CHECK(dt.columns()[9].type() == variant::Boolean);
+    BOOST_CHECK(dt.columns()[10].type() == variant::String);
+    BOOST_CHECK(dt.columns()[11].type() == variant::Date);
+
+    for (int i = 0; i < 10000; i += 997)
+    {
+        BOOST_CHECK_EQUAL(dt.columns()[6].begin<variant::Double>()[i], 0.5 * i * (i % 7));
+        BOOST_CHECK_EQUAL(dt.columns()[7].begin<variant::Int64>()[i], i % 7 + 1);
+        BOOST_CHECK_EQUAL(dt.columns()[8].begin<variant::Double>()[i], (i % 7) / 2.0);
+        BOOST_CHECK_EQUAL(dt.columns()[9].begin<variant::Boolean>()[i], i % 7 > 3);
+        BOOST_CHECK_EQUAL(std::string(dt.columns()[10].begin<variant::String>()[i].value()), "fixed");
+        BOOST_CHECK(dt.columns()[11].begin<variant::Date>()[i] == initial_date + boost::gregorian::days(i % 100));
+    }
+
+    // errors are reported when the expression is bound to the table
+    BOOST_CHECK_THROW(dt.where(expr::column("Missing") == 1), variant_error);
+    BOOST_CHECK_THROW(dt.where(expr::column("Name") == 1), variant_error);
+    BOOST_CHECK_THROW(dt.where(expr::column("Day") < 1.0), variant_error);
+    BOOST_CHECK_THROW(dt.where(expr::column("Price") + 1), variant_error);
+    BOOST_CHECK_THROW(dt.where(expr::column("Cancelled") && expr::column("Id")), variant_error);
+    BOOST_CHECK_THROW(dt.add_column("Bad", expr::column("Name") * 2), variant_error);
+    BOOST_CHECK_EQUAL(dt.columns().size(), 12u);
+    BOOST_CHECK_THROW(variant(variant::List).where(expr(true)), variant_error);
+
+    // UInt64 values above the range of Int64 compare as unsigned, and the special
+    // DateTime values are told apart
+    const boost::uint64_t large = (std::numeric_limits<boost::uint64_t>::max)();
+    const boost::posix_time::ptime initial_time(initial_date);
+
+    variant special(variant::DataTable);
+    special.add_column(variant::UInt64,   "Count")
+           .add_column(variant::DateTime, "Time");
+    special.push_back(make_row(large,                 boost::posix_time::ptime(boost::posix_time::not_a_date_time)))
+           .push_back(make_row(large - 1,             boost::posix_time::ptime(boost::posix_time::neg_infin)))
+           .push_back(make_row(boost::uint64_t(5),    initial_time))
+           .push_back(make_row(boost::uint64_t(0),    boost::posix_time::ptime(boost::posix_time::pos_infin)));
+
+    BOOST_CHECK_EQUAL(special.where(expr::column("Count") > 10).size(), 2u);
+    BOOST_CHECK_EQUAL(special.where(expr::column("Count") < 10).size(), 2u);
+    BOOST_CHECK_EQUAL(special.where(expr::column("Count") > -1).size(), 4u);
+    BOOST_CHECK_EQUAL(special.where(expr::column("Count") == boost::int64_t(-1)).size(), 0u);
+    BOOST_CHECK_EQUAL(special.where(expr::column("Count") * 1.0 > 1e19).size(), 2u);
+    BOOST_CHECK_EQUAL(special.where(expr::column("Time") < initial_time).size(), 2u);
+    BOOST_CHECK_EQUAL(special.where(expr::column("Time") == boost::posix_time::ptime(boost::posix_time::neg_infin)).size(), 1u);
+
+    special.add_column("Same", expr::column("Count"))
+           .add_column("Next", expr::column("Count") + expr::column("Count"))
+           .add_column("Mixed", expr::column("Count") - 10)
+           .add_column("Copy", expr::column("Time"));
+
+    BOOST_CHECK(special.columns()[2].type() == variant::UInt64);
+    BOOST_CHECK(special.columns()[3].type() == variant::UInt64);
+    BOOST_CHECK(special.columns()[4].type() == variant::Double);
+    BOOST_CHECK_EQUAL(special.columns()[2].begin<variant::UInt64>()[0], large);
+    BOOST_CHECK_EQUAL(special.columns()[3].begin<variant::UInt64>()[2], 10u);
+    BOOST_CHECK_EQUAL(special.columns()[4].begin<variant::Double>()[3], -10.0);
+    BOOST_CHECK(special.columns()[5].begin<variant::DateTime>()[0].is_not_a_date_time());
+    BOOST_CHECK(special.columns()[5].begin<variant::DateTime>()[1].is_neg_infinity());
+    BOOST_CHECK(special.columns()[5].begin<variant::DateTime>()[3].is_pos_infinity());
+
+    // derived columns are named and counted as other columns are
+    BOOST_CHECK_THROW(special.add_column("Count", expr::column("Count") + 1), variant_error);
+    BOOST_CHECK_EQUAL(special.columns().size(), 6u);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_expression_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const size_t rows = 20000000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    std::vector<double> prices(rows);
+    std::vector<boost::int64_t> quantities(rows);
+    std::vector<bool> cancelled(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        prices[i] = static_cast<double>((i * 7919) % 1000);
+        quantities[i] = static_cast<boost::int64_t>(i % 13);
+        cancelled[i] = (i % 11) == 0;
+    }
+
+    variant dt(variant::DataTable, rows);
+    dt.add_column(variant::Double,  "Price")
+      .add_column(variant::Int64,   "Qty")
+      .add_column(variant::Boolean, "Cancelled");
+    dt.columns()[0].assign<variant::Double>(std::move(prices));
+    dt.columns()[1].assign<variant::Int64>(std::move(quantities));
+    dt.columns()[2].assign<variant::Boolean>(std::move(cancelled));
+
+    // a row at a time through the typed iterators, copying the rows that match
+    variant matched(variant::DataTable);
+    matched.add_column(variant::Double,  "Price")
+           .add_column(variant::Int64,   "Qty")
+           .add_column(variant::Boolean, "Cancelled");
+
+    start = boost::chrono::high_resolution_clock::now();
+    data_table<variant::Double, variant::Int64, variant::Boolean>::const_iterator citr = dt.begin<variant::Double, variant::Int64, variant::Boolean>();
+    data_table<variant::Double, variant::Int64, variant::Boolean>::const_iterator cend = dt.end<variant::Double, variant::Int64, variant::Boolean>();
+    for (; citr != cend; ++citr)
+    {
+        if (citr->get<0>() * citr->get<1>() > 6000.0 && !citr->get<2>())
+            matched.push_back(*citr);
+    }
+    finish = boost::chrono::high_resolution_clock::now();
+
+    duration_checkpoint<duration_resolution>(std::cout, "Rows", "Filter", start, finish);
+
+    typedef data_table_expression expr;
+    const data_table_expression predicate(expr::column("Price") * expr::column("Qty") > 6000.0 && !expr::column("Cancelled"));
+
+    start = boost::chrono::high_resolution_clock::now();
+    data_table_selection selection(dt.where(predicate));
+    finish = boost::chrono::high_resolution_clock::now();
+
+    duration_checkpoint<duration_resolution>(std::cout, "Expression", "Selection", start, finish);
+    BOOST_CHECK_EQUAL(selection.size(), matched.size());
+
+    start = boost::chrono::high_resolution_clock::now();
+    variant filtered(dt.filter(predicate));
+    finish = boost::chrono::high_resolution_clock::now();
+
+    duration_checkpoint<duration_resolution>(std::cout, "Expression", "Filter", start, finish);
+    BOOST_CHECK(filtered.compare(matched) == 0);
+
+    start = boost::chrono::high_resolution_clock::now();
+    dt.add_column("Total", expr::column("Price") * expr::column("Qty"));
+    finish = boost::chrono::high_resolution_clock::now();
+
+    duration_checkpoint<duration_resolution>(std::cout, "Expression", "Projection", start, finish);
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_group_by)
+{
+    const boost::gregorian::date initial_date(2020, 1, 1);
+
+    // enough rows to be partitioned over several threads
+    static const int rows = 200000;
+
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int32,  "Account")
+      .add_column(variant::String, "Side", data_table_column_base::DictionaryEncoding)
+      .add_column(variant::Date,   "Day")
+      .add_column(variant::Int64,  "Qty")
+      .add_column(variant::Double, "Price");
+
+    typedef data_table_row<variant::Int32, variant::String, variant::Date, variant::Int64, variant::Double>::type row_type;
+    for (int i = 0; i < rows; ++i)
+    {
+        const row_type row(make_row(i % 37, detail::string(i % 3 == 0 ? "buy" : "sell"), initial_date + boost::gregorian::days(i % 5), static_cast<boost::int64_t>(i % 101) - 50, 0.25 * (i % 13)));
+        dt.push_back(row);
+    }
+
+    // expected results, in order of first appearance
+    typedef std::pair<int, std::string> key_type;
+    struct totals
+    {
+        size_t first_row;
+        boost::uint64_t count;
+        boost::int64_t sum_qty, min_qty, max_qty;
+        double sum_price;
+    };
+    std::map<key_type, totals> expected;
+    for (int i = 0; i < rows; ++i)
+    {
+        const key_type key(i % 37, i % 3 == 0 ? "buy" : "sell");
+        const boost::int64_t qty(i % 101 - 50);
+        const double price(0.25 * (i % 13));
+
+        std::map<key_type, totals>::iterator itr(expected.find(key));
+        if (itr == expected.end())
+        {
+            const totals initial = { static_cast<size_t>(i), 1, qty, qty, qty, price };
+            expected.insert(std::make_pair(key, initial));
+        }
+        else
+        {
+            ++itr->second.count;
+            itr->second.sum_qty += qty;
+            itr->second.min_qty = (std::min)(itr->second.min_qty, qty);
+            itr->second.max_qty = (std::max)(itr->second.max_qty, qty);
+            itr->second.sum_price += price;
+        }
+    }
+
+    std::vector<std::string> keys;
+    keys.push_back("Account");
+    keys.push_back("Side");
+
+    std::vector<data_table_aggregate> aggregates;
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Count));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Sum, "Qty"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Min, "Qty"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Max, "Qty", "Largest"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Sum, "Price"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Mean, "Qty"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Count, "Day"));
+
+    const variant single(dt.group_by(keys, aggregates, 1));
+    const variant parallel(dt.group_by(keys, aggregates, 4));
+
+    BOOST_CHECK_EQUAL(single.size(), expected.size());
+    BOOST_CHECK(parallel.compare(single) == 0);
+
+    BOOST_REQUIRE_EQUAL(single.columns().size(), 9u);
+    BOOST_CHECK_EQUAL(single.columns()[0].name(), "Account");
+    BOOST_CHECK(single.columns()[1].encoding() == data_table_column_base::DictionaryEncoding);
+    BOOST_CHECK_EQUAL(single.columns()[2].name(), "Count");
+    BOOST_CHECK(single.columns()[2].type() == variant::UInt64);
+    BOOST_CHECK_EQUAL(single.columns()[3].name(), "Sum(Qty)");
+    BOOST_CHECK(single.columns()[3].type() == variant::Int64);
+    BOOST_CHECK_EQUAL(single.columns()[5].name(), "Largest");
+    BOOST_CHECK(single.columns()[6].type() == variant::Double);
+    BOOST_CHECK(single.columns()[7].type() == variant::Double);
+
+    size_t previous_first_row = 0;
+    for (size_t g = 0; g < single.size(); ++g)
+    {
+        const key_type key(single.columns()[0].begin<variant::Int32>()[g], single.columns()[1].begin<variant::String>()[g].value());
+        const totals& t(expected[key]);
+
+        BOOST_CHECK(g == 0 || t.first_row > previous_first_row);
+        previous_first_row = t.first_row;
+
+        BOOST_CHECK_EQUAL(single.columns()[2].begin<variant::UInt64>()[g], t.count);
+        BOOST_CHECK_EQUAL(single.columns()[3].begin<variant::Int64>()[g], t.sum_qty);
+        BOOST_CHECK_EQUAL(single.columns()[4].begin<variant::Int64>()[g], t.min_qty);
+        BOOST_CHECK_EQUAL(single.columns()[5].begin<variant::Int64>()[g], t.max_qty);
+        BOOST_CHECK_CLOSE(single.columns()[6].begin<variant::Double>()[g], t.sum_price, 1e-9);
+        BOOST_CHECK_CLOSE(single.columns()[7].begin<variant::Double>()[g] + 100.0, static_cast<double>(t.sum_qty) / t.count + 100.0, 1e-9);
+        BOOST_CHECK_EQUAL(single.columns()[8].begin<variant::UInt64>()[g], t.count);
+    }
+
+    // dates as keys
+    const variant by_day(dt.group_by(std::vector<std::string>(1, "Day"), std::vector<data_table_aggregate>(1, data_table_aggregate(data_table_aggregate::Count)), 2));
+    BOOST_REQUIRE_EQUAL(by_day.size(), 5u);
+    BOOST_CHECK(by_day.columns()[0].begin<variant::Date>()[4] == initial_date + boost::gregorian::days(4));
+    BOOST_CHECK_EQUAL(by_day.columns()[1].begin<variant::UInt64>()[0], static_cast<boost::uint64_t>(rows / 5));
+
+    // an empty table has no groups
+    variant empty(variant::DataTable);
+    empty.add_column(variant::Int32, "Account")
+         .add_column(variant::Double, "Price");
+    const variant none(empty.group_by(std::vector<std::string>(1, "Account"), std::vector<data_table_aggregate>(1, data_table_aggregate(data_table_aggregate::Max, "Price"))));
+    BOOST_CHECK(none.empty());
+    BOOST_CHECK_EQUAL(none.columns().size(), 2u);
+
+    BOOST_CHECK_THROW(dt.group_by(std::vector<std::string>(), aggregates), variant_error);
+    BOOST_CHECK_THROW(dt.group_by(std::vector<std::string>(1, "Missing"), aggregates), variant_error);
+    BOOST_CHECK_THROW(dt.group_by(std::vector<std::string>(1, "Price"), aggregates), variant_error);
+    BOOST_CHECK_THROW(dt.group_by(keys, std::vector<data_table_aggregate>(1, data_table_aggregate(data_table_aggregate::Sum, "Side"))), variant_error);
+    BOOST_CHECK_THROW(variant(variant::List).group_by(keys, aggregates), variant_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_group_by_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const size_t rows = 20000000;
+    static const int accounts = 100000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    std::vector<boost::int32_t> account(rows);
+    std::vector<boost::int64_t> qty(rows);
+    std::vector<double> price(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        account[i] = static_cast<boost::int32_t>((i * 7919) % accounts);
+        qty[i] = static_cast<boost::int64_t>(i % 1000);
+        price[i] = 0.01 * (i % 10000);
+    }
+
+    variant dt(variant::DataTable, rows);
+    dt.add_column(variant::Int32,  "Account")
+      .add_column(variant::Int64,  "Qty")
+      .add_column(variant::Double, "Price");
+    dt.columns()[0].assign<variant::Int32>(std::move(account));
+    dt.columns()[1].assign<variant::Int64>(std::move(qty));
+    dt.columns()[2].assign<variant::Double>(std::move(price));
+
+    std::vector<data_table_aggregate> aggregates;
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Count));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Sum, "Qty"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Max, "Price"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Mean, "Price"));
+
+    const size_t cores = (std::max)(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= cores; ++threads)
+    {
+        start = boost::chrono::high_resolution_clock::now();
+        const variant result(dt.group_by(std::vector<std::string>(1, "Account"), aggregates, threads));
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, (boost::format("%d threads") % threads).str(), "Group-by", start, finish);
+        BOOST_CHECK_EQUAL(result.size(), static_cast<size_t>(accounts));
+    }
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_join)
+{
+    variant orders(variant::DataTable);
+    orders.add_column(variant::Int32,  "Account")
+          .add_column(variant::Int64,  "Qty");
+
+    const int order_accounts[] = { 1, 2, 3, 4, 2, 5 };
+    for (int i = 0; i < 6; ++i)
+    {
+        orders.push_back(make_row(order_accounts[i], static_cast<boost::int64_t>(10 * (i + 1))));
+    }
+
+    variant accounts(variant::DataTable);
+    accounts.add_column(variant::Int32,  "Id")
+            .add_column(variant::String, "Name", data_table_column_base::DictionaryEncoding)
+            .add_column(variant::Double, "Rate");
+
+    accounts.push_back(make_row(2, std::string("b1"), 0.2))
+            .push_back(make_row(1, std::string("a"),  0.1))
+            .push_back(make_row(2, std::string("b2"), 0.3))
+            .push_back(make_row(7, std::string("g"),  0.7));
+
+    const std::vector<std::string> account_key(1, "Account");
+    const std::vector<std::string> id_key(1, "Id");
+
+    // builds on the accounts, the smaller side, and probes the orders in order
+    const variant inner(orders.join(accounts, account_key, id_key));
+    BOOST_REQUIRE_EQUAL(inner.size(), 5u);
+    BOOST_REQUIRE_EQUAL(inner.columns().size(), 4u);
+    BOOST_CHECK_EQUAL(inner.columns()[0].name(), "Account");
+    BOOST_CHECK_EQUAL(inner.columns()[1].name(), "Qty");
+    BOOST_CHECK_EQUAL(inner.columns()[2].name(), "Name");
+    BOOST_CHECK(inner.columns()[2].encoding() == data_table_column_base::DictionaryEncoding);
+    BOOST_CHECK_EQUAL(inner.columns()[3].name(), "Rate");
+
+    const int inner_accounts[] = { 1, 2, 2, 2, 2 };
+    const boost::int64_t inner_qty[] = { 10, 20, 20, 50, 50 };
+    const char* inner_names[] = { "a", "b1", "b2", "b1", "b2" };
+    for (size_t i = 0; i < inner.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(inner.columns()[0].begin<variant::Int32>()[i], inner_accounts[i]);
+        BOOST_CHECK_EQUAL(inner.columns()[1].begin<variant::Int64>()[i], inner_qty[i]);
+        BOOST_CHECK_EQUAL(inner.columns()[2].begin<variant::String>()[i].value(), inner_names[i]);
+    }
+
+    // builds on the accounts, now the left side, and still keeps their order
+    const variant reversed(accounts.join(orders, id_key, account_key));
+    BOOST_REQUIRE_EQUAL(reversed.size(), 5u);
+    BOOST_REQUIRE_EQUAL(reversed.columns().size(), 4u);
+    BOOST_CHECK_EQUAL(reversed.columns()[3].name(), "Qty");
+
+    const int reversed_accounts[] = { 2, 2, 1, 2, 2 };
+    const boost::int64_t reversed_qty[] = { 20, 50, 10, 20, 50 };
+    const char* reversed_names[] = { "b1", "b1", "a", "b2", "b2" };
+    for (size_t i = 0; i < reversed.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(reversed.columns()[0].begin<variant::Int32>()[i], reversed_accounts[i]);
+        BOOST_CHECK_EQUAL(reversed.columns()[1].begin<variant::String>()[i].value(), reversed_names[i]);
+        BOOST_CHECK_EQUAL(reversed.columns()[3].begin<variant::Int64>()[i], reversed_qty[i]);
+    }
+
+    // columns of the right named as those of the left are suffixed
+    variant fills(variant::DataTable);
+    fills.add_column(variant::Int32, "Id")
+         .add_column(variant::Int64, "Qty")
+         .add_column(variant::Int64, "Qty_right");
+    fills.push_back(make_row(1, static_cast<boost::int64_t>(5), static_cast<boost::int64_t>(6)));
+
+    BOOST_CHECK_THROW(fills.join(orders, id_key, account_key), variant_error);
+    fills.columns().pop_back();
+
+    const variant suffixed(orders.join(fills, account_key, id_key));
+    BOOST_REQUIRE_EQUAL(suffixed.size(), 1u);
+    BOOST_REQUIRE_EQUAL(suffixed.columns().size(), 3u);
+    BOOST_CHECK_EQUAL(suffixed.columns()[1].name(), "Qty");
+    BOOST_CHECK_EQUAL(suffixed.columns()[2].name(), "Qty_right");
+    BOOST_CHECK_EQUAL(suffixed.columns()[1].begin<variant::Int64>()[0], 10);
+    BOOST_CHECK_EQUAL(suffixed.columns()[2].begin<variant::Int64>()[0], 5);
+
+    // orders without an account hold default values in the account columns
+    const variant left(orders.join(accounts, account_key, id_key, LeftJoin));
+    BOOST_REQUIRE_EQUAL(left.size(), 8u);
+
+    const int left_accounts[] = { 1, 2, 2, 3, 4, 2, 2, 5 };
+    const char* left_names[] = { "a", "b1", "b2", "", "", "b1", "b2", "" };
+    const double left_rates[] = { 0.1, 0.2, 0.3, 0.0, 0.0, 0.2, 0.3, 0.0 };
+    for (size_t i = 0; i < left.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(left.columns()[0].begin<variant::Int32>()[i], left_accounts[i]);
+        BOOST_CHECK_EQUAL(left.columns()[2].begin<variant::String>()[i].value(), left_names[i]);
+        BOOST_CHECK_EQUAL(left.columns()[3].begin<variant::Double>()[i], left_rates[i]);
+    }
+
+    // several string and date keys, probed in parallel
+    const boost::gregorian::date initial_date(2020, 1, 1);
+    static const int rows = 200000;
+
+    variant trades(variant::DataTable);
+    trades.add_column(variant::String, "Book")
+          .add_column(variant::Date,   "Day")
+          .add_column(variant::Int64,  "Qty");
+    for (int i = 0; i < rows; ++i)
+    {
+        trades.push_back(make_row(std::string(i % 2 == 0 ? "rates" : "credit"), initial_date + boost::gregorian::days(i % 10), static_cast<boost::int64_t>(i)));
+    }
+
+    variant limits(variant::DataTable);
+    limits.add_column(variant::String, "Book")
+          .add_column(variant::Date,   "Day")
+          .add_column(variant::Double, "Limit");
+    for (int i = 0; i < 5; ++i)
+    {
+        limits.push_back(make_row(std::string("rates"), initial_date + boost::gregorian::days(2 * i), 100.0 * i));
+    }
+
+    std::vector<std::string> keys;
+    keys.push_back("Book");
+    keys.push_back("Day");
+
+    const variant single(trades.join(limits, keys, keys, LeftJoin, 1));
+    const variant parallel(trades.join(limits, keys, keys, LeftJoin, 4));
+    BOOST_REQUIRE_EQUAL(single.size(), static_cast<size_t>(rows));
+    BOOST_CHECK(parallel.compare(single) == 0);
+
+    for (int i = 0; i < rows; i += 997)
+    {
+        BOOST_CHECK_EQUAL(single.columns()[2].begin<variant::Int64>()[i], i);
+        BOOST_CHECK_EQUAL(single.columns()[3].begin<variant::Double>()[i], i % 2 == 0 ? 100.0 * ((i % 10) / 2) : 0.0);
+    }
+
+    const variant matched(trades.join(limits, keys, keys, InnerJoin, 4));
+    BOOST_CHECK_EQUAL(matched.size(), static_cast<size_t>(rows / 2));
+
+    BOOST_CHECK_THROW(orders.join(accounts, std::vector<std::string>(), std::vector<std::string>()), variant_error);
+    BOOST_CHECK_THROW(orders.join(accounts, account_key, keys), variant_error);
+    BOOST_CHECK_THROW(orders.join(accounts, account_key, std::vector<std::string>(1, "Missing")), variant_error);
+    BOOST_CHECK_THROW(orders.join(accounts, std::vector<std::string>(1, "Qty"), id_key), variant_error);
+    BOOST_CHECK_THROW(orders.join(variant(variant::List), account_key, id_key), variant_error);
+    BOOST_CHECK_THROW(variant(variant::List).join(accounts, account_key, id_key), variant_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_join_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const size_t rows = 50000000;
+    static const int accounts = 100000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    std::vector<boost::int32_t> account(rows);
+    std::vector<double> price(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        account[i] = static_cast<boost::int32_t>((i * 7919) % accounts);
+        price[i] = 0.01 * (i % 10000);
+    }
+
+    variant trades(variant::DataTable, rows);
+    trades.add_column(variant::Int32,  "Account")
+          .add_column(variant::Double, "Price");
+    trades.columns()[0].assign<variant::Int32>(std::move(account));
+    trades.columns()[1].assign<variant::Double>(std::move(price));
+
+    variant dim(variant::DataTable, accounts);
+    dim.add_column(variant::Int32,  "Id")
+       .add_column(variant::Double, "Rate");
+    for (int i = 0; i < accounts; ++i)
+    {
+        dim.push_back(make_row(i, 0.001 * i));
+    }
+
+    const size_t cores = (std::max)(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= cores; ++threads)
+    {
+        start = boost::chrono::high_resolution_clock::now();
+        const variant result(trades.join(dim, std::vector<std::string>(1, "Account"), std::vector<std::string>(1, "Id"), InnerJoin, threads));
+        finish = boost::chrono::high_resolution_clock::now();
+
+        duration_checkpoint<duration_resolution>(std::cout, (boost::format("%d threads") % threads).str(), "Join", start, finish);
+        BOOST_CHECK_EQUAL(result.size(), rows);
+    }
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_sort)
+{
+    const boost::gregorian::date initial_date(2020, 1, 1);
+
+    // enough rows to be merge sorted over several threads
+    static const int rows = 200000;
+
+    std::vector<boost::int32_t> accounts(rows);
+    std::vector<std::string> sides(rows);
+    std::vector<boost::gregorian::date> days(rows);
+    std::vector<double> prices(rows);
+
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int32,  "Account")
+      .add_column(variant::String, "Side", data_table_column_base::DictionaryEncoding)
+      .add_column(variant::Date,   "Day")
+      .add_column(variant::Double, "Price")
+      .add_column(variant::Int64,  "Seq");
+
+    typedef data_table_row<variant::Int32, variant::String, variant::Date, variant::Double, variant::Int64>::type row_type;
+    for (int i = 0; i < rows; ++i)
+    {
+        accounts[i] = static_cast<boost::int32_t>((i * 7919) % 1001) - 500;
+        sides[i] = i % 3 == 0 ? "buy" : (i % 3 == 1 ? "sell" : "short");
+        days[i] = initial_date + boost::gregorian::days((i * 31) % 17);
+        prices[i] = 0.25 * ((i * 13) % 97) - 10.0;
+
+        const row_type row(make_row(accounts[i], detail::string(sides[i].c_str()), days[i], prices[i], static_cast<boost::int64_t>(i)));
+        dt.push_back(row);
+    }
+
+    std::vector<size_t> expected(rows);
+    for (int i = 0; i < rows; ++i)
+    {
+        expected[i] = static_cast<size_t>(i);
+    }
+
+    // a string key followed by a descending integer key
+    std::vector<data_table_sort_key> keys;
+    keys.push_back(data_table_sort_key("Side"));
+    keys.push_back(data_table_sort_key("Account", data_table_sort_key::Descending));
+
+    std::stable_sort(expected.begin(), expected.end(), [&](size_t lhs, size_t rhs) {
+        if (sides[lhs] != sides[rhs])
+            return sides[lhs] < sides[rhs];
+        return accounts[lhs] > accounts[rhs];
+    });
+
+    const data_table_selection view(dt.sorted_view(keys, 4));
+    BOOST_CHECK(view.rows() == expected);
+    BOOST_CHECK(dt.sorted_view(keys, 1).rows() == expected);
+
+    variant sorted(dt);
+    sorted.sort(keys, 4);
+    BOOST_REQUIRE_EQUAL(sorted.size(), static_cast<size_t>(rows));
+    BOOST_CHECK(sorted.compare(view.table()) == 0);
+    BOOST_CHECK(sorted.columns()[1].encoding() == data_table_column_base::DictionaryEncoding);
+    for (int i = 0; i < rows; i += 997)
+    {
+        BOOST_CHECK_EQUAL(sorted.columns()[4].begin<variant::Int64>()[i], static_cast<boost::int64_t>(expected[i]));
+    }
+
+    // radix sorted date and integer keys around a double key
+    keys.clear();
+    keys.push_back(data_table_sort_key("Day", data_table_sort_key::Descending));
+    keys.push_back(data_table_sort_key("Price"));
+    keys.push_back(data_table_sort_key("Account"));
+
+    std::stable_sort(expected.begin(), expected.end(), [](size_t lhs, size_t rhs) { return lhs < rhs; });
+    std::stable_sort(expected.begin(), expected.end(), [&](size_t lhs, size_t rhs) {
+        if (days[lhs] != days[rhs])
+            return days[lhs] > days[rhs];
+        if (prices[lhs] != prices[rhs])
+            return prices[lhs] < prices[rhs];
+        return accounts[lhs] < accounts[rhs];
+    });
+    BOOST_CHECK(dt.sorted_view(keys, 3).rows() == expected);
+
+    // the view refers to the table's own rows
+    const data_table_selection by_account(dt.sorted_view(std::vector<data_table_sort_key>(1, data_table_sort_key("Account"))));
+    BOOST_CHECK_EQUAL(by_account.get<variant::Int32>(0, 0), -500);
+    BOOST_CHECK_EQUAL(by_account.get<variant::Int32>(0, rows - 1), 500);
+    BOOST_CHECK_EQUAL(by_account.get<variant::Int64>(4, 0), 0);
+
+    // sorting an empty table leaves it empty
+    variant empty(variant::DataTable);
+    empty.add_column(variant::Int32, "Account");
+    BOOST_CHECK(empty.sort(std::vector<data_table_sort_key>(1, data_table_sort_key("Account"))).empty());
+
+    BOOST_CHECK_THROW(dt.sort(std::vector<data_table_sort_key>()), variant_error);
+    BOOST_CHECK_THROW(dt.sort(std::vector<data_table_sort_key>(1, data_table_sort_key("Missing"))), variant_error);
+    BOOST_CHECK_THROW(variant(variant::List).sorted_view(keys), variant_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_sort_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const size_t rows = 10000000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    std::vector<boost::int32_t> account(rows);
+    std::vector<double> price(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        account[i] = static_cast<boost::int32_t>((i * 7919) % 100000);
+        price[i] = 0.01 * ((i * 104729) % 10000);
+    }
+
+    variant dt(variant::DataTable, rows);
+    dt.add_column(variant::Int32,  "Account")
+      .add_column(variant::Double, "Price");
+    dt.columns()[0].assign<variant::Int32>(std::move(account));
+    dt.columns()[1].assign<variant::Double>(std::move(price));
+
+    std::vector<data_table_sort_key> keys;
+    keys.push_back(data_table_sort_key("Account"));
+    keys.push_back(data_table_sort_key("Price", data_table_sort_key::Descending));
+
+    start = boost::chrono::high_resolution_clock::now();
+    const data_table_selection view(dt.sorted_view(keys));
+    finish = boost::chrono::high_resolution_clock::now();
+    duration_checkpoint<duration_resolution>(std::cout, "Permutation", "Sort", start, finish);
+
+    start = boost::chrono::high_resolution_clock::now();
+    dt.sort(keys);
+    finish = boost::chrono::high_resolution_clock::now();
+    duration_checkpoint<duration_resolution>(std::cout, "Sort and gather", "Sort", start, finish);
+
+    BOOST_CHECK_EQUAL(dt.columns()[0].begin<variant::Int32>()[0], 0);
+    BOOST_CHECK_EQUAL(dt.columns()[0].begin<variant::Int32>()[rows - 1], 99999);
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_view)
+{
+    const boost::gregorian::date initial_date(2020, 1, 1);
+
+    // enough rows for the columns to be written in parallel
+    static const int rows = 20000;
+
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int32,  "Id")
+      .add_column(variant::String, "Side", data_table_column_base::DictionaryEncoding)
+      .add_column(variant::String, "Note", data_table_column_base::ArenaEncoding)
+      .add_column(variant::Double, "Price")
+      .add_column(variant::Date,   "Day")
+      .add_column(variant::List,   "Extra");
+
+    for (int i = 0; i < rows; ++i)
+    {
+        variant extra(variant::List);
+        extra.push_back(variant(i));
+        dt.push_back(make_row(i, detail::string(i % 3 == 0 ? "buy" : "sell"), detail::string(i % 2 == 0 ? "note" : "a longer note"), 0.5 * i, initial_date + boost::gregorian::days(i % 7), extra));
+    }
+
+    const data_table_view all(dt.view());
+    BOOST_CHECK_EQUAL(all.size(), static_cast<size_t>(rows));
+    BOOST_CHECK_EQUAL(all.column_count(), 6u);
+    BOOST_CHECK(all.table().compare(dt) == 0);
+
+    // slices and column subsets refer to the table's own storage
+    std::vector<std::string> names;
+    names.push_back("Price");
+    names.push_back("Id");
+
+    const data_table_view page(all.slice(100, 50).select(names));
+    BOOST_CHECK_EQUAL(page.size(), 50u);
+    BOOST_CHECK_EQUAL(page.offset(), 100u);
+    BOOST_REQUIRE_EQUAL(page.column_count(), 2u);
+    BOOST_CHECK_EQUAL(page.column(1).name(), "Id");
+    BOOST_CHECK(&page.column(0) == &dt.columns()[3]);
+    BOOST_CHECK_EQUAL(page.get<variant::Double>(0, 0), 50.0);
+    BOOST_CHECK_EQUAL(page.get<variant::Int32>(1, 49), 149);
+
+    int expected_id = 100;
+    for (data_table_const_iterator<variant::Double, variant::Int32> itr(page.begin<variant::Double, variant::Int32>()), end(page.end<variant::Double, variant::Int32>()); itr != end; ++itr)
+    {
+        BOOST_CHECK_EQUAL(itr.get<0>(), 0.5 * expected_id);
+        BOOST_CHECK_EQUAL(itr.get<1>(), expected_id);
+        ++expected_id;
+    }
+    BOOST_CHECK_EQUAL(expected_id, 150);
+
+    // slices of slices, clipped to the end
+    BOOST_CHECK_EQUAL(page.slice(10, 5).offset(), 110u);
+    BOOST_CHECK_EQUAL(page.slice(40, 20).size(), 10u);
+    BOOST_CHECK(page.slice(60, 5).empty());
+    BOOST_CHECK_EQUAL(all.slice(rows - 3, 10).size(), 3u);
+
+    const variant copy(page.table());
+    BOOST_REQUIRE_EQUAL(copy.size(), 50u);
+    BOOST_CHECK_EQUAL(copy.columns()[1].begin<variant::Int32>()[0], 100);
+
+    // only the rows and columns of the view are serialized
+    const data_table_view slices[] = { all.slice(0, 10), all.slice(rows - 15000, 15000), all.slice(7, 12345), all.slice(rows, 0) };
+    const int modes[] = {
+        binary_mode::Default,
+        binary_mode::Compact,
+        binary_mode::ParallelColumns,
+        binary_mode::ParallelColumns | binary_mode::SubtreeLengths
+    };
+    for (size_t s = 0; s < sizeof(slices)/sizeof(slices[0]); ++s)
+    {
+        for (size_t m = 0; m < sizeof(modes)/sizeof(modes[0]); ++m)
+        {
+            std::ostringstream oss;
+            binary_writer writer(oss, modes[m]);
+            writer << slices[s];
+
+            std::istringstream iss(oss.str());
+            binary_reader reader(iss);
+            variant result;
+            reader >> result;
+
+            BOOST_CHECK(result.compare(slices[s].table()) == 0);
+        }
+    }
+
+    // aggregation over a view
+    const data_table_view middle(all.slice(1000, 5000));
+    std::vector<data_table_aggregate> aggregates;
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Count));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Sum, "Price"));
+    aggregates.push_back(data_table_aggregate(data_table_aggregate::Min, "Id"));
+
+    const std::vector<std::string> keys(1, "Side");
+    const variant grouped(middle.group_by(keys, aggregates));
+    BOOST_CHECK(grouped.compare(middle.table().group_by(keys, aggregates)) == 0);
+    BOOST_REQUIRE_EQUAL(grouped.size(), 2u);
+    BOOST_CHECK_EQUAL(grouped.columns()[0].begin<variant::String>()[0].value(), std::string("sell"));
+    BOOST_CHECK_EQUAL(grouped.columns()[3].begin<variant::Int64>()[1], 1002);
+
+    BOOST_CHECK_THROW(all.select(std::vector<std::string>(1, "Missing")), variant_error);
+    BOOST_CHECK_THROW(page.column(2), variant_error);
+    BOOST_CHECK_THROW(variant(variant::List).view(), variant_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_chunks)
+{
+    data_table_chunks chunks(1000);
+    chunks.add_column(variant::Int32,  "Id")
+          .add_column(variant::String, "Side", data_table_column_base::DictionaryEncoding)
+          .add_column(variant::Double, "Price");
+
+    variant expected(variant::DataTable);
+    expected.add_column(variant::Int32,  "Id")
+            .add_column(variant::String, "Side", data_table_column_base::DictionaryEncoding)
+            .add_column(variant::Double, "Price");
+
+    typedef data_table_row<variant::Int32, variant::String, variant::Double>::type row_type;
+    for (int i = 0; i < 2500; ++i)
+    {
+        const row_type row(make_row(i, detail::string(i % 3 == 0 ? "buy" : "sell"), 0.5 * i));
+        chunks.push_back(row);
+        expected.push_back(row);
+    }
+
+    // rows already held never move
+    const boost::int32_t* first_id(&*chunks.chunk(0).columns()[0].begin<variant::Int32>());
+
+    std::vector<row_type> bulk;
+    for (int i = 2500; i < 4200; ++i)
+    {
+        bulk.push_back(make_row(i, detail::string(i % 3 == 0 ? "buy" : "sell"), 0.5 * i));
+        expected.push_back(bulk.back());
+    }
+    chunks.append(bulk.begin(), bulk.end());
+
+    BOOST_CHECK(&*chunks.chunk(0).columns()[0].begin<variant::Int32>() == first_id);
+    BOOST_CHECK_EQUAL(chunks.size(), 4200u);
+    BOOST_REQUIRE_EQUAL(chunks.chunk_count(), 5u);
+    BOOST_CHECK_EQUAL(chunks.chunk(2).size(), 1000u);
+    BOOST_CHECK_EQUAL(chunks.chunk(4).size(), 200u);
+    BOOST_CHECK_EQUAL(chunks.chunk(3).columns()[0].begin<variant::Int32>()[0], 3000);
+
+    // each chunk is a DataTable in its own right
+    std::ostringstream oss;
+    binary_writer writer(oss);
+    writer << chunks.chunk(1);
+
+    std::istringstream iss(oss.str());
+    binary_reader reader(iss);
+    variant chunk;
+    reader >> chunk;
+    BOOST_CHECK(chunk.compare(chunks.chunk(1)) == 0);
+
+    const variant released(chunks.release());
+    BOOST_CHECK(released.compare(expected) == 0);
+    BOOST_CHECK(released.columns()[1].encoding() == data_table_column_base::DictionaryEncoding);
+    BOOST_CHECK(chunks.empty());
+    BOOST_CHECK_EQUAL(chunks.chunk_count(), 0u);
+
+    // the columns remain for further rows
+    chunks.push_back(make_row(1, detail::string("buy"), 1.0));
+    BOOST_CHECK_EQUAL(chunks.release().size(), 1u);
+
+    chunks.push_back(make_row(2, detail::string("sell"), 2.0));
+    BOOST_CHECK_THROW(chunks.add_column(variant::Int32, "Qty"), variant_error);
+    BOOST_CHECK_THROW(chunks.chunk(1), std::exception);
+    BOOST_CHECK_THROW(data_table_chunks(0), variant_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_chunks_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const int rows = 20000000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    typedef data_table_row<variant::Int32, variant::Int64, variant::Double>::type row_type;
+
+    {
+        variant dt(variant::DataTable);
+        dt.add_column(variant::Int32,  "Account")
+          .add_column(variant::Int64,  "Qty")
+          .add_column(variant::Double, "Price");
+
+        start = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < rows; ++i)
+        {
+            dt.push_back(row_type(make_row(i % 1000, static_cast<boost::int64_t>(i), 0.01 * i)));
+        }
+        finish = boost::chrono::high_resolution_clock::now();
+        duration_checkpoint<duration_resolution>(std::cout, "DataTable", "Append", start, finish);
+    }
+
+    {
+        data_table_chunks chunks;
+        chunks.add_column(variant::Int32,  "Account")
+              .add_column(variant::Int64,  "Qty")
+              .add_column(variant::Double, "Price");
+
+        start = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < rows; ++i)
+        {
+            chunks.push_back(row_type(make_row(i % 1000, static_cast<boost::int64_t>(i), 0.01 * i)));
+        }
+        finish = boost::chrono::high_resolution_clock::now();
+        duration_checkpoint<duration_resolution>(std::cout, "Chunks", "Append", start, finish);
+
+        start = boost::chrono::high_resolution_clock::now();
+        const variant dt(chunks.release());
+        finish = boost::chrono::high_resolution_clock::now();
+        duration_checkpoint<duration_resolution>(std::cout, "Chunks", "Release", start, finish);
+
+        BOOST_CHECK_EQUAL(dt.size(), static_cast<size_t>(rows));
+    }
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_index)
+{
+    const boost::gregorian::date initial_date(2020, 1, 1);
+
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int32,  "Id")
+      .add_column(variant::String, "Symbol", data_table_column_base::DictionaryEncoding)
+      .add_column(variant::Date,   "Day");
+
+    const char* symbols[] = { "ABC", "DEF", "GHI" };
+    for (int i = 0; i < 100; ++i)
+    {
+        dt.push_back(make_row(i % 10, detail::string(symbols[i % 3]), initial_date + boost::gregorian::days(99 - i)));
+    }
+
+    BOOST_CHECK_THROW(dt.find("Id", variant(3)), variant_error);
+
+    dt.add_index("Id")
+      .add_index("Symbol")
+      .add_index("Day", SortedIndex);
+
+    // equality lookups return rows in row order
+    std::vector<size_t> rows(dt.find("Id", variant(3)));
+    BOOST_REQUIRE_EQUAL(rows.size(), 10u);
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(rows[i], 3 + 10 * i);
+    }
+
+    rows = dt.find("Symbol", variant("DEF"));
+    BOOST_REQUIRE_EQUAL(rows.size(), 33u);
+    BOOST_CHECK_EQUAL(rows.front(), 1u);
+    BOOST_CHECK_EQUAL(rows.back(), 97u);
+    BOOST_CHECK(dt.find("Symbol", variant("XYZ")).empty());
+    BOOST_CHECK(dt.find("Id", variant(10)).empty());
+
+    rows = dt.find("Day", variant(initial_date));
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_CHECK_EQUAL(rows[0], 99u);
+
+    // range lookups return rows in order of value
+    rows = dt.equal_range("Day", variant(initial_date + boost::gregorian::days(10)), variant(initial_date + boost::gregorian::days(13)));
+    BOOST_REQUIRE_EQUAL(rows.size(), 3u);
+    BOOST_CHECK_EQUAL(rows[0], 89u);
+    BOOST_CHECK_EQUAL(rows[2], 87u);
+    BOOST_CHECK(dt.equal_range("Day", variant(initial_date + boost::gregorian::days(13)), variant(initial_date)).empty());
+    BOOST_CHECK_THROW(dt.equal_range("Id", variant(1), variant(2)), variant_error);
+
+    // appended rows are picked up by indexes already built
+    for (int i = 100; i < 120; ++i)
+    {
+        dt.push_back(make_row(i % 10, detail::string(symbols[i % 3]), initial_date + boost::gregorian::days(i)));
+    }
+
+    rows = dt.find("Id", variant(3));
+    BOOST_REQUIRE_EQUAL(rows.size(), 12u);
+    BOOST_CHECK_EQUAL(rows.back(), 113u);
+
+    rows = dt.equal_range("Day", variant(initial_date + boost::gregorian::days(99)), variant(initial_date + boost::gregorian::days(101)));
+    BOOST_REQUIRE_EQUAL(rows.size(), 2u);
+    BOOST_CHECK_EQUAL(rows[0], 0u);
+    BOOST_CHECK_EQUAL(rows[1], 100u);
+
+    // copies of the table carry their own indexes, and sorting rebuilds them
+    variant copy(dt);
+    std::vector<data_table_sort_key> keys;
+    keys.push_back(data_table_sort_key("Day"));
+    copy.sort(keys);
+
+    rows = copy.find("Day", variant(initial_date));
+    BOOST_REQUIRE_EQUAL(rows.size(), 1u);
+    BOOST_CHECK_EQUAL(rows[0], 0u);
+    BOOST_CHECK_EQUAL(dt.find("Day", variant(initial_date))[0], 99u);
+
+    // numbers are converted to the type of the column
+    BOOST_CHECK_EQUAL(dt.find("Id", variant(static_cast<boost::int64_t>(7))).size(), 12u);
+
+    dt.drop_index("Id");
+    BOOST_CHECK_THROW(dt.find("Id", variant(3)), variant_error);
+    BOOST_CHECK_THROW(dt.add_index("Missing"), variant_error);
+    BOOST_CHECK_THROW(variant(variant::List).add_index("Id"), variant_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_index_rebuild)
+{
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int32,  "Id")
+      .add_column(variant::Double, "Price");
+
+    const double nan(std::numeric_limits<double>::quiet_NaN());
+    const double prices[] = { nan, 3.0, 1.0, nan, 2.0, 1.0 };
+    for (int i = 0; i < 6; ++i)
+    {
+        dt.push_back(boost::make_tuple(i, prices[i]));
+    }
+
+    dt.add_index("Id")
+      .add_index("Price", SortedIndex);
+
+    // NaNs are ordered after every other value
+    std::vector<size_t> rows(dt.equal_range("Price", variant(1.0), variant(3.5)));
+    BOOST_REQUIRE_EQUAL(rows.size(), 4u);
+    BOOST_CHECK_EQUAL(rows[0], 2u);
+    BOOST_CHECK_EQUAL(rows[1], 5u);
+    BOOST_CHECK_EQUAL(rows[2], 4u);
+    BOOST_CHECK_EQUAL(rows[3], 1u);
+
+    for (int i = 6; i < 12; ++i)
+    {
+        dt.push_back(boost::make_tuple(i, prices[i % 6]));
+    }
+    BOOST_CHECK_EQUAL(dt.equal_range("Price", variant(1.0), variant(2.0)).size(), 4u);
+    BOOST_CHECK_EQUAL(dt.find("Price", variant(3.0)).size(), 2u);
+
+    // values changed through the columns are seen by the indexes
+    BOOST_CHECK_EQUAL(dt.find("Id", variant(3)).size(), 1u);
+    dt.columns()[0].begin<variant::Int32>()[3] = 7;
+    rows = dt.find("Id", variant(7));
+    BOOST_REQUIRE_EQUAL(rows.size(), 2u);
+    BOOST_CHECK_EQUAL(rows[0], 3u);
+    BOOST_CHECK(dt.find("Id", variant(3)).empty());
+
+    std::vector<double> replaced(12, 5.0);
+    dt.columns()[1].assign<variant::Double>(std::move(replaced));
+    BOOST_CHECK_EQUAL(dt.find("Price", variant(5.0)).size(), 12u);
+    BOOST_CHECK(dt.equal_range("Price", variant(1.0), variant(3.5)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_index_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const int rows = 5000000;
+    static const int lookups = 1000;
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::microseconds duration_resolution;
+
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int64,  "Id")
+      .add_column(variant::Double, "Price");
+
+    dt.reserve(rows);
+    for (int i = 0; i < rows; ++i)
+    {
+        dt.push_back(make_row(static_cast<boost::int64_t>((i * 7919LL) % rows), 0.01 * i));
+    }
+
+    size_t found = 0;
+    start = boost::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 10; ++i)
+    {
+        const boost::int64_t id = (i * 104729LL) % rows;
+        for (data_table_const_iterator<variant::Int64> itr(dt.begin<variant::Int64>()), end(dt.end<variant::Int64>()); itr != end; ++itr)
+        {
+            found += (itr.get<0>() == id) ? 1 : 0;
+        }
+    }
+    finish = boost::chrono::high_resolution_clock::now();
+    duration_checkpoint<duration_resolution>(std::cout, "Scan", "10 lookups", start, finish);
+    BOOST_CHECK_EQUAL(found, 10u);
+
+    const data_table_index_t types[] = { HashIndex, SortedIndex };
+    for (size_t t = 0; t < 2; ++t)
+    {
+        dt.drop_index("Id").add_index("Id", types[t]);
+
+        start = boost::chrono::high_resolution_clock::now();
+        dt.find("Id", variant(static_cast<boost::int64_t>(0)));
+        finish = boost::chrono::high_resolution_clock::now();
+        duration_checkpoint<duration_resolution>(std::cout, t == 0 ? "Hash" : "Sorted", "Build", start, finish);
+
+        found = 0;
+        start = boost::chrono::high_resolution_clock::now();
+        for (int i = 0; i < lookups; ++i)
+        {
+            found += dt.find("Id", variant(static_cast<boost::int64_t>((i * 104729LL) % rows))).size();
+        }
+        finish = boost::chrono::high_resolution_clock::now();
+        duration_checkpoint<duration_resolution>(std::cout, t == 0 ? "Hash" : "Sorted", "1000 lookups", start, finish);
+        BOOST_CHECK_EQUAL(found, static_cast<size_t>(lookups));
+    }
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_file)
+{
+    const boost::gregorian::date initial_date(2020, 1, 1);
+    const std::string path("protean_test_data_table.ptdt");
+
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Int32,   "Id")
+      .add_column(variant::String,  "Symbol", data_table_column_base::DictionaryEncoding)
+      .add_column(variant::Double,  "Price")
+      .add_column(variant::Date,    "Day")
+      .add_column(variant::Boolean, "Flag");
+
+    const char* symbols[] = { "ABC", "DEF", "GHI" };
+    for (int i = 0; i < 1000; ++i)
+    {
+        dt.push_back(make_row(i, detail::string(symbols[i % 3]), 0.5 * i, initial_date + boost::gregorian::days(i / 10), i % 2 == 0));
+    }
+
+    data_table_file::write(path, dt.view(), 100);
+    {
+        const data_table_file file(path);
+        BOOST_CHECK_EQUAL(file.size(), 1000u);
+        BOOST_REQUIRE_EQUAL(file.column_count(), 5u);
+        BOOST_CHECK_EQUAL(file.column_name(1), "Symbol");
+        BOOST_CHECK_EQUAL(file.column_type(3), variant::Date);
+        BOOST_CHECK_EQUAL(file.column_index("Price"), 2u);
+
+        // row groups and their statistics
+        BOOST_REQUIRE_EQUAL(file.row_group_count(), 10u);
+        BOOST_CHECK_EQUAL(file.row_group_offset(3), 300u);
+        BOOST_CHECK_EQUAL(file.row_group_size(9), 100u);
+        BOOST_CHECK_EQUAL(file.min(3, 0).as<boost::int32_t>(), 300);
+        BOOST_CHECK_EQUAL(file.max(3, 0).as<boost::int32_t>(), 399);
+        BOOST_CHECK_EQUAL(file.min(0, 1).as<std::string>(), "ABC");
+        BOOST_CHECK(file.max(0, 3).as<variant::date_t>() == initial_date + boost::gregorian::days(9));
+
+        // numeric columns are read in place, aligned
+        const boost::iterator_range<const double*> prices(file.values<variant::Double>(2, 2));
+        BOOST_REQUIRE_EQUAL(prices.size(), 100u);
+        BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(prices.begin()) % 64, 0u);
+        BOOST_CHECK_EQUAL(prices[5], 102.5);
+        BOOST_CHECK_THROW(file.values<variant::Double>(0, 0), variant_error);
+        BOOST_CHECK_THROW(file.values<variant::Int32>(0, 1), variant_error);
+
+        BOOST_CHECK_EQUAL(file.value(0, 567).as<boost::int32_t>(), 567);
+        BOOST_CHECK_EQUAL(file.value(1, 569).as<std::string>(), "GHI");
+        BOOST_CHECK(file.value(3, 999).as<variant::date_t>() == initial_date + boost::gregorian::days(99));
+        BOOST_CHECK_EQUAL(file.value(4, 3).as<bool>(), false);
+
+        // scans skip the row groups whose statistics rule them out
+        std::vector<size_t> groups(file.row_groups("Id", variant(250), variant(420)));
+        BOOST_REQUIRE_EQUAL(groups.size(), 3u);
+        BOOST_CHECK_EQUAL(groups[0], 2u);
+        BOOST_CHECK_EQUAL(groups[2], 4u);
+
+        std::vector<size_t> rows(file.scan("Id", variant(250), variant(420)));
+        BOOST_REQUIRE_EQUAL(rows.size(), 170u);
+        BOOST_CHECK_EQUAL(rows.front(), 250u);
+        BOOST_CHECK_EQUAL(rows.back(), 419u);
+
+        rows = file.scan("Day", variant(initial_date + boost::gregorian::days(50)), variant(initial_date + boost::gregorian::days(51)));
+        BOOST_REQUIRE_EQUAL(rows.size(), 10u);
+        BOOST_CHECK_EQUAL(rows.front(), 500u);
+        BOOST_CHECK_EQUAL(file.row_groups("Day", variant(initial_date + boost::gregorian::days(50)), variant(initial_date + boost::gregorian::days(51))).size(), 1u);
+
+        rows = file.scan("Symbol", variant("DEF"), variant("DEG"));
+        BOOST_REQUIRE_EQUAL(rows.size(), 333u);
+        BOOST_CHECK_EQUAL(rows.front(), 1u);
+        BOOST_CHECK(file.scan("Id", variant(420), variant(250)).empty());
+
+        // loading copies the rows into a DataTable
+        BOOST_CHECK(file.table().compare(dt) == 0);
+
+        const variant group(file.table(7));
+        BOOST_REQUIRE_EQUAL(group.size(), 100u);
+        BOOST_CHECK_EQUAL(group.columns()[0].begin<variant::Int32>()[0], 700);
+    }
+
+    // slices of a table are written as they are
+    data_table_file::write(path, dt.view().slice(995, 100));
+    {
+        const data_table_file file(path);
+        BOOST_CHECK_EQUAL(file.size(), 5u);
+        BOOST_CHECK_EQUAL(file.row_group_count(), 1u);
+        BOOST_CHECK_EQUAL(file.value(0, 0).as<boost::int32_t>(), 995);
+    }
+    std::remove(path.c_str());
+
+    variant lists(variant::DataTable);
+    lists.add_column(variant::List, "Extra");
+    BOOST_CHECK_THROW(data_table_file::write(path, lists.view()), variant_error);
+    std::remove(path.c_str());
+
+    BOOST_CHECK_THROW(data_table_file file("protean_test_missing.ptdt"), variant_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_file_special_values)
+{
+    const std::string path("protean_test_data_table_special.ptdt");
+    const double nan(std::numeric_limits<double>::quiet_NaN());
+    const boost::posix_time::ptime initial_time(boost::gregorian::date(2020, 1, 1));
+
+    variant dt(variant::DataTable);
+    dt.add_column(variant::Double,   "Price")
+      .add_column(variant::DateTime, "Time");
+
+    for (int i = 0; i < 30; ++i)
+    {
+        // the first group leads with a NaN, the last holds nothing else
+        const double price(i == 0 || i >= 20 ? nan : static_cast<double>(i));
+        dt.push_back(boost::make_tuple(price, initial_time + boost::posix_time::seconds(i)));
+    }
+    dt.columns()[1].begin<variant::DateTime>()[12] = variant::date_time_t(boost::posix_time::pos_infin);
+    dt.columns()[1].begin<variant::DateTime>()[15] = variant::date_time_t(boost::posix_time::not_a_date_time);
+
+    data_table_file::write(path, dt.view(), 10);
+    {
+        const data_table_file file(path);
+
+        BOOST_CHECK_EQUAL(file.min(0, 0).as<double>(), 1.0);
+        BOOST_CHECK_EQUAL(file.max(0, 0).as<double>(), 9.0);
+        BOOST_CHECK(file.min(2, 0).is<variant::None>());
+
+        std::vector<size_t> rows(file.scan("Price", variant(2.0), variant(12.0)));
+        BOOST_REQUIRE_EQUAL(rows.size(), 10u);
+        BOOST_CHECK_EQUAL(rows.front(), 2u);
+        BOOST_CHECK_EQUAL(rows.back(), 11u);
+        BOOST_CHECK(file.scan("Price", variant(20.0), variant(30.0)).empty());
+
+        // special times are kept, and leave the statistics of their group unknown, but
+        // cannot be held in a variant
+        BOOST_CHECK_THROW(file.value(1, 12), variant_error);
+        BOOST_CHECK(file.max(0, 1).as<variant::date_time_t>() == initial_time + boost::posix_time::seconds(9));
+        BOOST_CHECK(file.min(1, 1).is<variant::None>());
+
+        rows = file.scan("Time", variant(initial_time + boost::posix_time::seconds(11)), variant(initial_time + boost::posix_time::seconds(14)));
+        BOOST_REQUIRE_EQUAL(rows.size(), 2u);
+        BOOST_CHECK_EQUAL(rows[0], 11u);
+        BOOST_CHECK_EQUAL(rows[1], 13u);
+
+        const variant table(file.table());
+        BOOST_CHECK(table.columns()[1].begin<variant::DateTime>()[12].is_pos_infinity());
+        BOOST_CHECK(table.columns()[1].begin<variant::DateTime>()[15].is_not_a_date_time());
+        BOOST_CHECK_EQUAL(table.columns()[0].begin<variant::Double>()[5], 5.0);
+    }
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_file_performance)
+{
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const int rows = 100000000;
+    const std::string path("protean_test_data_table_performance.ptdt");
+
+    boost::chrono::high_resolution_clock::time_point start;
+    boost::chrono::high_resolution_clock::time_point finish;
+    typedef boost::chrono::milliseconds duration_resolution;
+
+    {
+        variant dt(variant::DataTable);
+        dt.add_column(variant::Int64,  "Time")
+          .add_column(variant::Double, "Price");
+
+        dt.reserve(rows);
+        for (int i = 0; i < rows; ++i)
+        {
+            dt.push_back(make_row(static_cast<boost::int64_t>(i), 0.01 * (i % 1000)));
+        }
+
+        start = boost::chrono::high_resolution_clock::now();
+        data_table_file::write(path, dt.view());
+        finish = boost::chrono::high_resolution_clock::now();
+        duration_checkpoint<duration_resolution>(std::cout, "File", "Write", start, finish);
+    }
+
+    start = boost::chrono::high_resolution_clock::now();
+    const data_table_file file(path);
+    finish = boost::chrono::high_resolution_clock::now();
+    duration_checkpoint<duration_resolution>(std::cout, "File", "Open", start, finish);
+
+    start = boost::chrono::high_resolution_clock::now();
+    const std::vector<size_t> found(file.scan("Time", variant(static_cast<boost::int64_t>(rows / 2)), variant(static_cast<boost::int64_t>(rows / 2 + 1000))));
+    finish = boost::chrono::high_resolution_clock::now();
+    duration_checkpoint<duration_resolution>(std::cout, "File", "Scan", start, finish);
+    BOOST_CHECK_EQUAL(found.size(), 1000u);
+
+    std::remove(path.c_str());
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_data_table_arrow)
+{
+    const boost::posix_time::ptime initial_time(boost::gregorian::date(2020, 1, 1), boost::posix_time::hours(9));
+
+    boost::shared_ptr<variant> dt(new variant(variant::DataTable));
+    dt->add_column(variant::Int32,    "Id")
+       .add_column(variant::Double,   "Price")
+       .add_column(variant::Boolean,  "Flag")
+       .add_column(variant::String,   "Symbol", data_table_column_base::DictionaryEncoding)
+       .add_column(variant::Date,     "Day")
+       .add_column(variant::DateTime, "Stamp")
+       .add_column(variant::Time,     "Elapsed");
+
+    const char* symbols[] = { "ABC", "DEFG", "" };
+    for (int i = 0; i < 20; ++i)
+    {
+        dt->push_back(make_row(i, 0.5 * i, i % 3 == 0, detail::string(symbols[i % 3]), initial_time.date() + boost::gregorian::days(i),
+            initial_time + boost::posix_time::microseconds(i), boost::posix_time::milliseconds(i)));
+    }
+
+    ArrowArray array;
+    ArrowSchema schema;
+    export_arrow(dt, &array, &schema);
+
+    BOOST_CHECK_EQUAL(std::string(schema.format), "+s");
+    BOOST_REQUIRE_EQUAL(schema.n_children, 7);
+    BOOST_CHECK_EQUAL(std::string(schema.children[0]->name), "Id");
+    BOOST_CHECK_EQUAL(std::string(schema.children[0]->format), "i");
+    BOOST_CHECK_EQUAL(std::string(schema.children[2]->format), "b");
+    BOOST_CHECK_EQUAL(std::string(schema.children[3]->format), "u");
+    BOOST_CHECK_EQUAL(std::string(schema.children[4]->format), "tdD");
+    BOOST_CHECK_EQUAL(std::string(schema.children[5]->format), "tsu:");
+    BOOST_CHECK_EQUAL(std::string(schema.children[6]->format), "tDu");
+
+    BOOST_CHECK_EQUAL(array.length, 20);
+    BOOST_REQUIRE_EQUAL(array.n_children, 7);
+
+    // fixed-width columns share the table's buffers
+    BOOST_CHECK(array.children[1]->buffers[1] == &dt->columns()[1].begin<variant::Double>()[0]);
+
+    // booleans are bitmaps, dates days since the epoch and strings utf8 with offsets
+    const boost::uint8_t* flags(static_cast<const boost::uint8_t*>(array.children[2]->buffers[1]));
+    BOOST_CHECK_EQUAL(flags[0], 0x49);
+    BOOST_CHECK_EQUAL(static_cast<const boost::int32_t*>(array.children[4]->buffers[1])[1], 18263);
+    const boost::int32_t* offsets(static_cast<const boost::int32_t*>(array.children[3]->buffers[1]));
+    BOOST_CHECK_EQUAL(offsets[2], 7);
+    BOOST_CHECK_EQUAL(std::string(static_cast<const char*>(array.children[3]->buffers[2]) + offsets[1], 4), "DEFG");
+
+    // the exported array holds on to the table
+    const variant copy(*dt);
+    dt.reset();
+
+    const variant imported(import_arrow(&array, &schema));
+    BOOST_CHECK(array.release == nullptr);
+    BOOST_CHECK(schema.release == nullptr);
+    BOOST_CHECK(imported.compare(copy) == 0);
+
+    // typed arrays of numbers are exported as primitive arrays
+    typed_array typed(3, variant::Int64);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        typed[i] = static_cast<boost::int64_t>(10 * i);
+    }
+    boost::shared_ptr<variant> values(new variant(typed));
+
+    export_arrow(values, &array, &schema);
+    BOOST_CHECK_EQUAL(std::string(schema.format), "l");
+    BOOST_CHECK_EQUAL(static_cast<const boost::int64_t*>(array.buffers[1])[2], 20);
+
+    const variant imported_values(import_arrow(&array, &schema));
+    BOOST_REQUIRE(imported_values.is<variant::Array>());
+    BOOST_CHECK(imported_values.compare(*values) == 0);
+
+    // nulls and offsets of arrays from other producers
+    ArrowSchema child_schema = { "s", "Small", nullptr, ARROW_FLAG_NULLABLE, 0, nullptr, nullptr, [](ArrowSchema* schema) { schema->release = nullptr; }, nullptr };
+    ArrowSchema* child_schemas[] = { &child_schema };
+    ArrowSchema struct_schema = { "+s", "", nullptr, 0, 1, child_schemas, nullptr, [](ArrowSchema* schema) { schema->release = nullptr; }, nullptr };
+
+    const boost::uint8_t validity[] = { 0xfb };
+    const boost::int16_t smalls[] = { 1, 2, 3, 4, 5, 6 };
+    const void* child_buffers[] = { validity, smalls };
+    ArrowArray child_array = { 4, 1, 1, 2, 0, child_buffers, nullptr, nullptr, [](ArrowArray* array) { array->release = nullptr; }, nullptr };
+    ArrowArray* child_arrays[] = { &child_array };
+    ArrowArray struct_array = { 3, 0, 1, 1, 1, nullptr, child_arrays, nullptr, [](ArrowArray* array) { array->release = nullptr; }, nullptr };
+
+    const variant small(import_arrow(&struct_array, &struct_schema));
+    BOOST_REQUIRE_EQUAL(small.size(), 3u);
+    BOOST_CHECK_EQUAL(small.columns()[0].name(), "Small");
+    BOOST_CHECK_EQUAL(small.columns()[0].begin<variant::Int32>()[0], 0);
+    BOOST_CHECK_EQUAL(small.columns()[0].begin<variant::Int32>()[1], 4);
+    BOOST_CHECK(struct_array.release == nullptr);
+
+    variant lists(variant::DataTable);
+    lists.add_column(variant::List, "Extra");
+    BOOST_CHECK_THROW(export_arrow(boost::shared_ptr<variant>(new variant(lists)), &array, &schema), variant_error);
+    BOOST_CHECK_THROW(export_arrow(boost::shared_ptr<variant>(new variant(1)), &array, &schema), variant_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,13 @@
 using boost::unit_test::test_suite;    
 
 #include <protean/variant.hpp>
+#include <protean/binary_reader.hpp>
+#include <protean/binary_writer.hpp>
+#include <protean/timeseries_view.hpp>
+#include <protean/timeseries_aggregate.hpp>
+#include <boost/chrono/chrono.hpp>
+#include <boost/chrono/chrono_io.hpp>
+#include <iostream>
 using namespace protean;
 
 BOOST_AUTO_TEST_SUITE(list_suite);
@@ -86,4 +93,402 @@ BOOST_AUTO_TEST_CASE(test_timeseries_iterator)
     BOOST_CHECK(begin==end);
 }
 
+BOOST_AUTO_TEST_CASE(test_timeseries_columnar)
+{
+    const variant::date_time_t t0(variant::date_t(2020, 3, 1), boost::posix_time::microseconds(250));
+    const boost::posix_time::time_duration step(boost::posix_time::seconds(1));
+
+    // times round trip through ticks, special values included
+    BOOST_CHECK_EQUAL(detail::timeseries::to_ticks(variant::date_time_t(variant::date_t(1970, 1, 1))), 0);
+    BOOST_CHECK_EQUAL(detail::timeseries::from_ticks(detail::timeseries::to_ticks(t0)), t0);
+    BOOST_CHECK_EQUAL(detail::timeseries::from_ticks(detail::timeseries::to_ticks(variant::date_time_t(variant::date_t(1400, 1, 1)))),
+        variant::date_time_t(variant::date_t(1400, 1, 1)));
+    BOOST_CHECK(detail::timeseries::from_ticks(detail::timeseries::to_ticks(variant::date_time_t(boost::posix_time::pos_infin))).is_pos_infinity());
+    BOOST_CHECK(detail::timeseries::from_ticks(detail::timeseries::to_ticks(variant::date_time_t(boost::posix_time::neg_infin))).is_neg_infinity());
+    BOOST_CHECK(detail::timeseries::from_ticks(detail::timeseries::to_ticks(variant::date_time_t())).is_not_a_date_time());
+
+    // numbers of one type are held unboxed
+    detail::timeseries ts;
+    BOOST_CHECK_EQUAL(ts.value_type(), variant::None);
+    for (int i=0; i<5; ++i)
+    {
+        ts.append(t0 + step*i, variant(1.5*i));
+    }
+    BOOST_CHECK_EQUAL(ts.value_type(), variant::Double);
+    BOOST_REQUIRE_EQUAL(ts.size(), 5u);
+    BOOST_REQUIRE_EQUAL(ts.times().size(), 5u);
+    BOOST_CHECK_EQUAL(ts.times()[1] - ts.times()[0], step.ticks());
+    BOOST_REQUIRE_EQUAL(ts.values().size(), 5u);
+    BOOST_CHECK_EQUAL(ts.values().begin<variant::Double>()[3], 4.5);
+
+    variant copy;
+    BOOST_CHECK(ts.value(2, copy).is<variant::Double>());
+    BOOST_CHECK_EQUAL(ts.value(2, copy).as<double>(), 3.0);
+
+    // const iteration copies the values out
+    const detail::timeseries& cts(ts);
+    variant::const_iterator begin(cts.begin()), end(cts.end());
+    BOOST_CHECK_EQUAL(begin.time(), t0);
+    BOOST_CHECK_EQUAL(begin->as<double>(), 0.0);
+    ++begin; ++begin;
+    BOOST_CHECK_EQUAL(begin.time(), t0 + step*2);
+    BOOST_CHECK_EQUAL(begin->as<double>(), 3.0);
+    BOOST_CHECK_EQUAL(std::distance(variant::const_iterator(cts.begin()), variant::const_iterator(cts.end())), 5);
+
+    // copies hold their own column
+    detail::timeseries ts2(ts);
+    BOOST_CHECK_EQUAL(ts2.value_type(), variant::Double);
+    BOOST_CHECK_EQUAL(ts2.compare(ts), 0);
+    BOOST_CHECK_EQUAL(ts2.hash(0), ts.hash(0));
+
+    // a value of another type moves the values into variants
+    ts2.append(t0 + step*5, variant("six"));
+    BOOST_CHECK_EQUAL(ts2.value_type(), variant::Variant);
+    BOOST_REQUIRE_EQUAL(ts2.size(), 6u);
+    BOOST_CHECK_THROW(ts2.values(), variant_error);
+    BOOST_CHECK_EQUAL(ts2.value(3, copy).as<double>(), 4.5);
+    BOOST_CHECK_EQUAL(ts2.value(5, copy).as<std::string>(), "six");
+    BOOST_CHECK_EQUAL(ts.value_type(), variant::Double);
+    BOOST_CHECK(ts2.compare(ts)>0);
+
+    // boxed and unboxed series of the same points are equal and hash the same
+    detail::timeseries ts3;
+    for (int i=0; i<5; ++i)
+    {
+        ts3.push_back(t0 + step*i, variant(1.5*i));
+    }
+    BOOST_CHECK_EQUAL(ts3.value_type(), variant::Variant);
+    BOOST_CHECK_EQUAL(ts3.compare(ts), 0);
+    BOOST_CHECK_EQUAL(ts3.hash(0), ts.hash(0));
+
+    // values can be changed in place, and are unboxed again by the next append
+    ts.value(1) = variant(10.0);
+    BOOST_CHECK_EQUAL(ts.value_type(), variant::Variant);
+    BOOST_CHECK_EQUAL(ts.value(1, copy).as<double>(), 10.0);
+    ts.append(t0 + step*5, variant(7.5));
+    BOOST_CHECK_EQUAL(ts.value_type(), variant::Double);
+    BOOST_REQUIRE_EQUAL(ts.values().size(), 6u);
+    BOOST_CHECK_EQUAL(ts.values().begin<variant::Double>()[1], 10.0);
+
+    ts.value(2) = variant("three");
+    ts.append(t0 + step*6, variant(9.0));
+    BOOST_CHECK_EQUAL(ts.value_type(), variant::Variant);
+    BOOST_CHECK_EQUAL(ts.value(2, copy).as<std::string>(), "three");
+
+    // iterators over an empty series leave it to hold numbers unboxed
+    detail::timeseries fresh;
+    BOOST_CHECK(variant::iterator(fresh.begin())==variant::iterator(fresh.end()));
+    fresh.append(t0, variant(1.0));
+    BOOST_CHECK_EQUAL(fresh.value_type(), variant::Double);
+
+    ts.clear();
+    BOOST_CHECK(ts.empty());
+    BOOST_CHECK_EQUAL(ts.value_type(), variant::None);
+
+    // numeric series survive a binary round trip
+    variant v1(variant::TimeSeries);
+    for (int i=0; i<100; ++i)
+    {
+        v1.push_back(variant::date_time_t(variant::date_t(2020, 3, 1)) + step*i, variant(static_cast<boost::int64_t>(i*i)));
+    }
+
+    std::ostringstream oss;
+    binary_writer writer(oss);
+    writer << v1;
+
+    variant v2;
+    std::stringstream iss;
+    iss << oss.str();
+    binary_reader reader(iss);
+    reader >> v2;
+
+    BOOST_CHECK(v2.is<variant::TimeSeries>());
+    BOOST_CHECK(v1==v2);
+    BOOST_CHECK_EQUAL(v1.hash(), v2.hash());
+}
+
+BOOST_AUTO_TEST_CASE(test_timeseries_lookup)
+{
+    const variant::date_time_t t0(variant::date_t(2020, 3, 1), boost::posix_time::hours(9));
+    const boost::posix_time::time_duration step(boost::posix_time::seconds(10));
+
+    // a point every 10s, with two points at t0 + 50s
+    variant ts(variant::TimeSeries);
+    for (int i=0; i<10; ++i)
+    {
+        ts.push_back(t0 + step*i, variant(static_cast<boost::int64_t>(i)));
+        if (i==5)
+        {
+            ts.push_back(t0 + step*i, variant(static_cast<boost::int64_t>(50)));
+        }
+    }
+    BOOST_REQUIRE_EQUAL(ts.size(), 11u);
+
+    timeseries_view all(ts.series_view());
+    BOOST_CHECK_EQUAL(all.size(), 11u);
+    BOOST_CHECK_EQUAL(all.value_type(), variant::Int64);
+    BOOST_CHECK_EQUAL(all.time(10), t0 + step*9);
+    BOOST_CHECK_EQUAL(all.value(10).as<boost::int64_t>(), 9);
+    BOOST_CHECK_THROW(all.value(11), variant_error);
+
+    // lower_bound
+    timeseries_view lower(ts.lower_bound(t0 + step*5));
+    BOOST_CHECK_EQUAL(lower.offset(), 5u);
+    BOOST_CHECK_EQUAL(lower.size(), 6u);
+    BOOST_CHECK_EQUAL(ts.lower_bound(t0 + step*5 + boost::posix_time::seconds(1)).offset(), 7u);
+    BOOST_CHECK_EQUAL(ts.lower_bound(t0 - step).offset(), 0u);
+    BOOST_CHECK(ts.lower_bound(t0 + step*10).empty());
+
+    // at_or_before
+    timeseries_view point(ts.at_or_before(t0 + step*5 + boost::posix_time::seconds(9)));
+    BOOST_REQUIRE_EQUAL(point.size(), 1u);
+    BOOST_CHECK_EQUAL(point.time(0), t0 + step*5);
+    BOOST_CHECK_EQUAL(point.value(0).as<boost::int64_t>(), 50);
+    BOOST_CHECK_EQUAL(ts.at_or_before(t0 + step*3).value(0).as<boost::int64_t>(), 3);
+    BOOST_CHECK_EQUAL(ts.at_or_before(t0 + step*100).value(0).as<boost::int64_t>(), 9);
+    BOOST_CHECK(ts.at_or_before(t0 - boost::posix_time::seconds(1)).empty());
+
+    // range, half-open
+    timeseries_view range(ts.range(t0 + step*2, t0 + step*6));
+    BOOST_CHECK_EQUAL(range.offset(), 2u);
+    BOOST_REQUIRE_EQUAL(range.size(), 5u);
+    BOOST_CHECK_EQUAL(range.values<variant::Int64>().front(), 2);
+    BOOST_CHECK_EQUAL(range.values<variant::Int64>().back(), 50);
+    BOOST_CHECK_EQUAL(range.times().back() - range.times().front(), (step*3).ticks());
+    BOOST_CHECK(ts.range(t0 + step*6, t0 + step*2).empty());
+    BOOST_CHECK(ts.range(t0 + step*20, t0 + step*30).empty());
+
+    // lookups within a view
+    BOOST_CHECK_EQUAL(range.at_or_before(t0 + step*9).value(0).as<boost::int64_t>(), 50);
+    BOOST_CHECK(range.at_or_before(t0 + step).empty());
+    BOOST_CHECK_EQUAL(range.slice(1, 2).time(1), t0 + step*4);
+    BOOST_CHECK_EQUAL(range.slice(4, 10).size(), 1u);
+
+    variant copy(range.series());
+    BOOST_CHECK(copy.is<variant::TimeSeries>());
+    BOOST_CHECK_EQUAL(copy.size(), 5u);
+    BOOST_CHECK(copy.series_view().time(0)==t0 + step*2);
+
+    // points out of order are kept, but cannot be looked up
+    variant unordered(ts);
+    unordered.push_back(t0, variant(static_cast<boost::int64_t>(-1)));
+    BOOST_CHECK_THROW(unordered.lower_bound(t0), variant_error);
+    BOOST_CHECK_THROW(unordered.enforce_order(), variant_error);
+
+    // unless the order is enforced
+    ts.enforce_order();
+    BOOST_CHECK_THROW(ts.push_back(t0, variant(static_cast<boost::int64_t>(-1))), variant_error);
+    BOOST_CHECK_EQUAL(ts.size(), 11u);
+    ts.push_back(t0 + step*9, variant(static_cast<boost::int64_t>(90)));
+    BOOST_CHECK_EQUAL(ts.at_or_before(t0 + step*9).value(0).as<boost::int64_t>(), 90);
+
+    variant not_series(variant::List);
+    BOOST_CHECK_THROW(not_series.range(t0, t0 + step), variant_error);
+
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const int points = 10000000;
+    static const int lookups = 1000000;
+
+    variant ticks(variant::TimeSeries);
+    for (int i=0; i<points; ++i)
+    {
+        ticks.push_back(t0 + boost::posix_time::milliseconds(i*10), variant(0.01*i));
+    }
+
+    boost::chrono::high_resolution_clock::time_point start(boost::chrono::high_resolution_clock::now());
+    double sum(0.0);
+    for (int i=0; i<lookups; ++i)
+    {
+        sum += ticks.at_or_before(t0 + boost::posix_time::milliseconds((i*7919LL) % (points*10LL))).values<variant::Double>().front();
+    }
+    boost::chrono::high_resolution_clock::time_point finish(boost::chrono::high_resolution_clock::now());
+
+    std::cout << "[TimeSeries] at_or_before took "
+              << boost::chrono::duration_cast<boost::chrono::nanoseconds>(finish - start) / lookups << " per lookup ("
+              << sum << ")." << std::endl;
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
+BOOST_AUTO_TEST_CASE(test_timeseries_aggregation)
+{
+    const variant::date_time_t t0(variant::date_t(2020, 3, 1), boost::posix_time::hours(9));
+    const boost::posix_time::time_duration second(boost::posix_time::seconds(1));
+    const boost::posix_time::time_duration minute(boost::posix_time::minutes(1));
+
+    // prices 1..6 at 0s, 20s, 40s, 60s, 80s and 190s past the hour
+    variant ts(variant::TimeSeries);
+    const int offsets[] = { 0, 20, 40, 60, 80, 190 };
+    const boost::int64_t prices[] = { 3, 1, 4, 1, 5, 9 };
+    for (int i=0; i<6; ++i)
+    {
+        ts.push_back(t0 + second*offsets[i], variant(prices[i]));
+    }
+
+    std::vector<timeseries_aggregate> ohlc;
+    ohlc.push_back(timeseries_aggregate::Open);
+    ohlc.push_back(timeseries_aggregate::High);
+    ohlc.push_back(timeseries_aggregate::Low);
+    ohlc.push_back(timeseries_aggregate::Close);
+    ohlc.push_back(timeseries_aggregate::Sum);
+    ohlc.push_back(timeseries_aggregate::Count);
+    ohlc.push_back(timeseries_aggregate(timeseries_aggregate::Mean, "Average"));
+
+    // one-minute bars, leaving out the empty bar at 9:02
+    variant bars(ts.resample(minute, ohlc));
+    BOOST_REQUIRE(bars.is<variant::DataTable>());
+    BOOST_REQUIRE_EQUAL(bars.size(), 3u);
+    BOOST_REQUIRE_EQUAL(bars.columns().size(), 8u);
+    BOOST_CHECK_EQUAL(bars.columns()[0].name(), "Time");
+    BOOST_CHECK_EQUAL(bars.columns()[1].name(), "Open");
+    BOOST_CHECK_EQUAL(bars.columns()[7].name(), "Average");
+    BOOST_CHECK_EQUAL(bars.columns()[1].type(), variant::Int64);
+    BOOST_CHECK_EQUAL(bars.columns()[6].type(), variant::UInt64);
+    BOOST_CHECK_EQUAL(bars.columns()[7].type(), variant::Double);
+
+    BOOST_CHECK_EQUAL(bars.columns()[0].begin<variant::DateTime>()[0], t0);
+    BOOST_CHECK_EQUAL(bars.columns()[0].begin<variant::DateTime>()[1], t0 + minute);
+    BOOST_CHECK_EQUAL(bars.columns()[0].begin<variant::DateTime>()[2], t0 + minute*3);
+
+    BOOST_CHECK_EQUAL(bars.columns()[1].begin<variant::Int64>()[0], 3);
+    BOOST_CHECK_EQUAL(bars.columns()[2].begin<variant::Int64>()[0], 4);
+    BOOST_CHECK_EQUAL(bars.columns()[3].begin<variant::Int64>()[0], 1);
+    BOOST_CHECK_EQUAL(bars.columns()[4].begin<variant::Int64>()[0], 4);
+    BOOST_CHECK_EQUAL(bars.columns()[5].begin<variant::Int64>()[0], 8);
+    BOOST_CHECK_EQUAL(bars.columns()[6].begin<variant::UInt64>()[0], 3u);
+    BOOST_CHECK_CLOSE(bars.columns()[7].begin<variant::Double>()[0], 8.0/3.0, 1e-9);
+
+    BOOST_CHECK_EQUAL(bars.columns()[1].begin<variant::Int64>()[1], 1);
+    BOOST_CHECK_EQUAL(bars.columns()[4].begin<variant::Int64>()[1], 5);
+    BOOST_CHECK_EQUAL(bars.columns()[4].begin<variant::Int64>()[2], 9);
+
+    // a single aggregate as a TimeSeries, over a range of the series
+    variant closes(ts.lower_bound(t0 + second*20).resample(minute, timeseries_aggregate::Close));
+    BOOST_REQUIRE(closes.is<variant::TimeSeries>());
+    BOOST_REQUIRE_EQUAL(closes.size(), 3u);
+    timeseries_view close_view(closes.series_view());
+    BOOST_CHECK_EQUAL(close_view.value_type(), variant::Int64);
+    BOOST_CHECK_EQUAL(close_view.time(0), t0);
+    BOOST_CHECK_EQUAL(close_view.value(0).as<boost::int64_t>(), 4);
+    BOOST_CHECK_EQUAL(close_view.value(2).as<boost::int64_t>(), 9);
+
+    // 30s windows trailing each point, ie (t - 30s, t]
+    variant rolling(ts.rolling(second*30, ohlc));
+    BOOST_REQUIRE(rolling.is<variant::DataTable>());
+    BOOST_REQUIRE_EQUAL(rolling.size(), 6u);
+    const boost::int64_t sums[] = { 3, 4, 5, 5, 6, 9 };
+    const boost::int64_t highs[] = { 3, 3, 4, 4, 5, 9 };
+    const boost::int64_t lows[] = { 3, 1, 1, 1, 1, 9 };
+    for (size_t i=0; i<6; ++i)
+    {
+        BOOST_CHECK_EQUAL(rolling.columns()[0].begin<variant::DateTime>()[i], t0 + second*offsets[i]);
+        BOOST_CHECK_EQUAL(rolling.columns()[2].begin<variant::Int64>()[i], highs[i]);
+        BOOST_CHECK_EQUAL(rolling.columns()[3].begin<variant::Int64>()[i], lows[i]);
+        BOOST_CHECK_EQUAL(rolling.columns()[4].begin<variant::Int64>()[i], prices[i]);
+        BOOST_CHECK_EQUAL(rolling.columns()[5].begin<variant::Int64>()[i], sums[i]);
+    }
+    BOOST_CHECK_EQUAL(rolling.columns()[1].begin<variant::Int64>()[2], 1);
+    BOOST_CHECK_EQUAL(rolling.columns()[6].begin<variant::UInt64>()[0], 1u);
+    BOOST_CHECK_EQUAL(rolling.columns()[6].begin<variant::UInt64>()[1], 2u);
+    BOOST_CHECK_EQUAL(rolling.columns()[6].begin<variant::UInt64>()[5], 1u);
+
+    variant means(ts.rolling(second*30, timeseries_aggregate::Mean));
+    BOOST_REQUIRE(means.is<variant::TimeSeries>());
+    BOOST_CHECK_EQUAL(means.series_view().value_type(), variant::Double);
+    BOOST_CHECK_CLOSE(means.series_view().value(2).as<double>(), 2.5, 1e-9);
+
+    // values held as variants are aggregated as doubles
+    variant mixed(variant::TimeSeries);
+    mixed.push_back(t0, variant(1.5))
+         .push_back(t0 + second, variant(static_cast<boost::int32_t>(2)))
+         .push_back(t0 + second*2, variant(static_cast<boost::uint64_t>(3)));
+    BOOST_CHECK_EQUAL(mixed.series_view().value_type(), variant::Variant);
+    variant mixed_sum(mixed.resample(minute, timeseries_aggregate::Sum));
+    BOOST_REQUIRE_EQUAL(mixed_sum.size(), 1u);
+    BOOST_CHECK_EQUAL(mixed_sum.series_view().value(0).as<double>(), 6.5);
+
+    // bars are aligned to the interval, also before the epoch
+    variant early(variant::TimeSeries);
+    early.push_back(variant::date_time_t(variant::date_t(1969, 12, 31), boost::posix_time::seconds(90)), variant(1.0));
+    BOOST_CHECK_EQUAL(early.resample(minute, timeseries_aggregate::Count).series_view().time(0),
+        variant::date_time_t(variant::date_t(1969, 12, 31), minute));
+
+    BOOST_CHECK_THROW(ts.resample(boost::posix_time::seconds(0), ohlc), variant_error);
+    BOOST_CHECK_THROW(ts.rolling(boost::posix_time::seconds(-1), ohlc), variant_error);
+
+    // UInt64 values keep their type, rather than wrapping into Int64
+    const boost::uint64_t large(static_cast<boost::uint64_t>(1) << 63);
+    variant unsigneds(variant::TimeSeries);
+    unsigneds.push_back(t0, variant(large))
+             .push_back(t0 + second, variant(large + 5u))
+             .push_back(t0 + second*2, variant(static_cast<boost::uint64_t>(1)));
+    variant unsigned_bars(unsigneds.resample(minute, ohlc));
+    BOOST_CHECK_EQUAL(unsigned_bars.columns()[2].type(), variant::UInt64);
+    BOOST_CHECK_EQUAL(unsigned_bars.columns()[2].begin<variant::UInt64>()[0], large + 5u);
+    BOOST_CHECK_EQUAL(unsigned_bars.columns()[3].begin<variant::UInt64>()[0], 1u);
+    BOOST_CHECK_EQUAL(unsigneds.rolling(minute, timeseries_aggregate::High).series_view().value(2).as<boost::uint64_t>(), large + 5u);
+
+    // special times are rejected rather than overflowing the arithmetic on ticks
+    variant special(variant::TimeSeries);
+    special.push_back(t0, variant(1.0))
+           .push_back(variant::date_time_t(boost::posix_time::pos_infin), variant(2.0));
+    BOOST_CHECK_THROW(special.resample(minute, ohlc), variant_error);
+    BOOST_CHECK_THROW(special.rolling(minute, ohlc), variant_error);
+    BOOST_CHECK_EQUAL(special.lower_bound(t0).slice(0, 1).series().resample(minute, timeseries_aggregate::Count).size(), 1u);
+
+    // intervals and windows of thousands of centuries hold every point
+    BOOST_CHECK_EQUAL(ts.resample(boost::posix_time::hours(2000000000), timeseries_aggregate::Count).size(), 1u);
+    BOOST_CHECK_EQUAL(ts.rolling(boost::posix_time::hours(2000000000), timeseries_aggregate::Count).size(), 6u);
+
+    variant empty(variant::TimeSeries);
+    BOOST_CHECK_EQUAL(empty.resample(minute, ohlc).size(), 0u);
+    BOOST_CHECK_EQUAL(empty.rolling(minute, timeseries_aggregate::Sum).size(), 0u);
+
+    /* // Start of commented-out performance test (uncomment to run)
+
+    static const int points = 100000000;
+
+    variant ticks(variant::TimeSeries);
+    for (int i=0; i<points; ++i)
+    {
+        ticks.push_back(t0 + boost::posix_time::milliseconds(i), variant(0.01*(i % 1000)));
+    }
+
+    std::vector<timeseries_aggregate> bar;
+    bar.push_back(timeseries_aggregate::Open);
+    bar.push_back(timeseries_aggregate::High);
+    bar.push_back(timeseries_aggregate::Low);
+    bar.push_back(timeseries_aggregate::Close);
+    bar.push_back(timeseries_aggregate::Mean);
+
+    boost::chrono::high_resolution_clock::time_point start(boost::chrono::high_resolution_clock::now());
+    variant seconds(ticks.resample(second, bar));
+    boost::chrono::high_resolution_clock::time_point finish(boost::chrono::high_resolution_clock::now());
+    std::cout << "[TimeSeries] 1s OHLC/mean bars of " << points << " points took "
+              << boost::chrono::duration_cast<boost::chrono::milliseconds>(finish - start) << "." << std::endl;
+    BOOST_CHECK_EQUAL(seconds.size(), static_cast<size_t>(points / 1000));
+
+    start = boost::chrono::high_resolution_clock::now();
+    variant hours(ticks.resample(boost::posix_time::hours(1), timeseries_aggregate::Sum));
+    finish = boost::chrono::high_resolution_clock::now();
+    std::cout << "[TimeSeries] 1h sums of " << points << " points took "
+              << boost::chrono::duration_cast<boost::chrono::milliseconds>(finish - start) << "." << std::endl;
+
+    start = boost::chrono::high_resolution_clock::now();
+    variant window(ticks.rolling(minute, timeseries_aggregate::Mean));
+    finish = boost::chrono::high_resolution_clock::now();
+    std::cout << "[TimeSeries] 1m rolling mean of " << points << " points took "
+              << boost::chrono::duration_cast<boost::chrono::milliseconds>(finish - start) << "." << std::endl;
+    BOOST_CHECK_EQUAL(window.size(), static_cast<size_t>(points));
+
+    start = boost::chrono::high_resolution_clock::now();
+    variant highs_window(ticks.rolling(minute, timeseries_aggregate::High));
+    finish = boost::chrono::high_resolution_clock::now();
+    std::cout << "[TimeSeries] 1m rolling high of " << points << " points took "
+              << boost::chrono::duration_cast<boost::chrono::milliseconds>(finish - start) << "." << std::endl;
+
+    */ // End of commented-out performance test (uncomment to run)
+}
+
 BOOST_AUTO_TEST_SUITE_END()